@@ -125,6 +125,9 @@ int main()
 
 		driver->endScene();
 
+        //! Refit the collision engine's hierarchy to where the nodes ended up this frame
+        gCollEng->UpdateTransformation();
+
         cube->setMaterialFlag(video::EMF_WIREFRAME,false);
         sphere->setMaterialFlag(video::EMF_WIREFRAME,false);
         core::vectorSIMDf origin,dir;
@@ -159,12 +159,8 @@ int main()
         io::IReadFile* cacheFile = device->getFileSystem()->createAndOpenFile("./normalCache101010.sse");
         if (cacheFile)
         {
-            asset::normalCacheFor2_10_10_10Quant.resize(cacheFile->getSize()/sizeof(asset::QuantizationCacheEntry2_10_10_10));
-            cacheFile->read(asset::normalCacheFor2_10_10_10Quant.data(),cacheFile->getSize());
+            asset::normalCacheFor2_10_10_10Quant.loadFromFile(cacheFile);
             cacheFile->drop();
-
-            //make sure its still ok
-            std::sort(asset::normalCacheFor2_10_10_10Quant.begin(),asset::normalCacheFor2_10_10_10Quant.end());
         }
 	}
 
@@ -229,7 +225,7 @@ int main()
         //! cache results -- speeds up mesh generation on second run
         {
             io::IWriteFile* cacheFile = device->getFileSystem()->createAndWriteFile("./normalCache101010.sse");
-            cacheFile->write(asset::normalCacheFor2_10_10_10Quant.data(),asset::normalCacheFor2_10_10_10Quant.size()*sizeof(asset::QuantizationCacheEntry2_10_10_10));
+            asset::normalCacheFor2_10_10_10Quant.saveToFile(cacheFile);
             cacheFile->drop();
         }
 
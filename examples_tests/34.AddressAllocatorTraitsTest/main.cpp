@@ -5,10 +5,74 @@
 #include "irr/core/alloc/address_allocator_traits.h"
 #include "irr/core/alloc/LinearAddressAllocator.h"
 #include "irr/core/alloc/StackAddressAllocator.h"
+
+#include <map>
+#include <random>
 
 using namespace irr;
 
 
+//! Replays a random alloc/free trace on the TLSF allocator and checks every allocation against a reference map of the live ones
+static bool testTLSFRandomTrace()
+{
+	typedef core::TLSFAddressAllocatorST<uint32_t> allocator_t;
+	constexpr uint32_t bufSz = 1u<<20u;
+	constexpr uint32_t minBlockSz = 64u;
+	constexpr uint32_t maxAlignment = 4096u;
+	auto blockBytes = [](uint32_t bytes) {return core::roundUp(bytes,minBlockSz);};
+
+	void* reserved = _IRR_ALIGNED_MALLOC(allocator_t::reserved_size(maxAlignment,bufSz,minBlockSz),_IRR_SIMD_ALIGNMENT);
+	allocator_t allocator(reserved,0u,0u,maxAlignment,bufSz,minBlockSz);
+
+	std::mt19937 rng(0x7153u);
+	std::map<uint32_t,uint32_t> live; // address -> requested bytes
+	uint32_t liveBytes = 0u;
+	bool ok = true;
+	for (uint32_t i=0u; ok && i<1000000u; i++)
+	{
+		if (live.empty() || rng()%3u)
+		{
+			const uint32_t bytes = 1u+rng()%(16u*1024u);
+			const uint32_t alignment = 1u<<(rng()%13u);
+			const uint32_t addr = allocator.alloc_addr(bytes,alignment);
+			if (addr==allocator_t::invalid_address)
+				continue;
+
+			const auto next = live.lower_bound(addr);
+			const bool overlapsNext = next!=live.end() && next->first<addr+blockBytes(bytes);
+			const bool overlapsPrev = next!=live.begin() && std::prev(next)->first+blockBytes(std::prev(next)->second)>addr;
+			ok = (addr&(alignment-1u))==0u && addr+bytes<=bufSz && !overlapsNext && !overlapsPrev;
+			live.emplace_hint(next,addr,bytes);
+			liveBytes += blockBytes(bytes);
+		}
+		else
+		{
+			const auto it = std::next(live.begin(),rng()%live.size());
+			allocator.free_addr(it->first,it->second);
+			liveBytes -= blockBytes(it->second);
+			live.erase(it);
+		}
+		ok = ok && allocator.get_allocated_size()==liveBytes;
+	}
+
+	// nothing live may be cut off when shrinking, then grow to twice the size with the allocations still in place
+	const uint32_t shrinkSize = allocator.safe_shrink_size(0u,maxAlignment);
+	for (const auto& alloc : live)
+		ok = ok && alloc.first+blockBytes(alloc.second)<=shrinkSize;
+	void* grownReserved = _IRR_ALIGNED_MALLOC(allocator_t::reserved_size(maxAlignment,bufSz*2u,minBlockSz),_IRR_SIMD_ALIGNMENT);
+	allocator_t grown(bufSz*2u,std::move(allocator),grownReserved);
+	_IRR_ALIGNED_FREE(reserved);
+	ok = ok && grown.get_allocated_size()==liveBytes && grown.get_free_size()==bufSz*2u-liveBytes;
+
+	// free blocks coalesce immediately, so once everything is freed the whole buffer has to be allocatable again
+	for (const auto& alloc : live)
+		grown.free_addr(alloc.first,alloc.second);
+	ok = ok && grown.get_free_size()==bufSz*2u && grown.alloc_addr(bufSz*2u,minBlockSz)==0u;
+	_IRR_ALIGNED_FREE(grownReserved);
+
+	return ok;
+}
+
 int main()
 {
     printf("SINGLE THREADED======================================================\n");
@@ -22,6 +86,8 @@ int main()
 	irr::core::address_allocator_traits<core::ContiguousPoolAddressAllocatorST<uint32_t> >::printDebugInfo();
 	printf("General \n");
 	irr::core::address_allocator_traits<core::GeneralpurposeAddressAllocatorST<uint32_t> >::printDebugInfo();
+	printf("TLSF \n");
+	irr::core::address_allocator_traits<core::TLSFAddressAllocatorST<uint32_t> >::printDebugInfo();
 
     printf("MULTI THREADED=======================================================\n");
 	printf("Linear \n");
@@ -32,6 +98,11 @@ int main()
 	irr::core::address_allocator_traits<core::ContiguousPoolAddressAllocatorMT<uint32_t,std::recursive_mutex> >::printDebugInfo();
 	printf("General \n");
 	irr::core::address_allocator_traits<core::GeneralpurposeAddressAllocatorMT<uint32_t,std::recursive_mutex> >::printDebugInfo();
+	printf("TLSF \n");
+	irr::core::address_allocator_traits<core::TLSFAddressAllocatorMT<uint32_t,std::recursive_mutex> >::printDebugInfo();
 
-	return 0;
+	const bool traceOk = testTLSFRandomTrace();
+	printf("TLSF random trace %s\n",traceOk ? "passed":"FAILED");
+
+	return traceOk ? 0:1;
 }
@@ -0,0 +1,85 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+#include "CConcurrentObjectCache.h"
+
+using namespace irr;
+
+#define KEY_COUNT 4096u
+#define OPS_PER_THREAD (1u<<18)
+//! percentage of operations which are writes (insert+remove), the rest are lookups
+#define WRITE_PERCENTAGE 10u
+
+class RefCounted : public core::IReferenceCounted {};
+
+template<class CacheT>
+void runBenchmark(const char* _name, uint32_t _threadCnt, const core::vector<std::string>& _keys, const core::vector<RefCounted*>& _values)
+{
+    CacheT cache;
+    for (uint32_t i = 0u; i < KEY_COUNT; i += 2u)
+        cache.insert(_keys[i], _values[i]);
+
+    auto worker = [&](uint32_t _seed)
+    {
+        std::mt19937 generator(_seed);
+        std::uniform_int_distribution<uint32_t> keyDist(0u, KEY_COUNT-1u);
+        std::uniform_int_distribution<uint32_t> opDist(0u, 99u);
+        core::IReferenceCounted* found[4];
+        for (uint32_t i = 0u; i < OPS_PER_THREAD; ++i)
+        {
+            const uint32_t k = keyDist(generator);
+            if (opDist(generator) < WRITE_PERCENTAGE)
+            {
+                if (!cache.insert(_keys[k], _values[k]))
+                    cache.removeObject(_values[k], _keys[k]);
+            }
+            else
+            {
+                size_t cnt = 4u;
+                cache.findAndStoreRange(_keys[k], cnt, found);
+            }
+        }
+    };
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    core::vector<std::thread> threads;
+    for (uint32_t i = 1u; i < _threadCnt; ++i)
+        threads.emplace_back(worker, i);
+    worker(0u);
+    for (auto& th : threads)
+        th.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now()-start).count();
+
+    printf("%-8s threads: %3u  %10.3f Mops/s\n", _name, _threadCnt, double(_threadCnt)*OPS_PER_THREAD/seconds*1e-6);
+}
+
+int main()
+{
+    core::vector<std::string> keys(KEY_COUNT);
+    core::vector<RefCounted*> values(KEY_COUNT);
+    for (uint32_t i = 0u; i < KEY_COUNT; ++i)
+    {
+        keys[i] = "../../media/some/long/path/to/an/asset_" + std::to_string(i) + ".baw";
+        values[i] = new RefCounted();
+    }
+
+    using SingleLockCache = core::CConcurrentMultiObjectCache<std::string, core::IReferenceCounted*, std::multimap>;
+    using ShardedCache = core::CShardedConcurrentMultiObjectCache<std::string, core::IReferenceCounted*, std::multimap>;
+
+    const uint32_t maxThreads = core::max_(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t threadCnt = 1u; threadCnt <= maxThreads; threadCnt <<= 1u)
+    {
+        runBenchmark<SingleLockCache>("single", threadCnt, keys, values);
+        runBenchmark<ShardedCache>("sharded", threadCnt, keys, values);
+    }
+
+    for (auto v : values)
+        v->drop();
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "CObjectCache.h"
+
+using namespace irr;
+
+//! amount of .baw files, every one of them contributes SUBASSETS_PER_FILE sub-assets
+#define FILE_COUNT 1024u
+#define SUBASSETS_PER_FILE 128u
+#define LOOKUP_COUNT (1u<<20)
+
+class RefCounted : public core::IReferenceCounted {};
+
+static double secondsSince(const std::chrono::high_resolution_clock::time_point& _start)
+{
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now()-_start).count();
+}
+
+//! Mimics what the asset manager does with the path based cache: sub-assets of every file get inserted one by one (or in bulk),
+//! then looked up by key many times over, and finally everything gets removed.
+template<class CacheT>
+void runBenchmark(const char* _name, const core::vector<std::pair<std::string,core::IReferenceCounted*>>& _pairs, const core::vector<uint32_t>& _lookups)
+{
+    double insertTime, bulkInsertTime, lookupTime, removeTime;
+    {
+        CacheT cache;
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (const auto& p : _pairs)
+            cache.insert(p.first, p.second);
+        insertTime = secondsSince(start);
+    }
+
+    CacheT cache;
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0u; i < FILE_COUNT; ++i)
+            cache.bulkInsert(_pairs.begin()+i*SUBASSETS_PER_FILE, _pairs.begin()+(i+1u)*SUBASSETS_PER_FILE);
+        bulkInsertTime = secondsSince(start);
+    }
+    {
+        size_t foundCnt = 0u;
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t ix : _lookups)
+        {
+            core::IReferenceCounted* found[4];
+            size_t cnt = 4u;
+            cache.findAndStoreRange(_pairs[ix].first, cnt, found);
+            foundCnt += cnt;
+        }
+        lookupTime = secondsSince(start);
+        if (foundCnt != _lookups.size())
+            printf("%s: lookups found %u pairs instead of %u!\n", _name, static_cast<uint32_t>(foundCnt), static_cast<uint32_t>(_lookups.size()));
+    }
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t ix : _lookups)
+        if (ix % 8u == 0u)
+            cache.removeObject(_pairs[ix].second, _pairs[ix].first);
+        removeTime = secondsSince(start);
+    }
+
+    printf("%-10s insert: %8.2f ms  bulk insert: %8.2f ms  lookup: %8.2f ns/op  remove: %8.2f ms\n", _name,
+        insertTime*1e3, bulkInsertTime*1e3, lookupTime*1e9/double(_lookups.size()), removeTime*1e3);
+}
+
+int main()
+{
+    constexpr uint32_t pairCount = FILE_COUNT*SUBASSETS_PER_FILE;
+    core::vector<std::pair<std::string,core::IReferenceCounted*>> pairs;
+    pairs.reserve(pairCount);
+    // keys look like the ones CBAWMeshFileLoader::genSubAssetCacheKey() generates
+    for (uint32_t i = 0u; i < FILE_COUNT; ++i)
+    {
+        const std::string rootKey = "../../media/some/long/path/to/a/model_" + std::to_string(i) + ".baw";
+        for (uint32_t j = 0u; j < SUBASSETS_PER_FILE; ++j)
+            pairs.emplace_back(rootKey + "?" + std::to_string(0x7f3a12c0000ull+j*64u), new RefCounted());
+    }
+    // loaders insert sub-assets in blob order, not sorted by key
+    std::mt19937 generator(0x1234u);
+    for (uint32_t i = 0u; i < FILE_COUNT; ++i)
+        std::shuffle(pairs.begin()+i*SUBASSETS_PER_FILE, pairs.begin()+(i+1u)*SUBASSETS_PER_FILE, generator);
+
+    core::vector<uint32_t> lookups(LOOKUP_COUNT);
+    std::uniform_int_distribution<uint32_t> dist(0u, pairCount-1u);
+    for (auto& ix : lookups)
+        ix = dist(generator);
+
+    printf("%u keys, %u lookups\n", pairCount, LOOKUP_COUNT);
+    runBenchmark<core::CMultiObjectCache<std::string, core::IReferenceCounted*, std::vector>>("vector", pairs, lookups);
+    runBenchmark<core::CMultiObjectCache<std::string, core::IReferenceCounted*, std::multimap>>("multimap", pairs, lookups);
+    runBenchmark<core::CMultiObjectCache<std::string, core::IReferenceCounted*, core::open_addressing_multimap>>("open addr", pairs, lookups);
+
+    for (auto& p : pairs)
+        p.second->drop();
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <utility>
+
+#include "irr/video/convertColor.h"
+
+using namespace irr;
+
+//! amount of texels converted per format pair when measuring the fast path against the scalar path
+#define FAST_TEXEL_COUNT (1u<<16)
+//! amount of texels converted per format pair in the matrix of all pairs
+#define MATRIX_TEXEL_COUNT (1u<<12)
+#define MAX_TEXEL_SIZE 32u
+
+//! Formats which have a SIMD codec, see video::impl::SSIMDTexelCodec
+constexpr asset::E_FORMAT FastFormats[] = {
+    asset::EF_R8_UNORM, asset::EF_R8G8_UNORM, asset::EF_R8G8B8_UNORM, asset::EF_B8G8R8_UNORM,
+    asset::EF_R8G8B8A8_UNORM, asset::EF_B8G8R8A8_UNORM, asset::EF_A8B8G8R8_UNORM_PACK32,
+    asset::EF_R8_SRGB, asset::EF_R8G8_SRGB, asset::EF_R8G8B8_SRGB, asset::EF_B8G8R8_SRGB,
+    asset::EF_R8G8B8A8_SRGB, asset::EF_B8G8R8A8_SRGB, asset::EF_A8B8G8R8_SRGB_PACK32,
+    asset::EF_R16_SFLOAT, asset::EF_R16G16_SFLOAT, asset::EF_R16G16B16_SFLOAT, asset::EF_R16G16B16A16_SFLOAT,
+    asset::EF_R32_SFLOAT, asset::EF_R32G32_SFLOAT, asset::EF_R32G32B32_SFLOAT, asset::EF_R32G32B32A32_SFLOAT,
+    asset::EF_R5G6B5_UNORM_PACK16, asset::EF_B5G6R5_UNORM_PACK16,
+    asset::EF_A2R10G10B10_UNORM_PACK32, asset::EF_A2B10G10R10_UNORM_PACK32
+};
+constexpr size_t FastFormatCount = sizeof(FastFormats)/sizeof(asset::E_FORMAT);
+static const char* FastFormatNames[FastFormatCount] = {
+    "R8_UNORM", "R8G8_UNORM", "R8G8B8_UNORM", "B8G8R8_UNORM",
+    "R8G8B8A8_UNORM", "B8G8R8A8_UNORM", "A8B8G8R8_UNORM_PACK32",
+    "R8_SRGB", "R8G8_SRGB", "R8G8B8_SRGB", "B8G8R8_SRGB",
+    "R8G8B8A8_SRGB", "B8G8R8A8_SRGB", "A8B8G8R8_SRGB_PACK32",
+    "R16_SFLOAT", "R16G16_SFLOAT", "R16G16B16_SFLOAT", "R16G16B16A16_SFLOAT",
+    "R32_SFLOAT", "R32G32_SFLOAT", "R32G32B32_SFLOAT", "R32G32B32A32_SFLOAT",
+    "R5G6B5_UNORM_PACK16", "B5G6R5_UNORM_PACK16",
+    "A2R10G10B10_UNORM_PACK32", "A2B10G10R10_UNORM_PACK32"
+};
+
+using span_conversion_t = void(*)(const void*, void*, size_t);
+
+//! What convertColor did for every format pair before the fast path, one texel at a time through doubles
+template<asset::E_FORMAT sF, asset::E_FORMAT dF>
+void convertScalar(const void* _src, void* _dst, size_t _texelCnt)
+{
+    const uint32_t srcStride = asset::getTexelOrBlockSize(sF);
+    const uint32_t dstStride = asset::getTexelOrBlockSize(dF);
+    for (size_t i = 0u; i < _texelCnt; ++i)
+    {
+        const void* srcPix[4] = { reinterpret_cast<const uint8_t*>(_src)+i*srcStride, nullptr, nullptr, nullptr };
+        video::convertColor<sF, dF>(srcPix, reinterpret_cast<uint8_t*>(_dst)+i*dstStride, 0u, 0u);
+    }
+}
+template<size_t srcIx, size_t... dstIx>
+constexpr std::array<span_conversion_t, FastFormatCount> scalarConversionRow(std::index_sequence<dstIx...>)
+{
+    return { &convertScalar<FastFormats[srcIx], FastFormats[dstIx]>... };
+}
+template<size_t... srcIx>
+constexpr std::array<std::array<span_conversion_t, FastFormatCount>, FastFormatCount> scalarConversionTable(std::index_sequence<srcIx...>)
+{
+    return { scalarConversionRow<srcIx>(std::make_index_sequence<FastFormatCount>())... };
+}
+
+static double secondsSince(const std::chrono::high_resolution_clock::time_point& _start)
+{
+    // same format pairs are a memcpy which can finish below the clock's resolution
+    return std::max(std::chrono::duration<double>(std::chrono::high_resolution_clock::now()-_start).count(), 1e-9);
+}
+
+static bool isBenchmarkable(asset::E_FORMAT _fmt)
+{
+    return !asset::isBlockCompressionFormat(_fmt) && !asset::isPlanarFormat(_fmt) && !asset::isDepthOrStencilFormat(_fmt) &&
+        asset::getTexelOrBlockSize(_fmt) && asset::getTexelOrBlockSize(_fmt)<=MAX_TEXEL_SIZE;
+}
+
+//! Fills `_texelCnt` texels with random colors in [0,1], integer formats get 0s and 1s
+static void fillRandom(asset::E_FORMAT _fmt, uint8_t* _texels, size_t _texelCnt, std::mt19937& _rng)
+{
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    const uint32_t stride = asset::getTexelOrBlockSize(_fmt);
+    std::fill(_texels, _texels+_texelCnt*stride, 0u);
+    for (size_t i = 0u; i < _texelCnt; ++i)
+    {
+        double color[4];
+        for (uint32_t c = 0u; c < 4u; ++c)
+            color[c] = asset::isIntegerFormat(_fmt) ? std::round(dist(_rng)) : dist(_rng);
+        video::encodePixels<double>(_fmt, _texels+i*stride, color);
+    }
+}
+
+//! Largest difference of the channels both formats have, after decoding source and destination
+static double maxDecodedError(asset::E_FORMAT _sF, asset::E_FORMAT _dF, const uint8_t* _src, const uint8_t* _dst, size_t _texelCnt)
+{
+    const uint32_t chCnt = std::min(asset::getFormatChannelCount(_sF), asset::getFormatChannelCount(_dF));
+    double maxError = 0.0;
+    for (size_t i = 0u; i < _texelCnt; ++i)
+    {
+        const void* srcPix[4] = { _src+i*asset::getTexelOrBlockSize(_sF), nullptr, nullptr, nullptr };
+        const void* dstPix[4] = { _dst+i*asset::getTexelOrBlockSize(_dF), nullptr, nullptr, nullptr };
+        double expected[4], actual[4];
+        video::decodePixels<double>(_sF, srcPix, expected, 0u, 0u);
+        video::decodePixels<double>(_dF, dstPix, actual, 0u, 0u);
+        for (uint32_t c = 0u; c < chCnt; ++c)
+            maxError = std::max(maxError, std::abs(expected[c]-actual[c]));
+    }
+    return maxError;
+}
+
+int main()
+{
+    std::mt19937 rng(0x45u);
+    core::vector<uint8_t> src(FAST_TEXEL_COUNT*MAX_TEXEL_SIZE), dst(FAST_TEXEL_COUNT*MAX_TEXEL_SIZE);
+
+    printf("SIMD fast path vs. scalar path, %u texels per pair [Mtexels/s]\n", FAST_TEXEL_COUNT);
+    printf("%-26s %-26s %10s %10s %8s %10s\n", "source", "destination", "scalar", "SIMD", "speedup", "max error");
+    const auto scalarTable = scalarConversionTable(std::make_index_sequence<FastFormatCount>());
+    double speedupLogSum = 0.0;
+    for (size_t s = 0u; s < FastFormatCount; ++s)
+    {
+        fillRandom(FastFormats[s], src.data(), FAST_TEXEL_COUNT, rng);
+        for (size_t d = 0u; d < FastFormatCount; ++d)
+        {
+            std::fill(dst.begin(), dst.end(), 0u);
+            auto start = std::chrono::high_resolution_clock::now();
+            scalarTable[s][d](src.data(), dst.data(), FAST_TEXEL_COUNT);
+            const double scalarTime = secondsSince(start);
+
+            const void* srcPix[4] = { src.data(), nullptr, nullptr, nullptr };
+            core::vector3d<uint32_t> imgSize(FAST_TEXEL_COUNT, 1u, 1u);
+            start = std::chrono::high_resolution_clock::now();
+            video::convertColor(FastFormats[s], FastFormats[d], srcPix, dst.data(), FAST_TEXEL_COUNT, imgSize);
+            const double simdTime = secondsSince(start);
+
+            const double error = maxDecodedError(FastFormats[s], FastFormats[d], src.data(), dst.data(), FAST_TEXEL_COUNT);
+            speedupLogSum += std::log(scalarTime/simdTime);
+            printf("%-26s %-26s %10.1f %10.1f %7.1fx %10.6f\n", FastFormatNames[s], FastFormatNames[d],
+                FAST_TEXEL_COUNT/scalarTime*1e-6, FAST_TEXEL_COUNT/simdTime*1e-6, scalarTime/simdTime, error);
+        }
+    }
+    printf("Geometric mean speedup: %.1fx\n\n", std::exp(speedupLogSum/double(FastFormatCount*FastFormatCount)));
+
+    // every other pair goes through the generic path, so the matrix shows where adding a fast path would pay off most
+    FILE* csv = fopen("colorConversionMatrix.csv", "w");
+    if (csv)
+        fprintf(csv, "source,destination,fast path,Mtexels/s\n");
+    double fastTime = 0.0, genericTime = 0.0;
+    size_t fastCnt = 0u, genericCnt = 0u;
+    for (uint32_t s = 0u; s < asset::EF_UNKNOWN; ++s)
+    {
+        const asset::E_FORMAT sF = static_cast<asset::E_FORMAT>(s);
+        if (!isBenchmarkable(sF))
+            continue;
+        fillRandom(sF, src.data(), MATRIX_TEXEL_COUNT, rng);
+        const bool srcFast = std::find(FastFormats, FastFormats+FastFormatCount, sF)!=FastFormats+FastFormatCount;
+        for (uint32_t d = 0u; d < asset::EF_UNKNOWN; ++d)
+        {
+            const asset::E_FORMAT dF = static_cast<asset::E_FORMAT>(d);
+            if (!isBenchmarkable(dF))
+                continue;
+            const bool fast = srcFast && std::find(FastFormats, FastFormats+FastFormatCount, dF)!=FastFormats+FastFormatCount;
+
+            const void* srcPix[4] = { src.data(), nullptr, nullptr, nullptr };
+            core::vector3d<uint32_t> imgSize(MATRIX_TEXEL_COUNT, 1u, 1u);
+            const auto start = std::chrono::high_resolution_clock::now();
+            video::convertColor(sF, dF, srcPix, dst.data(), MATRIX_TEXEL_COUNT, imgSize);
+            const double time = secondsSince(start);
+
+            (fast ? fastTime:genericTime) += time;
+            (fast ? fastCnt:genericCnt)++;
+            if (csv)
+                fprintf(csv, "%u,%u,%u,%f\n", s, d, uint32_t(fast), MATRIX_TEXEL_COUNT/time*1e-6);
+        }
+    }
+    if (csv)
+        fclose(csv);
+    printf("All %u format pairs, %u texels per pair (per pair results in colorConversionMatrix.csv)\n", uint32_t(fastCnt+genericCnt), MATRIX_TEXEL_COUNT);
+    printf("Fast path pairs: %u, average %.1f Mtexels/s\n", uint32_t(fastCnt), fastCnt*MATRIX_TEXEL_COUNT/fastTime*1e-6);
+    printf("Generic pairs: %u, average %.1f Mtexels/s\n", uint32_t(genericCnt), genericCnt*MATRIX_TEXEL_COUNT/genericTime*1e-6);
+
+    return 0;
+}
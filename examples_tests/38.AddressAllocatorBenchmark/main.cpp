@@ -0,0 +1,568 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "irr/core/alloc/PoolAddressAllocator.h"
+#include "irr/core/alloc/StackAddressAllocator.h"
+
+using namespace irr;
+
+/**
+Replays allocation traces against every address allocator, no window or driver needed.
+
+Usage: 38.AddressAllocatorBenchmark [-trace file]... [-save prefix] [-csv file] [-ops count] [-threads count]
+    -trace      replay a recorded trace instead of the synthetic ones, can be given multiple times
+    -save       write the synthetic traces to `prefix<name>.trace` so they can be replayed by later releases
+    -csv        where to write the results, "addressAllocatorBenchmark.csv" by default
+    -ops        amount of operations per synthetic trace
+    -threads    threads hammering the concurrency adaptors, 0 means one per hardware thread
+
+Reported are throughput, latency percentiles, failed allocations, the peak fragmentation as 1-max_size()/get_free_size()
+(as far as the allocator knows, GeneralpurposeAddressAllocator only merges free blocks when it defragments) and how often
+GeneralpurposeAddressAllocator had to defragment. Results go to stdout and as CSV to a file.
+
+A trace file is plain text, one operation per line, lines starting with '#' are ignored:
+    a <id> <bytes> <alignment>
+    f <id>
+*/
+
+using size_type = uint32_t;
+constexpr size_type invalid_address = core::address_type_traits<size_type>::invalid_address;
+
+constexpr size_type BufferSize = 32u<<20u;
+constexpr size_type MaxAlignment = 4096u;
+constexpr size_type MinBlockSize = 64u;
+
+struct SOp
+{
+    enum E_TYPE : uint32_t
+    {
+        ET_ALLOC,
+        ET_FREE
+    };
+    E_TYPE type;
+    uint32_t id;
+    size_type bytes;
+    size_type alignment;
+};
+
+struct STrace
+{
+    std::string name;
+    core::vector<SOp> ops;
+    uint32_t allocCount = 0u;
+    size_type maxBytes = 0u;
+    size_type maxAlignment = 1u;
+    //! whether every free is of the most recent live allocation, only such traces can be replayed by a StackAddressAllocator
+    bool lifo = true;
+
+    //! @returns the id of the allocation
+    uint32_t alloc(size_type _bytes, size_type _alignment)
+    {
+        ops.push_back({SOp::ET_ALLOC,allocCount,_bytes,_alignment});
+        return allocCount++;
+    }
+    void free(uint32_t _id)
+    {
+        ops.push_back({SOp::ET_FREE,_id,0u,0u});
+    }
+
+    //! Fills in the sizes of frees and the statistics, @returns false if the trace is malformed
+    bool finalize()
+    {
+        core::vector<uint32_t> opOfAlloc(allocCount,~0u);
+        core::vector<bool> freed(allocCount,false);
+        core::vector<uint32_t> stack;
+        for (uint32_t i=0u; i<ops.size(); i++)
+        {
+            SOp& op = ops[i];
+            if (op.id>=allocCount)
+                return false;
+            if (op.type==SOp::ET_ALLOC)
+            {
+                if (!op.bytes || !core::isPoT(op.alignment) || op.alignment>MaxAlignment || opOfAlloc[op.id]!=~0u)
+                    return false;
+                opOfAlloc[op.id] = i;
+                stack.push_back(op.id);
+                maxBytes = std::max(maxBytes,op.bytes);
+                maxAlignment = std::max(maxAlignment,op.alignment);
+            }
+            else
+            {
+                if (opOfAlloc[op.id]==~0u || freed[op.id])
+                    return false;
+                freed[op.id] = true;
+                op.bytes = ops[opOfAlloc[op.id]].bytes;
+                op.alignment = ops[opOfAlloc[op.id]].alignment;
+                if (stack.empty() || stack.back()!=op.id)
+                    lifo = false;
+                else
+                    stack.pop_back();
+            }
+        }
+        return true;
+    }
+};
+
+static bool saveTrace(const STrace& _trace, const std::string& _path)
+{
+    FILE* file = fopen(_path.c_str(),"w");
+    if (!file)
+        return false;
+    fprintf(file,"# %s\n",_trace.name.c_str());
+    for (const auto& op : _trace.ops)
+    {
+        if (op.type==SOp::ET_ALLOC)
+            fprintf(file,"a %u %u %u\n",op.id,op.bytes,op.alignment);
+        else
+            fprintf(file,"f %u\n",op.id);
+    }
+    fclose(file);
+    return true;
+}
+
+static bool loadTrace(STrace& _trace, const std::string& _path)
+{
+    std::ifstream file(_path);
+    if (!file.is_open())
+        return false;
+    _trace.name = _path.substr(_path.find_last_of("/\\")+1u);
+    std::string line;
+    while (std::getline(file,line))
+    {
+        uint32_t id, bytes, alignment;
+        if (line.empty() || line[0]=='#')
+            continue;
+        else if (sscanf(line.c_str(),"a %u %u %u",&id,&bytes,&alignment)==3)
+        {
+            if (id!=_trace.allocCount)
+                return false;
+            _trace.alloc(bytes,alignment);
+        }
+        else if (sscanf(line.c_str(),"f %u",&id)==1)
+            _trace.free(id);
+        else
+            return false;
+    }
+    return _trace.finalize();
+}
+
+//! sizes spread evenly over orders of magnitude, like real mixes of small constants and large uploads
+static size_type logUniform(std::mt19937& _rng, size_type _min, size_type _max)
+{
+    std::uniform_real_distribution<double> dist(std::log(double(_min)),std::log(double(_max)));
+    return static_cast<size_type>(std::exp(dist(_rng)));
+}
+
+static core::vector<STrace> createSyntheticTraces(uint32_t _opCount)
+{
+    core::vector<STrace> traces;
+    std::mt19937 rng(0x45u);
+
+    // random sizes, alignments and lifetimes with at most half of the buffer in use
+    {
+        STrace trace;
+        trace.name = "random_lifetimes";
+        core::vector<std::pair<uint32_t,size_type> > live;
+        size_type liveBytes = 0u;
+        while (trace.ops.size()<_opCount)
+        {
+            const size_type bytes = logUniform(rng,16u,64u<<10u);
+            if (live.empty() || (rng()%100u<55u && liveBytes+bytes<BufferSize/2u))
+            {
+                live.emplace_back(trace.alloc(bytes,0x1u<<(rng()%9u)),bytes);
+                liveBytes += bytes;
+            }
+            else
+            {
+                std::swap(live[rng()%live.size()],live.back());
+                trace.free(live.back().first);
+                liveBytes -= live.back().second;
+                live.pop_back();
+            }
+        }
+        traces.push_back(std::move(trace));
+    }
+    // streaming uploads, every frame's allocations are freed when its fence signals three frames later
+    {
+        STrace trace;
+        trace.name = "streaming_frames";
+        core::vector<core::vector<uint32_t> > frames;
+        while (trace.ops.size()<_opCount)
+        {
+            if (frames.size()>=3u)
+            {
+                for (auto id : frames.front())
+                    trace.free(id);
+                frames.erase(frames.begin());
+            }
+            frames.emplace_back();
+            for (uint32_t i=32u+rng()%224u; i; i--)
+                frames.back().push_back(trace.alloc(logUniform(rng,16u,16u<<10u),256u));
+        }
+        traces.push_back(std::move(trace));
+    }
+    // fixed size blocks with random lifetimes, what pools are made for
+    {
+        STrace trace;
+        trace.name = "fixed_blocks";
+        core::vector<uint32_t> live;
+        while (trace.ops.size()<_opCount)
+        {
+            if (live.empty() || (rng()%100u<55u && live.size()<BufferSize/4096u/2u))
+                live.push_back(trace.alloc(4096u,256u));
+            else
+            {
+                std::swap(live[rng()%live.size()],live.back());
+                trace.free(live.back());
+                live.pop_back();
+            }
+        }
+        traces.push_back(std::move(trace));
+    }
+    // scratch memory, always freed in reverse order
+    {
+        STrace trace;
+        trace.name = "stack_lifo";
+        core::vector<std::pair<uint32_t,size_type> > live;
+        size_type liveBytes = 0u;
+        while (trace.ops.size()<_opCount)
+        {
+            const size_type bytes = logUniform(rng,16u,16u<<10u);
+            if (live.empty() || (rng()%100u<50u && liveBytes+bytes<BufferSize/2u))
+            {
+                live.emplace_back(trace.alloc(bytes,0x1u<<(rng()%5u)),bytes);
+                liveBytes += bytes;
+            }
+            else
+            {
+                trace.free(live.back().first);
+                liveBytes -= live.back().second;
+                live.pop_back();
+            }
+        }
+        traces.push_back(std::move(trace));
+    }
+
+    for (auto& trace : traces)
+        trace.finalize();
+    return traces;
+}
+
+
+//! Counts how often GeneralpurposeAddressAllocator defragments, it does so exactly when the first search for a block fails and then searches again
+class CDefragmentCountingStrategy : public core::impl::GeneralpurposeAddressAllocatorStrategy<size_type,false>
+{
+        typedef core::impl::GeneralpurposeAddressAllocatorStrategy<size_type,false> Base;
+        bool retrying = false;
+    protected:
+        using Base::Base;
+        uint32_t defragmentCount = 0u;
+
+        inline std::pair<Block,Block> findAndPopSuitableBlock(const size_type bytes, const size_type alignment) noexcept
+        {
+            auto found = Base::findAndPopSuitableBlock(bytes,alignment);
+            if (retrying)
+                retrying = false;
+            else if (found.first.startOffset==invalid_address)
+            {
+                defragmentCount++;
+                retrying = true;
+            }
+            return found;
+        }
+};
+class CCountingGeneralpurposeAddressAllocator : public core::GeneralpurposeAddressAllocator<size_type,CDefragmentCountingStrategy>
+{
+    public:
+        using core::GeneralpurposeAddressAllocator<size_type,CDefragmentCountingStrategy>::GeneralpurposeAddressAllocator;
+
+        inline uint32_t getDefragmentCount() const { return defragmentCount; }
+};
+
+template<class AddressAllocator>
+int64_t getDefragmentCount(const AddressAllocator&) { return -1; }
+int64_t getDefragmentCount(const CCountingGeneralpurposeAddressAllocator& _alloc) { return _alloc.getDefragmentCount(); }
+
+
+struct SResult
+{
+    std::string trace;
+    std::string allocator;
+    uint32_t threads;
+    uint64_t ops;
+    double opsPerSecond;
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t max;
+    uint64_t failedAllocs;
+    //! 1-max_size()/get_free_size(), -1 if the allocator doesn't expose it
+    double peakFragmentation;
+    //! -1 if the allocator never defragments
+    int64_t defragments;
+};
+
+template<class AddressAllocator>
+struct SReplayer
+{
+    using traits = core::address_allocator_traits<AddressAllocator>;
+
+    const STrace& trace;
+    core::vector<size_type> addresses;
+    core::vector<uint32_t> latencies;
+    uint64_t failedAllocs = 0u;
+    double peakFragmentation = 0.0;
+
+    SReplayer(const STrace& _trace) : trace(_trace), addresses(_trace.allocCount,invalid_address) {}
+
+    //! `measure` times every operation on its own and tracks the fragmentation, otherwise only the whole replay is timed
+    template<bool measure, bool hasStatistics>
+    void replay(AddressAllocator& _alloc)
+    {
+        if (measure)
+            latencies.reserve(trace.ops.size());
+        for (const auto& op : trace.ops)
+        {
+            const auto start = measure ? std::chrono::high_resolution_clock::now():std::chrono::high_resolution_clock::time_point();
+            size_type& address = addresses[op.id];
+            if (op.type==SOp::ET_ALLOC)
+                traits::multi_alloc_addr(_alloc,1u,&address,&op.bytes,&op.alignment);
+            else if (address!=invalid_address)
+                traits::multi_free_addr(_alloc,1u,&address,&op.bytes);
+
+            if (measure)
+            {
+                latencies.push_back(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now()-start).count()));
+                IRR_PSEUDO_IF_CONSTEXPR_BEGIN(hasStatistics)
+                {
+                    const double freeSize = double(_alloc.get_free_size());
+                    if (freeSize>0.0)
+                        peakFragmentation = std::max(peakFragmentation,1.0-double(_alloc.max_size())/freeSize);
+                }
+                IRR_PSEUDO_IF_CONSTEXPR_END
+            }
+            if (op.type==SOp::ET_ALLOC && address==invalid_address)
+                failedAllocs++;
+        }
+    }
+};
+
+static void sortLatencies(SResult& _result, core::vector<uint32_t>& _latencies)
+{
+    _result.p50 = _result.p99 = _result.max = 0u;
+    if (_latencies.empty())
+        return;
+
+    std::sort(_latencies.begin(),_latencies.end());
+    _result.p50 = _latencies[_latencies.size()/2u];
+    _result.p99 = _latencies[(_latencies.size()*99u)/100u];
+    _result.max = _latencies.back();
+}
+
+//! Replays the trace on one thread, first untimed per operation for throughput, then again timing every operation
+template<class AddressAllocator, bool hasStatistics=true, typename... Args>
+SResult benchmark(const char* _name, const STrace& _trace, const Args&... _args)
+{
+    SResult result;
+    result.trace = _trace.name;
+    result.allocator = _name;
+    result.threads = 1u;
+    result.ops = _trace.ops.size();
+    result.peakFragmentation = -1.0;
+    result.defragments = -1;
+
+    const size_type reservedSize = AddressAllocator::reserved_size(MaxAlignment,BufferSize,_args...);
+    void* reserved = _IRR_ALIGNED_MALLOC(std::max<size_type>(reservedSize,_IRR_SIMD_ALIGNMENT),_IRR_SIMD_ALIGNMENT);
+    {
+        AddressAllocator alloc(reserved,0u,0u,MaxAlignment,BufferSize,_args...);
+        SReplayer<AddressAllocator> replayer(_trace);
+        const auto start = std::chrono::high_resolution_clock::now();
+        replayer.template replay<false,hasStatistics>(alloc);
+        result.opsPerSecond = double(result.ops)/std::chrono::duration<double>(std::chrono::high_resolution_clock::now()-start).count();
+        result.failedAllocs = replayer.failedAllocs;
+        result.defragments = getDefragmentCount(alloc);
+    }
+    {
+        AddressAllocator alloc(reserved,0u,0u,MaxAlignment,BufferSize,_args...);
+        SReplayer<AddressAllocator> replayer(_trace);
+        replayer.template replay<true,hasStatistics>(alloc);
+        sortLatencies(result,replayer.latencies);
+        if (hasStatistics)
+            result.peakFragmentation = replayer.peakFragmentation;
+    }
+    _IRR_ALIGNED_FREE(reserved);
+    return result;
+}
+
+//! Every thread replays its own copy of the trace on one shared allocator which is `_threadCount` times larger
+template<class AddressAllocator, typename... Args>
+SResult benchmarkContended(const char* _name, const STrace& _trace, uint32_t _threadCount, const Args&... _args)
+{
+    SResult result;
+    result.trace = _trace.name;
+    result.allocator = _name;
+    result.threads = _threadCount;
+    result.ops = _trace.ops.size()*_threadCount;
+    result.peakFragmentation = -1.0;
+    result.defragments = -1;
+    result.failedAllocs = 0u;
+
+    // main() clamps the thread count so the whole buffer stays addressable with size_type
+    const uint64_t bufferBytes = uint64_t(BufferSize)*_threadCount;
+    assert(bufferBytes<invalid_address);
+    const size_type bufferSize = static_cast<size_type>(bufferBytes);
+    void* reserved = _IRR_ALIGNED_MALLOC(AddressAllocator::reserved_size(MaxAlignment,bufferSize,_args...),_IRR_SIMD_ALIGNMENT);
+    AddressAllocator alloc(reserved,0u,0u,MaxAlignment,bufferSize,_args...);
+
+    core::vector<SReplayer<AddressAllocator> > replayers(_threadCount,SReplayer<AddressAllocator>(_trace));
+    core::vector<std::thread> threads;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (auto& replayer : replayers)
+        threads.emplace_back([&]() -> void { replayer.template replay<true,false>(alloc); });
+    for (auto& thread : threads)
+        thread.join();
+    result.opsPerSecond = double(result.ops)/std::chrono::duration<double>(std::chrono::high_resolution_clock::now()-start).count();
+
+    core::vector<uint32_t> latencies;
+    for (auto& replayer : replayers)
+    {
+        latencies.insert(latencies.end(),replayer.latencies.begin(),replayer.latencies.end());
+        result.failedAllocs += replayer.failedAllocs;
+    }
+    sortLatencies(result,latencies);
+    _IRR_ALIGNED_FREE(reserved);
+    return result;
+}
+
+
+int main(int argc, char** argv)
+{
+    core::vector<std::string> tracePaths;
+    std::string savePrefix, csvPath = "addressAllocatorBenchmark.csv";
+    uint32_t opCount = 200000u, threadCount = 0u;
+    for (int i=1; i<argc; i++)
+    {
+        const bool hasValue = i+1<argc;
+        if (!strcmp(argv[i],"-trace") && hasValue)
+            tracePaths.push_back(argv[++i]);
+        else if (!strcmp(argv[i],"-save") && hasValue)
+            savePrefix = argv[++i];
+        else if (!strcmp(argv[i],"-csv") && hasValue)
+            csvPath = argv[++i];
+        else if (!strcmp(argv[i],"-ops") && hasValue)
+            opCount = std::max(atoi(argv[++i]),1);
+        else if (!strcmp(argv[i],"-threads") && hasValue)
+            threadCount = std::max(atoi(argv[++i]),0);
+        else
+        {
+            printf("Usage: %s [-trace file]... [-save prefix] [-csv file] [-ops count] [-threads count]\n",argv[0]);
+            return 1;
+        }
+    }
+    // contended runs share one buffer `threadCount` times larger than a single thread's, it still has to fit in size_type
+    const uint32_t maxContendedThreads = static_cast<uint32_t>((uint64_t(invalid_address)-1u)/BufferSize);
+    threadCount = std::min(core::resolveThreadCount(threadCount),maxContendedThreads);
+
+    core::vector<STrace> traces;
+    if (tracePaths.empty())
+        traces = createSyntheticTraces(opCount);
+    for (const auto& path : tracePaths)
+    {
+        traces.emplace_back();
+        if (!loadTrace(traces.back(),path))
+        {
+            printf("Could not load trace %s\n",path.c_str());
+            return 1;
+        }
+    }
+    if (!savePrefix.empty())
+    for (const auto& trace : traces)
+    {
+        if (!saveTrace(trace,savePrefix+trace.name+".trace"))
+            printf("Could not save trace %s\n",trace.name.c_str());
+    }
+
+    core::vector<uint8_t> contiguousPoolData(BufferSize);
+    core::vector<SResult> results;
+    for (const auto& trace : traces)
+    {
+        // a pool block has to fit the largest allocation and be a multiple of every alignment
+        const size_type blockSize = core::roundUpToPoT(std::max(trace.maxBytes,trace.maxAlignment));
+
+        // pools can't fragment, their max_size() is always one block
+        results.push_back(benchmark<core::PoolAddressAllocatorST<size_type>,false>("Pool",trace,blockSize));
+        results.push_back(benchmark<core::ContiguousPoolAddressAllocatorST<size_type>,false>("ContiguousPool",trace,blockSize,reinterpret_cast<void*>(contiguousPoolData.data())));
+        // frees are no-ops, so it only lasts as long as the first BufferSize bytes of allocations
+        results.push_back(benchmark<core::LinearAddressAllocatorST<size_type> >("Linear",trace));
+        if (trace.lifo)
+            results.push_back(benchmark<core::StackAddressAllocatorST<size_type> >("Stack",trace,MinBlockSize));
+        results.push_back(benchmark<CCountingGeneralpurposeAddressAllocator>("Generalpurpose",trace,MinBlockSize));
+        results.push_back(benchmark<core::TLSFAddressAllocatorST<size_type> >("TLSF",trace,MinBlockSize));
+
+        // lock overhead alone, then contention
+        results.push_back(benchmark<core::PoolAddressAllocatorMT<size_type,std::recursive_mutex>,false>("PoolMT",trace,blockSize));
+        results.push_back(benchmark<core::PoolAddressAllocatorMTCached<size_type,std::recursive_mutex>,false>("PoolMTCached",trace,blockSize));
+        results.push_back(benchmark<core::GeneralpurposeAddressAllocatorMT<size_type,std::recursive_mutex>,false>("GeneralpurposeMT",trace,MinBlockSize));
+        results.push_back(benchmark<core::GeneralpurposeAddressAllocatorMTCached<size_type,std::recursive_mutex>,false>("GeneralpurposeMTCached",trace,MinBlockSize));
+        results.push_back(benchmark<core::TLSFAddressAllocatorMT<size_type,std::recursive_mutex>,false>("TLSFMT",trace,MinBlockSize));
+        results.push_back(benchmark<core::TLSFAddressAllocatorMTCached<size_type,std::recursive_mutex>,false>("TLSFMTCached",trace,MinBlockSize));
+        if (threadCount>1u)
+        {
+            results.push_back(benchmarkContended<core::PoolAddressAllocatorMT<size_type,std::recursive_mutex> >("PoolMT",trace,threadCount,blockSize));
+            results.push_back(benchmarkContended<core::PoolAddressAllocatorMTCached<size_type,std::recursive_mutex> >("PoolMTCached",trace,threadCount,blockSize));
+            results.push_back(benchmarkContended<core::GeneralpurposeAddressAllocatorMT<size_type,std::recursive_mutex> >("GeneralpurposeMT",trace,threadCount,MinBlockSize));
+            results.push_back(benchmarkContended<core::GeneralpurposeAddressAllocatorMTCached<size_type,std::recursive_mutex> >("GeneralpurposeMTCached",trace,threadCount,MinBlockSize));
+            results.push_back(benchmarkContended<core::TLSFAddressAllocatorMT<size_type,std::recursive_mutex> >("TLSFMT",trace,threadCount,MinBlockSize));
+            results.push_back(benchmarkContended<core::TLSFAddressAllocatorMTCached<size_type,std::recursive_mutex> >("TLSFMTCached",trace,threadCount,MinBlockSize));
+        }
+    }
+
+    printf("%-18s %-22s %7s %9s %12s %8s %8s %10s %8s %8s %8s\n","trace","allocator","threads","ops","ops/s","p50[ns]","p99[ns]","max[ns]","failed","frag","defrags");
+    for (const auto& r : results)
+    {
+        printf("%-18s %-22s %7u %9llu %12.0f %8u %8u %10u %8llu ",r.trace.c_str(),r.allocator.c_str(),r.threads,
+            static_cast<unsigned long long>(r.ops),r.opsPerSecond,r.p50,r.p99,r.max,static_cast<unsigned long long>(r.failedAllocs));
+        if (r.peakFragmentation>=0.0)
+            printf("%8.3f ",r.peakFragmentation);
+        else
+            printf("%8s ","-");
+        if (r.defragments>=0)
+            printf("%8lld\n",static_cast<long long>(r.defragments));
+        else
+            printf("%8s\n","-");
+    }
+
+    FILE* csv = fopen(csvPath.c_str(),"w");
+    if (!csv)
+    {
+        printf("Could not write %s\n",csvPath.c_str());
+        return 1;
+    }
+    fprintf(csv,"trace,allocator,threads,ops,ops_per_second,p50_ns,p99_ns,max_ns,failed_allocs,peak_fragmentation,defragments\n");
+    for (const auto& r : results)
+    {
+        fprintf(csv,"%s,%s,%u,%llu,%f,%u,%u,%u,%llu,",r.trace.c_str(),r.allocator.c_str(),r.threads,
+            static_cast<unsigned long long>(r.ops),r.opsPerSecond,r.p50,r.p99,r.max,static_cast<unsigned long long>(r.failedAllocs));
+        if (r.peakFragmentation>=0.0)
+            fprintf(csv,"%f,",r.peakFragmentation);
+        else
+            fprintf(csv,",");
+        if (r.defragments>=0)
+            fprintf(csv,"%lld\n",static_cast<long long>(r.defragments));
+        else
+            fprintf(csv,"\n");
+    }
+    fclose(csv);
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "ISkinningStateManager.h"
+#include "irr/core/parallel_for.h"
+
+using namespace irr;
+
+/**
+Bones thousands of instances of a synthetic skeleton the way CSkinningStateManager::performBoning does for EBUM_NONE,
+no window or driver needed.
+
+Usage: 39.SkinningBenchmark [-instances count] [-bones count] [-threads count]
+*/
+
+using FinalBoneData = scene::ISkinningStateManager::FinalBoneData;
+
+//! A skeleton with `_boneCount` bones spread over a few levels and random keyframes
+static scene::CFinalBoneHierarchy* createHierarchy(size_t _boneCount, size_t _keyframeCount, std::mt19937& _rng)
+{
+    std::uniform_real_distribution<float> dist(-1.f,1.f);
+
+    // a root, then each level holds three times as many bones as the previous one
+    core::vector<size_t> levelEnds;
+    for (size_t levelEnd=1u; levelEnds.empty() || levelEnds.back()<_boneCount; levelEnd=levelEnd*3u)
+        levelEnds.push_back(std::min(levelEnd,_boneCount));
+
+    core::vector<scene::CFinalBoneHierarchy::BoneReferenceData> bones(_boneCount);
+    core::vector<core::stringc> names(_boneCount);
+    for (size_t level=0u; level<levelEnds.size(); level++)
+    for (size_t j=(level ? levelEnds[level-1u]:0u); j<levelEnds[level]; j++)
+    {
+        auto& bone = bones[j];
+        bone.PoseBindMatrix = core::matrix4x3();
+        bone.PoseBindMatrix.setTranslation(core::vector3df(dist(_rng),dist(_rng),dist(_rng)));
+        for (uint32_t c=0u; c<3u; c++)
+        {
+            bone.MinBBoxEdge[c] = -1.f+0.5f*dist(_rng);
+            bone.MaxBBoxEdge[c] = 1.f+0.5f*dist(_rng);
+        }
+        const size_t parent = level ? (_rng()%levelEnds[level-1u]):j;
+        bone.parentOffsetRelative = j-parent;
+        bone.parentOffsetFromTop = parent;
+        char name[16];
+        snprintf(name,sizeof(name),"bone%u",uint32_t(j));
+        names[j] = name;
+    }
+
+    core::vector<float> keyframes(_keyframeCount);
+    for (size_t k=0u; k<_keyframeCount; k++)
+        keyframes[k] = float(k);
+
+    core::vector<scene::CFinalBoneHierarchy::AnimationKeyData> animations(_boneCount*_keyframeCount);
+    for (auto& key : animations)
+    {
+        core::quaternion rotation = core::quaternion::normalize(core::quaternion(dist(_rng),dist(_rng),dist(_rng),dist(_rng)));
+        memcpy(key.Rotation,rotation.getPointer(),sizeof(key.Rotation));
+        for (uint32_t c=0u; c<3u; c++)
+        {
+            key.Position[c] = dist(_rng);
+            key.Scale[c] = 1.f+0.25f*dist(_rng);
+        }
+        key.Padding[0] = key.Padding[1] = 0.f;
+    }
+
+    return new scene::CFinalBoneHierarchy(bones.data(),bones.data()+bones.size(),names.data(),names.data()+names.size(),
+        levelEnds.data(),levelEnds.data()+levelEnds.size(),keyframes.data(),keyframes.data()+keyframes.size(),
+        animations.data(),animations.data()+animations.size(),animations.data(),animations.data()+animations.size());
+}
+
+//! What performBoning did per instance before, one bone at a time
+static void boneInstanceReference(const scene::CFinalBoneHierarchy* referenceHierarchy, float frame, bool interpolateAnimation, core::matrix4x3* globalMatrices, FinalBoneData* boneDataForInstance)
+{
+    float interpolationFactor;
+    size_t foundKeyIx = referenceHierarchy->getLowerBoundBoneKeyframes(interpolationFactor,frame);
+    float interpolantPrecalcTerm2,interpolantPrecalcTerm3;
+    core::quaternion::flerp_interpolant_terms(interpolantPrecalcTerm2,interpolantPrecalcTerm3,interpolationFactor);
+
+    for (size_t j=0; j<referenceHierarchy->getBoneCount(); j++)
+    {
+        boneDataForInstance[j].lastAnimatedFrame = frame;
+
+        scene::CFinalBoneHierarchy::AnimationKeyData upperFrame = (interpolateAnimation ? referenceHierarchy->getInterpolatedAnimationData(j):referenceHierarchy->getNonInterpolatedAnimationData(j))[foundKeyIx];
+
+        core::matrix3x4SIMD interpolatedLocalTform;
+        if (interpolateAnimation&&interpolationFactor<1.f)
+        {
+            scene::CFinalBoneHierarchy::AnimationKeyData lowerFrame =  (interpolateAnimation ? referenceHierarchy->getInterpolatedAnimationData(j):referenceHierarchy->getNonInterpolatedAnimationData(j))[foundKeyIx-1];
+            interpolatedLocalTform = referenceHierarchy->getMatrixFromKeys(lowerFrame,upperFrame,interpolationFactor,interpolantPrecalcTerm2,interpolantPrecalcTerm3);
+        }
+        else
+            interpolatedLocalTform = referenceHierarchy->getMatrixFromKey(upperFrame);
+
+        if (j < referenceHierarchy->getBoneLevelRangeEnd(0))
+            globalMatrices[j] = interpolatedLocalTform.getAsRetardedIrrlichtMatrix();
+        else
+        {
+            const core::matrix4x3& parentTform = globalMatrices[referenceHierarchy->getBoneData()[j].parentOffsetFromTop];
+            globalMatrices[j] = core::matrix3x4SIMD::concatenateBFollowedByA(core::matrix3x4SIMD().set(parentTform), interpolatedLocalTform).getAsRetardedIrrlichtMatrix();
+        }
+        boneDataForInstance[j].SkinningTransform = core::matrix3x4SIMD::concatenateBFollowedByA(core::matrix3x4SIMD().set(globalMatrices[j]), core::matrix3x4SIMD().set(referenceHierarchy->getBoneData()[j].PoseBindMatrix)).getAsRetardedIrrlichtMatrix();
+
+        core::aabbox3df bbox;
+        bbox.MinEdge.X = referenceHierarchy->getBoneData()[j].MinBBoxEdge[0];
+        bbox.MinEdge.Y = referenceHierarchy->getBoneData()[j].MinBBoxEdge[1];
+        bbox.MinEdge.Z = referenceHierarchy->getBoneData()[j].MinBBoxEdge[2];
+        bbox.MaxEdge.X = referenceHierarchy->getBoneData()[j].MaxBBoxEdge[0];
+        bbox.MaxEdge.Y = referenceHierarchy->getBoneData()[j].MaxBBoxEdge[1];
+        bbox.MaxEdge.Z = referenceHierarchy->getBoneData()[j].MaxBBoxEdge[2];
+        bbox = core::transformBoxEx(bbox, core::matrix3x4SIMD().set(boneDataForInstance[j].SkinningTransform));
+
+        boneDataForInstance[j].MinBBoxEdge[0] = bbox.MinEdge.X;
+        boneDataForInstance[j].MinBBoxEdge[1] = bbox.MinEdge.Y;
+        boneDataForInstance[j].MinBBoxEdge[2] = bbox.MinEdge.Z;
+        boneDataForInstance[j].MaxBBoxEdge[0] = bbox.MaxEdge.X;
+        boneDataForInstance[j].MaxBBoxEdge[1] = bbox.MaxEdge.Y;
+        boneDataForInstance[j].MaxBBoxEdge[2] = bbox.MaxEdge.Z;
+        boneDataForInstance[j].SkinningTransform.getSub3x3InverseTranspose(boneDataForInstance[j].SkinningNormalMatrix);
+    }
+}
+
+static double secondsSince(const std::chrono::high_resolution_clock::time_point& _start)
+{
+    return std::max(std::chrono::duration<double>(std::chrono::high_resolution_clock::now()-_start).count(),1e-9);
+}
+
+int main(int argc, char** argv)
+{
+    size_t instanceCount = 5000u, boneCount = 64u;
+    uint32_t threadCount = 0u;
+    for (int i=1; i<argc; i++)
+    {
+        const bool hasValue = i+1<argc;
+        if (!strcmp(argv[i],"-instances") && hasValue)
+            instanceCount = std::max(atoi(argv[++i]),1);
+        else if (!strcmp(argv[i],"-bones") && hasValue)
+            boneCount = std::max(atoi(argv[++i]),1);
+        else if (!strcmp(argv[i],"-threads") && hasValue)
+            threadCount = std::max(atoi(argv[++i]),0);
+        else
+        {
+            printf("Usage: %s [-instances count] [-bones count] [-threads count]\n",argv[0]);
+            return 1;
+        }
+    }
+    threadCount = core::resolveThreadCount(threadCount);
+
+    std::mt19937 rng(0x45u);
+    scene::CFinalBoneHierarchy* hierarchy = createHierarchy(boneCount,120u,rng);
+
+    // every instance plays at its own time and speed, a few without interpolation
+    std::uniform_real_distribution<float> frameDist(0.f,float(hierarchy->getKeyFrameCount()-1u));
+    std::uniform_real_distribution<float> speedDist(0.1f,2.f);
+    core::vector<float> frames(instanceCount), speeds(instanceCount);
+    core::vector<uint8_t> interpolate(instanceCount);
+    core::vector<uint32_t> keyframeCursors(instanceCount,0u);
+    for (size_t i=0u; i<instanceCount; i++)
+    {
+        frames[i] = frameDist(rng);
+        speeds[i] = speedDist(rng);
+        interpolate[i] = (rng()%8u)!=0u;
+    }
+
+    core::vector<core::matrix4x3> referenceGlobals(instanceCount*boneCount), globals(instanceCount*boneCount);
+    core::vector<FinalBoneData> referenceBoneData(instanceCount*boneCount), boneData(instanceCount*boneCount);
+    auto boneAll = [&](uint32_t _threads) -> double
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        core::parallel_for(_threads,size_t(0u),instanceCount,[&](size_t i) -> void
+        {
+            scene::ISkinningStateManager::boneInstance(hierarchy,frames[i],interpolate[i],keyframeCursors[i],globals.data()+i*boneCount,boneData.data()+i*boneCount);
+        },size_t(16u));
+        return secondsSince(start);
+    };
+    auto maxDifference = [&]() -> float
+    {
+        float maxError = 0.f;
+        for (size_t i=0u; i<boneData.size(); i++)
+        {
+            const float* a = referenceBoneData[i].SkinningTransform.pointer();
+            const float* b = boneData[i].SkinningTransform.pointer();
+            for (uint32_t k=0u; k<12u; k++)
+                maxError = std::max(maxError,std::abs(a[k]-b[k]));
+            for (uint32_t k=0u; k<3u; k++)
+            {
+                maxError = std::max(maxError,std::abs(referenceBoneData[i].MinBBoxEdge[k]-boneData[i].MinBBoxEdge[k]));
+                maxError = std::max(maxError,std::abs(referenceBoneData[i].MaxBBoxEdge[k]-boneData[i].MaxBBoxEdge[k]));
+            }
+        }
+        return maxError;
+    };
+
+    constexpr uint32_t kRepeats = 10u;
+    double referenceTime = 0.0, simdTime = 0.0, parallelTime = 0.0, soaTime = 0.0, soaParallelTime = 0.0;
+    float simdError = 0.f, soaError = 0.f;
+    for (uint32_t r=0u; r<kRepeats; r++)
+    {
+        // animations advance a little every update, which is what the keyframe cursors are good at
+        for (size_t i=0u; i<instanceCount; i++)
+            frames[i] = std::fmod(frames[i]+speeds[i],float(hierarchy->getKeyFrameCount()-1u));
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i=0u; i<instanceCount; i++)
+            boneInstanceReference(hierarchy,frames[i],interpolate[i],referenceGlobals.data()+i*boneCount,referenceBoneData.data()+i*boneCount);
+        referenceTime += secondsSince(start);
+
+        hierarchy->dropSoAAnimationData();
+        simdTime += boneAll(1u);
+        parallelTime += boneAll(threadCount);
+        simdError = std::max(simdError,maxDifference());
+
+        hierarchy->createSoAAnimationData();
+        soaTime += boneAll(1u);
+        soaParallelTime += boneAll(threadCount);
+        soaError = std::max(soaError,maxDifference());
+    }
+
+    printf("%u instances, %u bones in %u levels, %u keyframes, %u threads\n",uint32_t(instanceCount),uint32_t(boneCount),uint32_t(hierarchy->getHierarchyLevels()),uint32_t(hierarchy->getKeyFrameCount()),threadCount);
+    printf("%-36s %12s %16s %8s %10s\n","","ms/frame","bones/s","speedup","max error");
+    const double bonesPerFrame = double(instanceCount*boneCount);
+    auto printRow = [&](const char* _name, double _time, float _error) -> void
+    {
+        printf("%-36s %12.3f %16.0f %7.2fx %10.6f\n",_name,_time/kRepeats*1000.0,bonesPerFrame*kRepeats/_time,referenceTime/_time,_error);
+    };
+    printRow("per bone (previous loop)",referenceTime,0.f);
+    printRow("SIMD, 1 thread",simdTime,simdError);
+    printRow("SIMD, all threads",parallelTime,simdError);
+    printRow("SIMD, SoA quantized keys, 1 thread",soaTime,soaError);
+    printRow("SIMD, SoA quantized keys, all threads",soaParallelTime,soaError);
+
+    hierarchy->drop();
+    return 0;
+}
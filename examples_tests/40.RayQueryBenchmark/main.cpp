@@ -0,0 +1,203 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "irr/core/parallel_for.h"
+
+using namespace irr;
+
+/**
+Line of sight checks between agents walking over a terrain with buildings and trees, the scene of 11.RayCastCollision
+scaled up to a few thousand colliders, no window or driver needed.
+
+Usage: 40.RayQueryBenchmark [-rays count] [-colliders count] [-terrain quads] [-threads count]
+*/
+
+static double secondsSince(const std::chrono::high_resolution_clock::time_point& _start)
+{
+    return std::max(std::chrono::duration<double>(std::chrono::high_resolution_clock::now()-_start).count(),1e-9);
+}
+
+static float terrainHeight(float _x, float _z)
+{
+    return 2.f*std::sin(_x*0.07f)*std::cos(_z*0.05f)+0.5f*std::sin(_x*0.31f+_z*0.17f);
+}
+
+//! A heightfield of `_quadsPerSide`^2 quads, two triangles each, spanning [-_size/2,_size/2] on X and Z
+static core::STriangleMeshCollider* createTerrain(uint32_t _quadsPerSide, float _size)
+{
+    const uint32_t vertsPerSide = _quadsPerSide+1u;
+    core::vector<float> vertices(vertsPerSide*vertsPerSide*3u);
+    for (uint32_t z=0u; z<vertsPerSide; z++)
+    for (uint32_t x=0u; x<vertsPerSide; x++)
+    {
+        float* vertex = vertices.data()+(z*vertsPerSide+x)*3u;
+        vertex[0] = (float(x)/float(_quadsPerSide)-0.5f)*_size;
+        vertex[2] = (float(z)/float(_quadsPerSide)-0.5f)*_size;
+        vertex[1] = terrainHeight(vertex[0],vertex[2]);
+    }
+
+    core::vector<uint32_t> indices;
+    indices.reserve(_quadsPerSide*_quadsPerSide*6u);
+    for (uint32_t z=0u; z<_quadsPerSide; z++)
+    for (uint32_t x=0u; x<_quadsPerSide; x++)
+    {
+        const uint32_t corner = z*vertsPerSide+x;
+        const uint32_t quad[6] = {corner,corner+vertsPerSide,corner+1u,corner+1u,corner+vertsPerSide,corner+vertsPerSide+1u};
+        indices.insert(indices.end(),quad,quad+6u);
+    }
+
+    core::STriangleMeshCollider* terrain = new core::STriangleMeshCollider();
+    terrain->Init(vertices.data(),indices.size(),indices.data());
+    return terrain;
+}
+
+int main(int argc, char** argv)
+{
+    size_t rayCount = 100000u, colliderCount = 4000u;
+    uint32_t terrainQuads = 160u, threadCount = 0u;
+    for (int i=1; i<argc; i++)
+    {
+        const bool hasValue = i+1<argc;
+        if (!strcmp(argv[i],"-rays") && hasValue)
+            rayCount = std::max(atoi(argv[++i]),1);
+        else if (!strcmp(argv[i],"-colliders") && hasValue)
+            colliderCount = std::max(atoi(argv[++i]),0);
+        else if (!strcmp(argv[i],"-terrain") && hasValue)
+            terrainQuads = std::max(atoi(argv[++i]),1);
+        else if (!strcmp(argv[i],"-threads") && hasValue)
+            threadCount = std::max(atoi(argv[++i]),0);
+        else
+        {
+            printf("Usage: %s [-rays count] [-colliders count] [-terrain quads] [-threads count]\n",argv[0]);
+            return 1;
+        }
+    }
+    threadCount = core::resolveThreadCount(threadCount);
+
+    constexpr float kWorldSize = 1000.f;
+    std::mt19937 rng(0x11u);
+    std::uniform_real_distribution<float> worldDist(-0.5f*kWorldSize,0.5f*kWorldSize);
+    std::uniform_real_distribution<float> unitDist(0.f,1.f);
+
+    core::SCollisionEngine* collEng = new core::SCollisionEngine();
+    core::SColliderData collData;
+    {
+        core::STriangleMeshCollider* terrain = createTerrain(terrainQuads,kWorldSize);
+        core::SCompoundCollider* compound = new core::SCompoundCollider();
+        compound->AddTriangleMesh(terrain);
+        collData.instanceID = 0u;
+        compound->setColliderData(collData);
+        collEng->addCompoundCollider(compound);
+        compound->drop();
+        terrain->drop();
+    }
+    // buildings are boxes, trees are ellipsoids, like the cube and sphere of 11.RayCastCollision
+    for (size_t i=0u; i<colliderCount; i++)
+    {
+        const float x = worldDist(rng), z = worldDist(rng);
+        const float y = terrainHeight(x,z);
+        core::SCompoundCollider* compound = new core::SCompoundCollider();
+        if (i&1u)
+        {
+            const core::vector3df halfExtent(1.5f+3.f*unitDist(rng),3.f+10.f*unitDist(rng),1.5f+3.f*unitDist(rng));
+            const core::vector3df center(x,y+halfExtent.Y-0.5f,z);
+            compound->AddBox(core::SAABoxCollider(core::aabbox3df(center-halfExtent,center+halfExtent)));
+        }
+        else
+        {
+            const float radius = 1.f+2.f*unitDist(rng);
+            compound->AddEllipsoid(core::vectorSIMDf(x,y+2.f+radius,z),core::vectorSIMDf(radius,1.5f*radius,radius));
+        }
+        collData.instanceID = i+1u;
+        compound->setColliderData(collData);
+        collEng->addCompoundCollider(compound);
+        compound->drop();
+    }
+
+    // agents stand on the terrain and look at each other
+    core::vector<core::vectorSIMDf> origins(rayCount), directions(rayCount);
+    core::vector<float> maxRayLens(rayCount);
+    for (size_t i=0u; i<rayCount; i++)
+    {
+        const float fromX = worldDist(rng), fromZ = worldDist(rng);
+        const float toX = worldDist(rng), toZ = worldDist(rng);
+        origins[i].set(fromX,terrainHeight(fromX,fromZ)+1.8f,fromZ,0.f);
+        core::vectorSIMDf target(toX,terrainHeight(toX,toZ)+1.8f,toZ,0.f);
+        core::vectorSIMDf direction = target-origins[i];
+        maxRayLens[i] = core::length(direction).X;
+        directions[i] = direction/core::vectorSIMDf(maxRayLens[i]);
+        directions[i].W = 0.f;
+    }
+
+    core::vector<core::SColliderData> referenceData(rayCount), hitData(rayCount);
+    core::vector<float> referenceDistances(rayCount), distances(rayCount);
+    auto singleRays = [&](core::vector<core::SColliderData>& _data, core::vector<float>& _distances) -> double
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i=0u; i<rayCount; i++)
+            collEng->FastCollide(_data[i],_distances[i],origins[i],directions[i],maxRayLens[i]);
+        return secondsSince(start);
+    };
+    auto batchedRays = [&](uint32_t _threads) -> double
+    {
+        collEng->setRayQueryThreadCount(_threads);
+        const auto start = std::chrono::high_resolution_clock::now();
+        collEng->FastCollide(hitData.data(),distances.data(),origins.data(),directions.data(),maxRayLens.data(),rayCount);
+        return secondsSince(start);
+    };
+    // collider data is not compared, origins inside overlapping colliders make ties at distance 0
+    auto mismatches = [&]() -> size_t
+    {
+        size_t count = 0u;
+        for (size_t i=0u; i<rayCount; i++)
+        {
+            const bool referenceHit = referenceDistances[i]<maxRayLens[i];
+            const bool hit = distances[i]<maxRayLens[i];
+            if (referenceHit!=hit || std::abs(referenceDistances[i]-distances[i])>1e-4f*maxRayLens[i])
+                count++;
+        }
+        return count;
+    };
+
+    // the hierarchy is not built yet, so every collider gets tested
+    const double linearTime = singleRays(referenceData,referenceDistances);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    collEng->UpdateTransformation();
+    const double buildTime = secondsSince(start);
+
+    const double hierarchyTime = singleRays(hitData,distances);
+    const size_t hierarchyMismatches = mismatches();
+    size_t hitCount = 0u;
+    for (size_t i=0u; i<rayCount; i++)
+        hitCount += referenceDistances[i]<maxRayLens[i] ? 1u:0u;
+
+    std::fill(distances.begin(),distances.end(),-1.f);
+    const double batchedTime = batchedRays(1u);
+    const size_t batchedMismatches = mismatches();
+    std::fill(distances.begin(),distances.end(),-1.f);
+    const double parallelTime = batchedRays(threadCount);
+    const size_t parallelMismatches = mismatches();
+
+    printf("%u rays (%u blocked), %u colliders, %u terrain triangles, %u threads, top level built in %.3f ms\n",
+        uint32_t(rayCount),uint32_t(hitCount),uint32_t(collEng->getColliderCount()),terrainQuads*terrainQuads*2u,threadCount,buildTime*1000.0);
+    printf("%-36s %12s %14s %8s %10s\n","","ms","rays/s","speedup","mismatches");
+    auto printRow = [&](const char* _name, double _time, size_t _mismatches) -> void
+    {
+        printf("%-36s %12.3f %14.0f %7.2fx %10u\n",_name,_time*1000.0,double(rayCount)/_time,linearTime/_time,uint32_t(_mismatches));
+    };
+    printRow("single rays, every collider",linearTime,0u);
+    printRow("single rays, hierarchy",hierarchyTime,hierarchyMismatches);
+    printRow("octant sorted packets, 1 thread",batchedTime,batchedMismatches);
+    printRow("octant sorted packets, all threads",parallelTime,parallelMismatches);
+
+    delete collEng;
+    return 0;
+}
@@ -0,0 +1,150 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "irr/core/parallel_for.h"
+
+using namespace irr;
+
+/**
+Loads synthetic photogrammetry-like OBJ files (a displaced grid with positions, texture coordinates and normals for every vertex)
+of increasing size with one thread and with all of them, no window or driver needed. Generated files get deleted afterwards.
+
+Usage: 41.OBJLoaderBenchmark [-maxquads count] [-threads count]
+*/
+
+static double secondsSince(const std::chrono::high_resolution_clock::time_point& _start)
+{
+    return std::max(std::chrono::duration<double>(std::chrono::high_resolution_clock::now()-_start).count(),1e-9);
+}
+
+static float surfaceHeight(float _u, float _v)
+{
+    return 0.2f*std::sin(_u*37.f)*std::cos(_v*23.f)+0.05f*std::sin(_u*171.f+_v*113.f);
+}
+
+//! Writes a grid of `_quadsPerSide`^2 quads as triangles, every vertex has its own v, vt and vn record like in scanned meshes
+static size_t writeGrid(const std::string& _filename, uint32_t _quadsPerSide)
+{
+    FILE* file = fopen(_filename.c_str(),"wb");
+    if (!file)
+        return 0u;
+
+    const uint32_t vertsPerSide = _quadsPerSide+1u;
+    fprintf(file,"# synthetic grid, %u quads per side\n",_quadsPerSide);
+    for (uint32_t z=0u; z<vertsPerSide; z++)
+    for (uint32_t x=0u; x<vertsPerSide; x++)
+    {
+        const float u = float(x)/float(_quadsPerSide), v = float(z)/float(_quadsPerSide);
+        fprintf(file,"v %.6f %.6f %.6f\n",u*10.f,surfaceHeight(u,v),v*10.f);
+    }
+    for (uint32_t z=0u; z<vertsPerSide; z++)
+    for (uint32_t x=0u; x<vertsPerSide; x++)
+        fprintf(file,"vt %.6f %.6f\n",float(x)/float(_quadsPerSide),float(z)/float(_quadsPerSide));
+    for (uint32_t z=0u; z<vertsPerSide; z++)
+    for (uint32_t x=0u; x<vertsPerSide; x++)
+    {
+        const float u = float(x)/float(_quadsPerSide), v = float(z)/float(_quadsPerSide);
+        const float eps = 1.f/float(_quadsPerSide);
+        const float dx = (surfaceHeight(u+eps,v)-surfaceHeight(u-eps,v))/(20.f*eps);
+        const float dz = (surfaceHeight(u,v+eps)-surfaceHeight(u,v-eps))/(20.f*eps);
+        const float invLen = 1.f/std::sqrt(dx*dx+1.f+dz*dz);
+        fprintf(file,"vn %.6f %.6f %.6f\n",-dx*invLen,invLen,-dz*invLen);
+    }
+    for (uint32_t z=0u; z<_quadsPerSide; z++)
+    for (uint32_t x=0u; x<_quadsPerSide; x++)
+    {
+        const uint32_t a = z*vertsPerSide+x+1u, b = a+1u, c = a+vertsPerSide, d = c+1u;
+        fprintf(file,"f %u/%u/%u %u/%u/%u %u/%u/%u\n",a,a,a,c,c,c,b,b,b);
+        fprintf(file,"f %u/%u/%u %u/%u/%u %u/%u/%u\n",b,b,b,c,c,c,d,d,d);
+    }
+
+    const size_t size = static_cast<size_t>(ftell(file));
+    fclose(file);
+    return size;
+}
+
+//! Concatenation of the index and vertex data of every mesh buffer, to check that thread count does not change the result
+static std::string meshContents(asset::ICPUMesh* _mesh)
+{
+    std::string contents;
+    for (uint32_t i=0u; i<_mesh->getMeshBufferCount(); i++)
+    {
+        const asset::ICPUMeshBuffer* meshbuffer = _mesh->getMeshBuffer(i);
+        const auto* desc = meshbuffer->getMeshDataAndFormat();
+        if (const asset::ICPUBuffer* indices = desc->getIndexBuffer())
+            contents.append(reinterpret_cast<const char*>(indices->getPointer()),indices->getSize());
+        const asset::ICPUBuffer* vertices = desc->getMappedBuffer(asset::EVAI_ATTR0);
+        contents.append(reinterpret_cast<const char*>(vertices->getPointer()),vertices->getSize());
+    }
+    return contents;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t maxQuads = 2048u;
+    uint32_t threadCount = 0u;
+    for (int i=1; i<argc; i++)
+    {
+        const bool hasValue = i+1<argc;
+        if (!strcmp(argv[i],"-maxquads") && hasValue)
+            maxQuads = std::max(atoi(argv[++i]),16);
+        else if (!strcmp(argv[i],"-threads") && hasValue)
+            threadCount = std::max(atoi(argv[++i]),0);
+        else
+        {
+            printf("Usage: %s [-maxquads count] [-threads count]\n",argv[0]);
+            return 1;
+        }
+    }
+    threadCount = core::resolveThreadCount(threadCount);
+
+    SIrrlichtCreationParameters params;
+    params.DriverType = video::EDT_NULL;
+    IrrlichtDevice* device = createDeviceEx(params);
+    if (!device)
+        return 1;
+    asset::IAssetManager& assetMgr = device->getAssetManager();
+
+    auto load = [&](const std::string& _filename, uint32_t _threads, std::string& _contents) -> double
+    {
+        const asset::IAssetLoader::SAssetLoadParams lparams(0u,nullptr,asset::IAssetLoader::ECF_DONT_CACHE_REFERENCES,_threads);
+        const auto start = std::chrono::high_resolution_clock::now();
+        asset::SAssetBundle bundle = assetMgr.getAsset(_filename,lparams);
+        const double time = secondsSince(start);
+        auto contents = bundle.getContents();
+        _contents = contents.first!=contents.second ? meshContents(static_cast<asset::ICPUMesh*>(contents.first->get())):std::string();
+        return time;
+    };
+
+    printf("%u threads\n",threadCount);
+    printf("%10s %10s %12s %12s %12s %8s %10s\n","quads","MB","1 thread ms","all ms","MB/s","speedup","identical");
+    for (uint32_t quads=256u; quads<=maxQuads; quads*=2u)
+    {
+        const std::string filename = "obj_loader_benchmark_"+std::to_string(quads)+".obj";
+        const size_t fileSize = writeGrid(filename,quads);
+        if (!fileSize)
+        {
+            printf("could not write %s\n",filename.c_str());
+            break;
+        }
+
+        std::string referenceContents, contents;
+        const double singleTime = load(filename,1u,referenceContents);
+        const double parallelTime = load(filename,threadCount,contents);
+        remove(filename.c_str());
+
+        const double megabytes = double(fileSize)/double(1u<<20u);
+        printf("%10u %10.1f %12.1f %12.1f %12.1f %7.2fx %10s\n",quads*quads,megabytes,singleTime*1000.0,parallelTime*1000.0,megabytes/parallelTime,singleTime/parallelTime,
+            !referenceContents.empty()&&referenceContents==contents ? "yes":"NO");
+    }
+
+    device->drop();
+    return 0;
+}
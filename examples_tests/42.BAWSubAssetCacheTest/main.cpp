@@ -0,0 +1,157 @@
+#define _IRR_STATIC_LIB_
+#include <irrlicht.h>
+
+#include <cstdio>
+#include <string>
+
+#include "../src/irr/asset/CBAWMeshWriter.h"
+#include "irr/core/parallel_for.h"
+
+using namespace irr;
+
+/**
+Reloads a .baw mesh whose mesh buffers share one mesh data format descriptor (and through it the index and vertex buffers)
+while some of its sub-assets are still in the cache, with the serial and with the parallel blob loading path.
+No window or driver needed, prints one line per check and returns non-zero if any of them failed.
+
+Usage: 42.BAWSubAssetCacheTest
+*/
+
+//! Keeps the bundles of all mesh buffers inserted into the cache, so single ones can be evicted later
+class CRecordingLoaderOverride : public asset::IAssetLoader::IAssetLoaderOverride
+{
+public:
+    CRecordingLoaderOverride(asset::IAssetManager* _manager) : IAssetLoaderOverride(_manager) {}
+
+    void insertAssetIntoCache(asset::SAssetBundle& asset, const std::string& supposedKey, const asset::IAssetLoader::SAssetLoadContext& ctx, const uint32_t& hierarchyLevel) override
+    {
+        IAssetLoaderOverride::insertAssetIntoCache(asset, supposedKey, ctx, hierarchyLevel);
+        if (asset.getAssetType()==asset::IAsset::ET_SUB_MESH)
+            cachedMeshBuffers[asset.getContents().first->get()] = asset;
+    }
+
+    core::unordered_map<const asset::IAsset*, asset::SAssetBundle> cachedMeshBuffers;
+};
+
+static uint32_t failures = 0u;
+
+static void check(bool _condition, const char* _what, uint32_t _threads)
+{
+    printf("%-72s %2u threads: %s\n",_what,_threads,_condition ? "ok":"FAILED");
+    if (!_condition)
+        failures++;
+}
+
+static asset::ICPUMesh* meshOf(asset::SAssetBundle& _bundle)
+{
+    auto contents = _bundle.getContents();
+    return contents.first!=contents.second ? static_cast<asset::ICPUMesh*>(contents.first->get()):nullptr;
+}
+
+//! Concatenation of the index and vertex data of every mesh buffer
+static std::string meshContents(const asset::ICPUMesh* _mesh)
+{
+    std::string contents;
+    for (uint32_t i=0u; i<_mesh->getMeshBufferCount(); i++)
+    {
+        const auto* desc = _mesh->getMeshBuffer(i)->getMeshDataAndFormat();
+        if (!desc)
+            return std::string();
+        for (const asset::ICPUBuffer* buffer : {desc->getIndexBuffer(),desc->getMappedBuffer(asset::EVAI_ATTR0)})
+        {
+            if (!buffer)
+                return std::string();
+            contents.append(reinterpret_cast<const char*>(buffer->getPointer()),buffer->getSize());
+        }
+    }
+    return contents;
+}
+
+int main()
+{
+    SIrrlichtCreationParameters params;
+    params.DriverType = video::EDT_NULL;
+    IrrlichtDevice* device = createDeviceEx(params);
+    if (!device)
+        return 1;
+    asset::IAssetManager& assetMgr = device->getAssetManager();
+
+    // second mesh buffer shares the descriptor of the first one, so the descriptor blob is a dependency of both mesh buffer blobs
+    const std::string filename = "baw_sub_asset_cache_test.baw";
+    std::string referenceContents;
+    {
+        asset::ICPUMesh* cube = assetMgr.getGeometryCreator()->createCubeMesh(core::vector3df(1.f,2.f,3.f));
+        asset::ICPUMeshBuffer* original = cube->getMeshBuffer(0u);
+        asset::ICPUMeshBuffer* shared = new asset::ICPUMeshBuffer();
+        shared->setMeshDataAndFormat(original->getMeshDataAndFormat());
+        shared->setIndexType(original->getIndexType());
+        shared->setIndexCount(original->getIndexCount()/2u);
+
+        asset::SCPUMesh* mesh = new asset::SCPUMesh();
+        mesh->addMeshBuffer(original);
+        mesh->addMeshBuffer(shared);
+        mesh->recalculateBoundingBox();
+        shared->drop();
+        cube->drop();
+
+        asset::CBAWMeshWriter::WriteProperties bawprops;
+        const asset::IAssetWriter::SAssetWriteParams wparams(mesh, asset::EWF_NONE, 0.f, 0, nullptr, &bawprops);
+        const bool written = assetMgr.writeAsset(filename, wparams);
+        referenceContents = meshContents(mesh);
+        mesh->drop();
+        if (!written)
+        {
+            printf("could not write %s\n",filename.c_str());
+            device->drop();
+            return 1;
+        }
+    }
+
+    for (uint32_t threads : {1u,core::resolveThreadCount(0u)})
+    {
+        assetMgr.clearAllAssetCache();
+        CRecordingLoaderOverride loaderOverride(&assetMgr);
+        const asset::IAssetLoader::SAssetLoadParams lparams(0u,nullptr,asset::IAssetLoader::ECF_CACHE_EVERYTHING,threads);
+        // only the mesh buffers (and the raw buffers below them) stay cached, the root mesh has to be loaded again every time
+        auto load = [&]() -> asset::SAssetBundle
+        {
+            asset::SAssetBundle bundle = assetMgr.getAsset(filename,lparams,&loaderOverride);
+            if (meshOf(bundle))
+                assetMgr.removeAssetFromCache(bundle);
+            return bundle;
+        };
+
+        asset::SAssetBundle first = load();
+        const asset::ICPUMesh* firstMesh = meshOf(first);
+        check(firstMesh && firstMesh->getMeshBufferCount()==2u && meshContents(firstMesh)==referenceContents,"first load",threads);
+        if (!firstMesh || firstMesh->getMeshBufferCount()!=2u)
+            continue;
+        asset::ICPUMeshBuffer* const firstBuffers[2] = {firstMesh->getMeshBuffer(0u),firstMesh->getMeshBuffer(1u)};
+        check(firstBuffers[0]->getMeshDataAndFormat()==firstBuffers[1]->getMeshDataAndFormat(),"shared descriptor loaded once",threads);
+        const int32_t refCounts[2] = {firstBuffers[0]->getReferenceCount(),firstBuffers[1]->getReferenceCount()};
+
+        // every mesh buffer cached, the descriptor is reachable only through cached blobs
+        {
+            asset::SAssetBundle second = load();
+            const asset::ICPUMesh* secondMesh = meshOf(second);
+            check(secondMesh && secondMesh->getMeshBufferCount()==2u && meshContents(secondMesh)==referenceContents,"reload with all mesh buffers cached",threads);
+            check(secondMesh && secondMesh->getMeshBuffer(0u)==firstBuffers[0] && secondMesh->getMeshBuffer(1u)==firstBuffers[1],"cached mesh buffers reused",threads);
+        }
+        check(firstBuffers[0]->getReferenceCount()==refCounts[0] && firstBuffers[1]->getReferenceCount()==refCounts[1],"cached mesh buffers not over-released",threads);
+
+        // one mesh buffer evicted, the shared descriptor has a cached and a loaded parent
+        auto evicted = loaderOverride.cachedMeshBuffers.find(firstBuffers[0]);
+        check(evicted!=loaderOverride.cachedMeshBuffers.end() && assetMgr.removeAssetFromCache(evicted->second),"evict first mesh buffer",threads);
+        {
+            asset::SAssetBundle third = load();
+            const asset::ICPUMesh* thirdMesh = meshOf(third);
+            check(thirdMesh && thirdMesh->getMeshBufferCount()==2u && meshContents(thirdMesh)==referenceContents,"reload with one mesh buffer cached",threads);
+            check(thirdMesh && thirdMesh->getMeshBuffer(0u)!=firstBuffers[0] && thirdMesh->getMeshBuffer(1u)==firstBuffers[1],"only the evicted mesh buffer loaded again",threads);
+        }
+        check(firstBuffers[1]->getReferenceCount()==refCounts[1],"cached mesh buffer not over-released",threads);
+    }
+    remove(filename.c_str());
+
+    device->drop();
+    return failures ? 1:0;
+}
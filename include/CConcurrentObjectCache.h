@@ -1,6 +1,8 @@
 #ifndef __C_CONCURRENT_OBJECT_CACHE_H_INCLUDED__
 #define __C_CONCURRENT_OBJECT_CACHE_H_INCLUDED__
 
+#include <array>
+
 #include "CObjectCache.h"
 #include "../source/Irrlicht/FW_Mutex.h"
 
@@ -62,6 +64,16 @@ namespace impl
             return r;
         }
 
+        //! Takes the lock once for all pairs, see CDirectCacheBase::bulkInsert
+        template<typename ForwardIt>
+        inline size_t bulkInsert(ForwardIt _begin, ForwardIt _end)
+        {
+            this->m_lock.lockWrite();
+            const size_t r = BaseCache::bulkInsert(_begin, _end);
+            this->m_lock.unlockWrite();
+            return r;
+        }
+
         inline bool contains(typename BaseCache::ImmutableValueType_impl& _object) const
         {
             this->m_lock.lockRead();
@@ -110,6 +122,26 @@ namespace impl
             return r;
         }
 
+        //! Calls `_func()` with the lock held for writing if `_obj` is cached under `_key`, so no lookup can obtain the object meanwhile
+        /** \return false if the object was not found, otherwise what `_func` returned. */
+        template<typename F>
+        inline bool applyIfCached(const typename BaseCache::ValueType_impl& _obj, const typename BaseCache::KeyType_impl& _key, F&& _func)
+        {
+            this->m_lock.lockWrite();
+            bool r = false;
+            auto range = BaseCache::findRange(_key);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second == _obj)
+                {
+                    r = _func();
+                    break;
+                }
+            }
+            this->m_lock.unlockWrite();
+            return r;
+        }
+
         inline bool findAndStoreRange(const typename BaseCache::KeyType_impl& _key, size_t& _inOutStorageSize, typename BaseCache::MutablePairType* _out)
         {
             m_lock.lockRead();
@@ -158,6 +190,245 @@ namespace impl
             return r;
         }
     };
+
+    //! Partitions keys over `ShardCount` independently locked caches, so that threads working with different keys rarely contend for the same lock.
+    /** Offers the same API as CMakeCacheConcurrent. Operations concerning a single key lock only one shard (two for changeObjectKey()),
+    operations concerning the whole cache (contains, getSize, clear, outputAll) visit shards one after another and therefore are not an atomic snapshot.
+    outputAll() orders pairs by shard first and then as the underlying cache does. */
+    template<typename CacheT, size_t ShardCount, typename Hash>
+    class CMakeCacheSharded
+    {
+        static_assert(ShardCount>0u, "CMakeCacheSharded needs at least one shard");
+
+        //! Aligned to a cache line so that locks of neighbouring shards don't false-share
+        struct alignas(64) SShard : impl::CConcurrentObjectCacheBase, CacheT
+        {
+            using CacheT::CacheT;
+            using KeyType_impl = typename CacheT::KeyType_impl;
+            using ValueType_impl = typename CacheT::ValueType_impl;
+            using ImmutableValueType_impl = typename CacheT::ImmutableValueType_impl;
+        };
+        using K = typename SShard::KeyType_impl;
+        using V = typename SShard::ValueType_impl;
+        using ImmutableV = typename SShard::ImmutableValueType_impl;
+
+        std::array<SShard, ShardCount> m_shards;
+
+        template<size_t... Ix, typename... Args>
+        CMakeCacheSharded(std::index_sequence<Ix...>, const Args&... _args) : m_shards{{ (static_cast<void>(Ix), SShard(_args...))... }} {}
+
+        inline SShard& shardFor(const K& _key)
+        {
+            // std::hash is identity for pointers and integers on most implementations, so mix the bits before picking the shard
+            uint64_t h = Hash()(_key);
+            h ^= h>>33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h>>33;
+            return m_shards[h%ShardCount];
+        }
+        inline const SShard& shardFor(const K& _key) const { return const_cast<CMakeCacheSharded*>(this)->shardFor(_key); }
+
+    public:
+        using IteratorType = typename CacheT::IteratorType;
+        using ConstIteratorType = typename CacheT::ConstIteratorType;
+        using RevIteratorType = typename CacheT::RevIteratorType;
+        using ConstRevIteratorType = typename CacheT::ConstRevIteratorType;
+        using RangeType = typename CacheT::RangeType;
+        using ConstRangeType = typename CacheT::ConstRangeType;
+        using PairType = typename CacheT::PairType;
+        using MutablePairType = typename CacheT::MutablePairType;
+        using CachedType = typename CacheT::CachedType;
+        using KeyType = typename CacheT::KeyType;
+
+        //! Every shard gets constructed with the same arguments (usually greeting and disposal functions)
+        template<typename... Args>
+        explicit CMakeCacheSharded(const Args&... _args) : CMakeCacheSharded(std::make_index_sequence<ShardCount>{}, _args...) {}
+        CMakeCacheSharded(const CMakeCacheSharded&) = delete;
+        CMakeCacheSharded& operator=(const CMakeCacheSharded&) = delete;
+
+        template<typename RngT>
+        static bool isNonZeroRange(const RngT& _rng) { return CacheT::isNonZeroRange(_rng); }
+
+        inline bool insert(const K& _key, const V& _val)
+        {
+            SShard& shard = shardFor(_key);
+            shard.m_lock.lockWrite();
+            const bool r = shard.insert(_key, _val);
+            shard.m_lock.unlockWrite();
+            return r;
+        }
+
+        //! Partitions the pairs by shard first, so that every shard gets locked at most once
+        template<typename ForwardIt>
+        inline size_t bulkInsert(ForwardIt _begin, ForwardIt _end)
+        {
+            std::array<core::vector<MutablePairType>, ShardCount> perShard;
+            for (auto it = _begin; it != _end; ++it)
+                perShard[&shardFor(it->first)-m_shards.data()].emplace_back(it->first, it->second);
+
+            size_t r = 0u;
+            for (size_t i = 0u; i < ShardCount; i++)
+            {
+                if (perShard[i].empty())
+                    continue;
+                SShard& shard = m_shards[i];
+                shard.m_lock.lockWrite();
+                r += shard.bulkInsert(perShard[i].begin(), perShard[i].end());
+                shard.m_lock.unlockWrite();
+            }
+            return r;
+        }
+
+        inline bool contains(ImmutableV& _object) const
+        {
+            for (const SShard& shard : m_shards)
+            {
+                shard.m_lock.lockRead();
+                const bool r = shard.contains(_object);
+                shard.m_lock.unlockRead();
+                if (r)
+                    return true;
+            }
+            return false;
+        }
+
+        inline size_t getSize() const
+        {
+            size_t r = 0u;
+            for (const SShard& shard : m_shards)
+            {
+                shard.m_lock.lockRead();
+                r += shard.getSize();
+                shard.m_lock.unlockRead();
+            }
+            return r;
+        }
+
+        inline void clear()
+        {
+            for (SShard& shard : m_shards)
+            {
+                shard.m_lock.lockWrite();
+                shard.clear();
+                shard.m_lock.unlockWrite();
+            }
+        }
+
+        //! Returns true if had to insert
+        bool swapObjectValue(const K& _key, const ImmutableV& _obj, const V& _val)
+        {
+            SShard& shard = shardFor(_key);
+            shard.m_lock.lockWrite();
+            const bool r = shard.swapObjectValue(_key, _obj, _val);
+            shard.m_lock.unlockWrite();
+            return r;
+        }
+
+        bool getAndStoreKeyRangeOrReserve(const K& _key, size_t& _inOutStorageSize, V* _out, bool* _gotAll)
+        {
+            SShard& shard = shardFor(_key);
+            shard.m_lock.lockWrite();
+            const bool r = shard.getAndStoreKeyRangeOrReserve(_key, _inOutStorageSize, _out, _gotAll);
+            shard.m_lock.unlockWrite();
+            return r;
+        }
+
+        inline bool removeObject(const V& _obj, const K& _key)
+        {
+            SShard& shard = shardFor(_key);
+            shard.m_lock.lockWrite();
+            const bool r = shard.removeObject(_obj, _key);
+            shard.m_lock.unlockWrite();
+            return r;
+        }
+
+        template<typename F>
+        inline bool applyIfCached(const V& _obj, const K& _key, F&& _func)
+        {
+            SShard& shard = shardFor(_key);
+            shard.m_lock.lockWrite();
+            bool r = false;
+            auto range = shard.findRange(_key);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second == _obj)
+                {
+                    r = _func();
+                    break;
+                }
+            }
+            shard.m_lock.unlockWrite();
+            return r;
+        }
+
+        inline bool findAndStoreRange(const K& _key, size_t& _inOutStorageSize, MutablePairType* _out) const
+        {
+            const SShard& shard = shardFor(_key);
+            shard.m_lock.lockRead();
+            const bool r = shard.findAndStoreRange(_key, _inOutStorageSize, _out);
+            shard.m_lock.unlockRead();
+            return r;
+        }
+
+        inline bool findAndStoreRange(const K& _key, size_t& _inOutStorageSize, V* _out) const
+        {
+            const SShard& shard = shardFor(_key);
+            shard.m_lock.lockRead();
+            const bool r = shard.findAndStoreRange(_key, _inOutStorageSize, _out);
+            shard.m_lock.unlockRead();
+            return r;
+        }
+
+        inline bool outputAll(size_t& _inOutStorageSize, MutablePairType* _out) const
+        {
+            if (!_out)
+            {
+                _inOutStorageSize = getSize();
+                return false;
+            }
+
+            size_t written = 0u;
+            size_t required = 0u;
+            for (const SShard& shard : m_shards)
+            {
+                shard.m_lock.lockRead();
+                size_t cnt = _inOutStorageSize-written;
+                shard.outputAll(cnt, _out+written);
+                required += shard.getSize();
+                shard.m_lock.unlockRead();
+                written += cnt;
+            }
+            const bool r = _inOutStorageSize <= required;
+            _inOutStorageSize = written;
+            return r;
+        }
+
+        inline bool changeObjectKey(const V& _obj, const K& _key, const K& _newKey)
+        {
+            SShard& from = shardFor(_key);
+            SShard& to = shardFor(_newKey);
+            if (&from == &to)
+            {
+                from.m_lock.lockWrite();
+                const bool r = from.changeObjectKey(_obj, _key, _newKey);
+                from.m_lock.unlockWrite();
+                return r;
+            }
+
+            // always lock in the same order to not deadlock with a concurrent change in the opposite direction
+            SShard* first = &from < &to ? &from : &to;
+            SShard* second = &from < &to ? &to : &from;
+            first->m_lock.lockWrite();
+            second->m_lock.lockWrite();
+            constexpr bool DoGreetOrDispose = false;
+            const bool r = from.template removeObject<DoGreetOrDispose>(_obj, _key);
+            if (r)
+                to.template insert<DoGreetOrDispose>(_newKey, _obj);
+            second->m_lock.unlockWrite();
+            first->m_lock.unlockWrite();
+            return r;
+        }
+    };
 }
 
 template<
@@ -182,6 +453,32 @@ using CConcurrentMultiObjectCache =
         CMultiObjectCache<K, T, ContainerT_T, Alloc>
     >;
 
+template<
+    typename K,
+    typename T,
+    template<typename...> class ContainerT_T = std::vector,
+    typename Alloc = core::allocator<typename impl::key_val_pair_type_for<ContainerT_T, K, T>::type>,
+    size_t ShardCount = 16u,
+    typename Hash = std::hash<K>
+>
+using CShardedConcurrentObjectCache =
+    impl::CMakeCacheSharded<
+        CObjectCache<K, T, ContainerT_T, Alloc>, ShardCount, Hash
+    >;
+
+template<
+    typename K,
+    typename T,
+    template<typename...> class ContainerT_T = std::vector,
+    typename Alloc = core::allocator<typename impl::key_val_pair_type_for<ContainerT_T, K, T>::type>,
+    size_t ShardCount = 16u,
+    typename Hash = std::hash<K>
+>
+using CShardedConcurrentMultiObjectCache =
+    impl::CMakeCacheSharded<
+        CMultiObjectCache<K, T, ContainerT_T, Alloc>, ShardCount, Hash
+    >;
+
 }}
 
 #endif
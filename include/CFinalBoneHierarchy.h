@@ -38,6 +38,7 @@ namespace scene
                     free(interpolatedAnimations);
                 if (nonInterpolatedAnimations)
                     free(nonInterpolatedAnimations);
+                dropSoAAnimationData();
             }
         public:
             #include "irr/irrpack.h"
@@ -62,7 +63,8 @@ namespace scene
             CFinalBoneHierarchy(const core::vector<asset::ICPUSkinnedMesh::SJoint*>& inLevelFixedJoints, const core::vector<size_t>& inJointsLevelEnd)
                     : boneCount(inLevelFixedJoints.size()), NumLevelsInHierarchy(inJointsLevelEnd.size()),
                     ///boundBuffer(NULL),
-                    keyframeCount(0), keyframes(NULL), interpolatedAnimations(NULL), nonInterpolatedAnimations(NULL)
+                    keyframeCount(0), keyframes(NULL), interpolatedAnimations(NULL), nonInterpolatedAnimations(NULL),
+                    soaBoneStride(0), soaAnimations{NULL,NULL}
             {
                 boneFlatArray = (BoneReferenceData*)malloc(sizeof(BoneReferenceData)*boneCount);
                 boneNames = _IRR_NEW_ARRAY(core::stringc,boneCount);
@@ -107,7 +109,8 @@ namespace scene
 				const float* _keyframesBegin, const float* _keyframesEnd,
 				const void* _interpAnimsBegin, const void* _interpAnimsEnd,
 				const void* _nonInterpAnimsBegin, const void* _nonInterpAnimsEnd)
-			: boneCount((BoneReferenceData*)_bonesEnd - (BoneReferenceData*)_bonesBegin), NumLevelsInHierarchy(_levelsEnd - _levelsBegin), keyframeCount(_keyframesEnd - _keyframesBegin)
+			: boneCount((BoneReferenceData*)_bonesEnd - (BoneReferenceData*)_bonesBegin), NumLevelsInHierarchy(_levelsEnd - _levelsBegin), keyframeCount(_keyframesEnd - _keyframesBegin),
+				soaBoneStride(0), soaAnimations{NULL,NULL}
 			{
 				_IRR_DEBUG_BREAK_IF(_bonesBegin > _bonesEnd ||
 					_boneNamesBegin > _boneNamesEnd ||
@@ -263,6 +266,36 @@ namespace scene
                 return getLowerBoundBoneKeyframes(interpolationFactor, frame, found);
             }
 
+            //! Same as above but starts the search at `keyframeCursor`, which is updated to what was found for the next call
+            /** Animations mostly move forward by a keyframe or two between updates, so keeping a cursor per instance
+            makes the lookup O(1) amortized, big jumps fall back to a binary search from the cursor. */
+            inline size_t getLowerBoundBoneKeyframes(float& interpolationFactor, const float& frame, uint32_t& keyframeCursor) const
+            {
+                constexpr uint32_t kMaxLinearSteps = 4u;
+
+                const float* const keyframesBegin = keyframes;
+                const float* const keyframesEnd = keyframes+keyframeCount;
+                const float* found = keyframesBegin+std::min<size_t>(keyframeCursor,keyframeCount);
+                uint32_t steps = 0u;
+                if (found!=keyframesEnd && *found<frame)
+                {
+                    while (found!=keyframesEnd && *found<frame && (steps++)<kMaxLinearSteps)
+                        found++;
+                    if (found!=keyframesEnd && *found<frame)
+                        found = std::lower_bound(found,keyframesEnd,frame);
+                }
+                else
+                {
+                    while (found!=keyframesBegin && !(*(found-1)<frame) && (steps++)<kMaxLinearSteps)
+                        found--;
+                    if (found!=keyframesBegin && !(*(found-1)<frame))
+                        found = std::lower_bound(keyframesBegin,found,frame);
+                }
+                keyframeCursor = found-keyframesBegin;
+
+                return getLowerBoundBoneKeyframes(interpolationFactor, frame, found);
+            }
+
             inline size_t getLowerBoundBoneKeyframes(const float& frame) const
             {
                 float tmpDummy;
@@ -317,6 +350,173 @@ namespace scene
                 return getMatrixFromKeys(keyframe,keyframe,1.f,0.25f,0.f);
             }
 
+            //! Same as getMatrixFromKeys but for four bones at once, every SIMD lane works on a different bone
+            /** \param keysA Rotation XYZW, Position XYZ and Scale XYZ of the lower keys, one bone per lane.
+            \param keysB Same for the upper keys. */
+            static inline void getMatricesFromSoAKeys(core::matrix3x4SIMD outMatrices[4], const core::vectorSIMDf keysA[10], const core::vectorSIMDf keysB[10],
+                                                      const float& interpolant, const float& interpolantPrecalcTerm2, const float& interpolantPrecalcTerm3)
+            {
+                const core::vectorSIMDf t(interpolant);
+                core::vectorSIMDf pos[3], scale[3];
+                for (uint32_t j=0u; j<3u; j++)
+                {
+                    pos[j] = core::mix(keysA[4u+j],keysB[4u+j],t);
+                    scale[j] = core::mix(keysA[7u+j],keysB[7u+j],t);
+                }
+
+                // flerp with the shortest rotation, same as quaternion::flerp_adjustedinterpolant and quaternion::lerp
+                const __m128 signMask = _mm_set1_ps(-0.f);
+                const core::vectorSIMDf dot = keysA[0]*keysB[0]+keysA[1]*keysB[1]+keysA[2]*keysB[2]+keysA[3]*keysB[3];
+                const __m128 wrongDoubleCover = _mm_and_ps(dot.getAsRegister(),signMask);
+                const core::vectorSIMDf angle = _mm_andnot_ps(signMask,dot.getAsRegister());
+                const core::vectorSIMDf A = core::vectorSIMDf(1.0904f)+angle*(core::vectorSIMDf(-3.2452f)+angle*(core::vectorSIMDf(3.55645f)-angle*core::vectorSIMDf(1.43519f)));
+                const core::vectorSIMDf B = core::vectorSIMDf(0.848013f)+angle*(core::vectorSIMDf(-1.06021f)+angle*core::vectorSIMDf(0.215638f));
+                const core::vectorSIMDf adjustedT = t+core::vectorSIMDf(interpolantPrecalcTerm3)*(A*core::vectorSIMDf(interpolantPrecalcTerm2)+B);
+                core::vectorSIMDf q[4];
+                for (uint32_t j=0u; j<4u; j++)
+                    q[j] = core::mix(keysA[j],core::vectorSIMDf(_mm_xor_ps(keysB[j].getAsRegister(),wrongDoubleCover)),adjustedT);
+                const core::vectorSIMDf rcpLength = core::vectorSIMDf(1.f)/core::sqrt(q[0]*q[0]+q[1]*q[1]+q[2]*q[2]+q[3]*q[3]);
+                for (uint32_t j=0u; j<4u; j++)
+                    q[j] *= rcpLength;
+
+                // same as matrix3x4SIMD::setScaleRotationAndTranslation
+                const core::vectorSIMDf one(1.f), two(2.f);
+                const core::vectorSIMDf xx = q[0]*q[0], yy = q[1]*q[1], zz = q[2]*q[2];
+                const core::vectorSIMDf xy = q[0]*q[1], xz = q[0]*q[2], yz = q[1]*q[2];
+                const core::vectorSIMDf xw = q[0]*q[3], yw = q[1]*q[3], zw = q[2]*q[3];
+                core::vectorSIMDf rows[3][4] = {
+                    {scale[0]*(one-two*(yy+zz)), scale[1]*two*(xy-zw), scale[2]*two*(xz+yw), pos[0]},
+                    {scale[0]*two*(xy+zw), scale[1]*(one-two*(xx+zz)), scale[2]*two*(yz-xw), pos[1]},
+                    {scale[0]*two*(xz-yw), scale[1]*two*(yz+xw), scale[2]*(one-two*(xx+yy)), pos[2]}
+                };
+                for (uint32_t r=0u; r<3u; r++)
+                {
+                    core::transpose4(rows[r]);
+                    for (uint32_t i=0u; i<4u; i++)
+                        outMatrices[i].rows[r] = rows[r][i];
+                }
+            }
+
+            //! Same as getMatricesFromSoAKeys but with the keys of every bone as AnimationKeyData, which get transposed first
+            static inline void getMatricesFromKeys(core::matrix3x4SIMD outMatrices[4], const AnimationKeyData* const keyframesA[4], const AnimationKeyData* const keyframesB[4],
+                                                   const float& interpolant, const float& interpolantPrecalcTerm2, const float& interpolantPrecalcTerm3)
+            {
+                // after transposing: rotation XYZW, position XYZ, scale XYZ and padding, each with one bone per lane
+                core::vectorSIMDf a[12], b[12];
+                for (uint32_t i=0u; i<4u; i++)
+                for (uint32_t j=0u; j<3u; j++)
+                {
+                    a[j*4u+i] = core::vectorSIMDf(keyframesA[i]->Rotation+j*4u);
+                    b[j*4u+i] = core::vectorSIMDf(keyframesB[i]->Rotation+j*4u);
+                }
+                for (uint32_t j=0u; j<3u; j++)
+                {
+                    core::transpose4(a+j*4u);
+                    core::transpose4(b+j*4u);
+                }
+
+                getMatricesFromSoAKeys(outMatrices,a,b,interpolant,interpolantPrecalcTerm2,interpolantPrecalcTerm3);
+            }
+
+            //! Local transforms of the bones [firstBone,firstBone+count) at a keyframe found by getLowerBoundBoneKeyframes, four bones at a time
+            /** Gives the same matrices as getMatrixFromKeys or getMatrixFromKey called per bone with keys from getInterpolatedAnimationData or getNonInterpolatedAnimationData,
+            up to the rotation quantization when the SoA animation data was created. */
+            inline void getMatricesFromKeys(core::matrix3x4SIMD* outMatrices, const size_t& firstBone, const size_t& count, const size_t& foundKeyIx, const float& interpolationFactor, const bool& interpolate) const
+            {
+                const bool blend = interpolate&&interpolationFactor<1.f;
+                const float interpolant = blend ? interpolationFactor:1.f;
+                float interpolantPrecalcTerm2 = 0.25f, interpolantPrecalcTerm3 = 0.f;
+                if (blend)
+                    core::quaternion::flerp_interpolant_terms(interpolantPrecalcTerm2,interpolantPrecalcTerm3,interpolant);
+                const size_t lowerKeyIx = blend ? (foundKeyIx-1u):foundKeyIx;
+
+                if (hasSoAAnimationData())
+                {
+                    const uint8_t* soaData = soaAnimations[interpolate ? 0u:1u];
+                    const uint8_t* keyframeA = soaData+getSoAKeyframeSize()*lowerKeyIx;
+                    const uint8_t* keyframeB = soaData+getSoAKeyframeSize()*foundKeyIx;
+                    // streams are padded, so the last few bones can be done as a whole batch too
+                    for (size_t i=0u; i<count; i+=4u)
+                    {
+                        core::vectorSIMDf a[10], b[10];
+                        loadSoAKeys(a,keyframeA,firstBone+i);
+                        loadSoAKeys(b,keyframeB,firstBone+i);
+                        if (i+4u<=count)
+                            getMatricesFromSoAKeys(outMatrices+i,a,b,interpolant,interpolantPrecalcTerm2,interpolantPrecalcTerm3);
+                        else
+                        {
+                            core::matrix3x4SIMD tmp[4];
+                            getMatricesFromSoAKeys(tmp,a,b,interpolant,interpolantPrecalcTerm2,interpolantPrecalcTerm3);
+                            std::copy(tmp,tmp+(count-i),outMatrices+i);
+                        }
+                    }
+                    return;
+                }
+
+                const AnimationKeyData* animations = (interpolate ? interpolatedAnimations:nonInterpolatedAnimations)+keyframeCount*firstBone;
+                size_t i=0u;
+                for (; i+4u<=count; i+=4u)
+                {
+                    const AnimationKeyData* keyframesA[4];
+                    const AnimationKeyData* keyframesB[4];
+                    for (size_t j=0u; j<4u; j++)
+                    {
+                        keyframesA[j] = animations+keyframeCount*(i+j)+lowerKeyIx;
+                        keyframesB[j] = animations+keyframeCount*(i+j)+foundKeyIx;
+                    }
+                    getMatricesFromKeys(outMatrices+i,keyframesA,keyframesB,interpolant,interpolantPrecalcTerm2,interpolantPrecalcTerm3);
+                }
+                for (; i<count; i++)
+                    outMatrices[i] = getMatrixFromKeys(animations[keyframeCount*i+lowerKeyIx],animations[keyframeCount*i+foundKeyIx],interpolant,interpolantPrecalcTerm2,interpolantPrecalcTerm3);
+            }
+
+            //! Builds a structure-of-arrays copy of both animations, which getMatricesFromKeys samples from from then on
+            /** Every keyframe stores Position XYZ and Scale XYZ as float streams followed by Rotation XYZW as 16bit snorm streams,
+            with the bones as the innermost index so that four neighbouring bones are a single load. A key takes 32 bytes instead
+            of sizeof(AnimationKeyData). Editing the keyframes rebuilds it, the AnimationKeyData arrays stay the reference copy. */
+            inline void createSoAAnimationData()
+            {
+                dropSoAAnimationData();
+
+                // padded so that the batch starting at the last bone stays in bounds, and the 16bit streams stay aligned
+                soaBoneStride = (boneCount+3u+7u)&(~size_t(7u));
+                const AnimationKeyData* animations[2] = {interpolatedAnimations,nonInterpolatedAnimations};
+                for (uint32_t k=0u; k<2u; k++)
+                {
+                    soaAnimations[k] = reinterpret_cast<uint8_t*>(_IRR_ALIGNED_MALLOC(getSoAKeyframeSize()*keyframeCount,_IRR_SIMD_ALIGNMENT));
+                    memset(soaAnimations[k],0,getSoAKeyframeSize()*keyframeCount);
+                    for (size_t m=0; m<keyframeCount; m++)
+                    {
+                        float* streams = reinterpret_cast<float*>(soaAnimations[k]+getSoAKeyframeSize()*m);
+                        int16_t* rotations = reinterpret_cast<int16_t*>(streams+soaBoneStride*6u);
+                        for (size_t i=0; i<boneCount; i++)
+                        {
+                            const AnimationKeyData& key = animations[k][keyframeCount*i+m];
+                            for (uint32_t j=0u; j<3u; j++)
+                            {
+                                streams[soaBoneStride*j+i] = key.Position[j];
+                                streams[soaBoneStride*(3u+j)+i] = key.Scale[j];
+                            }
+                            for (uint32_t j=0u; j<4u; j++)
+                                rotations[soaBoneStride*j+i] = static_cast<int16_t>(core::round32(core::clamp(key.Rotation[j],-1.f,1.f)*32767.f));
+                        }
+                    }
+                }
+            }
+
+            inline void dropSoAAnimationData()
+            {
+                for (uint32_t k=0u; k<2u; k++)
+                {
+                    if (soaAnimations[k])
+                        _IRR_ALIGNED_FREE(soaAnimations[k]);
+                    soaAnimations[k] = NULL;
+                }
+                soaBoneStride = 0;
+            }
+
+            inline bool hasSoAAnimationData() const {return soaAnimations[0]!=NULL;}
+
             //effectively downsamples our animation
             inline void deleteKeyframes(const size_t& keyframesToRemoveCount, const float* sortedKeyFramesToRemove)
             {
@@ -377,6 +577,8 @@ namespace scene
 
                 //won't resize data buffers because cba
                 keyframeCount = keyframesOut-keyframes;
+                if (hasSoAAnimationData())
+                    createSoAAnimationData();
             }
 
             //effectively upsamples our animation
@@ -462,6 +664,8 @@ namespace scene
                 interpolatedAnimations = newInAnimations;
                 nonInterpolatedAnimations = newNoAnimations;
                 keyframeCount = newKeyframesOut-newKeyframes;
+                if (hasSoAAnimationData())
+                    createSoAAnimationData();
             }
 
             //typedef for an interpolation function when adding interpolated offsets to animation
@@ -490,9 +694,30 @@ namespace scene
                     for (float* found=start; found<end; found++)
                         transformFunc(it++,i,*found,this,true);
                 }
+
+                if (hasSoAAnimationData())
+                    createSoAAnimationData();
             }
 
         private:
+            inline size_t getSoAKeyframeSize() const {return soaBoneStride*(6u*sizeof(float)+4u*sizeof(int16_t));}
+
+            //! Loads Rotation XYZW, Position XYZ and Scale XYZ of the four bones starting at `boneID` from one keyframe of the SoA data
+            inline void loadSoAKeys(core::vectorSIMDf outKeys[10], const uint8_t* soaKeyframe, const size_t& boneID) const
+            {
+                const float* streams = reinterpret_cast<const float*>(soaKeyframe);
+                for (uint32_t j=0u; j<6u; j++)
+                    outKeys[4u+j] = _mm_loadu_ps(streams+soaBoneStride*j+boneID);
+
+                const int16_t* rotations = reinterpret_cast<const int16_t*>(streams+soaBoneStride*6u);
+                const __m128 dequantize = _mm_set1_ps(1.f/32767.f);
+                for (uint32_t j=0u; j<4u; j++)
+                {
+                    const __m128i quantized = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(rotations+soaBoneStride*j+boneID));
+                    outKeys[j] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepi16_epi32(quantized)),dequantize);
+                }
+            }
+
             inline void createAnimationKeys(const core::vector<asset::ICPUSkinnedMesh::SJoint*>& inLevelFixedJoints)
             {
                 core::unordered_set<float> sortedFrames;
@@ -722,6 +947,10 @@ namespace scene
             float* keyframes;
             AnimationKeyData* interpolatedAnimations;
             AnimationKeyData* nonInterpolatedAnimations;
+
+            // optional structure-of-arrays copy of both animations, see createSoAAnimationData
+            size_t soaBoneStride;
+            uint8_t* soaAnimations[2];
     };
 
 } // end namespace scene
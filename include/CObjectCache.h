@@ -11,6 +11,7 @@
 #include "irr/static_if.h"
 #include "irr/macros.h"
 #include "irr/core/Types.h"
+#include "irr/core/open_addressing_multimap.h"
 
 namespace irr { namespace core
 {
@@ -43,6 +44,8 @@ namespace impl
     struct is_multi_container<std::multimap> : std::true_type {};
     template<>
     struct is_multi_container<std::unordered_multimap> : std::true_type {};
+    template<>
+    struct is_multi_container<core::open_addressing_multimap> : std::true_type {};
 
     template<template<typename...> class>
     struct is_assoc_container : std::false_type {};
@@ -54,6 +57,19 @@ namespace impl
     struct is_assoc_container<std::multimap> : std::true_type {};
     template<>
     struct is_assoc_container<std::unordered_multimap> : std::true_type {};
+    template<>
+    struct is_assoc_container<core::open_addressing_multimap> : std::true_type {};
+
+    //! Instantiation of associative container used by a cache, ordered containers get std::less and hash-based ones their default hash
+    template<template<typename...> class C, typename KK, typename TT, typename AAlloc>
+    struct assoc_container_for { using type = C<KK, TT, std::less<KK>, AAlloc>; };
+    template<typename KK, typename TT, typename AAlloc>
+    struct assoc_container_for<core::open_addressing_multimap, KK, TT, AAlloc> { using type = core::open_addressing_multimap<KK, TT, open_addressing_hash<KK>, std::equal_to<KK>, AAlloc>; };
+
+    template<typename C, typename = void>
+    struct has_reserve : std::false_type {};
+    template<typename C>
+    struct has_reserve<C, std::void_t<decltype(std::declval<C&>().reserve(size_t(0u)))>> : std::true_type {};
 
     template<typename K, typename...>
     struct IRR_FORCE_EBO PropagKeyTypeTypedef_ { using KeyType = K; };
@@ -79,7 +95,7 @@ namespace impl
         struct help<true, C>
         {
             template<typename KK, typename TT, typename AAlloc>
-            using container_t = C<KK, TT, std::less<KK>, AAlloc>;
+            using container_t = typename assoc_container_for<C, KK, TT, AAlloc>::type;
         };
         template<template<typename...> class C>
         struct help<false, C>
@@ -239,7 +255,7 @@ namespace impl
     struct CPreInsertionVerifier<ContainerT_T, ContainerT, true, IsAssocContainer>
     {
         template<typename ...Ts>
-        static bool verify(Ts...) { return true; }
+        static bool verify(const Ts&...) { return true; } // by reference, otherwise the whole container gets copied on every insertion
     };
     template<template<typename...> class ContainerT_T, typename ContainerT>
     struct CPreInsertionVerifier<ContainerT_T, ContainerT, false, false>
@@ -654,6 +670,56 @@ namespace impl
             *_gotAll = this->outputRange(rng, _inOutStorageSize, _out);
             return res;
         }
+
+        //! Inserts all key-value pairs from [_begin,_end) greeting every inserted value, `*_begin` has to have `first` and `second` members (e.g. MutablePairType).
+        /** Much cheaper than consecutive insert() calls: vector-backed caches sort the new pairs and merge them in one pass
+        instead of shifting the whole container for every pair, containers with reserve() grow at most once.
+        @returns Amount of inserted pairs (non-multi caches reject keys already present, as insert() does). */
+        template<typename ForwardIt>
+        inline size_t bulkInsert(ForwardIt _begin, ForwardIt _end)
+        {
+            IRR_PSEUDO_IF_CONSTEXPR_BEGIN(isVectorContainer)
+            {
+                auto cmpf = [](const typename Base::PairType& _a, const typename Base::PairType& _b) -> bool { return _a.first < _b.first; };
+                const size_t oldSize = this->m_container.size();
+                for (auto it = _begin; it != _end; ++it)
+                    this->m_container.emplace_back(it->first, it->second);
+
+                auto newBegin = std::begin(this->m_container)+oldSize;
+                auto newEnd = std::end(this->m_container);
+                std::stable_sort(newBegin, newEnd, cmpf);
+                IRR_PSEUDO_IF_CONSTEXPR_BEGIN(!forMultiCache)
+                {
+                    newEnd = std::unique(newBegin, newEnd, [](const typename Base::PairType& _a, const typename Base::PairType& _b) -> bool { return !(_a.first < _b.first); });
+                    const auto oldEnd = newBegin;
+                    newEnd = std::remove_if(newBegin, newEnd, [&](const typename Base::PairType& _p) -> bool {
+                        auto found = std::lower_bound(std::begin(this->m_container), oldEnd, _p, cmpf);
+                        return found != oldEnd && !(_p.first < found->first);
+                    });
+                    this->m_container.erase(newEnd, std::end(this->m_container));
+                    newBegin = std::begin(this->m_container)+oldSize;
+                    newEnd = std::end(this->m_container);
+                }
+                IRR_PSEUDO_IF_CONSTEXPR_END
+                for (auto it = newBegin; it != newEnd; ++it)
+                    this->greet(it->second);
+                std::inplace_merge(std::begin(this->m_container), newBegin, newEnd, cmpf);
+                return this->m_container.size()-oldSize;
+            }
+            IRR_PSEUDO_ELSE_CONSTEXPR
+            {
+                IRR_PSEUDO_IF_CONSTEXPR_BEGIN(impl::has_reserve<typename Base::ContainerT>::value)
+                {
+                    this->m_container.reserve(this->m_container.size()+std::distance(_begin, _end));
+                }
+                IRR_PSEUDO_IF_CONSTEXPR_END
+                size_t inserted = 0u;
+                for (auto it = _begin; it != _end; ++it)
+                    inserted += this->insert(it->first, it->second);
+                return inserted;
+            }
+            IRR_PSEUDO_IF_CONSTEXPR_END
+        }
     };
 
     template <
@@ -718,7 +784,7 @@ class CMultiObjectCache<K, T, ContainerT_T, Alloc, false> :
     public impl::CDirectMultiCacheBase<false, ContainerT_T, Alloc, T, const K>,
     public impl::PropagTypedefs<T, const K>
 {
-    static_assert(impl::is_same_templ<ContainerT_T, std::multimap>::value || impl::is_same_templ<ContainerT_T, std::unordered_multimap>::value, "ContainerT_T must be one of: std::vector, std::multimap, std::unordered_multimap");
+    static_assert(impl::is_same_templ<ContainerT_T, std::multimap>::value || impl::is_same_templ<ContainerT_T, std::unordered_multimap>::value || impl::is_same_templ<ContainerT_T, core::open_addressing_multimap>::value, "ContainerT_T must be one of: std::vector, std::multimap, std::unordered_multimap, core::open_addressing_multimap");
 
 private:
     using Base = impl::CDirectMultiCacheBase<false, ContainerT_T, Alloc, T, const K>;
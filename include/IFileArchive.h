@@ -56,11 +56,20 @@ public:
 
 	//! Opens a file based on its name
 	/** Creates and returns a new IReadFile for a file in the archive.
+	Files opened from the same archive may be read by different threads at once,
+	but each of them must only be used by one thread at a time.
 	\param filename The file to open
 	\return Returns A pointer to the created file on success,
 	or 0 on failure. */
 	virtual IReadFile* createAndOpenFile(const path& filename) =0;
 
+	//! Opens a file based on its position in getFileList()
+	/** Saves looking the name up again when the entry is already known.
+	\param index The index of the file in the list returned by getFileList()
+	\return Returns A pointer to the created file on success,
+	or 0 on failure. */
+	virtual IReadFile* createAndOpenFile(uint32_t index) =0;
+
 	//! Returns the complete file tree
 	/** \return Returns the complete directory tree for the archive,
 	including all files and folders */
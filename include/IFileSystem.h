@@ -38,6 +38,24 @@ public:
 	See IReferenceCounted::drop() for more information. */
 	virtual IReadFile* createAndOpenFile(const path& filename) =0;
 
+	//! Opens a file on disk for read access through a memory mapping.
+	/** Archives are not searched. IReadFile::getMappedPointer() of the returned file
+	gives direct access to its contents, which lets loaders avoid copying data around.
+	\param filename: Name of file to open.
+	\return Pointer to the created file interface or nullptr if the file could not be opened or mapped.
+	The returned pointer should be dropped when no longer needed.
+	See IReferenceCounted::drop() for more information. */
+	virtual IReadFile* createMappedReadFile(const path& filename) =0;
+
+	//! Makes createAndOpenFile() memory map files on disk instead of reading them through stdio.
+	/** Off by default. Loaders parse mapped files in place, files which can't be mapped still
+	get opened the regular way, files inside archives are not affected.
+	\param enable: True to map files on disk. */
+	virtual void setUseMemoryMappedFiles(bool enable) =0;
+
+	//! Returns whether createAndOpenFile() memory maps files on disk.
+	virtual bool getUseMemoryMappedFiles() const =0;
+
 	//! Creates an IReadFile interface for accessing memory like a file.
 	/** This allows you to use a pointer to memory where an IReadFile is requested.
 	\param memory: A pointer to the start of the file in memory
@@ -14,15 +14,28 @@ namespace irr
 namespace io
 {
 
+	//! How a file is going to be read, lets the OS tune readahead and caching
+	enum E_FILE_ACCESS_PATTERN
+	{
+		//! no particular pattern, the OS defaults
+		EFAP_NORMAL = 0,
+		//! front to back, more aggressive readahead
+		EFAP_SEQUENTIAL,
+		//! scattered reads, readahead would be wasted
+		EFAP_RANDOM,
+		//! the whole file is going to be needed soon, start reading it in the background
+		EFAP_WILL_NEED
+	};
+
 	//! Interface providing read acess to a file.
 	class IReadFile : public virtual core::IReferenceCounted
 	{
 	public:
 		//! Reads an amount of bytes from the file.
 		/** \param buffer Pointer to buffer where read bytes are written to.
-		\param sizeToRead Amount of bytes to read from the file.
+		\param sizeToRead Amount of bytes to read from the file, may be more than 4GB.
 		\return How many bytes were read. */
-		virtual int32_t read(void* buffer, uint32_t sizeToRead) = 0;
+		virtual size_t read(void* buffer, size_t sizeToRead) = 0;
 
 		//! Changes position in file
 		/** \param finalPos Destination position in the file.
@@ -43,6 +56,15 @@ namespace io
 		//! Get name of file.
 		/** \return File name as zero terminated character string. */
 		virtual const io::path& getFileName() const = 0;
+
+		//! Get pointer to the whole contents of the file if it's memory mapped.
+		/** Memory stays valid for as long as the file object is alive (grab it to keep it so).
+		\return Pointer to the first byte of the file or nullptr if the file is not memory mapped. */
+		virtual const void* getMappedPointer() const { return nullptr; }
+
+		//! Hints how the file is going to be read from now on.
+		/** Purely an optimization (madvise/posix_fadvise), files which cannot make use of it ignore it. */
+		virtual void setAccessPattern(E_FILE_ACCESS_PATTERN /*pattern*/) {}
 	};
 
 } // end namespace io
@@ -563,6 +563,15 @@ namespace scene
 		\return True if node is not visible in the current scene, else
 		false. */
 		virtual bool isCulled(ISceneNode* node) const =0;
+
+		//! Sets how many threads drawAll() may use to cull the scene
+		/** All visible nodes with box culling are culled in one batch before they get registered,
+		isCulled() then just looks the result up.
+		\param threadCount Amount of threads, 0 means as many as there are hardware threads. The default is 1. */
+		virtual void setCullingThreadCount(const uint32_t& threadCount) = 0;
+
+		//! Gets the thread count set with setCullingThreadCount()
+		virtual const uint32_t& getCullingThreadCount() const = 0;
 	};
 
 
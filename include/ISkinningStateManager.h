@@ -213,9 +213,21 @@ namespace scene
                     uint64_t lastTimePulledAbsoluteTFormForBoning;
             };
 
+            //! Per-bone data of an instance, as it is laid out in the bone data buffer
+            #include "irr/irrpack.h"
+            struct FinalBoneData
+            {
+                core::matrix4x3 SkinningTransform;
+                float SkinningNormalMatrix[9];
+                float MinBBoxEdge[3];
+                float MaxBBoxEdge[3];
+                float lastAnimatedFrame; //to pad to 128bit align, maybe parentOffsetRelative?
+            } PACK_STRUCT;
+            #include "irr/irrunpack.h"
+
             //! Constructor
             ISkinningStateManager(const E_BONE_UPDATE_MODE& boneControl, video::IVideoDriver* driver, const CFinalBoneHierarchy* sourceHierarchy)
-                    : usingGPUorCPUBoning(-100), boneControlMode(boneControl), referenceHierarchy(sourceHierarchy), instanceData(nullptr), instanceDataSize(0)
+                    : usingGPUorCPUBoning(-100), boneControlMode(boneControl), boningThreadCount(1u), referenceHierarchy(sourceHierarchy), instanceData(nullptr), instanceDataSize(0)
             {
                 referenceHierarchy->grab();
 
@@ -308,6 +320,57 @@ namespace scene
 
             inline size_t getDataInstanceCount() const {return instanceBoneDataAllocator->getAddressAllocator().get_allocated_size()/instanceFinalBoneDataSize;}
 
+            //! How many threads performBoning may split EBUM_NONE instances across, 0 means one per hardware thread, default is 1
+            inline void setBoningThreadCount(const uint32_t& threadCount) {boningThreadCount = threadCount;}
+            inline const uint32_t& getBoningThreadCount() const {return boningThreadCount;}
+
+            //! Bones one instance which has no bone scene nodes (EBUM_NONE), what performBoning runs for every animated instance in that mode
+            /** Goes through the hierarchy level by level, interpolating the local transforms of four bones at a time.
+            Only reads the hierarchy and writes the instance's own data, so different instances can be boned from different threads.
+            \param globalMatrices Receives the transform of every bone relative to the instance.
+            \param boneData Receives the skinning transforms, normal matrices and bounding boxes. */
+            static inline void boneInstance(const CFinalBoneHierarchy* hierarchy, const float& frame, const bool& interpolateAnimation, uint32_t& keyframeCursor, core::matrix4x3* globalMatrices, FinalBoneData* boneData)
+            {
+                float interpolationFactor;
+                const size_t foundKeyIx = hierarchy->getLowerBoundBoneKeyframes(interpolationFactor,frame,keyframeCursor);
+
+                constexpr size_t kBatchSize = 64u;
+                core::matrix3x4SIMD localTforms[kBatchSize];
+                for (size_t level=0u; level<hierarchy->getHierarchyLevels(); level++)
+                {
+                    const size_t levelEnd = hierarchy->getBoneLevelRangeEnd(level);
+                    for (size_t first=hierarchy->getBoneLevelRangeStart(level); first<levelEnd; first+=kBatchSize)
+                    {
+                        const size_t count = std::min(levelEnd-first,kBatchSize);
+                        hierarchy->getMatricesFromKeys(localTforms,first,count,foundKeyIx,interpolationFactor,interpolateAnimation);
+                        for (size_t k=0u; k<count; k++)
+                        {
+                            const size_t j = first+k;
+                            const CFinalBoneHierarchy::BoneReferenceData& referenceData = hierarchy->getBoneData()[j];
+
+                            // parents are always in an earlier level
+                            core::matrix3x4SIMD globalTform = localTforms[k];
+                            if (level)
+                                globalTform = core::matrix3x4SIMD::concatenateBFollowedByA(core::matrix3x4SIMD().set(globalMatrices[referenceData.parentOffsetFromTop]),localTforms[k]);
+                            globalMatrices[j] = globalTform.getAsRetardedIrrlichtMatrix();
+
+                            FinalBoneData& out = boneData[j];
+                            out.lastAnimatedFrame = frame;
+                            const core::matrix3x4SIMD skinningTform = core::matrix3x4SIMD::concatenateBFollowedByA(globalTform,core::matrix3x4SIMD().set(referenceData.PoseBindMatrix));
+                            out.SkinningTransform = skinningTform.getAsRetardedIrrlichtMatrix();
+                            out.SkinningTransform.getSub3x3InverseTranspose(out.SkinningNormalMatrix);
+
+                            core::aabbox3df bbox;
+                            bbox.MinEdge.set(referenceData.MinBBoxEdge[0],referenceData.MinBBoxEdge[1],referenceData.MinBBoxEdge[2]);
+                            bbox.MaxEdge.set(referenceData.MaxBBoxEdge[0],referenceData.MaxBBoxEdge[1],referenceData.MaxBBoxEdge[2]);
+                            bbox = core::transformBoxEx(bbox,skinningTform);
+                            memcpy(out.MinBBoxEdge,&bbox.MinEdge.X,sizeof(float)*3u);
+                            memcpy(out.MaxBBoxEdge,&bbox.MaxEdge.X,sizeof(float)*3u);
+                        }
+                    }
+                }
+            }
+
         protected:
             virtual ~ISkinningStateManager()
             {
@@ -336,13 +399,14 @@ namespace scene
 
             int8_t usingGPUorCPUBoning;
             const E_BONE_UPDATE_MODE boneControlMode;
+            uint32_t boningThreadCount;
             const CFinalBoneHierarchy* referenceHierarchy;
 
             size_t actualSizeOfInstanceDataElement;
             class BoneHierarchyInstanceData : public core::AlignedBase<_IRR_SIMD_ALIGNMENT>
             {
                 public:
-                    BoneHierarchyInstanceData() : refCount(0), frame(0.f), lastAnimatedFrame(-1.f), interpolateAnimation(true), attachedNode(NULL)
+                    BoneHierarchyInstanceData() : refCount(0), frame(0.f), lastAnimatedFrame(-1.f), interpolateAnimation(true), keyframeCursor(0u), attachedNode(NULL)
                     {
                     }
 
@@ -356,6 +420,7 @@ namespace scene
                     };
 
                     bool interpolateAnimation;
+                    uint32_t keyframeCursor; //where the last keyframe lookup ended, fits in the padding before attachedNode
                     ISkinnedMeshSceneNode* attachedNode; //can be NULL
             };
             inline core::matrix4x3* getGlobalMatrices(BoneHierarchyInstanceData* currentInstance)
@@ -378,16 +443,6 @@ namespace scene
             uint32_t instanceDataSize;
 
             uint32_t instanceFinalBoneDataSize;
-            #include "irr/irrpack.h"
-            struct FinalBoneData
-            {
-                core::matrix4x3 SkinningTransform;
-                float SkinningNormalMatrix[9];
-                float MinBBoxEdge[3];
-                float MaxBBoxEdge[3];
-                float lastAnimatedFrame; //to pad to 128bit align, maybe parentOffsetRelative?
-            } PACK_STRUCT;
-            #include "irr/irrunpack.h"
             video::ResizableBufferingAllocatorST<InstanceDataAddressAllocator,core::allocator<uint8_t>,true>* instanceBoneDataAllocator;
 
             inline uint32_t getDataInstanceCapacity() const
@@ -420,7 +420,7 @@ currently only supports zip archives, though. */
 	#endif
 #endif
 
-#define _IRR_BAW_FORMAT_VERSION 1
+#define _IRR_BAW_FORMAT_VERSION 2
 
 //! @see @ref CBlobsLoadingManager
 #define _IRR_ADD_BLOB_SUPPORT(BlobClassName, EnumValue, Function, ...) \
@@ -0,0 +1,485 @@
+#ifndef __S_BOUNDING_VOLUME_HIERARCHY_H_INCLUDED__
+#define __S_BOUNDING_VOLUME_HIERARCHY_H_INCLUDED__
+
+#include <algorithm>
+
+#include "vectorSIMD.h"
+#include "aabbox3d.h"
+#include "matrix4x3.h"
+
+namespace irr
+{
+namespace core
+{
+
+//! Four rays in SoA layout, one ray per lane, traced together through a SBoundingVolumeHierarchy
+struct SRayPacket4
+{
+        SRayPacket4() {}
+        SRayPacket4(const vectorSIMDf* rayOrigins, const vectorSIMDf* rayDirections, const float* rayMaxT)
+        {
+            for (uint32_t i=0u; i<4u; i++)
+            for (uint32_t a=0u; a<3u; a++)
+            {
+                origin[a].pointer[i] = rayOrigins[i].pointer[a];
+                direction[a].pointer[i] = rayDirections[i].pointer[a];
+            }
+            for (uint32_t a=0u; a<3u; a++)
+                reciprocalDirection[a] = vectorSIMDf(1.f).preciseDivision(direction[a]);
+            maxT = vectorSIMDf(rayMaxT);
+        }
+
+        //! Transforms all rays by `mat`, ray parameters and therefore `maxT` stay valid
+        inline void transform(const matrix4x3& mat)
+        {
+            const vectorSIMDf inOrigin[3] = {origin[0],origin[1],origin[2]};
+            const vectorSIMDf inDirection[3] = {direction[0],direction[1],direction[2]};
+            for (uint32_t a=0u; a<3u; a++)
+            {
+                const float* row = &mat.getColumn(0).X+a;
+                origin[a] = inOrigin[0]*row[0]+inOrigin[1]*row[3]+inOrigin[2]*row[6]+vectorSIMDf(row[9]);
+                direction[a] = inDirection[0]*row[0]+inDirection[1]*row[3]+inDirection[2]*row[6];
+                reciprocalDirection[a] = vectorSIMDf(1.f).preciseDivision(direction[a]);
+            }
+        }
+
+        inline void getRay(vectorSIMDf& rayOrigin, vectorSIMDf& rayDirection, const uint32_t lane) const
+        {
+            rayOrigin.set(origin[0].pointer[lane],origin[1].pointer[lane],origin[2].pointer[lane],0.f);
+            rayDirection.set(direction[0].pointer[lane],direction[1].pointer[lane],direction[2].pointer[lane],0.f);
+        }
+
+        //! @returns Mask of the lanes whose ray hits the box before its maxT
+        inline uint32_t intersectBox(const float* minEdge, const float* maxEdge) const
+        {
+            vectorSIMDf tEntry(0.f);
+            vectorSIMDf tExit = maxT;
+            for (uint32_t a=0u; a<3u; a++)
+            {
+                const vectorSIMDf t0 = (vectorSIMDf(minEdge[a])-origin[a])*reciprocalDirection[a];
+                const vectorSIMDf t1 = (vectorSIMDf(maxEdge[a])-origin[a])*reciprocalDirection[a];
+                tEntry = max_(tEntry,min_(t0,t1));
+                tExit = min_(tExit,max_(t0,t1));
+            }
+            return _mm_movemask_ps(_mm_castsi128_ps((tEntry<=tExit).getAsRegister()));
+        }
+
+        vectorSIMDf origin[3];
+        vectorSIMDf direction[3];
+        vectorSIMDf reciprocalDirection[3];
+        //! Rays only report hits closer than this, leaf callbacks lower it as they find hits
+        vectorSIMDf maxT;
+};
+
+//! Binned surface area heuristic BVH over axis aligned boxes, the boxes themselves are owned by the user.
+/** Nodes are laid out depth-first, so the left child of an inner node directly follows it and
+children always come after their parents; refitting is a single backwards sweep. */
+class SBoundingVolumeHierarchy// : public AllocationOverrideDefault EBO inheritance problem
+{
+    public:
+        struct SNode
+        {
+            float minEdge[3];
+            //! First slot in getPrimitiveIndices() for leaves, right child for inner nodes
+            uint32_t firstPrimitiveOrRightChild;
+            float maxEdge[3];
+            //! 0 for inner nodes
+            uint32_t primitiveCount;
+
+            inline bool isLeaf() const {return primitiveCount!=0u;}
+        };
+        static_assert(sizeof(SNode)==8u*sizeof(float),"SNode edges are loaded with unaligned vector loads");
+
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t kInvalidIndex = 0xdeadbeefu;
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t kBinCount = 16u;
+        //! Deeper than this the builder only splits at the median, which keeps traversal stacks within 64 entries
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t kMaxSAHDepth = 32u;
+
+        //! Builds the hierarchy from scratch.
+        /**
+        @param primitiveBoxes Bounding boxes of the primitives, indexed by primitive.
+        @param primitiveCount Amount of primitives.
+        @param maxLeafSize Ranges this small always become leaves, bigger ones only when splitting costs more than not.
+        */
+        inline void build(const aabbox3df* primitiveBoxes, const uint32_t primitiveCount, const uint32_t maxLeafSize=4u)
+        {
+            clear();
+            if (!primitiveCount)
+                return;
+
+            primitiveIndices.resize(primitiveCount);
+            vector<vectorSIMDf> centroids(primitiveCount);
+            for (uint32_t i=0u; i<primitiveCount; i++)
+            {
+                primitiveIndices[i] = i;
+                centroids[i].set((primitiveBoxes[i].MinEdge+primitiveBoxes[i].MaxEdge)*0.5f);
+            }
+            nodes.reserve(primitiveCount*2u/(maxLeafSize>1u ? maxLeafSize:1u)+1u);
+            parents.reserve(nodes.capacity());
+
+            struct SBuildItem
+            {
+                uint32_t begin,end;
+                uint32_t parent; //!< kInvalidIndex unless this is the right child of `parent`
+                uint32_t depth;
+            };
+            vector<SBuildItem> stack;
+            stack.push_back({0u,primitiveCount,kInvalidIndex,0u});
+            while (stack.size())
+            {
+                const SBuildItem item = stack.back();
+                stack.pop_back();
+
+                const uint32_t nodeIx = nodes.size();
+                if (item.parent!=kInvalidIndex)
+                    nodes[item.parent].firstPrimitiveOrRightChild = nodeIx;
+                // the left child is popped right after its parent is created
+                parents.push_back(item.parent!=kInvalidIndex ? item.parent:(nodeIx ? nodeIx-1u:kInvalidIndex));
+
+                aabbox3df bounds(primitiveBoxes[primitiveIndices[item.begin]]);
+                aabbox3df centroidBounds(centroids[primitiveIndices[item.begin]].getAsVector3df());
+                for (uint32_t i=item.begin+1u; i<item.end; i++)
+                {
+                    bounds.addInternalBox(primitiveBoxes[primitiveIndices[i]]);
+                    centroidBounds.addInternalPoint(centroids[primitiveIndices[i]].getAsVector3df());
+                }
+                nodes.push_back(makeNode(bounds,item.begin,item.end-item.begin));
+
+                const uint32_t count = item.end-item.begin;
+                if (count<=maxLeafSize)
+                    continue;
+
+                // evaluate every bin boundary on every axis
+                const float nodeArea = getHalfArea(bounds);
+                float bestCost = FLT_MAX;
+                uint32_t bestAxis = 0u, bestSplit = 0u;
+                const vector3df centroidExtent = centroidBounds.getExtent();
+                for (uint32_t axis=0u; axis<(item.depth<kMaxSAHDepth ? 3u:0u); axis++)
+                {
+                    const float extent = (&centroidExtent.X)[axis];
+                    if (extent<=0.f)
+                        continue;
+
+                    const float binScale = float(kBinCount)*0.999f/extent;
+                    const float binOffset = (&centroidBounds.MinEdge.X)[axis];
+                    aabbox3df binBounds[kBinCount];
+                    uint32_t binCounts[kBinCount] = {};
+                    for (uint32_t i=item.begin; i<item.end; i++)
+                    {
+                        const uint32_t bin = uint32_t((centroids[primitiveIndices[i]].pointer[axis]-binOffset)*binScale);
+                        if (binCounts[bin]++)
+                            binBounds[bin].addInternalBox(primitiveBoxes[primitiveIndices[i]]);
+                        else
+                            binBounds[bin] = primitiveBoxes[primitiveIndices[i]];
+                    }
+
+                    // sweep from the right, then from the left combining with the right sweep
+                    float rightAreas[kBinCount];
+                    uint32_t rightCounts[kBinCount];
+                    aabbox3df accumulated;
+                    uint32_t accumulatedCount = 0u;
+                    for (uint32_t bin=kBinCount-1u; bin>0u; bin--)
+                    {
+                        if (binCounts[bin])
+                        {
+                            if (accumulatedCount)
+                                accumulated.addInternalBox(binBounds[bin]);
+                            else
+                                accumulated = binBounds[bin];
+                            accumulatedCount += binCounts[bin];
+                        }
+                        rightAreas[bin] = accumulatedCount ? getHalfArea(accumulated):0.f;
+                        rightCounts[bin] = accumulatedCount;
+                    }
+                    accumulatedCount = 0u;
+                    for (uint32_t split=1u; split<kBinCount; split++)
+                    {
+                        const uint32_t bin = split-1u;
+                        if (binCounts[bin])
+                        {
+                            if (accumulatedCount)
+                                accumulated.addInternalBox(binBounds[bin]);
+                            else
+                                accumulated = binBounds[bin];
+                            accumulatedCount += binCounts[bin];
+                        }
+                        if (!accumulatedCount || !rightCounts[split])
+                            continue;
+
+                        const float cost = getHalfArea(accumulated)*float(accumulatedCount)+rightAreas[split]*float(rightCounts[split]);
+                        if (cost<bestCost)
+                        {
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestSplit = split;
+                        }
+                    }
+                }
+
+                // traversal step costs about as much as one primitive test
+                uint32_t middle;
+                if (bestSplit)
+                {
+                    if (nodeArea>0.f && 1.f+bestCost/nodeArea>=float(count) && count<=maxLeafSize*4u)
+                        continue;
+
+                    const float binScale = float(kBinCount)*0.999f/(&centroidExtent.X)[bestAxis];
+                    const float binOffset = (&centroidBounds.MinEdge.X)[bestAxis];
+                    middle = std::partition(primitiveIndices.begin()+item.begin,primitiveIndices.begin()+item.end,
+                        [&](const uint32_t primitive) -> bool {return uint32_t((centroids[primitive].pointer[bestAxis]-binOffset)*binScale)<bestSplit;}
+                    )-primitiveIndices.begin();
+                }
+                else // all centroids coincide or the tree got too deep, split in the middle
+                    middle = item.begin+count/2u;
+
+                nodes.back().primitiveCount = 0u;
+                nodes.back().firstPrimitiveOrRightChild = kInvalidIndex;
+                stack.push_back({middle,item.end,nodeIx,item.depth+1u});
+                stack.push_back({item.begin,middle,kInvalidIndex,item.depth+1u});
+            }
+
+            primitiveLeaves.resize(primitiveCount);
+            for (uint32_t i=0u; i<nodes.size(); i++)
+            {
+                if (!nodes[i].isLeaf())
+                    continue;
+                for (uint32_t j=0u; j<nodes[i].primitiveCount; j++)
+                    primitiveLeaves[primitiveIndices[nodes[i].firstPrimitiveOrRightChild+j]] = i;
+            }
+        }
+
+        //! Recomputes all node boxes after the primitive boxes moved, keeps the topology.
+        /** Cheap compared to build(), but the tree quality degrades if primitives move far. */
+        inline void refit(const aabbox3df* primitiveBoxes)
+        {
+            for (auto i=nodes.size(); i--; )
+                refitNode(i,primitiveBoxes);
+        }
+
+        //! Incremental refit, only walks up from the leaves of the primitives that changed
+        /** Stops climbing as soon as a node's box does not change. */
+        inline void refit(const aabbox3df* primitiveBoxes, const uint32_t* changedPrimitives, const uint32_t changedCount)
+        {
+            for (uint32_t i=0u; i<changedCount; i++)
+            {
+                for (uint32_t nodeIx=primitiveLeaves[changedPrimitives[i]]; nodeIx!=kInvalidIndex; nodeIx=parents[nodeIx])
+                {
+                    if (!refitNode(nodeIx,primitiveBoxes))
+                        break;
+                }
+            }
+        }
+
+        inline void clear()
+        {
+            nodes.clear();
+            primitiveIndices.clear();
+            parents.clear();
+            primitiveLeaves.clear();
+        }
+
+        inline bool empty() const {return nodes.empty();}
+
+        inline const vector<SNode>& getNodes() const {return nodes;}
+
+        //! Leaves reference consecutive slots of this array, which hold primitive indices.
+        inline const vector<uint32_t>& getPrimitiveIndices() const {return primitiveIndices;}
+
+        //! Visits leaves intersected by the ray, nearer children first.
+        /**
+        @param origin Ray origin.
+        @param reciprocalDirection Precise reciprocal of the ray direction.
+        @param maxT Nodes starting further than this are skipped, `leafFunc` may lower it to prune the rest of the traversal.
+        @param leafFunc Called as `leafFunc(firstSlot,slotCount)` for every leaf reached, slots index getPrimitiveIndices().
+        */
+        template<class LeafFunc>
+        inline void traverseRay(const vectorSIMDf& origin, const vectorSIMDf& reciprocalDirection, const float& maxT, LeafFunc&& leafFunc) const
+        {
+            if (nodes.empty())
+                return;
+
+            float tEntry;
+            if (!intersectNode(tEntry,nodes[0],origin,reciprocalDirection,maxT))
+                return;
+
+            struct SStackEntry
+            {
+                uint32_t node;
+                float tEntry;
+            };
+            SStackEntry stack[64];
+            uint32_t stackSize = 0u;
+            stack[stackSize++] = {0u,tEntry};
+            while (stackSize)
+            {
+                const SStackEntry entry = stack[--stackSize];
+                if (entry.tEntry>maxT)
+                    continue;
+
+                const SNode& node = nodes[entry.node];
+                if (node.isLeaf())
+                {
+                    leafFunc(node.firstPrimitiveOrRightChild,node.primitiveCount);
+                    continue;
+                }
+
+                const uint32_t left = entry.node+1u;
+                const uint32_t right = node.firstPrimitiveOrRightChild;
+                float tLeft,tRight;
+                const bool hitLeft = intersectNode(tLeft,nodes[left],origin,reciprocalDirection,maxT);
+                const bool hitRight = intersectNode(tRight,nodes[right],origin,reciprocalDirection,maxT);
+                if (hitLeft&&hitRight)
+                {
+                    if (tLeft<tRight)
+                    {
+                        stack[stackSize++] = {right,tRight};
+                        stack[stackSize++] = {left,tLeft};
+                    }
+                    else
+                    {
+                        stack[stackSize++] = {left,tLeft};
+                        stack[stackSize++] = {right,tRight};
+                    }
+                }
+                else if (hitLeft)
+                    stack[stackSize++] = {left,tLeft};
+                else if (hitRight)
+                    stack[stackSize++] = {right,tRight};
+                _IRR_DEBUG_BREAK_IF(stackSize>62u);
+            }
+        }
+
+        //! Visits leaves intersected by any active ray of the packet, all four rays are tested against a node at once.
+        /**
+        @param packet Rays to trace, `leafFunc` lowers `packet.maxT` lanes to prune the rest of the traversal.
+        @param activeMask Bit `i` set if lane `i` of the packet should be traced.
+        @param leafFunc Called as `leafFunc(firstSlot,slotCount,laneMask)` where `laneMask` has the rays that reached the leaf.
+        */
+        template<class LeafFunc>
+        inline void traversePacket(const SRayPacket4& packet, const uint32_t activeMask, LeafFunc&& leafFunc) const
+        {
+            if (nodes.empty() || !activeMask)
+                return;
+
+            uint32_t stack[64];
+            uint32_t stackSize = 0u;
+            stack[stackSize++] = 0u;
+            while (stackSize)
+            {
+                const uint32_t nodeIx = stack[--stackSize];
+                const SNode& node = nodes[nodeIx];
+                const uint32_t laneMask = packet.intersectBox(node.minEdge,node.maxEdge)&activeMask;
+                if (!laneMask)
+                    continue;
+
+                if (node.isLeaf())
+                {
+                    leafFunc(node.firstPrimitiveOrRightChild,node.primitiveCount,laneMask);
+                    continue;
+                }
+
+                // visit the child on the side the first active ray comes from first
+                const uint32_t firstLane = findLSB(laneMask);
+                const uint32_t left = nodeIx+1u;
+                const uint32_t right = node.firstPrimitiveOrRightChild;
+                const SNode& leftNode = nodes[left];
+                const SNode& rightNode = nodes[right];
+                uint32_t axis = 0u;
+                float separation = 0.f;
+                for (uint32_t a=0u; a<3u; a++)
+                {
+                    const float s = (leftNode.minEdge[a]+leftNode.maxEdge[a])-(rightNode.minEdge[a]+rightNode.maxEdge[a]);
+                    if (fabsf(s)>fabsf(separation))
+                    {
+                        separation = s;
+                        axis = a;
+                    }
+                }
+                const bool leftFirst = (separation<0.f)==(packet.direction[axis].pointer[firstLane]>=0.f);
+                stack[stackSize++] = leftFirst ? right:left;
+                stack[stackSize++] = leftFirst ? left:right;
+                _IRR_DEBUG_BREAK_IF(stackSize>62u);
+            }
+        }
+
+    private:
+        static inline SNode makeNode(const aabbox3df& box, const uint32_t firstPrimitive, const uint32_t primitiveCount)
+        {
+            SNode node;
+            for (uint32_t a=0u; a<3u; a++)
+            {
+                node.minEdge[a] = (&box.MinEdge.X)[a];
+                node.maxEdge[a] = (&box.MaxEdge.X)[a];
+            }
+            node.firstPrimitiveOrRightChild = firstPrimitive;
+            node.primitiveCount = primitiveCount;
+            return node;
+        }
+
+        static inline float getHalfArea(const aabbox3df& box)
+        {
+            const vector3df extent = box.getExtent();
+            return extent.X*extent.Y+extent.Y*extent.Z+extent.Z*extent.X;
+        }
+
+        static inline uint32_t findLSB(const uint32_t mask)
+        {
+            uint32_t lane = 0u;
+            while (!((mask>>lane)&1u))
+                lane++;
+            return lane;
+        }
+
+        //! @returns Whether the node's box changed
+        inline bool refitNode(const size_t nodeIx, const aabbox3df* primitiveBoxes)
+        {
+            SNode& node = nodes[nodeIx];
+            aabbox3df box;
+            if (node.isLeaf())
+            {
+                box = primitiveBoxes[primitiveIndices[node.firstPrimitiveOrRightChild]];
+                for (uint32_t i=1u; i<node.primitiveCount; i++)
+                    box.addInternalBox(primitiveBoxes[primitiveIndices[node.firstPrimitiveOrRightChild+i]]);
+            }
+            else
+            {
+                const SNode& left = nodes[nodeIx+1u];
+                const SNode& right = nodes[node.firstPrimitiveOrRightChild];
+                for (uint32_t a=0u; a<3u; a++)
+                {
+                    (&box.MinEdge.X)[a] = core::min_(left.minEdge[a],right.minEdge[a]);
+                    (&box.MaxEdge.X)[a] = core::max_(left.maxEdge[a],right.maxEdge[a]);
+                }
+            }
+
+            const SNode refitted = makeNode(box,node.firstPrimitiveOrRightChild,node.primitiveCount);
+            if (memcmp(&refitted,&node,sizeof(SNode))==0)
+                return false;
+            node = refitted;
+            return true;
+        }
+
+        static inline bool intersectNode(float& tEntry, const SNode& node, const vectorSIMDf& origin, const vectorSIMDf& reciprocalDirection, const float& maxT)
+        {
+            const vectorSIMDf t0 = (vectorSIMDf(node.minEdge)-origin)*reciprocalDirection;
+            const vectorSIMDf t1 = (vectorSIMDf(node.maxEdge)-origin)*reciprocalDirection;
+            const vectorSIMDf tNear = min_(t0,t1);
+            const vectorSIMDf tFar = max_(t0,t1);
+            tEntry = core::max_(core::max_(tNear.x,tNear.y),core::max_(tNear.z,0.f));
+            const float tExit = core::min_(core::min_(tFar.x,tFar.y),core::min_(tFar.z,maxT));
+            return tEntry<=tExit;
+        }
+
+        vector<SNode> nodes;
+        vector<uint32_t> primitiveIndices;
+        //! Parent of every node, for incremental refits
+        vector<uint32_t> parents;
+        //! Leaf of every primitive, for incremental refits
+        vector<uint32_t> primitiveLeaves;
+};
+
+
+}
+}
+
+#endif
@@ -1,9 +1,12 @@
 #ifndef __S_COLLISION_ENGINE_H_INCLUDED__
 #define __S_COLLISION_ENGINE_H_INCLUDED__
 
+#include <atomic>
+
 #include "irrlicht.h"
 #include "SCompoundCollider.h"
 #include "SViewFrustum.h"
+#include "irr/core/parallel_for.h"
 
 namespace irr
 {
@@ -13,8 +16,18 @@ namespace core
 class SCollisionEngine : public AllocationOverrideDefault
 {
         vector<SCompoundCollider*> colliders;
+        //! Over the world space boxes of `colliders`, only valid while `hierarchyNeedsRebuild` is false
+        SBoundingVolumeHierarchy hierarchy;
+        vector<aabbox3df> colliderBoxes;
+        vector<uint32_t> movedColliders;
+        size_t refitsSinceRebuild;
+        bool hierarchyNeedsRebuild;
+        uint32_t rayQueryThreadCount;
 
     public:
+		//! Default constructor.
+        SCollisionEngine() : refitsSinceRebuild(0), hierarchyNeedsRebuild(true), rayQueryThreadCount(1u) {}
+
 		//! Destructor.
         ~SCollisionEngine()
         {
@@ -114,6 +127,7 @@ class SCollisionEngine : public AllocationOverrideDefault
 
             collider->grab();
             colliders.insert(found,collider);
+            hierarchyNeedsRebuild = true;
         }
 
 		//! Removes collider pointed by `collider`
@@ -132,38 +146,234 @@ class SCollisionEngine : public AllocationOverrideDefault
 
 			(*found)->drop();
             colliders.erase(found);
+            hierarchyNeedsRebuild = true;
         }
 
 		//! Gets current amount of colliders
 		/** @rturns Current amount of colliders. */
         inline size_t getColliderCount() const { return colliders.size(); }
 
+		//! Sets how many threads the batched FastCollide spreads its rays over.
+		/** @param threadCount Amount of threads including the calling one, 0 means as many as there are hardware threads. The default is 1, like ISceneManager::setCullingThreadCount(). */
+        inline void setRayQueryThreadCount(const uint32_t& threadCount) { rayQueryThreadCount = threadCount; }
+
+		//! Gets the thread count set with setRayQueryThreadCount()
+        inline const uint32_t& getRayQueryThreadCount() const { return rayQueryThreadCount; }
+
+		//! Brings the hierarchy over the colliders up to date with the transformations of the nodes they are attached to.
+		/** Call after adding or removing colliders and whenever their nodes have moved, before issuing ray queries.
+		Until the first call after adding or removing colliders the queries test every collider.
+		Moved colliders only get refitted, the hierarchy is rebuilt once the refits could have degraded it. @see isHierarchyStale() */
+        inline void UpdateTransformation()
+        {
+            if (!hierarchyNeedsRebuild)
+            {
+                movedColliders.clear();
+                for (size_t i=0; i<colliders.size(); i++)
+                {
+                    const aabbox3df box = colliders[i]->getWorldBoundingBox();
+                    if (box==colliderBoxes[i])
+                        continue;
+
+                    colliderBoxes[i] = box;
+                    movedColliders.push_back(i);
+                }
+                hierarchy.refit(colliderBoxes.data(),movedColliders.data(),movedColliders.size());
+
+                refitsSinceRebuild += movedColliders.size();
+                if (refitsSinceRebuild<=colliders.size()*4)
+                    return;
+            }
+
+            colliderBoxes.resize(colliders.size());
+            for (size_t i=0; i<colliders.size(); i++)
+                colliderBoxes[i] = colliders[i]->getWorldBoundingBox();
+            // one compound collider per leaf, testing one is as expensive as a few box tests already
+            hierarchy.build(colliderBoxes.data(),colliderBoxes.size(),1u);
+            refitsSinceRebuild = 0;
+            hierarchyNeedsRebuild = false;
+        }
+
+		//! Whether any collider was added, removed or moved since the last UpdateTransformation()
+		/** Costs one world bounding box computation per collider, as much as UpdateTransformation() does when nothing moved. */
+        inline bool isHierarchyStale() const
+        {
+            if (hierarchyNeedsRebuild)
+                return true;
+            for (size_t i=0; i<colliders.size(); i++)
+            {
+                if (!(colliders[i]->getWorldBoundingBox()==colliderBoxes[i]))
+                    return true;
+            }
+            return false;
+        }
+
 		//! Performs collision test with a given ray defined by `origin`, `direction` and `maxRayLen` parameters
 		/**
 		@param[out] hitPointObjectData Data of collider with which the collision occured. Does not get touched if no collision occured.
-		@param[out] collisionDistance If no collision occured - gets value of `maxRayLen` parameter. Otherwise - ???
+		@param[out] collisionDistance If no collision occured - gets value of `maxRayLen` parameter. Otherwise - distance along the ray to the closest hit.
 		@param[in] origin Start point point of the input ray
 		@param[in] direction Normalized vector denoting direction of the input ray
 		@param[in] maxRayLen Length of the input ray
+		The hierarchy is not checked against the nodes' current transformations (that would cost as much as testing every collider),
+		so UpdateTransformation() must have been called since the nodes colliders are attached to last moved, otherwise moved colliders can be missed.
 		*/
         inline bool FastCollide(SColliderData& hitPointObjectData, float &collisionDistance, const vectorSIMDf& origin, const vectorSIMDf& direction, const float& maxRayLen=FLT_MAX) const
         {
+            _IRR_DEBUG_BREAK_IF(!hierarchyNeedsRebuild && isHierarchyStale())
             bool retval = false;
 
             collisionDistance = maxRayLen;
-            for (size_t i=0; i<colliders.size(); i++)
+            auto collideWith = [&](const SCompoundCollider* collider) -> void
             {
                 float tmpDist;
-                if (colliders[i]->CollideWithRay(tmpDist,origin,direction,collisionDistance)&&tmpDist<collisionDistance)
+                if (collider->CollideWithRay(tmpDist,origin,direction,collisionDistance)&&tmpDist<collisionDistance)
                 {
                     collisionDistance = tmpDist;
-                    hitPointObjectData = colliders[i]->getColliderData();
+                    hitPointObjectData = collider->getColliderData();
                     retval = true;
                 }
+            };
+
+            if (hierarchyNeedsRebuild)
+            {
+                for (size_t i=0; i<colliders.size(); i++)
+                    collideWith(colliders[i]);
+                return retval;
             }
 
+            const vector<uint32_t>& colliderIndices = hierarchy.getPrimitiveIndices();
+            hierarchy.traverseRay(origin,vectorSIMDf(1.f).preciseDivision(direction),collisionDistance,[&](const uint32_t firstSlot, const uint32_t slotCount) -> void
+            {
+                for (uint32_t i=firstSlot; i<firstSlot+slotCount; i++)
+                    collideWith(colliders[colliderIndices[i]]);
+            });
+
             return retval;
         }
+
+		//! Performs collision test with a packet of four rays at once, same as calling the single ray FastCollide four times.
+		/**
+		@param[out] hitPointObjectData Array of four, data of the collider each ray hit. Entries of rays that hit nothing do not get touched.
+		@param[out] collisionDistance Array of four, distance to the closest hit or `maxRayLen` of the ray if it hit nothing.
+		@param[in] origin Array of four ray start points.
+		@param[in] direction Array of four normalized ray directions.
+		@param[in] maxRayLen Array of four ray lengths.
+		@returns Mask with bit `i` set if the i-th ray hit anything.
+		Like the single ray FastCollide, requires UpdateTransformation() to have been called since the nodes last moved.
+		*/
+        inline uint32_t FastCollidePacket(SColliderData* hitPointObjectData, float* collisionDistance, const vectorSIMDf* origin, const vectorSIMDf* direction, const float* maxRayLen) const
+        {
+            _IRR_DEBUG_BREAK_IF(!hierarchyNeedsRebuild && isHierarchyStale())
+            return collidePacket(hitPointObjectData,collisionDistance,origin,direction,maxRayLen,!hierarchyNeedsRebuild);
+        }
+
+		//! Performs collision tests with many rays at once, same results as calling the single ray FastCollide for each of them.
+		/** The rays get grouped by the octant of their direction, traced four at a time with FastCollidePacket
+		and spread over getRayQueryThreadCount() threads. The nodes colliders are attached to must not change during the call.
+		Unlike the single ray queries this one checks whether colliders moved since the last UpdateTransformation() (see isHierarchyStale(),
+		the cost gets spread over all the rays) and if so tests every collider instead of using the stale hierarchy.
+		@param[out] hitPointObjectData Array of `rayCount`, data of the collider each ray hit. Entries of rays that hit nothing do not get touched.
+		@param[out] collisionDistance Array of `rayCount`, distance to the closest hit or `maxRayLen` of the ray if it hit nothing.
+		@param[in] origin Array of `rayCount` ray start points.
+		@param[in] direction Array of `rayCount` normalized ray directions.
+		@param[in] maxRayLen Array of `rayCount` ray lengths.
+		@param[in] rayCount Amount of rays.
+		@returns Amount of rays that hit anything.
+		*/
+        inline size_t FastCollide(SColliderData* hitPointObjectData, float* collisionDistance, const vectorSIMDf* origin, const vectorSIMDf* direction, const float* maxRayLen, const size_t rayCount) const
+        {
+            if (!rayCount)
+                return 0u;
+
+            const bool useHierarchy = !isHierarchyStale();
+            // counting sort by octant, so that the rays of a packet go through the same children first
+            vector<uint32_t> sortedRays(rayCount);
+            {
+                auto getOctant = [&](const size_t ray) -> uint32_t
+                {
+                    return (direction[ray].X<0.f ? 0x1u:0u)|(direction[ray].Y<0.f ? 0x2u:0u)|(direction[ray].Z<0.f ? 0x4u:0u);
+                };
+                size_t octantOffsets[9] = {};
+                for (size_t i=0; i<rayCount; i++)
+                    octantOffsets[getOctant(i)+1u]++;
+                for (uint32_t octant=1u; octant<8u; octant++)
+                    octantOffsets[octant] += octantOffsets[octant-1u];
+                for (size_t i=0; i<rayCount; i++)
+                    sortedRays[octantOffsets[getOctant(i)]++] = i;
+            }
+
+            std::atomic<size_t> hitCount(0u);
+            auto tracePacket = [&](const size_t packetIx) -> void
+            {
+                // the last packet gets padded with copies of the last ray
+                const size_t laneCount = core::min_<size_t>(rayCount-packetIx*4u,4u);
+                uint32_t rays[4];
+                vectorSIMDf packetOrigin[4], packetDirection[4];
+                float packetMaxRayLen[4];
+                for (uint32_t lane=0u; lane<4u; lane++)
+                {
+                    rays[lane] = sortedRays[packetIx*4u+core::min_<size_t>(lane,laneCount-1u)];
+                    packetOrigin[lane] = origin[rays[lane]];
+                    packetDirection[lane] = direction[rays[lane]];
+                    packetMaxRayLen[lane] = maxRayLen[rays[lane]];
+                }
+
+                SColliderData packetData[4];
+                float packetDistance[4];
+                const uint32_t hitMask = collidePacket(packetData,packetDistance,packetOrigin,packetDirection,packetMaxRayLen,useHierarchy);
+                size_t packetHits = 0u;
+                for (uint32_t lane=0u; lane<laneCount; lane++)
+                {
+                    collisionDistance[rays[lane]] = packetDistance[lane];
+                    if ((hitMask>>lane)&1u)
+                    {
+                        hitPointObjectData[rays[lane]] = packetData[lane];
+                        packetHits++;
+                    }
+                }
+                hitCount += packetHits;
+            };
+            core::parallel_for(rayQueryThreadCount,size_t(0u),(rayCount+3u)/4u,tracePacket,size_t(16u));
+
+            return hitCount;
+        }
+
+    private:
+        inline uint32_t collidePacket(SColliderData* hitPointObjectData, float* collisionDistance, const vectorSIMDf* origin, const vectorSIMDf* direction, const float* maxRayLen, const bool useHierarchy) const
+        {
+            SRayPacket4 packet(origin,direction,maxRayLen);
+            uint32_t hitMask = 0u;
+            auto collideWith = [&](const SCompoundCollider* collider, const uint32_t laneMask) -> void
+            {
+                const uint32_t colliderHitMask = collider->CollideWithRayPacket(packet,laneMask);
+                for (uint32_t lane=0u; lane<4u; lane++)
+                {
+                    if ((colliderHitMask>>lane)&1u)
+                        hitPointObjectData[lane] = collider->getColliderData();
+                }
+                hitMask |= colliderHitMask;
+            };
+
+            if (!useHierarchy)
+            {
+                for (size_t i=0; i<colliders.size(); i++)
+                    collideWith(colliders[i],0xfu);
+            }
+            else
+            {
+                const vector<uint32_t>& colliderIndices = hierarchy.getPrimitiveIndices();
+                hierarchy.traversePacket(packet,0xfu,[&](const uint32_t firstSlot, const uint32_t slotCount, const uint32_t laneMask) -> void
+                {
+                    for (uint32_t i=firstSlot; i<firstSlot+slotCount; i++)
+                        collideWith(colliders[colliderIndices[i]],laneMask);
+                });
+            }
+
+            for (uint32_t lane=0u; lane<4u; lane++)
+                collisionDistance[lane] = packet.maxT.pointer[lane];
+            return hitMask;
+        }
 };
 
 }
@@ -130,12 +130,46 @@ class SCompoundCollider : public IReferenceCounted
             return coll;
         }
 
+		//! Gets the transformation from the collider's space to world space.
+		/** @returns false if the collider is attached to a node whose transformation cannot be inverted. */
+        inline bool getWorldTransform(matrix4x3& outTransform) const
+        {
+            if (!colliderData.attachedNode)
+            {
+                outTransform = matrix4x3();
+                return true;
+            }
+
+            outTransform = colliderData.attachedNode->getAbsoluteTransformation();
+            switch (colliderData.attachedNode->getType())
+            {
+                case scene::ESNT_MESH_INSTANCED:
+                    outTransform = concatenateBFollowedByA(outTransform,static_cast<scene::IMeshSceneNodeInstanced*>(colliderData.attachedNode)->getInstanceTransform(colliderData.instanceID));
+                    break;
+                ///case ESNT_INSTANCED_ANIMATED_MESH:
+                default:
+                    break;
+            }
+            matrix4x3 dummy;
+            return outTransform.getInverse(dummy);
+        }
+
+		//! Gets the collider's bounding box in world space, used by SCollisionEngine's hierarchy.
+        inline aabbox3df getWorldBoundingBox() const
+        {
+            aabbox3df box = BBox.Box;
+            matrix4x3 worldTransform;
+            if (getWorldTransform(worldTransform))
+                worldTransform.transformBoxEx(box);
+            return box;
+        }
+
 		//! Performs collision test with given ray.
 		/**
-		@param[out] collisionDistance Distance between collider and ray.
+		@param[out] collisionDistance Ray parameter of the closest hit with any of the shapes, untouched if nothing was hit.
 		@param[in] origin Attachment point of the ray.
 		@param[in] direction Normalized drection vector of the ray.
-		@param[in] dirMaxMultiplier
+		@param[in] dirMaxMultiplier Only hits closer than `origin+direction*dirMaxMultiplier` count.
 		*/
         inline bool CollideWithRay(float& collisionDistance, vectorSIMDf origin, vectorSIMDf direction, const float& dirMaxMultiplier) const
         {
@@ -170,7 +204,8 @@ class SCompoundCollider : public IReferenceCounted
                 }
             }
 
-            vectorSIMDf direction_reciprocal = reciprocal(direction);
+            // precise, the triangle mesh hierarchies get walked with it
+            vectorSIMDf direction_reciprocal = vectorSIMDf(1.f).preciseDivision(direction);
             float dummyPosition;
             if (!BBox.CollideWithRay(dummyPosition,origin,direction,dirMaxMultiplier,direction_reciprocal))
             {
@@ -178,44 +213,123 @@ class SCompoundCollider : public IReferenceCounted
             }
 
 
+            bool retval = false;
+            float closest = dirMaxMultiplier;
             for (size_t i=0; i<Shapes.size(); i++)
             {
+                float tmpDist;
+                bool hit = false;
                 switch (Shapes[i].objectType)
                 {
                     case SCollisionShapeDef::ECST_AABOX:
                         {
                             SAABoxCollider* tmp = static_cast<SAABoxCollider*>(Shapes[i].object);
-                            if (tmp->CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier,direction_reciprocal))
-                                return true;
+                            hit = tmp->CollideWithRay(tmpDist,origin,direction,closest,direction_reciprocal);
                         }
                         break;
                     case SCollisionShapeDef::ECST_ELLIPSOID:
                         {
                             SEllipsoidCollider* tmp = static_cast<SEllipsoidCollider*>(Shapes[i].object);
-                            if (tmp->CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier))
-                                return true;
+                            hit = tmp->CollideWithRay(tmpDist,origin,direction,closest);
                         }
                         break;
                     case SCollisionShapeDef::ECST_TRIANGLE:
                         {
                             STriangleCollider* tmp = static_cast<STriangleCollider*>(Shapes[i].object);
-                            if (tmp->CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier))
-                                return true;
+                            hit = tmp->CollideWithRay(tmpDist,origin,direction,closest);
                         }
                         break;
                     case SCollisionShapeDef::ECST_TRIANGLE_MESH:
                         {
                             STriangleMeshCollider* tmp = static_cast<STriangleMeshCollider*>(Shapes[i].object);
-                            if (tmp->CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier))
-                                return true;
+                            hit = tmp->CollideWithRay(tmpDist,origin,direction,closest,direction_reciprocal);
                         }
                         break;
                     case SCollisionShapeDef::ECST_COUNT:
                         assert(0);
                         break;
                 }
+                if (hit && tmpDist<closest)
+                {
+                    closest = tmpDist;
+                    retval = true;
+                }
+            }
+
+            if (retval)
+                collisionDistance = closest;
+            return retval;
+        }
+
+		//! Performs collision test with every active ray of the packet, each ray's closest hit is kept.
+		/**
+		@param packet Rays in world space, the distance of a hit is written to the ray's lane of `packet.maxT`.
+		@param activeMask Bit `i` set if lane `i` of the packet should be tested.
+		@returns Mask of the lanes that hit the collider.
+		*/
+        inline uint32_t CollideWithRayPacket(SRayPacket4& packet, uint32_t activeMask) const
+        {
+            SRayPacket4 localPacket = packet;
+            if (colliderData.attachedNode)
+            {
+                matrix4x3 worldTransform, inverseTransform;
+                if (!getWorldTransform(worldTransform))
+                    return 0u;
+                worldTransform.getInverse(inverseTransform);
+                localPacket.transform(inverseTransform);
+            }
+
+            activeMask &= localPacket.intersectBox(&BBox.Box.MinEdge.X,&BBox.Box.MaxEdge.X);
+            if (!activeMask)
+                return 0u;
+
+            uint32_t hitMask = 0u;
+            for (size_t i=0; i<Shapes.size(); i++)
+            {
+                switch (Shapes[i].objectType)
+                {
+                    case SCollisionShapeDef::ECST_TRIANGLE:
+                        hitMask |= static_cast<STriangleCollider*>(Shapes[i].object)->CollideWithRayPacket(localPacket,activeMask);
+                        break;
+                    case SCollisionShapeDef::ECST_TRIANGLE_MESH:
+                        hitMask |= static_cast<STriangleMeshCollider*>(Shapes[i].object)->CollideWithRayPacket(localPacket,activeMask);
+                        break;
+                    case SCollisionShapeDef::ECST_COUNT:
+                        assert(0);
+                        break;
+                    default: // no packet tests for these, go ray by ray
+                        for (uint32_t lane=0u; lane<4u; lane++)
+                        {
+                            if (!((activeMask>>lane)&1u))
+                                continue;
+
+                            vectorSIMDf origin,direction;
+                            localPacket.getRay(origin,direction,lane);
+                            float tmpDist;
+                            bool hit;
+                            if (Shapes[i].objectType==SCollisionShapeDef::ECST_AABOX)
+                            {
+                                const vectorSIMDf direction_reciprocal = vectorSIMDf(1.f).preciseDivision(direction);
+                                hit = static_cast<SAABoxCollider*>(Shapes[i].object)->CollideWithRay(tmpDist,origin,direction,localPacket.maxT.pointer[lane],direction_reciprocal);
+                            }
+                            else
+                                hit = static_cast<SEllipsoidCollider*>(Shapes[i].object)->CollideWithRay(tmpDist,origin,direction,localPacket.maxT.pointer[lane]);
+                            if (hit && tmpDist<localPacket.maxT.pointer[lane])
+                            {
+                                localPacket.maxT.pointer[lane] = tmpDist;
+                                hitMask |= 0x1u<<lane;
+                            }
+                        }
+                        break;
+                }
+            }
+
+            for (uint32_t lane=0u; lane<4u; lane++)
+            {
+                if ((hitMask>>lane)&1u)
+                    packet.maxT.pointer[lane] = localPacket.maxT.pointer[lane];
             }
-            return false;
+            return hitMask;
         }
 
 		inline size_t getShapeCount() const { return Shapes.size(); }
@@ -2,6 +2,7 @@
 #define __S_TRIANGLE_MESH_COLLIDER_H_INCLUDED__
 
 #include "SAABoxCollider.h"
+#include "SBoundingVolumeHierarchy.h"
 #include "irr/core/IReferenceCounted.h"
 
 namespace irr
@@ -21,34 +22,32 @@ class STriangleCollider// : public AllocationOverrideDefault EBO inheritance pro
                 validTriangle = false;
                 return;
             }
-            boundaryPlanes[0] = cross(normal,B-A);
-            boundaryPlanes[1] = cross(C-A,normal);
-
-            planeEq.W = dot(planeEq,A).X;
-            boundaryPlanes[0].W = dot(boundaryPlanes[0],A).X;
-            boundaryPlanes[1].W = dot(boundaryPlanes[1],A).X;
+            // scaled so that the planes give the barycentric coordinates of C and B
+            const float normalLen2 = dot(normal,normal).X;
+            boundaryPlanes[0] = cross(normal,B-A)*(1.f/normalLen2);
+            boundaryPlanes[1] = cross(C-A,normal)*(1.f/normalLen2);
+
+            planeEq.W = dot3(planeEq,A);
+            boundaryPlanes[0].W = dot3(boundaryPlanes[0],A);
+            boundaryPlanes[1].W = dot3(boundaryPlanes[1],A);
             validTriangle = true;
         }
 
         inline bool CollideWithRay(float& collisionDistance, const vectorSIMDf& origin, const vectorSIMDf& direction, const float& dirMaxMultiplier) const
         {
-            float NdotD = dot(direction,planeEq).X;
-            if (NdotD!=0.f)
+            float NdotD = dot3(direction,planeEq);
+            if (NdotD==0.f)
                 return false;
 
-            float NdotOrigin = -dot(origin,planeEq).X;
-            float d = planeEq.W;
-
-            float t = (NdotOrigin-d)/NdotD;
+            float t = (planeEq.W-dot3(origin,planeEq))/NdotD;
             if (t>=dirMaxMultiplier||t<0.f)
                 return false;
 
             vectorSIMDf outPoint = origin+direction*t;
 
-            vectorSIMDf extraComponent(0.f,0.f,0.f,1.f);
-            vectorSIMDf outPointW1 = outPoint|reinterpret_cast<const vectorSIMDu32&>(extraComponent);
-
-            if (dot(outPointW1,boundaryPlanes[0]).X>=0.f&&dot(outPointW1,boundaryPlanes[1]).X>=0.f)
+            const float u = dot3(outPoint,boundaryPlanes[0])-boundaryPlanes[0].W;
+            const float v = dot3(outPoint,boundaryPlanes[1])-boundaryPlanes[1].W;
+            if (u>=0.f&&v>=0.f&&u+v<=1.f)
             {
                 collisionDistance = t;
                 return true;
@@ -57,8 +56,41 @@ class STriangleCollider// : public AllocationOverrideDefault EBO inheritance pro
                 return false;
         }
 
+        //! Same test as CollideWithRay for all active rays of the packet at once.
+        /** @returns Mask of the lanes that hit, their distance is written to the lane of `packet.maxT`. */
+        inline uint32_t CollideWithRayPacket(SRayPacket4& packet, const uint32_t activeMask) const
+        {
+            const vectorSIMDf NdotD = packet.direction[0]*planeEq.X+packet.direction[1]*planeEq.Y+packet.direction[2]*planeEq.Z;
+            const vectorSIMDf NdotOrigin = packet.origin[0]*planeEq.X+packet.origin[1]*planeEq.Y+packet.origin[2]*planeEq.Z;
+            // parallel rays end up with infinite or NaN `t` and fail the range test
+            const vectorSIMDf t = (vectorSIMDf(planeEq.W)-NdotOrigin).preciseDivision(NdotD);
+
+            vectorSIMDf outPoint[3];
+            for (uint32_t a=0u; a<3u; a++)
+                outPoint[a] = packet.origin[a]+packet.direction[a]*t;
+            const vectorSIMDf u = outPoint[0]*boundaryPlanes[0].X+outPoint[1]*boundaryPlanes[0].Y+outPoint[2]*boundaryPlanes[0].Z-vectorSIMDf(boundaryPlanes[0].W);
+            const vectorSIMDf v = outPoint[0]*boundaryPlanes[1].X+outPoint[1]*boundaryPlanes[1].Y+outPoint[2]*boundaryPlanes[1].Z-vectorSIMDf(boundaryPlanes[1].W);
+
+            const vectorSIMDf zero(0.f);
+            const vector4db_SIMD hit = (t>=zero)&(t<packet.maxT)&(u>=zero)&(v>=zero)&((u+v)<=vectorSIMDf(1.f));
+            const uint32_t hitMask = _mm_movemask_ps(_mm_castsi128_ps(hit.getAsRegister()))&activeMask;
+            for (uint32_t i=0u; i<4u; i++)
+            {
+                if ((hitMask>>i)&1u)
+                    packet.maxT.pointer[i] = t.pointer[i];
+            }
+            return hitMask;
+        }
+
         vectorSIMDf planeEq;
         vectorSIMDf boundaryPlanes[2];
+
+    private:
+        //! the W components hold plane distances, so they have to stay out of the dot products
+        static inline float dot3(const vectorSIMDf& a, const vectorSIMDf& b)
+        {
+            return a.X*b.X+a.Y*b.Y+a.Z*b.Z;
+        }
 };
 
 
@@ -69,7 +101,9 @@ class STriangleMeshCollider : public IReferenceCounted
         SAABoxCollider BBox;
         ///matrix4x3 cachedTransformInverse;
         ///matrix4x3 cachedTransform;
+        //! Stored in the order the hierarchy's leaves reference them
         vector<STriangleCollider> triangles;
+        SBoundingVolumeHierarchy hierarchy;
     public:
         STriangleMeshCollider() : BBox(core::aabbox3df()) {}
 
@@ -78,8 +112,15 @@ class STriangleMeshCollider : public IReferenceCounted
 
         inline size_t getTriangleCount() const {return triangles.size();}
 
+        inline const SBoundingVolumeHierarchy& getHierarchy() const {return hierarchy;}
+
         inline bool Init(float* vertices, const size_t &indexCount, uint32_t* indices=NULL)
         {
+            // the bounding box gets reset anyway, so start over with the triangles too
+            triangles.clear();
+            vector<aabbox3df> triangleBoxes;
+            triangleBoxes.reserve(indexCount/3);
+
             bool firstPoint = true;
             if (indices)
             {
@@ -103,6 +144,11 @@ class STriangleMeshCollider : public IReferenceCounted
                         BBox.Box.addInternalPoint(B.getAsVector3df());
                         BBox.Box.addInternalPoint(C.getAsVector3df());
                         triangles.push_back(triangle);
+
+                        aabbox3df triangleBox(A.getAsVector3df());
+                        triangleBox.addInternalPoint(B.getAsVector3df());
+                        triangleBox.addInternalPoint(C.getAsVector3df());
+                        triangleBoxes.push_back(triangleBox);
                     }
                 }
             }
@@ -128,31 +174,75 @@ class STriangleMeshCollider : public IReferenceCounted
                         BBox.Box.addInternalPoint(B.getAsVector3df());
                         BBox.Box.addInternalPoint(C.getAsVector3df());
                         triangles.push_back(triangle);
+
+                        aabbox3df triangleBox(A.getAsVector3df());
+                        triangleBox.addInternalPoint(B.getAsVector3df());
+                        triangleBox.addInternalPoint(C.getAsVector3df());
+                        triangleBoxes.push_back(triangleBox);
                     }
                 }
             }
 
+            // leaves of a few triangles, the triangle tests are about as cheap as the box tests
+            hierarchy.build(triangleBoxes.data(),triangles.size(),4u);
+            vector<STriangleCollider> sortedTriangles(triangles.size());
+            for (size_t i=0; i<triangles.size(); i++)
+                sortedTriangles[i] = triangles[hierarchy.getPrimitiveIndices()[i]];
+            triangles.swap(sortedTriangles);
+
             return triangles.size();
         }
 
+		//! Finds the closest triangle hit by the ray.
+		/**
+		@param[out] collisionDistance Ray parameter of the closest hit, untouched if nothing was hit.
+		@param[in] origin Start point of the ray.
+		@param[in] direction Direction of the ray, does not need to be normalized.
+		@param[in] dirMaxMultiplier Only hits closer than `origin+direction*dirMaxMultiplier` count.
+		*/
         inline bool CollideWithRay(float& collisionDistance, const vectorSIMDf& origin, const vectorSIMDf& direction, const float& dirMaxMultiplier) const
         {
-            return CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier,reciprocal(direction));
+            return CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier,vectorSIMDf(1.f).preciseDivision(direction));
         }
 
+		//! Same as above, `direction_reciprocal` has to be precise as it is used to walk the hierarchy.
         inline bool CollideWithRay(float& collisionDistance, const vectorSIMDf& origin, const vectorSIMDf& direction, const float& dirMaxMultiplier, const vectorSIMDf& direction_reciprocal) const
         {
-            float dummyDist;
-            if (!BBox.CollideWithRay(dummyDist,origin,direction,dirMaxMultiplier,direction_reciprocal))
-                return false;
-
-            for (size_t i=0; i<triangles.size(); i++)
+            bool retval = false;
+            float closest = dirMaxMultiplier;
+            hierarchy.traverseRay(origin,direction_reciprocal,closest,[&](const uint32_t firstTriangle, const uint32_t triangleCount) -> void
             {
-                if (triangles[i].CollideWithRay(collisionDistance,origin,direction,dirMaxMultiplier))
-                    return true;
-            }
+                for (uint32_t i=firstTriangle; i<firstTriangle+triangleCount; i++)
+                {
+                    float tmpDist;
+                    if (triangles[i].CollideWithRay(tmpDist,origin,direction,closest))
+                    {
+                        closest = tmpDist;
+                        retval = true;
+                    }
+                }
+            });
 
-            return false;
+            if (retval)
+                collisionDistance = closest;
+            return retval;
+        }
+
+		//! Finds the closest triangle for every active ray of the packet.
+		/**
+		@param packet Rays to test, the distance of a hit is written to the ray's lane of `packet.maxT`.
+		@param activeMask Bit `i` set if lane `i` of the packet should be tested.
+		@returns Mask of the lanes that hit a triangle.
+		*/
+        inline uint32_t CollideWithRayPacket(SRayPacket4& packet, const uint32_t activeMask) const
+        {
+            uint32_t hitMask = 0u;
+            hierarchy.traversePacket(packet,activeMask,[&](const uint32_t firstTriangle, const uint32_t triangleCount, const uint32_t laneMask) -> void
+            {
+                for (uint32_t i=firstTriangle; i<firstTriangle+triangleCount; i++)
+                    hitMask |= triangles[i].CollideWithRayPacket(packet,laneMask);
+            });
+            return hitMask;
         }
 /**
         inline bool UpdateTransformation(const matrix4x3& newTransform)
@@ -7,10 +7,15 @@
 
 #include "vectorSIMD.h"
 #include "irr/video/IGPUMeshBuffer.h"
+#include "IReadFile.h"
+#include "IWriteFile.h"
 #include <vector>
 #include <fstream>
 #include <iterator>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
 
 namespace irr
 {
@@ -52,11 +57,227 @@ namespace asset
 
 	using QuantizationCacheEntryHalfFloat = QuantizationCacheEntry16_16_16;
 
+	//! Insert-only hash map from normals to their quantized values, safe to use from any amount of threads at once.
+	/** Lock-free for writers, readers spin while a slot is being published (so does an insertion probing past that slot), which takes the writer just a few stores.
+	The map is a list of open addressing tables, each twice as big as the previous one,
+	new entries go to the newest table and a new one is added (under a lock, rarely) once it gets half full.
+	Entries never move, so a lookup probes each table at most until the first empty slot.
+	Normals are compared bit by bit on X, Y and Z. Two threads inserting the same normal at once may both store it, which is harmless.
+	The file format of loadFromFile and saveToFile is a plain array of `CacheEntry`, as the caches used to be dumped. */
+	template<class CacheEntry>
+	class QuantizationCache
+	{
+		public:
+			using value_type = decltype(CacheEntry::value);
+
+			QuantizationCache() : tableCount(0u) {}
+			~QuantizationCache() { clear(); }
+
+			//! @returns whether `normal` is in the cache, in which case `outValue` gets its quantized value.
+			inline bool find(value_type& outValue, const core::vectorSIMDf& normal) const
+			{
+				SKey key(normal);
+				const size_t hash = key.hash();
+				for (uint32_t i=tableCount.load(std::memory_order_acquire); i--; )
+				{
+					const STable* table = tables[i].load(std::memory_order_acquire);
+					for (size_t j=hash&table->mask; true; j=(j+1u)&table->mask)
+					{
+						const SSlot& slot = table->slots[j];
+						uint32_t state = slot.state.load(std::memory_order_acquire);
+						if (state==ESS_EMPTY)
+							break;
+						while (state==ESS_BUSY) // the writer only has a few stores left
+							state = slot.state.load(std::memory_order_acquire);
+
+						if (slot.key==key)
+						{
+							outValue = slot.value;
+							return true;
+						}
+					}
+				}
+				return false;
+			}
+
+			inline void insert(const core::vectorSIMDf& normal, const value_type& value)
+			{
+				SKey key(normal);
+				const size_t hash = key.hash();
+				while (true)
+				{
+					STable* table = getTableForInsertion();
+					for (size_t j=hash&table->mask; table->size.load(std::memory_order_relaxed)<=table->mask/2u; j=(j+1u)&table->mask)
+					{
+						SSlot& slot = table->slots[j];
+						uint32_t state = slot.state.load(std::memory_order_acquire);
+						if (state==ESS_EMPTY)
+						{
+							if (!slot.state.compare_exchange_strong(state,ESS_BUSY,std::memory_order_acquire))
+							{
+								j = (j-1u)&table->mask; // someone else took it, look at what they put there
+								continue;
+							}
+							slot.key = key;
+							slot.value = value;
+							slot.state.store(ESS_READY,std::memory_order_release);
+							table->size.fetch_add(1u,std::memory_order_relaxed);
+							return;
+						}
+						while (state==ESS_BUSY)
+							state = slot.state.load(std::memory_order_acquire);
+						if (slot.key==key)
+							return;
+					}
+					// got half full while probing, try again in the next table
+				}
+			}
+
+			//! Amount of cached normals.
+			inline size_t size() const
+			{
+				size_t retval = 0u;
+				for (uint32_t i=tableCount.load(std::memory_order_acquire); i--; )
+					retval += tables[i].load(std::memory_order_acquire)->size.load(std::memory_order_relaxed);
+				return retval;
+			}
+
+			//! Empties the cache, must not run concurrently with anything else.
+			inline void clear()
+			{
+				for (uint32_t i=0u; i<tableCount.load(std::memory_order_relaxed); i++)
+				{
+					STable* table = tables[i].load(std::memory_order_relaxed);
+					delete [] table->slots;
+					delete table;
+					tables[i].store(nullptr,std::memory_order_relaxed);
+				}
+				tableCount.store(0u,std::memory_order_release);
+			}
+
+			//! Adds the entries stored in `file` to the cache.
+			/** @returns false if the file does not hold whole entries. */
+			inline bool loadFromFile(io::IReadFile* file)
+			{
+				if (!file || file->getSize()%sizeof(CacheEntry))
+					return false;
+
+				core::vector<CacheEntry> entries(file->getSize()/sizeof(CacheEntry));
+				if (file->read(entries.data(),entries.size()*sizeof(CacheEntry))!=entries.size()*sizeof(CacheEntry))
+					return false;
+				for (const auto& entry : entries)
+					insert(entry.key,entry.value);
+				return true;
+			}
+
+			//! Writes all the entries to `file`, entries inserted while saving might be missing.
+			inline bool saveToFile(io::IWriteFile* file) const
+			{
+				if (!file)
+					return false;
+
+				core::vector<CacheEntry> entries;
+				entries.reserve(size());
+				for (uint32_t i=0u; i<tableCount.load(std::memory_order_acquire); i++)
+				{
+					const STable* table = tables[i].load(std::memory_order_acquire);
+					for (size_t j=0u; j<=table->mask; j++)
+					{
+						if (table->slots[j].state.load(std::memory_order_acquire)!=ESS_READY)
+							continue;
+
+						CacheEntry entry;
+						entry.key = core::vectorSIMDf(0.f);
+						memcpy(entry.key.pointer,table->slots[j].key.bits,sizeof(SKey::bits));
+						entry.value = table->slots[j].value;
+						entries.push_back(entry);
+					}
+				}
+				return file->write(entries.data(),entries.size()*sizeof(CacheEntry))==int32_t(entries.size()*sizeof(CacheEntry));
+			}
+
+		private:
+			enum E_SLOT_STATE : uint32_t
+			{
+				ESS_EMPTY=0u,
+				ESS_BUSY,
+				ESS_READY
+			};
+
+			struct SKey
+			{
+				SKey() {}
+				SKey(const core::vectorSIMDf& normal) { memcpy(bits,normal.pointer,sizeof(bits)); }
+
+				inline bool operator==(const SKey& other) const { return bits[0]==other.bits[0]&&bits[1]==other.bits[1]&&bits[2]==other.bits[2]; }
+
+				inline size_t hash() const
+				{
+					uint64_t h = (uint64_t(bits[0])|(uint64_t(bits[1])<<32u))*0x9e3779b97f4a7c15ull;
+					h ^= (uint64_t(bits[2])+(h>>29u))*0xbf58476d1ce4e5b9ull;
+					return h^(h>>32u);
+				}
+
+				uint32_t bits[3];
+			};
+
+			struct SSlot
+			{
+				std::atomic<uint32_t> state;
+				SKey key;
+				value_type value;
+			};
+
+			struct STable
+			{
+				SSlot* slots;
+				size_t mask;
+				std::atomic<size_t> size;
+			};
+
+			_IRR_STATIC_INLINE_CONSTEXPR size_t kFirstTableSize = 1024u;
+			_IRR_STATIC_INLINE_CONSTEXPR uint32_t kMaxTables = 32u;
+
+			inline STable* getTableForInsertion()
+			{
+				uint32_t count = tableCount.load(std::memory_order_acquire);
+				if (count)
+				{
+					STable* newest = tables[count-1u].load(std::memory_order_acquire);
+					if (newest->size.load(std::memory_order_relaxed)<=newest->mask/2u)
+						return newest;
+				}
+
+				std::lock_guard<std::mutex> lock(growMutex);
+				count = tableCount.load(std::memory_order_acquire);
+				if (count)
+				{
+					STable* newest = tables[count-1u].load(std::memory_order_acquire);
+					if (newest->size.load(std::memory_order_relaxed)<=newest->mask/2u)
+						return newest;
+				}
+				_IRR_DEBUG_BREAK_IF(count>=kMaxTables);
+
+				const size_t slotCount = kFirstTableSize<<count;
+				STable* table = new STable();
+				table->slots = new SSlot[slotCount]();
+				table->mask = slotCount-1u;
+				table->size.store(0u,std::memory_order_relaxed);
+				tables[count].store(table,std::memory_order_release);
+				tableCount.store(count+1u,std::memory_order_release);
+				return table;
+			}
+
+			std::atomic<STable*> tables[kMaxTables] = {};
+			std::atomic<uint32_t> tableCount;
+			std::mutex growMutex;
+	};
+
 	// defined in CMeshManipulator.cpp
-    extern core::vector<QuantizationCacheEntry2_10_10_10>   normalCacheFor2_10_10_10Quant;
-	extern core::vector<QuantizationCacheEntry8_8_8>        normalCacheFor8_8_8Quant;
-	extern core::vector<QuantizationCacheEntry16_16_16>     normalCacheFor16_16_16Quant;
-	extern core::vector<QuantizationCacheEntryHalfFloat>    normalCacheForHalfFloatQuant;
+	extern QuantizationCache<QuantizationCacheEntry2_10_10_10>  normalCacheFor2_10_10_10Quant;
+	extern QuantizationCache<QuantizationCacheEntry8_8_8>       normalCacheFor8_8_8Quant;
+	extern QuantizationCache<QuantizationCacheEntry16_16_16>    normalCacheFor16_16_16Quant;
+	extern QuantizationCache<QuantizationCacheEntryHalfFloat>   normalCacheForHalfFloatQuant;
 
     inline core::vectorSIMDf findBestFit(const uint32_t& bits, const core::vectorSIMDf& normal)
     {
@@ -134,21 +355,16 @@ namespace asset
 
 	inline uint32_t quantizeNormal2_10_10_10(const core::vectorSIMDf &normal)
 	{
-        QuantizationCacheEntry2_10_10_10 dummySearchVal;
-        dummySearchVal.key = normal;
-        auto found = std::lower_bound(normalCacheFor2_10_10_10Quant.begin(),normalCacheFor2_10_10_10Quant.end(),dummySearchVal);
-        if (found!=normalCacheFor2_10_10_10Quant.end()&&(found->key==normal).all())
-        {
-            return found->value;
-        }
+        uint32_t bestFit;
+        if (normalCacheFor2_10_10_10Quant.find(bestFit,normal))
+            return bestFit;
 
         core::vectorSIMDf fit = findBestFit(10u, normal);
         const uint32_t xorflag = (0x1u<<10)-1;
-        uint32_t bestFit = ((uint32_t(fit.X)^(normal.X<0.f ? xorflag:0))+(normal.X<0.f ? 1:0))&xorflag;
+        bestFit = ((uint32_t(fit.X)^(normal.X<0.f ? xorflag:0))+(normal.X<0.f ? 1:0))&xorflag;
         bestFit |= (((uint32_t(fit.Y)^(normal.Y<0.f ? xorflag:0))+(normal.Y<0.f ? 1:0))&xorflag)<<10;
         bestFit |= (((uint32_t(fit.Z)^(normal.Z<0.f ? xorflag:0))+(normal.Z<0.f ? 1:0))&xorflag)<<20;
-        dummySearchVal.value = bestFit;
-        normalCacheFor2_10_10_10Quant.insert(found,dummySearchVal);
+        normalCacheFor2_10_10_10Quant.insert(normal,bestFit);
 
 
 	    return bestFit;
@@ -156,13 +372,9 @@ namespace asset
 
 	inline uint32_t quantizeNormal888(const core::vectorSIMDf &normal)
 	{
-		QuantizationCacheEntry8_8_8 dummySearchVal;
-		dummySearchVal.key = normal;
-		auto found = std::lower_bound(normalCacheFor8_8_8Quant.begin(), normalCacheFor8_8_8Quant.end(), dummySearchVal);
-		if (found != normalCacheFor8_8_8Quant.end() && (found->key == normal).all())
-		{
-			return found->value;
-		}
+		uint32_t cached;
+		if (normalCacheFor8_8_8Quant.find(cached, normal))
+			return cached;
 
         uint8_t bestFit[4] {0u,0u,0u,0u};
 
@@ -172,21 +384,16 @@ namespace asset
         bestFit[1] = (uint32_t(fit.Y)^(normal.Y<0.f ? xorflag:0))+(normal.Y<0.f ? 1:0);
         bestFit[2] = (uint32_t(fit.Z)^(normal.Z<0.f ? xorflag:0))+(normal.Z<0.f ? 1:0);
 
-		dummySearchVal.value = *reinterpret_cast<uint32_t*>(bestFit);
-		normalCacheFor8_8_8Quant.insert(found, dummySearchVal);
+		normalCacheFor8_8_8Quant.insert(normal, *reinterpret_cast<uint32_t*>(bestFit));
 
 	    return *reinterpret_cast<uint32_t*>(bestFit);
 	}
 
 	inline uint64_t quantizeNormal16_16_16(const core::vectorSIMDf& normal)
 	{
-		QuantizationCacheEntry16_16_16 dummySearchVal;
-		dummySearchVal.key = normal;
-		auto found = std::lower_bound(normalCacheFor16_16_16Quant.begin(), normalCacheFor16_16_16Quant.end(), dummySearchVal);
-		if (found != normalCacheFor16_16_16Quant.end() && (found->key == normal).all())
-		{
-			return found->value;
-		}
+		uint64_t cached;
+		if (normalCacheFor16_16_16Quant.find(cached, normal))
+			return cached;
 
 		uint16_t bestFit[4]{0u,0u,0u,0u};
 
@@ -196,21 +403,16 @@ namespace asset
 		bestFit[1] = (uint32_t(fit.y) ^ (normal.y < 0.f ? xorflag : 0u)) + (normal.y < 0.f ? 1u : 0u);
 		bestFit[2] = (uint32_t(fit.z) ^ (normal.z < 0.f ? xorflag : 0u)) + (normal.z < 0.f ? 1u : 0u);
 
-		dummySearchVal.value = *reinterpret_cast<uint64_t*>(bestFit);
-		normalCacheFor16_16_16Quant.insert(found, dummySearchVal);
+		normalCacheFor16_16_16Quant.insert(normal, *reinterpret_cast<uint64_t*>(bestFit));
 
 		return *reinterpret_cast<uint64_t*>(bestFit);
 	}
 
 	inline uint64_t quantizeNormalHalfFloat(const core::vectorSIMDf& normal)
 	{
-		QuantizationCacheEntryHalfFloat dummySearchVal;
-		dummySearchVal.key = normal;
-		auto found = std::lower_bound(normalCacheForHalfFloatQuant.begin(), normalCacheForHalfFloatQuant.end(), dummySearchVal);
-		if (found != normalCacheForHalfFloatQuant.end() && (found->key == normal).all())
-		{
-			return found->value;
-		}
+		uint64_t cached;
+		if (normalCacheForHalfFloatQuant.find(cached, normal))
+			return cached;
 
 		uint16_t bestFit[4] {
 			core::Float16Compressor::compress(normal.x),
@@ -219,8 +421,7 @@ namespace asset
 			0u
 		};
 
-		dummySearchVal.value = *reinterpret_cast<uint64_t*>(bestFit);
-		normalCacheForHalfFloatQuant.insert(found, dummySearchVal);
+		normalCacheForHalfFloatQuant.insert(normal, *reinterpret_cast<uint64_t*>(bestFit));
 
 		return *reinterpret_cast<uint64_t*>(bestFit);
 	}
@@ -0,0 +1,170 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBAW Engine"
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __IRR_C_ASYNC_ASSET_LOADER_H_INCLUDED__
+#define __IRR_C_ASYNC_ASSET_LOADER_H_INCLUDED__
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include "irr/core/Types.h"
+#include "irr/core/parallel_for.h"
+#include "IAssetLoader.h"
+
+namespace irr
+{
+namespace asset
+{
+
+class IAssetManager;
+
+//! Requests of higher priority are always picked up by the workers before any request of lower priority
+enum E_ASSET_LOAD_PRIORITY : uint32_t
+{
+    EALP_LOW = 0u,
+    EALP_NORMAL,
+    EALP_HIGH,
+    EALP_COUNT
+};
+
+//! Worker pool behind IAssetManager::getAssetAsync(), not meant to be used directly.
+/** Requests wait in one FIFO queue per priority level and are served by at most `getMaxThreadCount()` worker threads,
+which are spawned lazily, so an asset manager which never loads asynchronously never spawns any.
+Requests for the same filename which are still pending share one load (unless ECF_DUPLICATE_TOP_LEVEL is requested),
+the first request's parameters and loader override are used and the priority is raised to the highest one requested. */
+class CAsyncAssetLoader
+{
+    public:
+        class SRequest : public core::IReferenceCounted
+        {
+                friend class CAsyncAssetLoader;
+                friend class SAssetLoadFuture;
+
+                enum E_STATE : uint32_t
+                {
+                    ES_QUEUED = 0u,
+                    ES_RUNNING,
+                    ES_DONE,
+                    ES_CANCELLED
+                };
+                // state lives in the high bits and the count of not-cancelled futures in the low ones, so both change atomically together
+                _IRR_STATIC_INLINE_CONSTEXPR uint32_t StateShift = 24u;
+                _IRR_STATIC_INLINE_CONSTEXPR uint32_t WaiterMask = (0x1u<<StateShift)-1u;
+                static inline uint32_t getState(uint32_t _word) { return _word>>StateShift; }
+                static inline uint32_t getWaiters(uint32_t _word) { return _word&WaiterMask; }
+
+                std::string filename;
+                const IAssetLoader::SAssetLoadParams params;
+                IAssetLoader::IAssetLoaderOverride* loaderOverride;
+                std::promise<SAssetBundle> promise;
+                std::shared_future<SAssetBundle> future;
+                std::atomic<uint32_t> stateAndWaiters;
+                uint32_t priority; // guarded by the loader's mutex
+
+                //! Succeeds unless the request was already cancelled
+                bool addWaiter();
+                //! @returns whether the state changed from `_from` to `_to`
+                bool transition(E_STATE _from, E_STATE _to);
+
+            protected:
+                ~SRequest() = default;
+
+            public:
+                SRequest(const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, IAssetLoader::IAssetLoaderOverride* _override, E_ASSET_LOAD_PRIORITY _priority) :
+                    filename(_filename), params(_params), loaderOverride(_override), future(promise.get_future().share()),
+                    stateAndWaiters((ES_QUEUED<<StateShift)|1u), priority(_priority)
+                {
+                }
+        };
+
+        CAsyncAssetLoader(IAssetManager* _mgr, uint32_t _maxThreadCount=0u);
+        //! Cancels requests which haven't started yet (their futures get empty bundles) and waits for the running ones
+        ~CAsyncAssetLoader();
+
+        //! Takes effect only for threads spawned afterwards, 0 means one per hardware thread
+        inline void setMaxThreadCount(uint32_t _maxThreadCount) { m_maxThreadCount = core::resolveThreadCount(_maxThreadCount); }
+        inline uint32_t getMaxThreadCount() const { return m_maxThreadCount; }
+
+        //! @returns request which either was just queued or is the pending request for the same filename
+        core::smart_refctd_ptr<SRequest> enqueue(const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, IAssetLoader::IAssetLoaderOverride* _override, E_ASSET_LOAD_PRIORITY _priority);
+
+    private:
+        void workerMain();
+        void pushToQueue(core::smart_refctd_ptr<SRequest>&& _request, uint32_t _priority);
+
+        IAssetManager* const m_mgr;
+        std::atomic<uint32_t> m_maxThreadCount;
+
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::array<std::deque<core::smart_refctd_ptr<SRequest>>, EALP_COUNT> m_queues;
+        //! Pending (queued or running) requests by filename, for de-duplication
+        core::unordered_map<std::string, core::smart_refctd_ptr<SRequest>> m_pending;
+        core::vector<std::thread> m_threads;
+        uint32_t m_queuedCount = 0u;
+        uint32_t m_idleThreads = 0u;
+        bool m_quit = false;
+};
+
+//! Result of IAssetManager::getAssetAsync(), the same load may be shared by several futures
+class SAssetLoadFuture
+{
+        core::smart_refctd_ptr<CAsyncAssetLoader::SRequest> m_request;
+        bool m_cancelled = false;
+
+    public:
+        SAssetLoadFuture() = default;
+        explicit SAssetLoadFuture(core::smart_refctd_ptr<CAsyncAssetLoader::SRequest>&& _request) : m_request(std::move(_request)) {}
+        // every future counts as one waiter of the request, use getFuture() to share the result
+        SAssetLoadFuture(const SAssetLoadFuture&) = delete;
+        SAssetLoadFuture(SAssetLoadFuture&& other) : m_request(std::move(other.m_request)), m_cancelled(other.m_cancelled) {}
+        SAssetLoadFuture& operator=(const SAssetLoadFuture&) = delete;
+        SAssetLoadFuture& operator=(SAssetLoadFuture&& other)
+        {
+            std::swap(m_request, other.m_request);
+            std::swap(m_cancelled, other.m_cancelled);
+            return *this;
+        }
+
+        //! Default constructed and moved-from futures are not valid, they are never ready and get() returns an empty bundle
+        inline bool valid() const { return bool(m_request); }
+
+        //! Non-blocking check whether get() would return immediately
+        inline bool ready() const
+        {
+            return m_request && m_request->future.wait_for(std::chrono::seconds(0))==std::future_status::ready;
+        }
+        inline void wait() const
+        {
+            if (m_request)
+                m_request->future.wait();
+        }
+        //! Blocks until the load is done, returns empty bundle if the load failed or got cancelled
+        inline const SAssetBundle& get() const
+        {
+            static const SAssetBundle empty;
+            return m_request ? m_request->future.get():empty;
+        }
+        //! The returned future is not valid() when this one isn't
+        inline const std::shared_future<SAssetBundle>& getFuture() const
+        {
+            static const std::shared_future<SAssetBundle> invalid;
+            return m_request ? m_request->future:invalid;
+        }
+
+        //! Gives up on this future, the load gets cancelled if it hasn't started yet and no other future shares it.
+        /** A load which already started always runs to completion (and caches its result as usual).
+        @returns true if the load got cancelled, its futures then return an empty bundle */
+        bool cancel();
+};
+
+}
+}
+
+#endif
@@ -25,13 +25,16 @@ public:
 
     struct SAssetLoadParams
     {
-        SAssetLoadParams(const size_t& _decryptionKeyLen = 0u, const uint8_t* _decryptionKey = nullptr, const E_CACHING_FLAGS& _cacheFlags = ECF_CACHE_EVERYTHING)
-            : decryptionKeyLen(_decryptionKeyLen), decryptionKey(_decryptionKey), cacheFlags(_cacheFlags)
+        SAssetLoadParams(const size_t& _decryptionKeyLen = 0u, const uint8_t* _decryptionKey = nullptr, const E_CACHING_FLAGS& _cacheFlags = ECF_CACHE_EVERYTHING, const uint32_t& _workerThreadCount = 1u)
+            : decryptionKeyLen(_decryptionKeyLen), decryptionKey(_decryptionKey), cacheFlags(_cacheFlags), workerThreadCount(_workerThreadCount)
         {
         }
         size_t decryptionKeyLen;
         const uint8_t* decryptionKey;
         const E_CACHING_FLAGS cacheFlags;
+        //! Amount of threads a loader may use for a single load, 1 means the calling thread only and 0 means one per hardware thread.
+        /** Loaders which cannot split their work simply ignore this. */
+        uint32_t workerThreadCount;
     };
 
     //! Struct for keeping the state of the current loadoperation for safe threading
@@ -11,12 +11,17 @@
 #include "IWriteFile.h"
 #include "IAssetLoader.h"
 #include "IAssetWriter.h"
+#include "irr/asset/CAsyncAssetLoader.h"
 #include "irr/core/Types.h"
 
 #include <array>
+#include <atomic>
+#include <mutex>
 #include <ostream>
 
 #define USE_MAPS_FOR_PATH_BASED_CACHE //benchmark and choose, paths can be full system paths
+#define USE_HASH_FOR_PATH_BASED_CACHE //takes precedence over USE_MAPS_FOR_PATH_BASED_CACHE, see examples_tests/36.ObjectCacheBackends
+#define USE_SHARDED_ASSET_CACHE //loader threads contend on one lock per cache otherwise, see examples_tests/35.ConcurrentCacheContention
 
 namespace irr
 {
@@ -36,13 +41,49 @@ namespace asset
         friend std::function<void(SAssetBundle&)> makeAssetDisposeFunc(const IAssetManager* const _mgr);
 
     public:
-#ifdef USE_MAPS_FOR_PATH_BASED_CACHE
-        using AssetCacheType = core::CConcurrentMultiObjectCache<std::string, SAssetBundle, std::multimap>;
+#ifdef USE_SHARDED_ASSET_CACHE
+    #if defined(USE_HASH_FOR_PATH_BASED_CACHE)
+        using AssetCacheType = core::CShardedConcurrentMultiObjectCache<std::string, SAssetBundle, core::open_addressing_multimap>;
+    #elif defined(USE_MAPS_FOR_PATH_BASED_CACHE)
+        using AssetCacheType = core::CShardedConcurrentMultiObjectCache<std::string, SAssetBundle, std::multimap>;
+    #else
+        using AssetCacheType = core::CShardedConcurrentMultiObjectCache<std::string, IAssetBundle, std::vector>;
+    #endif //USE_HASH_FOR_PATH_BASED_CACHE
+
+        using CpuGpuCacheType = core::CShardedConcurrentObjectCache<const IAsset*, core::IReferenceCounted*>;
 #else
+    #if defined(USE_HASH_FOR_PATH_BASED_CACHE)
+        using AssetCacheType = core::CConcurrentMultiObjectCache<std::string, SAssetBundle, core::open_addressing_multimap>;
+    #elif defined(USE_MAPS_FOR_PATH_BASED_CACHE)
+        using AssetCacheType = core::CConcurrentMultiObjectCache<std::string, SAssetBundle, std::multimap>;
+    #else
         using AssetCacheType = core::CConcurrentMultiObjectCache<std::string, IAssetBundle, std::vector>;
-#endif //USE_MAPS_FOR_PATH_BASED_CACHE
+    #endif //USE_HASH_FOR_PATH_BASED_CACHE
 
         using CpuGpuCacheType = core::CConcurrentObjectCache<const IAsset*, core::IReferenceCounted*>;
+#endif //USE_SHARDED_ASSET_CACHE
+
+        //! What happens to cached assets evicted to keep the cache of their type within its byte budget
+        enum E_CACHE_EVICTION_MODE : uint32_t
+        {
+            //! Bundle is removed from the cache, which destroys it as nothing else references it
+            ECEM_REMOVE = 0u,
+            //! Bundle's assets are converted to dummies (see convertAssetToEmptyCacheHandle) which releases their memory,
+            //! lookups treat the dummy bundle as a miss and remove it from the cache
+            ECEM_CONVERT_TO_DUMMY
+        };
+
+        struct SAssetCacheStatistics
+        {
+            //! Lookups by key (also the ones done by loaders) which found or didn't find anything
+            uint64_t hits = 0u;
+            uint64_t misses = 0u;
+            //! Per IAsset::E_TYPE index, see IAsset::typeFlagToIndex
+            std::array<uint64_t, IAsset::ET_STANDARD_TYPES_COUNT> cachedBytes = {};
+            std::array<uint64_t, IAsset::ET_STANDARD_TYPES_COUNT> byteBudget = {};
+            std::array<uint64_t, IAsset::ET_STANDARD_TYPES_COUNT> evictions = {};
+            std::array<uint64_t, IAsset::ET_STANDARD_TYPES_COUNT> evictedBytes = {};
+        };
 
     private:
         struct WriterKey
@@ -74,6 +115,43 @@ namespace asset
         std::array<AssetCacheType*, IAsset::ET_STANDARD_TYPES_COUNT> m_assetCache;
         std::array<CpuGpuCacheType*, IAsset::ET_STANDARD_TYPES_COUNT> m_cpuGpuCache;
 
+        //! Byte accounting and CLOCK (second chance) eviction state of one asset cache
+        struct SCacheBudget
+        {
+            struct SEntry
+            {
+                SAssetBundle bundle;
+                uint64_t bytes;
+                bool referenced; // set by lookups, cleared when the clock hand passes
+                bool evicting;
+                bool dummy; // converted by ECEM_CONVERT_TO_DUMMY, lookups treat it as a miss
+            };
+
+            std::mutex mutex;
+            uint64_t budget = 0u; // 0 means unlimited
+            E_CACHE_EVICTION_MODE mode = ECEM_REMOVE;
+            uint64_t usedBytes = 0u;
+            uint64_t evictions = 0u;
+            uint64_t evictedBytes = 0u;
+            core::vector<SEntry> clock;
+            size_t hand = 0u;
+            //! Index into `clock` by bundle contents
+            core::unordered_map<const void*, size_t> lookup;
+        };
+        // modified by the caches' greet and dispose functions as well as by lookups, which are const
+        mutable std::array<SCacheBudget, IAsset::ET_STANDARD_TYPES_COUNT> m_cacheBudgets;
+        mutable std::atomic<uint64_t> m_cacheHits;
+        mutable std::atomic<uint64_t> m_cacheMisses;
+
+        void trackCachedAsset(const SAssetBundle& _asset) const;
+        void untrackCachedAsset(const SAssetBundle& _asset) const;
+        //! Also moves bundles converted to dummies by the budget to the end of the range and clears them, since they are of no use anymore
+        /** \return amount of usable bundles left at the front of the range. */
+        size_t markCachedAssetsReferenced(SAssetBundle* _begin, SAssetBundle* _end) const;
+        //! Only meaningful for bundles which are in a cache, `_extraRefs` is the amount of known bundle copies other than the cache's and the tracker's
+        static bool isOnlyReferencedByCache(const SAssetBundle& _asset, int32_t _extraRefs);
+        void enforceCacheBudget(uint32_t _typeIx);
+
         struct Loaders {
             Loaders() : perFileExt{&refCtdGreet<IAssetLoader>, &refCtdDispose<IAssetLoader>} {}
 
@@ -101,6 +179,8 @@ namespace asset
         friend class IAssetLoader;
         friend class IAssetLoader::IAssetLoaderOverride; // for access to non-const findAssets
 
+        CAsyncAssetLoader* m_asyncLoader;
+
         IGeometryCreator* m_geometryCreator;
         IMeshManipulator* m_meshManipulator;
         // called as a part of constructor only
@@ -111,7 +191,9 @@ namespace asset
         //! Constructor
         explicit IAssetManager(io::IFileSystem* _fs) :
             m_fileSystem{_fs},
-            m_defaultLoaderOverride{nullptr}
+            m_defaultLoaderOverride{nullptr},
+            m_cacheHits{0u},
+            m_cacheMisses{0u}
         {
             initializeMeshTools();
 
@@ -121,6 +203,7 @@ namespace asset
                 m_cpuGpuCache[i] = new CpuGpuCacheType(&refCtdGreet<core::IReferenceCounted>, &refCtdDispose<core::IReferenceCounted>);
             m_fileSystem->grab();
             m_defaultLoaderOverride = IAssetLoader::IAssetLoaderOverride{this};
+            m_asyncLoader = new CAsyncAssetLoader(this);
         }
         /*
         IAssetManager(const IAssetManager&) = delete;
@@ -136,6 +219,9 @@ namespace asset
         */
         virtual ~IAssetManager()
         {
+            // workers may still be loading, so they must finish before anything else goes away
+            delete m_asyncLoader;
+
             for (size_t i = 0u; i < m_assetCache.size(); ++i)
                 if (m_assetCache[i])
                     delete m_assetCache[i];
@@ -275,6 +361,22 @@ namespace asset
             return getAsset(_file, _supposedFilename, _params, &m_defaultLoaderOverride);
         }
 
+        //! Queues the load of an asset to be done by one of the asset manager's worker threads, the calling thread never blocks.
+        /** Behaves like getAsset() otherwise, pending requests for the same filename share one load (see CAsyncAssetLoader).
+        `_override` and `_params.decryptionKey` must stay valid until the load is done. */
+        SAssetLoadFuture getAssetAsync(const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, IAssetLoader::IAssetLoaderOverride* _override, E_ASSET_LOAD_PRIORITY _priority = EALP_NORMAL)
+        {
+            return SAssetLoadFuture(m_asyncLoader->enqueue(_filename, _params, _override, _priority));
+        }
+
+        SAssetLoadFuture getAssetAsync(const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, E_ASSET_LOAD_PRIORITY _priority = EALP_NORMAL)
+        {
+            return getAssetAsync(_filename, _params, &m_defaultLoaderOverride, _priority);
+        }
+
+        //! Maximum amount of threads doing asynchronous loads, 0 (default) means one per hardware thread. Threads already running are not stopped.
+        void setAsyncLoadThreadCount(uint32_t _threadCount) { m_asyncLoader->setMaxThreadCount(_threadCount); }
+
         //TODO change name
         inline bool findAssets(size_t& _inOutStorageSize, SAssetBundle* _out, const std::string& _key, const IAsset::E_TYPE* _types = nullptr) const
         {
@@ -306,6 +408,12 @@ namespace asset
                     _out += readCnt;
                 }
             }
+            if (_inOutStorageSize)
+                _inOutStorageSize = markCachedAssetsReferenced(_out-_inOutStorageSize, _out);
+            if (_inOutStorageSize)
+                m_cacheHits++;
+            else
+                m_cacheMisses++;
             return res;
         }
         //TODO change name
@@ -352,7 +460,28 @@ namespace asset
         bool insertAssetIntoCache(SAssetBundle& _asset)
         {
             const uint32_t ix = IAsset::typeFlagToIndex(_asset.getAssetType());
-            return m_assetCache[ix]->insert(_asset.getCacheKey(), _asset);
+            const bool inserted = m_assetCache[ix]->insert(_asset.getCacheKey(), _asset);
+            if (inserted)
+                enforceCacheBudget(ix);
+            return inserted;
+        }
+
+        //! Inserts many assets into the cache at once, cheaper than calling insertAssetIntoCache() for each of them
+        /** \return amount of assets added into cache. */
+        size_t insertAssetsIntoCache(SAssetBundle* _begin, SAssetBundle* _end)
+        {
+            std::array<core::vector<typename AssetCacheType::MutablePairType>, IAsset::ET_STANDARD_TYPES_COUNT> perType;
+            for (auto it = _begin; it != _end; ++it)
+                perType[IAsset::typeFlagToIndex(it->getAssetType())].emplace_back(it->getCacheKey(), *it);
+
+            size_t inserted = 0u;
+            for (uint32_t i = 0u; i < IAsset::ET_STANDARD_TYPES_COUNT; ++i)
+                if (perType[i].size())
+                {
+                    inserted += m_assetCache[i]->bulkInsert(perType[i].begin(), perType[i].end());
+                    enforceCacheBudget(i);
+                }
+            return inserted;
         }
 
         //! Remove an asset from cache (calls the private methods of IAsset behind the scenes)
@@ -371,6 +500,37 @@ namespace asset
                     m_assetCache[i]->clear();
         }
 
+        //! Limits the estimated (IAsset::conservativeSizeEstimate) memory of the assets cached under one type, 0 (default) means unlimited.
+        /** Whenever the budget is exceeded, cached bundles which nothing but the cache references are evicted in approximately least recently
+        used order (CLOCK algorithm, lookups by key count as use) until the cache fits again. Bundles referenced from outside of the cache
+        (including by other assets, e.g. a mesh buffer by its mesh) are never evicted, so the budget may stay exceeded. */
+        void setAssetCacheBudget(IAsset::E_TYPE _type, uint64_t _byteBudget, E_CACHE_EVICTION_MODE _mode = ECEM_REMOVE)
+        {
+            const uint32_t ix = IAsset::typeFlagToIndex(_type);
+            {
+                std::unique_lock<std::mutex> lock(m_cacheBudgets[ix].mutex);
+                m_cacheBudgets[ix].budget = _byteBudget;
+                m_cacheBudgets[ix].mode = _mode;
+            }
+            enforceCacheBudget(ix);
+        }
+
+        SAssetCacheStatistics getAssetCacheStatistics() const
+        {
+            SAssetCacheStatistics stats;
+            stats.hits = m_cacheHits;
+            stats.misses = m_cacheMisses;
+            for (uint32_t i = 0u; i < IAsset::ET_STANDARD_TYPES_COUNT; ++i)
+            {
+                std::unique_lock<std::mutex> lock(m_cacheBudgets[i].mutex);
+                stats.cachedBytes[i] = m_cacheBudgets[i].usedBytes;
+                stats.byteBudget[i] = m_cacheBudgets[i].budget;
+                stats.evictions[i] = m_cacheBudgets[i].evictions;
+                stats.evictedBytes[i] = m_cacheBudgets[i].evictedBytes;
+            }
+            return stats;
+        }
+
         //! This function frees most of the memory consumed by IAssets, but not destroying them.
         /** Keeping assets around (by their pointers) helps a lot by letting the loaders retrieve them from the cache and not load cpu objects which have been loaded, converted to gpu resources and then would have been disposed of. However each dummy object needs to have a GPU object associated with it in yet-another-cache for use when we convert CPU objects to GPU objects.*/
         void convertAssetToEmptyCacheHandle(IAsset* _asset, core::IReferenceCounted* _gpuObject)
@@ -544,7 +704,14 @@ namespace asset
 
         // for greet/dispose lambdas for asset caches so we don't have to make another friend decl.
         //TODO change name
-        inline void setAssetCached(SAssetBundle& _asset, bool _val) const { _asset.setCached(_val); }
+        inline void setAssetCached(SAssetBundle& _asset, bool _val) const
+        {
+            _asset.setCached(_val);
+            if (_val)
+                trackCachedAsset(_asset);
+            else
+                untrackCachedAsset(_asset);
+        }
 	};
 }
 }
@@ -11,6 +11,7 @@
 #include "irr/core/IBuffer.h"
 #include "IAsset.h"
 #include "irr/core/alloc/null_allocator.h"
+#include "irr/core/alloc/refctd_memory_view_allocator.h"
 #include "coreutil.h"
 
 namespace irr
@@ -109,7 +110,7 @@ class CCustomAllocatorCPUBuffer;
 template<typename Allocator>
 class CCustomAllocatorCPUBuffer<Allocator, true> : public ICPUBuffer
 {
-    static_assert(sizeof(Allocator::value_type) == 1u, "Allocator::value_type must be of size 1");
+    static_assert(sizeof(typename Allocator::value_type) == 1u, "Allocator::value_type must be of size 1");
 protected:
     Allocator m_allocator;
 
@@ -124,6 +125,14 @@ public:
     CCustomAllocatorCPUBuffer(size_t sizeInBytes, void* dat, core::adopt_memory_t, Allocator&& alctr = Allocator()) : ICPUBuffer(sizeInBytes, dat), m_allocator(std::move(alctr))
     {
     }
+
+    virtual void convertToDummyObject() override
+    {
+        if (ICPUBuffer::data)
+            m_allocator.deallocate(reinterpret_cast<typename Allocator::pointer>(ICPUBuffer::data), ICPUBuffer::size);
+        ICPUBuffer::data = nullptr; // so that ICPUBuffer won't try deallocating
+        ICPUBuffer::convertToDummyObject();
+    }
 };
 
 template<typename Allocator>
@@ -142,6 +151,13 @@ public:
     }
 };
 
+//! Buffer adopting (not copying) a view into memory owned by a reference counted object, such as a memory mapped file.
+/** The owner is kept alive for as long as the buffer exists, e.g.
+\code
+auto buf = new CMemoryViewCPUBuffer(size, ptr, core::adopt_memory, core::refctd_memory_view_allocator<uint8_t>(core::smart_refctd_ptr<const core::IReferenceCounted>(owner)));
+\endcode */
+using CMemoryViewCPUBuffer = CCustomAllocatorCPUBuffer<core::refctd_memory_view_allocator<uint8_t> >;
+
 } // end namespace asset
 } // end namespace irr
 
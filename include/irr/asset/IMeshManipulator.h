@@ -101,6 +101,8 @@ namespace asset
 		/** \param mesh Input mesh
         \param errMetrics Array of size EVAI_COUNT. Describes error metric for each vertex attribute (used if attribute is of floating point or normalized type).
 		\param tolerance The threshold for vertex comparisons.
+		When positions are compared with EEM_POSITIONS, vertices are bucketed on a grid of position cells in parallel
+		and compared only with the neighbouring cells, otherwise every vertex is compared with every other one. Both give the same result.
 		\return Mesh without redundant vertices. If you no longer need
 		the cloned mesh, you should call IMesh::drop(). See
 		IReferenceCounted::drop() for more information. */
@@ -36,6 +36,7 @@ namespace scene
 namespace io
 {
 	class IFileSystem;
+	class IReadFile;
 }
 namespace video
 {
@@ -57,7 +58,11 @@ namespace asset
 			EBCT_LZ4 = 0x02,
 			EBCT_LZ4_AES128_GCM = 0x03,
 			EBCT_LZMA = 0x04,
-			EBCT_LZMA_AES128_GCM = 0x05
+			EBCT_LZMA_AES128_GCM = 0x05,
+			//! Since .baw v2. Data is split into independently compressed chunks prefixed by BlobChunkIndexV2, always combined with EBCT_LZ4 or EBCT_LZMA and never encrypted.
+			EBCT_CHUNKED = 0x08,
+			EBCT_LZ4_CHUNKED = 0x0a,
+			EBCT_LZMA_CHUNKED = 0x0c
 		};
 		//! Type of blob enumeration
 		enum E_BLOB_TYPE
@@ -437,24 +442,63 @@ namespace asset
         return sizeof(MeshDataFormatDescBlobV1);
     }
 
+    // ===============
+    // .baw VERSION 2
+    // ===============
+    using BlobHeaderV2 = BlobHeaderVn<2>;
+    using BAWFileV2 = BAWFileVn<2>;
+    using RawBufferBlobV2 = RawBufferBlobV1;
+    using TexturePathBlobV2 = TexturePathBlobV1;
+    using MeshBlobV2 = MeshBlobV1;
+    using SkinnedMeshBlobV2 = SkinnedMeshBlobV1;
+    using MeshBufferBlobV2 = MeshBufferBlobV1;
+    using SkinnedMeshBufferBlobV2 = SkinnedMeshBufferBlobV1;
+    using MeshDataFormatDescBlobV2 = MeshDataFormatDescBlobV1;
+    using FinalBoneHierarchyBlobV2 = FinalBoneHierarchyBlobV1;
+
+#include "irr/irrpack.h"
+    //! Prefix of data of blobs coded with Blob::EBCT_CHUNKED. Followed by `chunkCount` entries and then by the chunks themselves.
+    /** Every chunk but the last one decompresses to exactly `chunkSize` bytes. A chunk whose `compressedSize` equals its decompressed size is stored raw. */
+    struct BlobChunkIndexV2
+    {
+        struct ChunkEntry
+        {
+            //! Counted from the first byte after the index (i.e. after `calcSize(chunkCount)` bytes of blob data)
+            uint32_t offset;
+            uint32_t compressedSize;
+        } PACK_STRUCT;
+
+        uint32_t chunkSize;
+        uint32_t chunkCount;
+        ChunkEntry chunks[1];
+
+        static uint32_t calcChunkCount(uint32_t _sizeDecompr, uint32_t _chunkSize) { return (_sizeDecompr+_chunkSize-1u)/_chunkSize; }
+        static size_t calcSize(uint32_t _chunkCount) { return sizeof(chunkSize) + sizeof(chunkCount) + _chunkCount*sizeof(ChunkEntry); }
+        uint32_t calcChunkSizeDecompr(uint32_t _chunkIx, uint32_t _sizeDecompr) const { return _chunkIx+1u<chunkCount ? chunkSize : (_sizeDecompr-_chunkIx*chunkSize); }
+        //! Checks whether the index is consistent with sizes of the blob, `chunkCount` entries must be readable.
+        bool validate(uint32_t _blobSize, uint32_t _sizeDecompr) const;
+    } PACK_STRUCT;
+#include "irr/irrunpack.h"
+    static_assert(sizeof(BlobChunkIndexV2::ChunkEntry)==8u, "sizeof(BlobChunkIndexV2::ChunkEntry) must be 8");
+
 	template<typename>
 	struct CorrespondingBlobTypeFor;
 	template<>
-	struct CorrespondingBlobTypeFor<asset::ICPUBuffer> { typedef RawBufferBlobV1 type; };
+	struct CorrespondingBlobTypeFor<asset::ICPUBuffer> { typedef RawBufferBlobV2 type; };
 	template<>
-	struct CorrespondingBlobTypeFor<asset::ICPUMesh> { typedef MeshBlobV1 type; };
+	struct CorrespondingBlobTypeFor<asset::ICPUMesh> { typedef MeshBlobV2 type; };
 	template<>
-	struct CorrespondingBlobTypeFor<asset::ICPUSkinnedMesh> { typedef SkinnedMeshBlobV1 type; };
+	struct CorrespondingBlobTypeFor<asset::ICPUSkinnedMesh> { typedef SkinnedMeshBlobV2 type; };
 	template<>
-	struct CorrespondingBlobTypeFor<asset::ICPUMeshBuffer> { typedef MeshBufferBlobV1 type; };
+	struct CorrespondingBlobTypeFor<asset::ICPUMeshBuffer> { typedef MeshBufferBlobV2 type; };
 	template<>
-	struct CorrespondingBlobTypeFor<asset::ICPUSkinnedMeshBuffer> { typedef SkinnedMeshBufferBlobV1 type; };
+	struct CorrespondingBlobTypeFor<asset::ICPUSkinnedMeshBuffer> { typedef SkinnedMeshBufferBlobV2 type; };
 	template<>
-	struct CorrespondingBlobTypeFor<asset::IMeshDataFormatDesc<asset::ICPUBuffer> > { typedef MeshDataFormatDescBlobV1 type; };
+	struct CorrespondingBlobTypeFor<asset::IMeshDataFormatDesc<asset::ICPUBuffer> > { typedef MeshDataFormatDescBlobV2 type; };
 	template<>
-	struct CorrespondingBlobTypeFor<scene::CFinalBoneHierarchy> { typedef FinalBoneHierarchyBlobV1 type; };
+	struct CorrespondingBlobTypeFor<scene::CFinalBoneHierarchy> { typedef FinalBoneHierarchyBlobV2 type; };
 	template<>
-	struct CorrespondingBlobTypeFor<video::IVirtualTexture> { typedef TexturePathBlobV1 type; };
+	struct CorrespondingBlobTypeFor<video::IVirtualTexture> { typedef TexturePathBlobV2 type; };
 
 	template<typename T>
 	typename CorrespondingBlobTypeFor<T>::type* toBlobPtr(const void* _blob)
@@ -473,6 +517,17 @@ namespace asset
 	bool encAes128gcm(const void* _input, size_t _inSize, void* _output, size_t _outSize, const unsigned char* _key, const unsigned char* _iv, void* _tag);
 	bool decAes128gcm(const void* _input, size_t _inSize, void* _output, size_t _outSize, const unsigned char* _key, const unsigned char* _iv, void* _tag);
 
+	//! Decompresses chunks [_firstChunk,_lastChunk) of Blob::EBCT_CHUNKED coded data of a blob, chunk `_firstChunk` lands at `_dst`.
+	/** @param _blob Whole (validated) data of the blob as stored in the file, beginning with BlobChunkIndexV2.
+	@param _threadCnt Amount of threads decompressing chunks, 0 means one per hardware thread.
+	@returns false if the index is corrupted or any of the chunks failed to decompress. */
+	bool decompressBlobChunks(const void* _blob, const BlobHeaderV2& _header, uint32_t _firstChunk, uint32_t _lastChunk, void* _dst, uint32_t _threadCnt=1u);
+	//! Reads `_size` bytes starting at `_offset` of decompressed contents of a Blob::EBCT_CHUNKED coded blob, without reading nor decompressing the rest of it.
+	/** Since the blob's hash covers all of its data, integrity of chunks is not verified beyond what decompression itself detects.
+	@param _blobOffset Absolute offset of blob's data in `_file`.
+	@returns false if the range is out of bounds, the file is too short or decompression failed. */
+	bool readBlobChunksRange(io::IReadFile* _file, size_t _blobOffset, const BlobHeaderV2& _header, size_t _offset, size_t _size, void* _dst, uint32_t _threadCnt=1u);
+
 }} // irr::asset
 
 #endif
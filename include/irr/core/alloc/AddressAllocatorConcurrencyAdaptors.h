@@ -7,6 +7,9 @@
 
 #include "IrrCompileConfig.h"
 
+#include <atomic>
+
+#include "irr/core/math/irrMath.h"
 #include "irr/core/alloc/address_allocator_traits.h"
 
 namespace irr
@@ -20,7 +23,7 @@ template<class AddressAllocator, class RecursiveLockable>
 class AddressAllocatorBasicConcurrencyAdaptor : private AddressAllocator
 {
         static_assert(std::is_standard_layout<RecursiveLockable>::value,"Lock class is not standard layout");
-        RecursiveLockable lock;
+        mutable RecursiveLockable lock;
 
         AddressAllocator& getBaseRef() {return reinterpret_cast<AddressAllocator&>(*this);}
     public:
@@ -113,6 +116,191 @@ class AddressAllocatorBasicConcurrencyAdaptor : private AddressAllocator
         }
 };
 
+
+/**
+Keeps small magazines of already allocated addresses per power-of-two size class in front of the locked allocator,
+so that most allocations and frees from many threads never touch the lock.
+
+Every allocation in one of the `ClassCount` cached size classes is rounded up to its class size and aligned to
+min(classSize,max_alignment()), which makes any freed address reusable for any other request of the same class.
+Magazines are refilled and flushed in bulk, half their capacity at a time, with a single `multi_alloc_addr`/`multi_free_addr`
+under the lock. Larger allocations go straight to the locked allocator.
+
+Threads are assigned round-robin to one of `CacheSlotCount` slots, a thread finding its slot busy
+(more threads than slots) uses the locked allocator instead of waiting.
+
+Call flush() before resizing the underlying allocator or relying on its statistics, cached addresses still count as allocated.
+*/
+template<class AddressAllocator, class RecursiveLockable, uint32_t MagazineCapacity=32u, uint32_t CacheSlotCount=32u>
+class AddressAllocatorThreadCachingAdaptor : public AddressAllocatorBasicConcurrencyAdaptor<AddressAllocator,RecursiveLockable>
+{
+        typedef AddressAllocatorBasicConcurrencyAdaptor<AddressAllocator,RecursiveLockable> Base;
+        static_assert(MagazineCapacity>=2u,"Magazines need space for at least two addresses!");
+    public:
+        _IRR_DECLARE_ADDRESS_ALLOCATOR_TYPEDEFS(typename AddressAllocator::size_type);
+
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t ClassCount = 16u;
+
+        using Base::Base;
+        virtual ~AddressAllocatorThreadCachingAdaptor() {}
+
+
+        inline void         multi_alloc_addr(uint32_t count, size_type* outAddresses, const size_type* bytes, const size_type* alignment, const size_type* hint=nullptr) noexcept
+        {
+            SCacheSlot* slot = tryAcquireSlot();
+            for (uint32_t i=0; i<count; i++)
+            {
+                if (outAddresses[i]!=invalid_address)
+                    continue;
+
+                const uint32_t sizeClass = getSizeClass(bytes[i]);
+                if (sizeClass>=ClassCount)
+                {
+                    Base::multi_alloc_addr(1u,outAddresses+i,bytes+i,alignment+i,hint ? (hint+i):nullptr);
+                    continue;
+                }
+
+                const size_type classSize = getClassSize(sizeClass);
+                const size_type classAlignment = getClassAlignment(sizeClass);
+                if (slot && alignment[i]<=classAlignment)
+                {
+                    auto& magazineCount = slot->counts[sizeClass];
+                    if (magazineCount==0u)
+                    {
+                        size_type refillBytes[MagazineCapacity/2u],refillAlignment[MagazineCapacity/2u];
+                        size_type* refill = slot->addresses[sizeClass];
+                        std::fill(refill,refill+MagazineCapacity/2u,invalid_address);
+                        std::fill(refillBytes,refillBytes+MagazineCapacity/2u,classSize);
+                        std::fill(refillAlignment,refillAlignment+MagazineCapacity/2u,classAlignment);
+                        Base::multi_alloc_addr(MagazineCapacity/2u,refill,refillBytes,refillAlignment);
+                        for (uint32_t j=0u; j<MagazineCapacity/2u; j++)
+                        if (refill[j]!=invalid_address)
+                            refill[magazineCount++] = refill[j];
+                    }
+                    if (magazineCount)
+                        outAddresses[i] = slot->addresses[sizeClass][--magazineCount];
+                }
+                else
+                {
+                    // still allocate the whole class, the free could end up in a magazine
+                    const size_type classAlignments[1] = {std::max(alignment[i],classAlignment)};
+                    Base::multi_alloc_addr(1u,outAddresses+i,&classSize,classAlignments);
+                }
+            }
+            releaseSlot(slot);
+        }
+
+        inline void         multi_free_addr(uint32_t count, const size_type* addr, const size_type* bytes) noexcept
+        {
+            SCacheSlot* slot = tryAcquireSlot();
+            for (uint32_t i=0; i<count; i++)
+            {
+                if (addr[i]==invalid_address)
+                    continue;
+
+                const uint32_t sizeClass = getSizeClass(bytes[i]);
+                if (sizeClass>=ClassCount)
+                {
+                    Base::multi_free_addr(1u,addr+i,bytes+i);
+                    continue;
+                }
+
+                const size_type classSize = getClassSize(sizeClass);
+                if (slot)
+                {
+                    auto& magazineCount = slot->counts[sizeClass];
+                    if (magazineCount==MagazineCapacity)
+                    {
+                        size_type flushBytes[MagazineCapacity/2u];
+                        std::fill(flushBytes,flushBytes+MagazineCapacity/2u,classSize);
+                        magazineCount -= MagazineCapacity/2u;
+                        Base::multi_free_addr(MagazineCapacity/2u,slot->addresses[sizeClass]+magazineCount,flushBytes);
+                    }
+                    slot->addresses[sizeClass][magazineCount++] = addr[i];
+                }
+                else
+                    Base::multi_free_addr(1u,addr+i,&classSize);
+            }
+            releaseSlot(slot);
+        }
+
+        //! Returns all cached addresses to the underlying allocator
+        inline void         flush() noexcept
+        {
+            size_type flushBytes[MagazineCapacity];
+            for (auto& slot : slots)
+            {
+                while (slot.busy.exchange(true,std::memory_order_acquire)) {}
+                for (uint32_t sizeClass=0u; sizeClass<ClassCount; sizeClass++)
+                {
+                    std::fill(flushBytes,flushBytes+MagazineCapacity,getClassSize(sizeClass));
+                    Base::multi_free_addr(slot.counts[sizeClass],slot.addresses[sizeClass],flushBytes);
+                    slot.counts[sizeClass] = 0u;
+                }
+                slot.busy.store(false,std::memory_order_release);
+            }
+        }
+
+        inline void         reset() noexcept
+        {
+            for (auto& slot : slots)
+            {
+                while (slot.busy.exchange(true,std::memory_order_acquire)) {}
+                std::fill(slot.counts,slot.counts+ClassCount,0u);
+                slot.busy.store(false,std::memory_order_release);
+            }
+            Base::reset();
+        }
+
+    protected:
+        struct alignas(64) SCacheSlot
+        {
+            std::atomic<bool> busy{false};
+            uint32_t counts[ClassCount] = {};
+            size_type addresses[ClassCount][MagazineCapacity];
+        };
+
+        inline SCacheSlot*  tryAcquireSlot() noexcept
+        {
+            static std::atomic<uint32_t> threadCounter(0u);
+            thread_local const uint32_t slotIx = (threadCounter++)%CacheSlotCount;
+
+            SCacheSlot* slot = slots+slotIx;
+            if (slot->busy.load(std::memory_order_relaxed) || slot->busy.exchange(true,std::memory_order_acquire))
+                return nullptr;
+            return slot;
+        }
+        inline void         releaseSlot(SCacheSlot* slot) noexcept
+        {
+            if (slot)
+                slot->busy.store(false,std::memory_order_release);
+        }
+
+        //! Returns ClassCount or more if the size should not be cached
+        inline uint32_t     getSizeClass(size_type bytes) const noexcept
+        {
+            if (bytes==0u)
+                return ClassCount;
+            if (bytes<=smallestClassSize)
+                return 0u;
+            return core::findMSB(bytes-size_type(1u))+1u-smallestClassLog2;
+        }
+        inline size_type    getClassSize(uint32_t sizeClass) const noexcept
+        {
+            return smallestClassSize<<size_type(sizeClass);
+        }
+        inline size_type    getClassAlignment(uint32_t sizeClass) const noexcept
+        {
+            return std::min(getClassSize(sizeClass),maxAlignment);
+        }
+
+        // default member initializers run after the inherited constructor has set up the allocator
+        size_type   maxAlignment = Base::max_alignment();
+        size_type   smallestClassSize = core::roundUpToPoT(std::max(Base::min_size(),size_type(1u)));
+        uint32_t    smallestClassLog2 = core::findLSB(smallestClassSize);
+        SCacheSlot  slots[CacheSlotCount];
+};
+
 }
 }
 
@@ -609,6 +609,9 @@ using GeneralpurposeAddressAllocatorST = GeneralpurposeAddressAllocator<size_typ
 template<typename size_type, class RecursiveLockable>
 using GeneralpurposeAddressAllocatorMT = AddressAllocatorBasicConcurrencyAdaptor<GeneralpurposeAddressAllocator<size_type>,RecursiveLockable>;
 
+template<typename size_type, class RecursiveLockable>
+using GeneralpurposeAddressAllocatorMTCached = AddressAllocatorThreadCachingAdaptor<GeneralpurposeAddressAllocator<size_type>,RecursiveLockable>;
+
 }
 }
 
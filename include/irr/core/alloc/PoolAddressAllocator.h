@@ -209,6 +209,165 @@ namespace irr
 namespace core
 {
 
+/**
+Pool blocks are all interchangeable, so instead of per-thread magazines freed blocks go onto one lock-free stack
+(with an ABA tag) shared by all threads and the pool is only locked to refill that stack in bulk when it runs dry.
+Only the main constructor is provided, call flush() and construct a new allocator to resize.
+*/
+template<typename _size_type, class RecursiveLockable, uint32_t MagazineCapacity, uint32_t CacheSlotCount>
+class AddressAllocatorThreadCachingAdaptor<PoolAddressAllocator<_size_type>,RecursiveLockable,MagazineCapacity,CacheSlotCount> : public AddressAllocatorBasicConcurrencyAdaptor<PoolAddressAllocator<_size_type>,RecursiveLockable>
+{
+        typedef AddressAllocatorBasicConcurrencyAdaptor<PoolAddressAllocator<_size_type>,RecursiveLockable> Base;
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t invalid_block = 0xffffffffu;
+    public:
+        _IRR_DECLARE_ADDRESS_ALLOCATOR_TYPEDEFS(_size_type);
+
+        AddressAllocatorThreadCachingAdaptor(void* reservedSpc, size_type addressOffsetToApply, size_type alignOffsetNeeded, size_type maxAllocatableAlignment, size_type bufSz, size_type blockSz) noexcept :
+                    Base(reservedSpc,addressOffsetToApply,alignOffsetNeeded,maxAllocatableAlignment,bufSz,blockSz),
+                        blockSize(blockSz), combinedOffset(addressOffsetToApply+alignOffsetNeeded), blockCount((bufSz-alignOffsetNeeded)/blockSz),
+                        nextFree(reinterpret_cast<std::atomic<uint32_t>*>(reinterpret_cast<uint8_t*>(reservedSpc)+PoolAddressAllocator<_size_type>::reserved_size(maxAllocatableAlignment,bufSz,blockSz))),
+                        freeHead(packHead(invalid_block,0u))
+        {
+            #ifdef _IRR_DEBUG
+                assert(blockCount<invalid_block);
+            #endif // _IRR_DEBUG
+            for (size_type i=0u; i<blockCount; i++)
+                new (nextFree+i) std::atomic<uint32_t>(invalid_block);
+        }
+
+        virtual ~AddressAllocatorThreadCachingAdaptor() {}
+
+
+        inline void         multi_alloc_addr(uint32_t count, size_type* outAddresses, const size_type* bytes, const size_type* alignment, const size_type* hint=nullptr) noexcept
+        {
+            for (uint32_t i=0; i<count; i++)
+            {
+                // same conditions as PoolAddressAllocator::alloc_addr
+                if (outAddresses[i]!=invalid_address || (blockSize%alignment[i])!=0u || bytes[i]==0u || bytes[i]>blockSize)
+                    continue;
+
+                uint32_t block = popFree();
+                if (block==invalid_block)
+                    block = refill();
+                if (block!=invalid_block)
+                    outAddresses[i] = block*blockSize+combinedOffset;
+            }
+        }
+
+        inline void         multi_free_addr(uint32_t count, const size_type* addr, const size_type* bytes) noexcept
+        {
+            for (uint32_t i=0; i<count; i++)
+            {
+                if (addr[i]==invalid_address)
+                    continue;
+
+                #ifdef _IRR_DEBUG
+                    assert(addr[i]>=combinedOffset && (addr[i]-combinedOffset)%blockSize==0);
+                #endif // _IRR_DEBUG
+                const uint32_t block = (addr[i]-combinedOffset)/blockSize;
+                pushFree(block,block);
+            }
+        }
+
+        //! Returns all cached blocks to the pool
+        inline void         flush() noexcept
+        {
+            uint64_t head = freeHead.load(std::memory_order_relaxed);
+            while (!freeHead.compare_exchange_weak(head,packHead(invalid_block,uint32_t(head>>32u)+1u),std::memory_order_acquire,std::memory_order_relaxed)) {}
+
+            size_type addresses[MagazineCapacity],sizes[MagazineCapacity];
+            std::fill(sizes,sizes+MagazineCapacity,blockSize);
+            uint32_t addressCount = 0u;
+            for (uint32_t block=uint32_t(head); block!=invalid_block; block=nextFree[block].load(std::memory_order_relaxed))
+            {
+                addresses[addressCount++] = block*blockSize+combinedOffset;
+                if (addressCount==MagazineCapacity)
+                {
+                    Base::multi_free_addr(addressCount,addresses,sizes);
+                    addressCount = 0u;
+                }
+            }
+            Base::multi_free_addr(addressCount,addresses,sizes);
+        }
+
+        inline void         reset() noexcept
+        {
+            freeHead.store(packHead(invalid_block,0u),std::memory_order_relaxed);
+            Base::reset();
+        }
+
+        static inline size_type reserved_size(size_type maxAlignment, size_type bufSz, size_type blockSz) noexcept
+        {
+            return PoolAddressAllocator<_size_type>::reserved_size(maxAlignment,bufSz,blockSz)+(bufSz/blockSz)*sizeof(std::atomic<uint32_t>);
+        }
+
+    protected:
+        static inline uint64_t packHead(uint32_t block, uint32_t tag) noexcept
+        {
+            return (uint64_t(tag)<<32u)|block;
+        }
+
+        inline uint32_t     popFree() noexcept
+        {
+            uint64_t head = freeHead.load(std::memory_order_acquire);
+            while (uint32_t(head)!=invalid_block)
+            {
+                // the tag makes the exchange fail if the block got popped and pushed back in the meantime
+                const uint64_t next = packHead(nextFree[uint32_t(head)].load(std::memory_order_relaxed),uint32_t(head>>32u)+1u);
+                if (freeHead.compare_exchange_weak(head,next,std::memory_order_acquire,std::memory_order_acquire))
+                    return uint32_t(head);
+            }
+            return invalid_block;
+        }
+        //! `first` to `last` must already be linked through `nextFree`
+        inline void         pushFree(uint32_t first, uint32_t last) noexcept
+        {
+            uint64_t head = freeHead.load(std::memory_order_relaxed);
+            do
+            {
+                nextFree[last].store(uint32_t(head),std::memory_order_relaxed);
+            } while (!freeHead.compare_exchange_weak(head,packHead(first,uint32_t(head>>32u)+1u),std::memory_order_release,std::memory_order_relaxed));
+        }
+
+        //! Takes a batch of blocks from the pool under the lock, returns one and pushes the rest
+        inline uint32_t     refill() noexcept
+        {
+            size_type addresses[MagazineCapacity],sizes[MagazineCapacity],alignments[MagazineCapacity];
+            std::fill(addresses,addresses+MagazineCapacity,invalid_address);
+            std::fill(sizes,sizes+MagazineCapacity,blockSize);
+            std::fill(alignments,alignments+MagazineCapacity,size_type(1u));
+            Base::multi_alloc_addr(MagazineCapacity,addresses,sizes,alignments);
+
+            uint32_t retval = invalid_block, first = invalid_block, last = invalid_block;
+            for (uint32_t i=0u; i<MagazineCapacity; i++)
+            {
+                if (addresses[i]==invalid_address)
+                    continue;
+
+                const uint32_t block = (addresses[i]-combinedOffset)/blockSize;
+                if (retval==invalid_block)
+                    retval = block;
+                else
+                {
+                    if (last!=invalid_block)
+                        nextFree[last].store(block,std::memory_order_relaxed);
+                    else
+                        first = block;
+                    last = block;
+                }
+            }
+            if (first!=invalid_block)
+                pushFree(first,last);
+            return retval;
+        }
+
+        size_type               blockSize;
+        size_type               combinedOffset;
+        size_type               blockCount;
+        std::atomic<uint32_t>*  nextFree;
+        std::atomic<uint64_t>   freeHead;
+};
+
 // aliases
 template<typename size_type>
 using PoolAddressAllocatorST = PoolAddressAllocator<size_type>;
@@ -216,6 +375,9 @@ using PoolAddressAllocatorST = PoolAddressAllocator<size_type>;
 template<typename size_type, class RecursiveLockable>
 using PoolAddressAllocatorMT = AddressAllocatorBasicConcurrencyAdaptor<PoolAddressAllocator<size_type>,RecursiveLockable>;
 
+template<typename size_type, class RecursiveLockable>
+using PoolAddressAllocatorMTCached = AddressAllocatorThreadCachingAdaptor<PoolAddressAllocator<size_type>,RecursiveLockable>;
+
 }
 }
 
@@ -0,0 +1,466 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBAW Engine"
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __IRR_TLSF_ADDRESS_ALLOCATOR_H_INCLUDED__
+#define __IRR_TLSF_ADDRESS_ALLOCATOR_H_INCLUDED__
+
+#include "IrrCompileConfig.h"
+
+#include "irr/core/math/irrMath.h"
+
+#include "irr/core/alloc/AddressAllocatorBase.h"
+
+namespace irr
+{
+namespace core
+{
+
+//! Two-Level Segregated Fit allocator, alloc and free are O(1) and a freed block coalesces with its free neighbours straight away
+/** The buffer is split into units of `minBlockSz` (has to be a power of two) and every block spans a whole number of units.
+Free blocks are kept in segregated free lists, the first level is the power of two size class and the second level splits it into 16 linear ranges,
+non-empty lists are tracked in bitmaps so a list with a block large enough is found with two bit scans.
+The requested size is rounded up to the next list's lower bound when searching so any block of the list fits (good-fit instead of best-fit),
+alignment padding is accounted for up-front, so unlike GeneralpurposeAddressAllocator there is never a need for a `defragment()` pass.
+A header per unit and the list heads live in the reserved space, the allocator itself never touches the buffer.
+Only power of two alignments are supported. */
+template<typename _size_type>
+class TLSFAddressAllocator : public AddressAllocatorBase<TLSFAddressAllocator<_size_type>,_size_type>
+{
+    private:
+        typedef AddressAllocatorBase<TLSFAddressAllocator<_size_type>,_size_type> Base;
+    public:
+        _IRR_DECLARE_ADDRESS_ALLOCATOR_TYPEDEFS(_size_type);
+
+        static constexpr bool supportsNullBuffer = true;
+
+    protected:
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t secondLevelLog2 = 4u;
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t secondLevelCount = 0x1u<<secondLevelLog2;
+        _IRR_STATIC_INLINE_CONSTEXPR uint32_t maxFirstLevels = sizeof(size_type)*8u-secondLevelLog2+1u;
+
+        //! Header of the block starting at a unit, headers of units in the middle of a block are stale
+        struct Block
+        {
+            size_type   unitCount;
+            size_type   prevPhysical; // start unit of the block right before this one, invalid_address for the first
+            size_type   prevFree;
+            size_type   nextFree;
+            bool        free;
+        };
+
+    public:
+        #define DUMMY_DEFAULT_CONSTRUCTOR TLSFAddressAllocator() noexcept : minBlockSize(invalid_address), unitCount(0u), firstLevelCount(0u), freeSize(0u),\
+                                                lastBlock(invalid_address), blocks(nullptr), freeListHeads(nullptr), firstLevelBitmap(0ull), secondLevelBitmap{} {}
+        GCC_CONSTRUCTOR_INHERITANCE_BUG_WORKAROUND(DUMMY_DEFAULT_CONSTRUCTOR)
+        #undef DUMMY_DEFAULT_CONSTRUCTOR
+
+        virtual ~TLSFAddressAllocator() {}
+
+        TLSFAddressAllocator(void* reservedSpc, size_type addressOffsetToApply, size_type alignOffsetNeeded, size_type maxAllocatableAlignment, size_type bufSz, size_type minBlockSz) noexcept :
+                    Base(reservedSpc,addressOffsetToApply,alignOffsetNeeded,maxAllocatableAlignment), minBlockSize(minBlockSz), unitCount((bufSz-Base::alignOffset)/minBlockSz),
+                    firstLevelCount(findFirstLevelCount(unitCount)), freeSize(0u), lastBlock(invalid_address), firstLevelBitmap(0ull)
+        {
+            // units are indexed by `address/minBlockSize` and alignments are powers of two, this keeps every block boundary on the unit grid
+            assert(core::isPoT(minBlockSize));
+            // buffer has to be large enough for at least one block of minimum size
+            assert(bufSz>=Base::alignOffset+minBlockSize && unitCount<invalid_address);
+
+            setReservedPointers();
+            reset();
+        }
+
+        //! When resizing we require that the copying of data buffer has already been handled by the user of the address allocator even if `supportsNullBuffer==true`
+        /** When shrinking, the cut-off part of the buffer must be free, see safe_shrink_size(). */
+        template<typename... Args>
+        TLSFAddressAllocator(size_type newBuffSz, TLSFAddressAllocator&& other, void* newReservedSpc, Args&&... args) noexcept :
+                    Base(std::move(other),newReservedSpc,std::forward<Args>(args)...), minBlockSize(other.minBlockSize), unitCount((newBuffSz-Base::alignOffset)/other.minBlockSize),
+                    firstLevelCount(findFirstLevelCount(unitCount)), freeSize(0u), lastBlock(invalid_address), firstLevelBitmap(0ull)
+        {
+            #ifdef _IRR_DEBUG
+                assert(Base::checkResize(newBuffSz,Base::alignOffset));
+            #endif // _IRR_DEBUG
+            setReservedPointers();
+            clearFreeLists();
+
+            // copy the blocks across in address order, relinking the free ones
+            for (size_type unit=0u; unit<other.unitCount && unit<unitCount; unit+=other.blocks[unit].unitCount)
+            {
+                const Block& block = other.blocks[unit];
+                const size_type count = std::min(block.unitCount,unitCount-unit);
+                #ifdef _IRR_DEBUG
+                    assert(block.free || count==block.unitCount); // an allocation got cut off
+                #endif // _IRR_DEBUG
+                blocks[unit] = Block{count,lastBlock,invalid_address,invalid_address,false};
+                lastBlock = unit;
+                if (block.free)
+                    insertFreeBlock(unit);
+            }
+            // new space at the end
+            if (unitCount>other.unitCount)
+            {
+                if (blocks[lastBlock].free)
+                {
+                    removeFreeBlock(lastBlock);
+                    blocks[lastBlock].unitCount += unitCount-other.unitCount;
+                }
+                else
+                {
+                    blocks[other.unitCount] = Block{unitCount-other.unitCount,lastBlock,invalid_address,invalid_address,false};
+                    lastBlock = other.unitCount;
+                }
+                insertFreeBlock(lastBlock);
+            }
+
+            other.minBlockSize = invalid_address;
+            other.unitCount = 0u;
+            other.firstLevelCount = 0u;
+            other.freeSize = 0u;
+            other.lastBlock = invalid_address;
+            other.blocks = nullptr;
+            other.freeListHeads = nullptr;
+            other.firstLevelBitmap = 0ull;
+        }
+
+        TLSFAddressAllocator& operator=(TLSFAddressAllocator&& other)
+        {
+            Base::operator=(std::move(other));
+            std::swap(minBlockSize,other.minBlockSize);
+            std::swap(unitCount,other.unitCount);
+            std::swap(firstLevelCount,other.firstLevelCount);
+            std::swap(freeSize,other.freeSize);
+            std::swap(lastBlock,other.lastBlock);
+            std::swap(blocks,other.blocks);
+            std::swap(freeListHeads,other.freeListHeads);
+            std::swap(firstLevelBitmap,other.firstLevelBitmap);
+            std::swap(secondLevelBitmap,other.secondLevelBitmap);
+            return *this;
+        }
+
+
+        //! O(1), `hint` is ignored
+        inline size_type        alloc_addr( size_type bytes, size_type alignment, size_type hint=0ull) noexcept
+        {
+            if (alignment>Base::maxRequestableAlignment || bytes==0u || !core::isPoT(alignment))
+                return invalid_address;
+
+            const size_type units = (bytes-1u)/minBlockSize+1u;
+            const size_type alignUnits = alignment>minBlockSize ? (alignment/minBlockSize):size_type(1u);
+            // a block this large fits the allocation whatever the misalignment of its start
+            const size_type searchUnits = units+alignUnits-1u;
+            if (searchUnits>freeSize/minBlockSize)
+                return invalid_address;
+
+            size_type unit = findSuitableBlock(searchUnits);
+            if (unit==invalid_address)
+            {
+                // the rounded up search skips the list of the exact size class, but its head still might fit (i.e. a request for the whole buffer)
+                uint32_t fl,sl;
+                mappingInsert(searchUnits,fl,sl);
+                unit = freeListHeads[fl*secondLevelCount+sl];
+                if (unit==invalid_address || core::roundUp(unit,alignUnits)+units>unit+blocks[unit].unitCount)
+                    return invalid_address;
+            }
+            removeFreeBlock(unit);
+
+            // trim the front padding and the back, their other neighbours are allocated (free blocks are always coalesced)
+            const size_type alignedUnit = core::roundUp(unit,alignUnits);
+            if (alignedUnit!=unit)
+            {
+                splitBlock(unit,alignedUnit-unit);
+                insertFreeBlock(unit);
+                unit = alignedUnit;
+            }
+            if (blocks[unit].unitCount>units)
+                insertFreeBlock(splitBlock(unit,units));
+
+            return unit*minBlockSize+Base::combinedOffset;
+        }
+
+        //! O(1)
+        inline void             free_addr(size_type addr, size_type bytes) noexcept
+        {
+            #ifdef _IRR_DEBUG
+                // address must have had combinedOffset already applied to it, and allocation must not be outside the buffer
+                assert(addr>=Base::combinedOffset && (addr-Base::combinedOffset)%minBlockSize==0u && (addr-Base::combinedOffset)/minBlockSize<unitCount);
+            #endif // _IRR_DEBUG
+            size_type unit = (addr-Base::combinedOffset)/minBlockSize;
+            #ifdef _EXTREME_DEBUG
+                // double free protection
+                assert(!is_double_free(addr,bytes));
+            #endif // _EXTREME_DEBUG
+            #ifdef _IRR_DEBUG
+                assert(!blocks[unit].free && blocks[unit].unitCount==(std::max<size_type>(bytes,1u)-1u)/minBlockSize+1u);
+            #endif // _IRR_DEBUG
+
+            const size_type next = unit+blocks[unit].unitCount;
+            if (next<unitCount && blocks[next].free)
+            {
+                removeFreeBlock(next);
+                mergeWithNext(unit);
+            }
+            const size_type prev = blocks[unit].prevPhysical;
+            if (prev!=invalid_address && blocks[prev].free)
+            {
+                removeFreeBlock(prev);
+                mergeWithNext(prev);
+                unit = prev;
+            }
+            insertFreeBlock(unit);
+        }
+
+        inline void             reset()
+        {
+            clearFreeLists();
+            blocks[0u] = Block{unitCount,invalid_address,invalid_address,invalid_address,false};
+            lastBlock = 0u;
+            insertFreeBlock(0u);
+        }
+
+        //! Conservative estimate, max_size() gives largest size we are sure to be able to allocate
+        inline size_type        max_size() const noexcept
+        {
+            if (!firstLevelBitmap)
+                return 0u;
+
+            // lower bound of the size class of the largest free block
+            const uint32_t fl = core::findMSB(firstLevelBitmap);
+            const uint32_t sl = core::findMSB(secondLevelBitmap[fl]);
+            const size_type units = fl ? (size_type(secondLevelCount+sl)<<size_type(fl-1u)):size_type(sl);
+
+            const size_type maxWastedUnits = Base::maxRequestableAlignment>minBlockSize ? (Base::maxRequestableAlignment/minBlockSize-1u):size_type(0u);
+            if (units>maxWastedUnits)
+                return (units-maxWastedUnits)*minBlockSize;
+            return 0u;
+        }
+
+        //! Most allocators do not support e.g. 1-byte allocations
+        inline size_type        min_size() const noexcept
+        {
+            return minBlockSize;
+        }
+
+        inline size_type        safe_shrink_size(size_type sizeBound, size_type newBuffAlignmentWeCanGuarantee=1u) const noexcept
+        {
+            size_type retval = get_total_size()-Base::alignOffset;
+            if (sizeBound>=retval)
+                return Base::safe_shrink_size(sizeBound,newBuffAlignmentWeCanGuarantee);
+
+            // free blocks are always coalesced, so only the last one can be cut off
+            if (blocks[lastBlock].free)
+                retval = lastBlock*minBlockSize;
+
+            return Base::safe_shrink_size(std::max(retval,sizeBound),newBuffAlignmentWeCanGuarantee);
+        }
+
+
+        static inline size_type reserved_size(size_type maxAlignment, size_type bufSz, size_type minBlockSz) noexcept
+        {
+            const size_type maxUnitCount = bufSz/minBlockSz;
+            return maxUnitCount*sizeof(Block)+findFirstLevelCount(maxUnitCount)*secondLevelCount*sizeof(size_type);
+        }
+        static inline size_type reserved_size(const TLSFAddressAllocator<_size_type>& other, size_type bufSz) noexcept
+        {
+            return reserved_size(other.maxRequestableAlignment,bufSz,other.minBlockSize);
+        }
+
+        inline size_type        get_free_size() const noexcept
+        {
+            return freeSize;
+        }
+        inline size_type        get_allocated_size() const noexcept
+        {
+            return unitCount*minBlockSize-freeSize;
+        }
+        inline size_type        get_total_size() const noexcept
+        {
+            return unitCount*minBlockSize+Base::alignOffset;
+        }
+
+        //! Walks all the blocks, so its only meant for debugging
+        inline bool             is_double_free(size_type addr, size_type bytes) const noexcept
+        {
+            addr -= Base::combinedOffset;
+            bytes = std::max<size_type>(bytes,1u);
+            for (size_type unit=0u; unit<unitCount; unit+=blocks[unit].unitCount)
+            {
+                const size_type start = unit*minBlockSize;
+                const size_type end = start+blocks[unit].unitCount*minBlockSize;
+                if (blocks[unit].free && addr<end && addr+bytes>start)
+                    return true;
+            }
+            return false;
+        }
+    protected:
+        size_type   minBlockSize;
+        size_type   unitCount;
+        uint32_t    firstLevelCount;
+        size_type   freeSize;
+        size_type   lastBlock;
+        Block*      blocks;
+        size_type*  freeListHeads;
+        uint64_t    firstLevelBitmap;
+        uint32_t    secondLevelBitmap[maxFirstLevels];
+
+        static inline uint32_t  findFirstLevelCount(size_type _unitCount) noexcept
+        {
+            if (_unitCount<secondLevelCount)
+                return 1u;
+            return core::findMSB(_unitCount)-secondLevelLog2+2u;
+        }
+
+        //! Free list of blocks of `_units` size
+        static inline void      mappingInsert(size_type _units, uint32_t& _fl, uint32_t& _sl) noexcept
+        {
+            if (_units<secondLevelCount)
+            {
+                _fl = 0u;
+                _sl = _units;
+                return;
+            }
+            const uint32_t msb = core::findMSB(_units);
+            _fl = msb-secondLevelLog2+1u;
+            _sl = (_units>>size_type(msb-secondLevelLog2))-secondLevelCount;
+        }
+        //! First free list whose every block is at least `_units` large
+        static inline void      mappingSearch(size_type _units, uint32_t& _fl, uint32_t& _sl) noexcept
+        {
+            if (_units>=secondLevelCount)
+                _units += (size_type(0x1u)<<size_type(core::findMSB(_units)-secondLevelLog2))-1u;
+            mappingInsert(_units,_fl,_sl);
+        }
+
+        inline void             setReservedPointers() noexcept
+        {
+            blocks = reinterpret_cast<Block*>(Base::reservedSpace);
+            freeListHeads = reinterpret_cast<size_type*>(blocks+unitCount);
+        }
+
+        inline void             clearFreeLists() noexcept
+        {
+            std::fill(freeListHeads,freeListHeads+firstLevelCount*secondLevelCount,invalid_address);
+            firstLevelBitmap = 0ull;
+            std::fill(secondLevelBitmap,secondLevelBitmap+maxFirstLevels,0u);
+            freeSize = 0u;
+        }
+
+        //! @returns start unit of a free block of at least `_units`, or invalid_address
+        inline size_type        findSuitableBlock(size_type _units) const noexcept
+        {
+            uint32_t fl,sl;
+            mappingSearch(_units,fl,sl);
+            if (fl>=firstLevelCount)
+                return invalid_address;
+
+            uint32_t secondLevelMap = secondLevelBitmap[fl]&(~0u<<sl);
+            if (!secondLevelMap)
+            {
+                const uint64_t firstLevelMap = fl+1u<64u ? (firstLevelBitmap&(~0ull<<uint64_t(fl+1u))):0ull;
+                if (!firstLevelMap)
+                    return invalid_address;
+                fl = core::findLSB(firstLevelMap);
+                secondLevelMap = secondLevelBitmap[fl];
+            }
+            sl = core::findLSB(secondLevelMap);
+            return freeListHeads[fl*secondLevelCount+sl];
+        }
+
+        inline void             insertFreeBlock(size_type _unit) noexcept
+        {
+            Block& block = blocks[_unit];
+            uint32_t fl,sl;
+            mappingInsert(block.unitCount,fl,sl);
+            size_type& head = freeListHeads[fl*secondLevelCount+sl];
+
+            block.free = true;
+            block.prevFree = invalid_address;
+            block.nextFree = head;
+            if (head!=invalid_address)
+                blocks[head].prevFree = _unit;
+            head = _unit;
+
+            firstLevelBitmap |= 0x1ull<<uint64_t(fl);
+            secondLevelBitmap[fl] |= 0x1u<<sl;
+            freeSize += block.unitCount*minBlockSize;
+        }
+
+        inline void             removeFreeBlock(size_type _unit) noexcept
+        {
+            Block& block = blocks[_unit];
+            #ifdef _IRR_DEBUG
+                assert(block.free);
+            #endif // _IRR_DEBUG
+            uint32_t fl,sl;
+            mappingInsert(block.unitCount,fl,sl);
+            size_type& head = freeListHeads[fl*secondLevelCount+sl];
+
+            if (block.prevFree!=invalid_address)
+                blocks[block.prevFree].nextFree = block.nextFree;
+            else
+                head = block.nextFree;
+            if (block.nextFree!=invalid_address)
+                blocks[block.nextFree].prevFree = block.prevFree;
+
+            if (head==invalid_address)
+            {
+                secondLevelBitmap[fl] &= ~(0x1u<<sl);
+                if (!secondLevelBitmap[fl])
+                    firstLevelBitmap &= ~(0x1ull<<uint64_t(fl));
+            }
+            block.free = false;
+            freeSize -= block.unitCount*minBlockSize;
+        }
+
+        //! Splits off everything past the first `_units` into a new (not free) block, @returns its start unit
+        inline size_type        splitBlock(size_type _unit, size_type _units) noexcept
+        {
+            const size_type rest = _unit+_units;
+            blocks[rest] = Block{blocks[_unit].unitCount-_units,_unit,invalid_address,invalid_address,false};
+            blocks[_unit].unitCount = _units;
+
+            const size_type next = rest+blocks[rest].unitCount;
+            if (next<unitCount)
+                blocks[next].prevPhysical = rest;
+            else
+                lastBlock = rest;
+            return rest;
+        }
+
+        //! Absorbs the block right after, which must already be off the free lists
+        inline void             mergeWithNext(size_type _unit) noexcept
+        {
+            blocks[_unit].unitCount += blocks[_unit+blocks[_unit].unitCount].unitCount;
+
+            const size_type next = _unit+blocks[_unit].unitCount;
+            if (next<unitCount)
+                blocks[next].prevPhysical = _unit;
+            else
+                lastBlock = _unit;
+        }
+};
+
+
+}
+}
+
+#include "irr/core/alloc/AddressAllocatorConcurrencyAdaptors.h"
+
+namespace irr
+{
+namespace core
+{
+
+// aliases
+template<typename size_type>
+using TLSFAddressAllocatorST = TLSFAddressAllocator<size_type>;
+
+template<typename size_type, class RecursiveLockable>
+using TLSFAddressAllocatorMT = AddressAllocatorBasicConcurrencyAdaptor<TLSFAddressAllocator<size_type>,RecursiveLockable>;
+
+template<typename size_type, class RecursiveLockable>
+using TLSFAddressAllocatorMTCached = AddressAllocatorThreadCachingAdaptor<TLSFAddressAllocator<size_type>,RecursiveLockable>;
+
+}
+}
+
+#endif // __IRR_TLSF_ADDRESS_ALLOCATOR_H_INCLUDED__
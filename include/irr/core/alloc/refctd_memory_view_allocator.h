@@ -0,0 +1,69 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBAW Engine"
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __IRR_REFCTD_MEMORY_VIEW_ALLOCATOR_H_INCLUDED__
+#define __IRR_REFCTD_MEMORY_VIEW_ALLOCATOR_H_INCLUDED__
+
+#include "IrrCompileConfig.h"
+#include "irr/core/IReferenceCounted.h"
+#include "irr/core/alloc/AllocatorTrivialBases.h"
+
+namespace irr
+{
+namespace core
+{
+
+//! Allocator which never allocates, it is used to adopt a view into memory owned by some reference counted object.
+/** The owner (for instance a memory mapped file) is kept alive for as long as the allocator exists,
+so a container adopting the view via `core::adopt_memory` can outlive every other reference to the owner.
+`deallocate` only releases the owner, the memory itself is never freed by this allocator. */
+template <class T>
+class IRR_FORCE_EBO refctd_memory_view_allocator : public irr::core::AllocatorTrivialBase<T>
+{
+        smart_refctd_ptr<const IReferenceCounted> owner;
+
+        template<typename U> friend class refctd_memory_view_allocator;
+    public:
+        typedef size_t      size_type;
+        typedef ptrdiff_t   difference_type;
+
+        template< class U> struct rebind { typedef refctd_memory_view_allocator<U> other; };
+
+
+        refctd_memory_view_allocator() = default;
+        explicit refctd_memory_view_allocator(smart_refctd_ptr<const IReferenceCounted>&& _owner) : owner(std::move(_owner)) {}
+        template<typename U>
+        refctd_memory_view_allocator(const refctd_memory_view_allocator<U>& other) : owner(other.owner) {}
+        template<typename U>
+        refctd_memory_view_allocator(refctd_memory_view_allocator<U>&& other) : owner(std::move(other.owner)) {}
+
+
+        inline typename refctd_memory_view_allocator::pointer  allocate(size_type n, typename refctd_memory_view_allocator::const_void_pointer hint=nullptr) noexcept
+        {
+            return nullptr;
+        }
+
+        inline void deallocate(typename refctd_memory_view_allocator::pointer p, size_type n) noexcept
+        {
+            owner = smart_refctd_ptr<const IReferenceCounted>();
+        }
+
+        inline const IReferenceCounted* getOwner() const {return owner.get();}
+
+        template<typename U>
+        inline bool operator!=(const refctd_memory_view_allocator<U>& other) const noexcept
+        {
+            return owner.get()!=other.owner.get();
+        }
+        template<typename U>
+        inline bool operator==(const refctd_memory_view_allocator<U>& other) const noexcept
+        {
+            return owner.get()==other.owner.get();
+        }
+};
+
+} // end namespace core
+} // end namespace irr
+
+#endif
@@ -0,0 +1,124 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBAW Engine"
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __IRR_FAST_ATOF_H_INCLUDED__
+#define __IRR_FAST_ATOF_H_INCLUDED__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "irr/core/Types.h"
+
+namespace irr
+{
+namespace core
+{
+
+namespace impl
+{
+    inline bool isDigit(const char _c) { return static_cast<unsigned char>(_c-'0')<10u; }
+}
+
+//! Parses a float at `_in` the same way regardless of the C locale, does not skip whitespace.
+/** Handles an optional sign, digits with an optional fraction and an optional exponent, which is everything text mesh formats write,
+anything else (inf, nan, hex floats) goes through strtof. The first 19 significant digits are accumulated in an integer and scaled by
+a power of ten once, in double precision, so the result is either the correctly rounded float or one ulp away from it.
+\return Pointer past the last character of the number, `_in` if there was no number. */
+inline const char* fast_atof_move(const char* _in, float& _out)
+{
+    const char* c = _in;
+    const bool negative = *c=='-';
+    if (*c=='-' || *c=='+')
+        c++;
+
+    uint64_t mantissa = 0u;
+    int32_t exponent = 0;
+    uint32_t significantDigits = 0u;
+    bool anyDigits = false;
+    for (; impl::isDigit(*c); c++)
+    {
+        anyDigits = true;
+        if (significantDigits<19u)
+        {
+            mantissa = mantissa*10u+uint64_t(*c-'0');
+            significantDigits += mantissa ? 1u:0u;
+        }
+        else
+            exponent++;
+    }
+    if (*c=='.')
+    {
+        for (c++; impl::isDigit(*c); c++)
+        {
+            anyDigits = true;
+            if (significantDigits<19u)
+            {
+                mantissa = mantissa*10u+uint64_t(*c-'0');
+                significantDigits += mantissa ? 1u:0u;
+                exponent--;
+            }
+        }
+    }
+    if (!anyDigits)
+    {
+        char* end;
+        _out = strtof(_in,&end);
+        return end;
+    }
+
+    if (*c=='e' || *c=='E')
+    {
+        const char* e = c+1;
+        const bool negativeExponent = *e=='-';
+        if (*e=='-' || *e=='+')
+            e++;
+        if (impl::isDigit(*e))
+        {
+            int32_t exponentValue = 0;
+            for (; impl::isDigit(*e); e++)
+            {
+                if (exponentValue<100000)
+                    exponentValue = exponentValue*10+(*e-'0');
+            }
+            exponent += negativeExponent ? -exponentValue:exponentValue;
+            c = e;
+        }
+    }
+
+    // powers of ten up to 22 are exact in double, dividing by them is more precise than multiplying by their inexact reciprocals
+    static const double powersOf10[] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+    double value = double(mantissa);
+    if (mantissa && exponent)
+    {
+        const int32_t absExponent = exponent<0 ? -exponent:exponent;
+        const double scale = absExponent<=22 ? powersOf10[absExponent]:std::pow(10.0,double(absExponent));
+        value = exponent<0 ? (value/scale):(value*scale);
+    }
+    _out = static_cast<float>(negative ? -value:value);
+    return c;
+}
+
+//! Variant of fast_atof_move for text which is not null terminated (memory mapped files), never reads at or past `_end`.
+inline const char* fast_atof_move(const char* _in, const char* _end, float& _out)
+{
+    // any whitespace before `_end` stops the parse in time
+    const char* wordEnd = _in;
+    while (wordEnd!=_end && *wordEnd!=' ' && *wordEnd!='\t' && *wordEnd!='\n' && *wordEnd!='\r')
+        wordEnd++;
+    if (wordEnd!=_end)
+        return fast_atof_move(_in,_out);
+
+    char word[64];
+    const size_t length = std::min<size_t>(_end-_in,sizeof(word)-1u);
+    memcpy(word,_in,length);
+    word[length] = 0;
+    return _in+(fast_atof_move(word,_out)-word);
+}
+
+} // end namespace core
+} // end namespace irr
+
+#endif
@@ -0,0 +1,393 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBAW Engine"
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __IRR_OPEN_ADDRESSING_MULTIMAP_H_INCLUDED__
+#define __IRR_OPEN_ADDRESSING_MULTIMAP_H_INCLUDED__
+
+#include <iterator>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "irr/core/Types.h"//for core::allocator
+#include "coreutil.h"//for XXHash_256
+
+namespace irr { namespace core
+{
+
+//! Default hash of open_addressing_multimap, strings (usually paths) are hashed with XXHash_256 and everything else with std::hash
+template<typename K>
+struct open_addressing_hash : std::hash<K> {};
+template<typename K>
+struct open_addressing_hash<const K> : open_addressing_hash<K> {};
+template<typename C, typename T, typename A>
+struct open_addressing_hash<std::basic_string<C,T,A>>
+{
+    inline size_t operator()(const std::basic_string<C,T,A>& _str) const
+    {
+        uint64_t out[4];
+        XXHash_256(_str.data(), _str.size()*sizeof(C), out);
+        return static_cast<size_t>(out[0]^out[1]^out[2]^out[3]);
+    }
+};
+
+//! Multimap with open addressing (linear probing) over a flat array, meant to replace node-based std::multimap in caches with a lot of entries.
+/** Hash of every key is computed once on insertion and stored alongside the pair in a separate array, so probing touches only that array
+and a key is compared (and never re-hashed, not even on rehash) only when the stored hashes match. Erasure shifts following pairs back, so there are no tombstones.
+Implements the subset of std::unordered_multimap's interface that CObjectCache needs, with these differences:
+- any insertion or erasure invalidates all iterators and references,
+- iterators returned by equal_range() and insert() walk only the pairs with the same key, so `std::next(insert(...))` is the end of its key's range,
+- value_type has a non-const key (as in vector-backed caches) so that pairs can be moved around, it must not be modified through iterators. */
+template<
+    typename K,
+    typename T,
+    class Hash = open_addressing_hash<K>,
+    class KeyEqual = std::equal_to<K>,
+    class Alloc = core::allocator<std::pair<typename std::remove_const<K>::type, T>>
+>
+class open_addressing_multimap
+{
+public:
+    using key_type = typename std::remove_const<K>::type;
+    using mapped_type = T;
+    using value_type = std::pair<key_type, T>;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<value_type>;
+
+private:
+    using hash_allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<size_t>;
+    using value_traits = std::allocator_traits<allocator_type>;
+
+    // stored hash of 0 marks an empty slot, real hashes are never 0
+    static constexpr size_t EmptySlot = 0u;
+    static constexpr size_t MinCapacity = 16u;
+
+    size_t* m_hashes = nullptr;
+    value_type* m_values = nullptr;
+    size_t m_capacity = 0u; // always 0 or a power of two
+    size_t m_size = 0u;
+    hasher m_hasher;
+    key_equal m_keyEqual;
+    allocator_type m_valueAlloc;
+    hash_allocator_type m_hashAlloc;
+
+    template<bool IsConst>
+    class iterator_impl
+    {
+        friend class open_addressing_multimap;
+        template<bool> friend class iterator_impl;
+
+        using owner_t = typename std::conditional<IsConst, const open_addressing_multimap, open_addressing_multimap>::type;
+
+        owner_t* m_owner = nullptr;
+        size_t m_ix = 0u;
+        // only for iterators over a single key's range, 0 means the iterator walks over the whole container
+        size_t m_hash = EmptySlot;
+        const key_type* m_key = nullptr;
+
+        iterator_impl(owner_t* _owner, size_t _ix, size_t _hash=EmptySlot, const key_type* _key=nullptr) : m_owner(_owner), m_ix(_ix), m_hash(_hash), m_key(_key) {}
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename open_addressing_multimap::value_type;
+        using difference_type = ptrdiff_t;
+        using reference = typename std::conditional<IsConst, const value_type&, value_type&>::type;
+        using pointer = typename std::conditional<IsConst, const value_type*, value_type*>::type;
+
+        iterator_impl() = default;
+        template<bool OtherConst, typename = typename std::enable_if<IsConst&&!OtherConst>::type>
+        iterator_impl(const iterator_impl<OtherConst>& other) : m_owner(other.m_owner), m_ix(other.m_ix), m_hash(other.m_hash), m_key(other.m_key) {}
+
+        inline reference operator*() const { return m_owner->m_values[m_ix]; }
+        inline pointer operator->() const { return m_owner->m_values+m_ix; }
+
+        inline iterator_impl& operator++()
+        {
+            if (m_hash==EmptySlot)
+                m_ix = m_owner->nextOccupied(m_ix+1u);
+            else
+                m_ix = m_owner->nextInChain(m_ix, m_hash, *m_key);
+            return *this;
+        }
+        inline iterator_impl operator++(int)
+        {
+            iterator_impl tmp(*this);
+            ++(*this);
+            return tmp;
+        }
+
+        template<bool OtherConst>
+        inline bool operator==(const iterator_impl<OtherConst>& other) const { return m_ix==other.m_ix; }
+        template<bool OtherConst>
+        inline bool operator!=(const iterator_impl<OtherConst>& other) const { return m_ix!=other.m_ix; }
+    };
+
+public:
+    using iterator = iterator_impl<false>;
+    using const_iterator = iterator_impl<true>;
+    // only for interface compatibility with the other containers CObjectCache can use, the iterators are forward-only
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    open_addressing_multimap() = default;
+    explicit open_addressing_multimap(const allocator_type& _alloc) : m_valueAlloc(_alloc), m_hashAlloc(_alloc) {}
+    open_addressing_multimap(const open_addressing_multimap& other) : m_hasher(other.m_hasher), m_keyEqual(other.m_keyEqual),
+        m_valueAlloc(value_traits::select_on_container_copy_construction(other.m_valueAlloc)), m_hashAlloc(m_valueAlloc)
+    {
+        reserve(other.m_size);
+        for (size_t i=0u; i<other.m_capacity; i++)
+        if (other.m_hashes[i]!=EmptySlot)
+            insertHashed(other.m_hashes[i], other.m_values[i]);
+    }
+    open_addressing_multimap(open_addressing_multimap&& other) : open_addressing_multimap()
+    {
+        operator=(std::move(other));
+    }
+    ~open_addressing_multimap()
+    {
+        clear();
+        deallocate();
+    }
+
+    open_addressing_multimap& operator=(const open_addressing_multimap& other)
+    {
+        if (this!=&other)
+        {
+            open_addressing_multimap tmp(other);
+            operator=(std::move(tmp));
+        }
+        return *this;
+    }
+    open_addressing_multimap& operator=(open_addressing_multimap&& other)
+    {
+        std::swap(m_hashes, other.m_hashes);
+        std::swap(m_values, other.m_values);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_size, other.m_size);
+        std::swap(m_hasher, other.m_hasher);
+        std::swap(m_keyEqual, other.m_keyEqual);
+        std::swap(m_valueAlloc, other.m_valueAlloc);
+        std::swap(m_hashAlloc, other.m_hashAlloc);
+        return *this;
+    }
+
+    inline size_type size() const { return m_size; }
+    inline bool empty() const { return m_size==0u; }
+    inline size_type bucket_count() const { return m_capacity; }
+    inline hasher hash_function() const { return m_hasher; }
+    inline key_equal key_eq() const { return m_keyEqual; }
+
+    inline iterator begin() { return iterator(this, nextOccupied(0u)); }
+    inline iterator end() { return iterator(this, m_capacity); }
+    inline const_iterator begin() const { return cbegin(); }
+    inline const_iterator end() const { return cend(); }
+    inline const_iterator cbegin() const { return const_iterator(this, nextOccupied(0u)); }
+    inline const_iterator cend() const { return const_iterator(this, m_capacity); }
+
+    //! Makes room for `_count` pairs, so that inserting up to that many of them won't rehash
+    inline void reserve(size_type _count)
+    {
+        if (_count*4u <= m_capacity*3u)
+            return;
+        size_t newCapacity = m_capacity ? m_capacity:MinCapacity;
+        while (_count*4u > newCapacity*3u)
+            newCapacity <<= 1;
+        rehash(newCapacity);
+    }
+
+    inline void clear()
+    {
+        for (size_t i=0u; i<m_capacity; i++)
+        if (m_hashes[i]!=EmptySlot)
+        {
+            value_traits::destroy(m_valueAlloc, m_values+i);
+            m_hashes[i] = EmptySlot;
+        }
+        m_size = 0u;
+    }
+
+    //! @returns iterator over the pairs with the same key, positioned at the inserted one
+    inline iterator insert(const value_type& _val)
+    {
+        const size_t hash = hashOf(_val.first);
+        reserve(m_size+1u);
+        const size_t ix = insertHashed(hash, _val);
+        return iterator(this, ix, hash, &m_values[ix].first);
+    }
+    inline iterator insert(value_type&& _val)
+    {
+        const size_t hash = hashOf(_val.first);
+        reserve(m_size+1u);
+        const size_t ix = insertHashed(hash, std::move(_val));
+        return iterator(this, ix, hash, &m_values[ix].first);
+    }
+    //! The hint is ignored, present only for interface compatibility
+    inline iterator insert(const_iterator, const value_type& _val) { return insert(_val); }
+    inline iterator insert(const_iterator, value_type&& _val) { return insert(std::move(_val)); }
+
+    inline void erase(const_iterator _it)
+    {
+        size_t hole = _it.m_ix;
+        value_traits::destroy(m_valueAlloc, m_values+hole);
+        m_hashes[hole] = EmptySlot;
+        m_size--;
+
+        // backward shift: move every following pair of the cluster which may be placed in the hole without breaking its probe chain
+        const size_t mask = m_capacity-1u;
+        for (size_t ix=(hole+1u)&mask; m_hashes[ix]!=EmptySlot; ix=(ix+1u)&mask)
+        {
+            const size_t home = m_hashes[ix]&mask;
+            // can move when `home` is not cyclically within (hole,ix]
+            const bool canMove = hole<=ix ? (home<=hole||home>ix):(home<=hole&&home>ix);
+            if (!canMove)
+                continue;
+            value_traits::construct(m_valueAlloc, m_values+hole, std::move(m_values[ix]));
+            value_traits::destroy(m_valueAlloc, m_values+ix);
+            m_hashes[hole] = m_hashes[ix];
+            m_hashes[ix] = EmptySlot;
+            hole = ix;
+        }
+    }
+
+    inline std::pair<iterator,iterator> equal_range(const key_type& _key)
+    {
+        size_t hash, first, last;
+        findChain(_key, hash, first, last);
+        return { iterator(this, first, hash, first==last ? nullptr:&m_values[first].first), iterator(this, last, hash) };
+    }
+    inline std::pair<const_iterator,const_iterator> equal_range(const key_type& _key) const
+    {
+        auto rng = const_cast<open_addressing_multimap*>(this)->equal_range(_key);
+        return { rng.first, rng.second };
+    }
+
+    inline iterator find(const key_type& _key)
+    {
+        auto rng = equal_range(_key);
+        return rng.first!=rng.second ? iterator(this, rng.first.m_ix):end();
+    }
+    inline const_iterator find(const key_type& _key) const
+    {
+        return const_cast<open_addressing_multimap*>(this)->find(_key);
+    }
+
+    inline size_type count(const key_type& _key) const
+    {
+        auto rng = equal_range(_key);
+        return std::distance(rng.first, rng.second);
+    }
+
+private:
+    inline size_t hashOf(const key_type& _key) const
+    {
+        // murmur3 finalizer, std::hash is identity for pointers and integers on most implementations
+        uint64_t h = m_hasher(_key);
+        h ^= h>>33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h>>33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h>>33;
+        return h!=EmptySlot ? static_cast<size_t>(h):size_t(1u);
+    }
+
+    inline size_t nextOccupied(size_t _ix) const
+    {
+        for (; _ix<m_capacity; _ix++)
+        if (m_hashes[_ix]!=EmptySlot)
+            return _ix;
+        return m_capacity;
+    }
+
+    //! @returns next slot after `_ix` holding `_key` or the empty slot terminating the chain
+    inline size_t nextInChain(size_t _ix, size_t _hash, const key_type& _key) const
+    {
+        const size_t mask = m_capacity-1u;
+        for (_ix=(_ix+1u)&mask; m_hashes[_ix]!=EmptySlot; _ix=(_ix+1u)&mask)
+        if (m_hashes[_ix]==_hash && m_keyEqual(m_values[_ix].first, _key))
+            break;
+        return _ix;
+    }
+
+    //! Outputs first slot holding `_key` (or chain's end if there's none) and the empty slot terminating the chain
+    inline void findChain(const key_type& _key, size_t& _outHash, size_t& _outFirst, size_t& _outLast) const
+    {
+        _outHash = hashOf(_key);
+        if (!m_capacity)
+        {
+            _outFirst = _outLast = m_capacity;
+            return;
+        }
+        const size_t mask = m_capacity-1u;
+        size_t ix = _outHash&mask;
+        for (; m_hashes[ix]!=EmptySlot; ix=(ix+1u)&mask)
+        if (m_hashes[ix]==_outHash && m_keyEqual(m_values[ix].first, _key))
+        {
+            _outFirst = ix;
+            // pairs with equal keys may be interleaved with others, so the range ends only at the first empty slot
+            for (; m_hashes[ix]!=EmptySlot; ix=(ix+1u)&mask) {}
+            _outLast = ix;
+            return;
+        }
+        _outFirst = _outLast = ix;
+    }
+
+    //! Capacity must already be sufficient
+    template<typename V>
+    inline size_t insertHashed(size_t _hash, V&& _val)
+    {
+        const size_t mask = m_capacity-1u;
+        size_t ix = _hash&mask;
+        while (m_hashes[ix]!=EmptySlot)
+            ix = (ix+1u)&mask;
+        value_traits::construct(m_valueAlloc, m_values+ix, std::forward<V>(_val));
+        m_hashes[ix] = _hash;
+        m_size++;
+        return ix;
+    }
+
+    inline void rehash(size_t _newCapacity)
+    {
+        size_t* const oldHashes = m_hashes;
+        value_type* const oldValues = m_values;
+        const size_t oldCapacity = m_capacity;
+
+        m_hashes = m_hashAlloc.allocate(_newCapacity);
+        m_values = m_valueAlloc.allocate(_newCapacity);
+        m_capacity = _newCapacity;
+        m_size = 0u;
+        std::fill(m_hashes, m_hashes+m_capacity, EmptySlot);
+
+        // stored hashes are reused, keys are never hashed again
+        for (size_t i=0u; i<oldCapacity; i++)
+        if (oldHashes[i]!=EmptySlot)
+        {
+            insertHashed(oldHashes[i], std::move(oldValues[i]));
+            value_traits::destroy(m_valueAlloc, oldValues+i);
+        }
+        if (oldCapacity)
+        {
+            m_hashAlloc.deallocate(oldHashes, oldCapacity);
+            m_valueAlloc.deallocate(oldValues, oldCapacity);
+        }
+    }
+
+    inline void deallocate()
+    {
+        if (!m_capacity)
+            return;
+        m_hashAlloc.deallocate(m_hashes, m_capacity);
+        m_valueAlloc.deallocate(m_values, m_capacity);
+        m_hashes = nullptr;
+        m_values = nullptr;
+        m_capacity = 0u;
+    }
+};
+
+} // end namespace core
+} // end namespace irr
+
+#endif
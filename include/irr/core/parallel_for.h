@@ -0,0 +1,68 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBAW Engine"
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __IRR_PARALLEL_FOR_H_INCLUDED__
+#define __IRR_PARALLEL_FOR_H_INCLUDED__
+
+#include <atomic>
+#include <thread>
+
+#include "irr/core/Types.h"
+
+namespace irr
+{
+namespace core
+{
+
+//! Resolves a user-provided thread count, 0 means "as many as there are hardware threads"
+inline uint32_t resolveThreadCount(uint32_t _threadCnt)
+{
+    if (_threadCnt)
+        return _threadCnt;
+    const uint32_t hw = std::thread::hardware_concurrency();
+    return hw ? hw:1u;
+}
+
+//! Calls `_func(i)` for every `i` in [_begin,_end) using up to `_threadCnt` threads (the calling thread is one of them).
+/** Work is handed out dynamically in batches of `_grainSize` indices, so iterations of uneven cost balance themselves.
+The function returns only after every iteration has completed. With `_threadCnt==1` or a single batch no thread is spawned.
+\param _threadCnt maximum amount of threads to use, 0 means std::thread::hardware_concurrency().
+\param _func must be safe to call concurrently for distinct indices. */
+template<typename IndexType, class F>
+inline void parallel_for(uint32_t _threadCnt, IndexType _begin, IndexType _end, F&& _func, IndexType _grainSize=IndexType(1))
+{
+    if (_begin>=_end)
+        return;
+    if (_grainSize<IndexType(1))
+        _grainSize = IndexType(1);
+
+    const IndexType batchCount = (_end-_begin+_grainSize-IndexType(1))/_grainSize;
+    uint32_t threadCnt = resolveThreadCount(_threadCnt);
+    if (static_cast<IndexType>(threadCnt)>batchCount)
+        threadCnt = static_cast<uint32_t>(batchCount);
+
+    std::atomic<IndexType> next(_begin);
+    auto worker = [&]() -> void
+    {
+        for (IndexType first=next.fetch_add(_grainSize); first<_end; first=next.fetch_add(_grainSize))
+        {
+            const IndexType last = (_end-first)>_grainSize ? (first+_grainSize):_end;
+            for (IndexType i=first; i<last; i++)
+                _func(i);
+        }
+    };
+
+    core::vector<std::thread> threads;
+    threads.reserve(threadCnt-1u);
+    for (uint32_t i=1u; i<threadCnt; i++)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& th : threads)
+        th.join();
+}
+
+} // end namespace core
+} // end namespace irr
+
+#endif
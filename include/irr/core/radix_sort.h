@@ -0,0 +1,80 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBAW Engine"
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __IRR_RADIX_SORT_H_INCLUDED__
+#define __IRR_RADIX_SORT_H_INCLUDED__
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "irr/core/Types.h"
+
+namespace irr
+{
+namespace core
+{
+
+//! Stable LSD radix sort of [_begin,_end) by the unsigned integer `_getKey(element)` returns, in ascending order of the keys
+/** One pass per byte of the key, passes in which all keys have the same byte are skipped.
+Only (key,index) pairs move around during the passes, every element is moved exactly twice at the end no matter how big it is.
+\param _getKey gets called once per element. */
+template<typename RandomIt, class KeyFunc>
+inline void radix_sort(RandomIt _begin, RandomIt _end, KeyFunc&& _getKey)
+{
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+    using key_type = typename std::decay<decltype(_getKey(*_begin))>::type;
+    static_assert(std::is_unsigned<key_type>::value, "radix_sort needs unsigned integer keys");
+    constexpr uint32_t kPassCount = sizeof(key_type);
+
+    const size_t count = std::distance(_begin,_end);
+    if (count<2u)
+        return;
+
+    struct KeyAndIndex
+    {
+        key_type key;
+        uint32_t index;
+    };
+    core::vector<KeyAndIndex> keys(count), scratch(count);
+    size_t histograms[kPassCount][256] = {};
+    for (size_t i=0u; i<count; i++)
+    {
+        keys[i] = {_getKey(_begin[i]),static_cast<uint32_t>(i)};
+        for (uint32_t pass=0u; pass<kPassCount; pass++)
+            histograms[pass][(keys[i].key>>(pass*8u))&0xffu]++;
+    }
+
+    KeyAndIndex* src = keys.data();
+    KeyAndIndex* dst = scratch.data();
+    for (uint32_t pass=0u; pass<kPassCount; pass++)
+    {
+        size_t* histogram = histograms[pass];
+        const uint32_t shift = pass*8u;
+        if (histogram[(src[0].key>>shift)&0xffu]==count)
+            continue;
+
+        size_t offset = 0u;
+        for (uint32_t digit=0u; digit<256u; digit++)
+        {
+            const size_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+        for (size_t i=0u; i<count; i++)
+            dst[histogram[(src[i].key>>shift)&0xffu]++] = src[i];
+        std::swap(src,dst);
+    }
+
+    core::vector<value_type> sorted;
+    sorted.reserve(count);
+    for (size_t i=0u; i<count; i++)
+        sorted.push_back(std::move(_begin[src[i].index]));
+    std::move(sorted.begin(),sorted.end(),_begin);
+}
+
+} // end namespace core
+} // end namespace irr
+
+#endif
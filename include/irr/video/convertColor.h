@@ -6,6 +6,7 @@
 #include "irr/asset/EFormat.h"
 #include "decodePixels.h"
 #include "encodePixels.h"
+#include "convertColorSIMD.h"
 
 #ifdef __GNUC__
     #pragma GCC diagnostic push
@@ -127,45 +128,56 @@ namespace irr { namespace video
     {
         using namespace asset;
 
-        const uint32_t srcStride = getTexelOrBlockSize(sF);
-        const uint32_t dstStride = getTexelOrBlockSize(dF);
+        // contiguous texels of formats with a SIMD codec skip the per-texel conversion through doubles
+        IRR_PSEUDO_IF_CONSTEXPR_BEGIN(has_simd_color_conversion<sF,dF>::value)
+        {
+            convertColorSIMD<sF,dF>(srcPix[0], dstPix, _pixOrBlockCnt);
+            // the source pointer ends up past the converted texels, same as with the generic path
+            srcPix[0] = reinterpret_cast<const uint8_t*>(srcPix[0])+_pixOrBlockCnt*getTexelOrBlockSize(sF);
+        }
+        IRR_PSEUDO_ELSE_CONSTEXPR
+        {
+            const uint32_t srcStride = getTexelOrBlockSize(sF);
+            const uint32_t dstStride = getTexelOrBlockSize(dF);
 
-        uint32_t hPlaneReduction[4], vPlaneReduction[4], chCntInPlane[4];
-        getHorizontalReductionFactorPerPlane(sF, hPlaneReduction);
-        getVerticalReductionFactorPerPlane(sF, vPlaneReduction);
-        getChannelsPerPlane(sF, chCntInPlane);
+            uint32_t hPlaneReduction[4], vPlaneReduction[4], chCntInPlane[4];
+            getHorizontalReductionFactorPerPlane(sF, hPlaneReduction);
+            getVerticalReductionFactorPerPlane(sF, vPlaneReduction);
+            getChannelsPerPlane(sF, chCntInPlane);
 
-        const core::vector3d<uint32_t> sdims = getBlockDimensions(sF);
+            const core::vector3d<uint32_t> sdims = getBlockDimensions(sF);
 
-        const uint8_t** src = reinterpret_cast<const uint8_t**>(srcPix);
-        uint8_t* const dst_begin = reinterpret_cast<uint8_t*>(dstPix);
-        for (size_t i = 0u; i < _pixOrBlockCnt; ++i)
-        {
-            // assuming _imgSize is always represented in texels
-            const uint32_t px = i % (_imgSize.X / sdims.X);
-            const uint32_t py = i / (_imgSize.X / sdims.X);
-            //px, py are block or texel position
-            //x, y are position within block
-            for (uint32_t x = 0u; x < sdims.X; ++x)
+            const uint8_t** src = reinterpret_cast<const uint8_t**>(srcPix);
+            uint8_t* const dst_begin = reinterpret_cast<uint8_t*>(dstPix);
+            for (size_t i = 0u; i < _pixOrBlockCnt; ++i)
             {
-                for (uint32_t y = 0u; y < sdims.Y; ++y)
+                // assuming _imgSize is always represented in texels
+                const uint32_t px = i % (_imgSize.X / sdims.X);
+                const uint32_t py = i / (_imgSize.X / sdims.X);
+                //px, py are block or texel position
+                //x, y are position within block
+                for (uint32_t x = 0u; x < sdims.X; ++x)
                 {
-                    const ptrdiff_t off = ((sdims.Y * py + y)*_imgSize.X + px * sdims.X + x);
-                    convertColor<sF, dF>(reinterpret_cast<const void**>(src), dst_begin + static_cast<ptrdiff_t>(dstStride)*off, x, y);
+                    for (uint32_t y = 0u; y < sdims.Y; ++y)
+                    {
+                        const ptrdiff_t off = ((sdims.Y * py + y)*_imgSize.X + px * sdims.X + x);
+                        convertColor<sF, dF>(reinterpret_cast<const void**>(src), dst_begin + static_cast<ptrdiff_t>(dstStride)*off, x, y);
+                    }
+                }
+                if (!isPlanarFormat<sF>())
+                {
+                    src[0] += srcStride;
+                }
+                else
+                {
+                    const uint32_t px = i % _imgSize.X;
+                    const uint32_t py = i / _imgSize.X;
+                    for (uint32_t j = 0u; j < 4u; ++j)
+                        src[j] = reinterpret_cast<const uint8_t*>(srcPix[j]) + chCntInPlane[j]*((_imgSize.X/hPlaneReduction[j]) * (py/vPlaneReduction[j]) + px/hPlaneReduction[j]);
                 }
-            }
-            if (!isPlanarFormat<sF>())
-            {
-                src[0] += srcStride;
-            }
-            else
-            {
-                const uint32_t px = i % _imgSize.X;
-                const uint32_t py = i / _imgSize.X;
-                for (uint32_t j = 0u; j < 4u; ++j)
-                    src[j] = reinterpret_cast<const uint8_t*>(srcPix[j]) + chCntInPlane[j]*((_imgSize.X/hPlaneReduction[j]) * (py/vPlaneReduction[j]) + px/hPlaneReduction[j]);
             }
         }
+        IRR_PSEUDO_IF_CONSTEXPR_END
     }
 
     void convertColor(asset::E_FORMAT _sfmt, asset::E_FORMAT _dfmt, const void* _srcPix[4], void* _dstPix, size_t _pixOrBlockCnt, core::vector3d<uint32_t>& _imgSize);
@@ -0,0 +1,288 @@
+#ifndef __IRR_CONVERT_COLOR_SIMD_H_INCLUDED__
+#define __IRR_CONVERT_COLOR_SIMD_H_INCLUDED__
+
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <smmintrin.h>
+
+#include "irr/static_if.h"
+#include "decodePixels.h"
+#include "irr/asset/EFormat.h"
+
+namespace irr { namespace video
+{
+namespace impl
+{
+    //! Lookup tables of sRGB 8bit encoding, built on first use
+    struct SSRGB8Tables
+    {
+        //! Linear value of every 8bit sRGB value
+        float toLinear[256];
+        //! Encoded value of a linear value is the amount of thresholds not greater than it, `thresholds[0]` is -inf
+        float thresholds[256];
+
+        SSRGB8Tables()
+        {
+            thresholds[0] = -std::numeric_limits<float>::infinity();
+            for (uint32_t i = 0u; i < 256u; ++i)
+            {
+                toLinear[i] = srgb2lin(i/255.);
+                if (i)
+                    thresholds[i] = srgb2lin((i-0.5)/255.);
+            }
+        }
+
+        static inline const SSRGB8Tables& get()
+        {
+            static const SSRGB8Tables tables;
+            return tables;
+        }
+
+        //! Rounds to the nearest 8bit sRGB value, branchless binary search over the thresholds
+        inline uint8_t encode(float _lin) const
+        {
+            uint32_t ix = 0u;
+            for (uint32_t step = 128u; step; step >>= 1u)
+                ix += (_lin >= thresholds[ix+step]) ? step : 0u;
+            return ix;
+        }
+    };
+
+    //! 4 floats to 4 unsigned normalized integers, saturated and rounded to nearest
+    inline __m128i floatToUnorm(__m128 _v, __m128 _scale)
+    {
+        _v = _mm_min_ps(_mm_max_ps(_v, _mm_setzero_ps()), _mm_set1_ps(1.f));
+        return _mm_cvtps_epi32(_mm_mul_ps(_v, _scale));
+    }
+    //! ORs together all 4 lanes
+    inline uint32_t horizontalOr(__m128i _v)
+    {
+        _v = _mm_or_si128(_v, _mm_shuffle_epi32(_v, _MM_SHUFFLE(2,3,0,1)));
+        _v = _mm_or_si128(_v, _mm_shuffle_epi32(_v, _MM_SHUFFLE(1,0,3,2)));
+        return _mm_cvtsi128_si32(_v);
+    }
+    inline __m128 swapRedBlue(__m128 _v)
+    {
+        return _mm_shuffle_ps(_v, _v, _MM_SHUFFLE(3,0,1,2));
+    }
+
+    //! Exact (including denormals, infinities and NaNs), expects the halves in the low 16 bits of every lane
+    inline __m128 halfToFloat(__m128i _h)
+    {
+        const __m128i expmant = _mm_and_si128(_h, _mm_set1_epi32(0x7fff));
+        const __m128i sign = _mm_slli_epi32(_mm_xor_si128(_h, expmant), 16);
+        // rebias the exponent by multiplication, which normalizes denormals too
+        const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expmant, 13)), _mm_castsi128_ps(_mm_set1_epi32((254-15)<<23)));
+        const __m128i wasInfNaN = _mm_cmpgt_epi32(expmant, _mm_set1_epi32(0x7bff));
+        const __m128 infNaNExp = _mm_and_ps(_mm_castsi128_ps(wasInfNaN), _mm_castsi128_ps(_mm_set1_epi32(255<<23)));
+        return _mm_or_ps(scaled, _mm_or_ps(_mm_castsi128_ps(sign), infNaNExp));
+    }
+    //! Rounds to nearest even, overflows to infinity and keeps NaNs, halves land in the low 16 bits of every lane
+    inline __m128i floatToHalf(__m128 _f)
+    {
+        const __m128i denormMagic = _mm_set1_epi32(((127-15)+(23-10)+1)<<23);
+
+        __m128i u = _mm_castps_si128(_f);
+        const __m128i sign = _mm_and_si128(u, _mm_set1_epi32(0x80000000));
+        u = _mm_xor_si128(u, sign);
+
+        // adding the magic number makes the FPU do the rounding of the denormal mantissa
+        const __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(u), _mm_castsi128_ps(denormMagic))), denormMagic);
+        const __m128i mantOdd = _mm_and_si128(_mm_srli_epi32(u, 13), _mm_set1_epi32(1));
+        // rebias the exponent from 127 to 15 (wrapping unsigned subtraction, shifting the negative difference would be undefined) and round to nearest even
+        const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(u, _mm_set1_epi32(int32_t(0xfffu-(uint32_t(127-15)<<23)))), mantOdd), 13);
+        const __m128i infNaN = _mm_blendv_epi8(_mm_set1_epi32(0x7c00), _mm_set1_epi32(0x7e00), _mm_cmpgt_epi32(u, _mm_set1_epi32(0x7f800000)));
+
+        __m128i o = _mm_blendv_epi8(normal, denormal, _mm_cmplt_epi32(u, _mm_set1_epi32(113<<23)));
+        o = _mm_blendv_epi8(o, infNaN, _mm_cmpgt_epi32(u, _mm_set1_epi32(((127+16)<<23)-1)));
+        return _mm_or_si128(o, _mm_srli_epi32(sign, 16));
+    }
+
+
+    //! SIMD codec of a single texel, for formats with a fast path of convertColor.
+    /** Specializations have `value==true` and provide `static __m128 decode(const uint8_t* _pix)` which returns RGBA
+    (missing color channels decode as 0 and missing alpha as 1) and `static void encode(uint8_t* _pix, __m128 _rgba)` which
+    only writes the bytes of the texel. Unlike encodePixels(), encoding to normalized formats saturates and rounds to nearest. */
+    template<asset::E_FORMAT fmt>
+    struct SSIMDTexelCodec : std::false_type {};
+
+    template<uint32_t chCnt, bool bgr, bool srgb>
+    struct SUnorm8TexelCodec : std::true_type
+    {
+        static inline __m128 decode(const uint8_t* _pix)
+        {
+            uint32_t pix = 0xff000000u;
+            memcpy(&pix, _pix, chCnt);
+
+            __m128 rgba;
+            IRR_PSEUDO_IF_CONSTEXPR_BEGIN(srgb)
+            {
+                const float* toLinear = SSRGB8Tables::get().toLinear;
+                rgba = _mm_set_ps((pix>>24)/255.f, chCnt>2u ? toLinear[(pix>>16)&0xffu]:0.f, chCnt>1u ? toLinear[(pix>>8)&0xffu]:0.f, toLinear[pix&0xffu]);
+            }
+            IRR_PSEUDO_ELSE_CONSTEXPR
+            {
+                rgba = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(pix))), _mm_set1_ps(1.f/255.f));
+            }
+            IRR_PSEUDO_IF_CONSTEXPR_END
+            return bgr ? swapRedBlue(rgba) : rgba;
+        }
+        static inline void encode(uint8_t* _pix, __m128 _rgba)
+        {
+            if (bgr)
+                _rgba = swapRedBlue(_rgba);
+            const __m128i v = floatToUnorm(_rgba, _mm_set1_ps(255.f));
+            uint32_t pix = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packus_epi32(v, v), v));
+            IRR_PSEUDO_IF_CONSTEXPR_BEGIN(srgb)
+            {
+                const SSRGB8Tables& tables = SSRGB8Tables::get();
+                alignas(16) float lin[4];
+                _mm_store_ps(lin, _rgba);
+                pix &= 0xff000000u;
+                for (uint32_t i = 0u; i < (chCnt<3u ? chCnt:3u); ++i)
+                    pix |= uint32_t(tables.encode(lin[i]))<<(i*8u);
+            }
+            IRR_PSEUDO_IF_CONSTEXPR_END
+            memcpy(_pix, &pix, chCnt);
+        }
+    };
+
+    template<uint32_t chCnt>
+    struct SFloat16TexelCodec : std::true_type
+    {
+        static inline __m128 decode(const uint8_t* _pix)
+        {
+            uint16_t pix[4] = {0u, 0u, 0u, 0x3c00u};
+            memcpy(pix, _pix, chCnt*2u);
+            return halfToFloat(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pix))));
+        }
+        static inline void encode(uint8_t* _pix, __m128 _rgba)
+        {
+            const __m128i h = floatToHalf(_rgba);
+            uint16_t pix[4];
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(pix), _mm_packus_epi32(h, h));
+            memcpy(_pix, pix, chCnt*2u);
+        }
+    };
+
+    template<uint32_t chCnt>
+    struct SFloat32TexelCodec : std::true_type
+    {
+        static inline __m128 decode(const uint8_t* _pix)
+        {
+            float pix[4] = {0.f, 0.f, 0.f, 1.f};
+            memcpy(pix, _pix, chCnt*4u);
+            return _mm_loadu_ps(pix);
+        }
+        static inline void encode(uint8_t* _pix, __m128 _rgba)
+        {
+            float pix[4];
+            _mm_storeu_ps(pix, _rgba);
+            memcpy(_pix, pix, chCnt*4u);
+        }
+    };
+
+    //! 5-6-5 formats, `bgr` means red in the low bits
+    template<bool bgr>
+    struct SUnorm565TexelCodec : std::true_type
+    {
+        static inline __m128 decode(const uint8_t* _pix)
+        {
+            uint16_t pix;
+            memcpy(&pix, _pix, 2u);
+            // masking the channels in place and folding their shifts into the scale saves per-lane shifts which SSE lacks
+            const __m128i v = _mm_and_si128(_mm_set1_epi32(pix), _mm_set_epi32(0, 0xf800, 0x7e0, 0x1f));
+            const __m128 rgba = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set_ps(0.f, 1.f/(31.f*2048.f), 1.f/(63.f*32.f), 1.f/31.f)), _mm_set_ps(1.f, 0.f, 0.f, 0.f));
+            return bgr ? rgba : swapRedBlue(rgba);
+        }
+        static inline void encode(uint8_t* _pix, __m128 _rgba)
+        {
+            if (!bgr)
+                _rgba = swapRedBlue(_rgba);
+            const __m128i v = _mm_mullo_epi32(floatToUnorm(_rgba, _mm_set_ps(0.f, 31.f, 63.f, 31.f)), _mm_set_epi32(0, 2048, 32, 1));
+            const uint16_t pix = horizontalOr(v);
+            memcpy(_pix, &pix, 2u);
+        }
+    };
+
+    //! 2-10-10-10 formats, `bgr` means red in the high bits of the color
+    template<bool bgr>
+    struct SUnorm1010102TexelCodec : std::true_type
+    {
+        static inline __m128 decode(const uint8_t* _pix)
+        {
+            uint32_t pix;
+            memcpy(&pix, _pix, 4u);
+            const __m128i all = _mm_set1_epi32(pix);
+            // alpha would come out negative when masked in place, so it gets shifted down instead
+            const __m128i v = _mm_blend_epi16(_mm_and_si128(all, _mm_set_epi32(0, 0x3ff<<20, 0x3ff<<10, 0x3ff)), _mm_srli_epi32(all, 30), 0xc0);
+            const __m128 rgba = _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set_ps(1.f/3.f, 1.f/(1023.f*1048576.f), 1.f/(1023.f*1024.f), 1.f/1023.f));
+            return bgr ? swapRedBlue(rgba) : rgba;
+        }
+        static inline void encode(uint8_t* _pix, __m128 _rgba)
+        {
+            if (bgr)
+                _rgba = swapRedBlue(_rgba);
+            const __m128i v = _mm_mullo_epi32(floatToUnorm(_rgba, _mm_set_ps(3.f, 1023.f, 1023.f, 1023.f)), _mm_set_epi32(1<<30, 1<<20, 1<<10, 1));
+            const uint32_t pix = horizontalOr(v);
+            memcpy(_pix, &pix, 4u);
+        }
+    };
+
+    template<> struct SSIMDTexelCodec<asset::EF_R8_UNORM> : SUnorm8TexelCodec<1u, false, false> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R8G8_UNORM> : SUnorm8TexelCodec<2u, false, false> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R8G8B8_UNORM> : SUnorm8TexelCodec<3u, false, false> {};
+    template<> struct SSIMDTexelCodec<asset::EF_B8G8R8_UNORM> : SUnorm8TexelCodec<3u, true, false> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R8G8B8A8_UNORM> : SUnorm8TexelCodec<4u, false, false> {};
+    template<> struct SSIMDTexelCodec<asset::EF_B8G8R8A8_UNORM> : SUnorm8TexelCodec<4u, true, false> {};
+    template<> struct SSIMDTexelCodec<asset::EF_A8B8G8R8_UNORM_PACK32> : SUnorm8TexelCodec<4u, false, false> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R8_SRGB> : SUnorm8TexelCodec<1u, false, true> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R8G8_SRGB> : SUnorm8TexelCodec<2u, false, true> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R8G8B8_SRGB> : SUnorm8TexelCodec<3u, false, true> {};
+    template<> struct SSIMDTexelCodec<asset::EF_B8G8R8_SRGB> : SUnorm8TexelCodec<3u, true, true> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R8G8B8A8_SRGB> : SUnorm8TexelCodec<4u, false, true> {};
+    template<> struct SSIMDTexelCodec<asset::EF_B8G8R8A8_SRGB> : SUnorm8TexelCodec<4u, true, true> {};
+    template<> struct SSIMDTexelCodec<asset::EF_A8B8G8R8_SRGB_PACK32> : SUnorm8TexelCodec<4u, false, true> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R16_SFLOAT> : SFloat16TexelCodec<1u> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R16G16_SFLOAT> : SFloat16TexelCodec<2u> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R16G16B16_SFLOAT> : SFloat16TexelCodec<3u> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R16G16B16A16_SFLOAT> : SFloat16TexelCodec<4u> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R32_SFLOAT> : SFloat32TexelCodec<1u> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R32G32_SFLOAT> : SFloat32TexelCodec<2u> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R32G32B32_SFLOAT> : SFloat32TexelCodec<3u> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R32G32B32A32_SFLOAT> : SFloat32TexelCodec<4u> {};
+    template<> struct SSIMDTexelCodec<asset::EF_R5G6B5_UNORM_PACK16> : SUnorm565TexelCodec<false> {};
+    template<> struct SSIMDTexelCodec<asset::EF_B5G6R5_UNORM_PACK16> : SUnorm565TexelCodec<true> {};
+    template<> struct SSIMDTexelCodec<asset::EF_A2R10G10B10_UNORM_PACK32> : SUnorm1010102TexelCodec<true> {};
+    template<> struct SSIMDTexelCodec<asset::EF_A2B10G10R10_UNORM_PACK32> : SUnorm1010102TexelCodec<false> {};
+} //namespace impl
+
+    //! Whether convertColor<sF,dF> takes the SIMD fast path
+    template<asset::E_FORMAT sF, asset::E_FORMAT dF>
+    struct has_simd_color_conversion : std::integral_constant<bool, impl::SSIMDTexelCodec<sF>::value&&impl::SSIMDTexelCodec<dF>::value> {};
+
+    //! Converts a contiguous span of `_texelCnt` texels, both formats must have a fast path (see has_simd_color_conversion)
+    template<asset::E_FORMAT sF, asset::E_FORMAT dF>
+    inline void convertColorSIMD(const void* _srcPix, void* _dstPix, size_t _texelCnt)
+    {
+        static_assert(has_simd_color_conversion<sF,dF>::value, "No SIMD fast path for this pair of formats!");
+
+        const uint32_t srcStride = asset::getTexelOrBlockSize(sF);
+        const uint32_t dstStride = asset::getTexelOrBlockSize(dF);
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(_srcPix);
+        uint8_t* dst = reinterpret_cast<uint8_t*>(_dstPix);
+        IRR_PSEUDO_IF_CONSTEXPR_BEGIN(sF==dF)
+        {
+            memcpy(dst, src, _texelCnt*srcStride);
+        }
+        IRR_PSEUDO_ELSE_CONSTEXPR
+        {
+            for (const uint8_t* const srcEnd = src+_texelCnt*srcStride; src != srcEnd; src += srcStride, dst += dstStride)
+                impl::SSIMDTexelCodec<dF>::encode(dst, impl::SSIMDTexelCodec<sF>::decode(src));
+        }
+        IRR_PSEUDO_IF_CONSTEXPR_END
+    }
+}} //irr:video
+
+#endif //__IRR_CONVERT_COLOR_SIMD_H_INCLUDED__
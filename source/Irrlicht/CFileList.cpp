@@ -63,7 +63,16 @@ void CFileList::addItem(const io::path& fullPath, uint32_t offset, uint32_t size
 
 	//os::Printer::log(Path.c_str(), entry.FullName);
 
-	Files.insert(std::lower_bound(Files.begin(),Files.end(),entry),entry);
+	Files.push_back(entry);
+}
+
+
+//! sorts the list so that it can be searched
+void CFileList::sort()
+{
+	// of items with the same name the last one added gets found, same as when every item got inserted at its place
+	std::reverse(Files.begin(),Files.end());
+	std::stable_sort(Files.begin(),Files.end());
 }
 
 
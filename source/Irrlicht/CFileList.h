@@ -33,6 +33,10 @@ class CFileList : public IFileList
         \param id The ID of the file in the archive which owns it */
         virtual void addItem(const io::path& fullPath, uint32_t offset, uint32_t size, bool isDirectory, uint32_t id=0);
 
+        //! Sorts the list so that it can be searched, call once after adding all the items
+        /** Items are only appended by addItem, sorting them all at once is what keeps big archives fast to open. */
+        void sort();
+
         //! Returns the amount of files in the filelist.
         virtual uint32_t getFileCount() const override {return Files.size();}
 
@@ -48,6 +52,9 @@ class CFileList : public IFileList
         //! Returns the base path of the file list
         virtual const io::path& getPath() const {return Path;}
 
+        //! Returns whether files are searched for without their directories
+        inline bool ignoresPaths() const {return IgnorePaths;}
+
     protected:
         //! Ignore paths when adding or searching for files
         bool IgnorePaths;
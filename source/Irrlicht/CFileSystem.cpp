@@ -6,6 +6,7 @@
 #include <list>
 #include "CFileSystem.h"
 #include "CReadFile.h"
+#include "CMappedReadFile.h"
 #include "IWriteFile.h"
 #include "CZipReader.h"
 #include "CMountPointReader.h"
@@ -45,7 +46,7 @@ namespace io
 {
 
 //! constructor
-CFileSystem::CFileSystem()
+CFileSystem::CFileSystem() : UseMemoryMappedFiles(false)
 {
 	#ifdef _IRR_DEBUG
 	setDebugName("CFileSystem");
@@ -103,11 +104,48 @@ CFileSystem::~CFileSystem()
 IReadFile* CFileSystem::createAndOpenFile(const io::path& filename)
 {
 	IReadFile* file = 0;
-	uint32_t i;
 
-	for (i=0; i< FileArchives.size(); ++i)
+	if (isArchiveDirectoryName(filename))
+	{
+		// directories are not indexed, so every archive gets asked in turn
+		for (uint32_t i=0; i < FileArchives.size(); ++i)
+		{
+			file = FileArchives[i]->createAndOpenFile(filename);
+			if (file)
+				return file;
+		}
+	}
+	else
 	{
-		file = FileArchives[i]->createAndOpenFile(filename);
+		const SArchiveFile found = findInArchiveIndex(filename);
+		for (uint32_t i : UnindexedArchives)
+		{
+			if (i > found.Archive)
+				break;
+
+			file = FileArchives[i]->createAndOpenFile(filename);
+			if (file)
+				return file;
+		}
+		if (found.Archive < FileArchives.size())
+		{
+			file = FileArchives[found.Archive]->createAndOpenFile(found.File);
+			if (file)
+				return file;
+
+			// the entry could not be opened, give the archives after it a chance
+			for (uint32_t i=found.Archive+1; i < FileArchives.size(); ++i)
+			{
+				file = FileArchives[i]->createAndOpenFile(filename);
+				if (file)
+					return file;
+			}
+		}
+	}
+
+	if (UseMemoryMappedFiles)
+	{
+		file = createMappedReadFile(filename);
 		if (file)
 			return file;
 	}
@@ -123,6 +161,18 @@ IReadFile* CFileSystem::createAndOpenFile(const io::path& filename)
 }
 
 
+//! opens a file on disk for read access through a memory mapping
+IReadFile* CFileSystem::createMappedReadFile(const io::path& filename)
+{
+    CMappedReadFile* file = new CMappedReadFile(getAbsolutePath(filename));
+    if (file->isOpen())
+        return file;
+
+    file->drop();
+    return nullptr;
+}
+
+
 //! Creates an IReadFile interface for treating memory like a file.
 IReadFile* CFileSystem::createMemoryReadFile(const void* contents, size_t len, const io::path& fileName)
 {
@@ -202,6 +252,8 @@ bool CFileSystem::moveFileArchive(uint32_t sourceIndex, int32_t relative)
 		FileArchives[s] = t;
 		r = true;
 	}
+	if (r)
+		rebuildArchiveIndex();
 	return r;
 }
 
@@ -299,6 +351,7 @@ bool CFileSystem::addFileArchive(const io::path& filename, bool ignoreCase,
 	if (archive)
 	{
 		FileArchives.push_back(archive);
+		indexArchive(FileArchives.size()-1);
 		if (password.size())
 			archive->Password=password;
 		if (retArchive)
@@ -404,6 +457,7 @@ bool CFileSystem::addFileArchive(IReadFile* file, bool ignoreCase,
 		if (archive)
 		{
 			FileArchives.push_back(archive);
+			indexArchive(FileArchives.size()-1);
 			if (password.size())
 				archive->Password=password;
 			if (retArchive)
@@ -429,6 +483,7 @@ bool CFileSystem::addFileArchive(IFileArchive* archive)
 			return false;
 	}
 	FileArchives.push_back(archive);
+	indexArchive(FileArchives.size()-1);
 	return true;
 }
 
@@ -442,6 +497,7 @@ bool CFileSystem::removeFileArchive(uint32_t index)
 	    auto it = FileArchives.begin()+index;
 		(*it)->drop();
 		FileArchives.erase(it);
+		rebuildArchiveIndex();
 		ret = true;
 	}
 
@@ -476,6 +532,79 @@ bool CFileSystem::removeFileArchive(const IFileArchive* archive)
 }
 
 
+//! adds the files of an archive to the index
+void CFileSystem::indexArchive(uint32_t archiveIndex)
+{
+	// the layout of file lists is only known for the archives of the engine
+	const CFileList* list = dynamic_cast<const CFileList*>(FileArchives[archiveIndex]->getFileList());
+	if (!list)
+	{
+		UnindexedArchives.push_back(archiveIndex);
+		return;
+	}
+
+	auto& index = list->ignoresPaths() ? ArchiveNames : ArchivePaths;
+	const core::vector<SFileListEntry>& files = list->getFilesReference();
+	index.reserve(index.size()+files.size());
+	for (uint32_t i=0; i < files.size(); ++i)
+	{
+		if (files[i].IsDirectory)
+			continue;
+
+		// lists compare names ignoring case, and earlier archives take precedence so existing keys stay
+		io::path key = files[i].FullName;
+		key.make_lower();
+		index.emplace(key.c_str(), SArchiveFile{archiveIndex,i});
+	}
+}
+
+
+//! indexes all archives again
+void CFileSystem::rebuildArchiveIndex()
+{
+	ArchivePaths.clear();
+	ArchiveNames.clear();
+	UnindexedArchives.clear();
+	for (uint32_t i=0; i < FileArchives.size(); ++i)
+		indexArchive(i);
+}
+
+
+//! whether the name can't be looked up in the archive index
+bool CFileSystem::isArchiveDirectoryName(const io::path& filename)
+{
+	// names with a trailing slash are directories, only files get indexed
+	return !filename.size() || filename.lastChar() == '/' || filename.lastChar() == '\\';
+}
+
+
+//! returns the first indexed archive with the file
+CFileSystem::SArchiveFile CFileSystem::findInArchiveIndex(const io::path& filename) const
+{
+	SArchiveFile retval = {static_cast<uint32_t>(FileArchives.size()),0};
+	if (isArchiveDirectoryName(filename))
+		return retval;
+
+	// same normalization as CFileList::findFile
+	io::path name = filename;
+	handleBackslashes(&name);
+	name.make_lower();
+
+	auto found = ArchivePaths.find(name.c_str());
+	if (found != ArchivePaths.end())
+		retval = found->second;
+
+	if (ArchiveNames.size())
+	{
+		core::deletePathFromFilename(name);
+		found = ArchiveNames.find(name.c_str());
+		if (found != ArchiveNames.end() && found->second.Archive < retval.Archive)
+			retval = found->second;
+	}
+	return retval;
+}
+
+
 //! gets an archive
 uint32_t CFileSystem::getFileArchiveCount() const
 {
@@ -858,6 +987,8 @@ IFileList* CFileSystem::createFileList()
 		}
 	}
 
+	if (r)
+		r->sort();
 	return r;
 }
 
@@ -871,12 +1002,32 @@ IFileList* CFileSystem::createEmptyFileList(const io::path& path, bool ignoreCas
 //! determines if a file exists and would be able to be opened.
 bool CFileSystem::existFile(const io::path& filename) const
 {
-	for (uint32_t i=0; i < FileArchives.size(); ++i)
-	{
+	auto inArchiveList = [&](uint32_t i) -> bool
+	{
         auto _list = FileArchives[i]->getFileList();
         auto files = _list->getFiles();
-		if (_list->findFile(files.begin(),files.end(),filename)!=files.end())
-			return true;
+		return _list->findFile(files.begin(),files.end(),filename)!=files.end();
+	};
+
+	if (isArchiveDirectoryName(filename))
+	{
+		// directories are not indexed, so every archive's list gets searched
+		for (uint32_t i=0; i < FileArchives.size(); ++i)
+		{
+			if (inArchiveList(i))
+				return true;
+		}
+	}
+	else
+	{
+		if (findInArchiveIndex(filename).Archive < FileArchives.size())
+			return true;
+
+		for (uint32_t i : UnindexedArchives)
+		{
+			if (inArchiveList(i))
+				return true;
+		}
 	}
 
 #if defined(_MSC_VER)
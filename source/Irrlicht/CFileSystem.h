@@ -6,6 +6,9 @@
 #define __C_FILE_SYSTEM_H_INCLUDED__
 
 #include "IFileSystem.h"
+#include "irr/core/Types.h"
+
+#include <string>
 
 namespace irr
 {
@@ -32,6 +35,15 @@ class CFileSystem : public IFileSystem
         //! opens a file for read access
         virtual IReadFile* createAndOpenFile(const io::path& filename);
 
+        //! opens a file on disk for read access through a memory mapping
+        virtual IReadFile* createMappedReadFile(const io::path& filename) override;
+
+        //! makes createAndOpenFile memory map files on disk
+        virtual void setUseMemoryMappedFiles(bool enable) override {UseMemoryMappedFiles = enable;}
+
+        //! returns whether createAndOpenFile memory maps files on disk
+        virtual bool getUseMemoryMappedFiles() const override {return UseMemoryMappedFiles;}
+
         //! Creates an IReadFile interface for accessing memory like a file.
         virtual IReadFile* createMemoryReadFile(const void* contents, size_t len, const io::path& fileName) override;
 
@@ -129,6 +141,36 @@ class CFileSystem : public IFileSystem
         core::vector<IArchiveLoader*> ArchiveLoader;
         //! currently attached Archives
         core::vector<IFileArchive*> FileArchives;
+
+        //! A file inside one of FileArchives
+        struct SArchiveFile
+        {
+            //! index into FileArchives
+            uint32_t Archive;
+            //! index into the archive's file list
+            uint32_t File;
+        };
+
+        //! Adds the files of an archive to the index, the archive must not come before any of the indexed ones
+        void indexArchive(uint32_t archiveIndex);
+
+        //! Indexes all archives again, after they changed order or got removed
+        void rebuildArchiveIndex();
+
+        //! Whether the name is empty or a directory (trailing slash), those are not in the index and every archive has to be searched
+        static bool isArchiveDirectoryName(const io::path& filename);
+
+        //! Returns the first archive in the index with the file, Archive is FileArchives.size() if there is none
+        SArchiveFile findInArchiveIndex(const io::path& filename) const;
+
+        //! Lower case full paths of the files in archives which keep paths, each mapped to the first archive containing it
+        core::unordered_map<std::string,SArchiveFile> ArchivePaths;
+        //! Same for archives which ignore paths, keyed by lower case file names
+        core::unordered_map<std::string,SArchiveFile> ArchiveNames;
+        //! Archives with file lists of unknown layout, they get searched one by one, ascending
+        core::vector<uint32_t> UnindexedArchives;
+        //! whether createAndOpenFile maps files on disk
+        bool UseMemoryMappedFiles;
 };
 
 
@@ -13,43 +13,50 @@ namespace io
 CLimitReadFile::CLimitReadFile(IReadFile* alreadyOpenedFile, const size_t& pos,
 		const size_t& areaSize, const io::path& name)
 	: Filename(name), AreaStart(0), AreaEnd(0), Pos(0),
-	File(alreadyOpenedFile)
+	Shared(0)
 {
 	#ifdef _IRR_DEBUG
 	setDebugName("CLimitReadFile");
 	#endif
 
-	if (File)
+	if (alreadyOpenedFile)
 	{
-		File->grab();
 		AreaStart = pos;
 		AreaEnd = AreaStart + areaSize;
+
+		// read straight from the innermost file, so no lock is held while reading through another limit file
+		const CLimitReadFile* outer = dynamic_cast<const CLimitReadFile*>(alreadyOpenedFile);
+		if (outer && outer->Shared)
+		{
+			AreaStart = core::min_(outer->AreaStart + pos, outer->AreaEnd);
+			AreaEnd = core::min_(AreaStart + areaSize, outer->AreaEnd);
+			alreadyOpenedFile = outer->Shared->File;
+		}
+		Shared = acquireSharedFile(alreadyOpenedFile);
 	}
 }
 
 
 CLimitReadFile::~CLimitReadFile()
 {
-	if (File)
-		File->drop();
+	if (Shared)
+		releaseSharedFile(Shared);
 }
 
 
 //! returns how much was read
-int32_t CLimitReadFile::read(void* buffer, uint32_t sizeToRead)
+size_t CLimitReadFile::read(void* buffer, size_t sizeToRead)
 {
 #if 1
-	if (0 == File)
+	if (0 == Shared)
 		return 0;
 
-	int32_t r = AreaStart + Pos;
-	int32_t toRead = core::s32_min(AreaEnd, r + sizeToRead) - core::s32_max(AreaStart, r);
-	if (toRead < 0)
+	const size_t r = AreaStart + Pos;
+	if (r >= AreaEnd)
 		return 0;
-	File->seek(r);
-	r = File->read(buffer, toRead);
-	Pos += r;
-	return r;
+	const size_t readCount = readShared(Shared, r, buffer, core::min_(AreaEnd - r, sizeToRead));
+	Pos += readCount;
+	return readCount;
 #else
 	const size_t pos = File->getPos();
 
@@ -68,7 +75,7 @@ int32_t CLimitReadFile::read(void* buffer, uint32_t sizeToRead)
 bool CLimitReadFile::seek(const size_t& finalPos, bool relativeMovement)
 {
 #if 1
-	Pos = core::s32_clamp(finalPos + (relativeMovement ? Pos : 0 ), 0, AreaEnd - AreaStart);
+	Pos = core::min_(finalPos + (relativeMovement ? Pos : 0 ), AreaEnd - AreaStart);
 	return true;
 #else
 	const size_t pos = File->getPos();
@@ -115,6 +122,92 @@ const io::path& CLimitReadFile::getFileName() const
 }
 
 
+//! returns the start of the area inside the underlying file's memory, if that one is mapped
+const void* CLimitReadFile::getMappedPointer() const
+{
+	const void* const mapped = Shared ? Shared->File->getMappedPointer() : 0;
+	if (!mapped)
+		return 0;
+
+	return reinterpret_cast<const uint8_t*>(mapped) + AreaStart;
+}
+
+
+//! forwards the hint to the underlying file
+void CLimitReadFile::setAccessPattern(E_FILE_ACCESS_PATTERN pattern)
+{
+	if (Shared)
+		Shared->File->setAccessPattern(pattern);
+}
+
+
+//! reads from `file` at `pos` without disturbing limit files reading from it at the same time
+size_t CLimitReadFile::readAt(IReadFile* file, size_t pos, void* buffer, size_t sizeToRead)
+{
+	const CLimitReadFile* limit = dynamic_cast<const CLimitReadFile*>(file);
+	if (limit)
+	{
+		const size_t r = limit->AreaStart + pos;
+		if (!limit->Shared || r >= limit->AreaEnd)
+			return 0;
+		return readShared(limit->Shared, r, buffer, core::min_(limit->AreaEnd - r, sizeToRead));
+	}
+
+	SSharedFile* shared = acquireSharedFile(file);
+	const size_t readCount = readShared(shared, pos, buffer, sizeToRead);
+	releaseSharedFile(shared);
+	return readCount;
+}
+
+
+//! never destroyed, limit files might outlive static destruction
+CLimitReadFile::SSharedFileRegistry& CLimitReadFile::getSharedFileRegistry()
+{
+	static SSharedFileRegistry* registry = new SSharedFileRegistry();
+	return *registry;
+}
+
+
+CLimitReadFile::SSharedFile* CLimitReadFile::acquireSharedFile(IReadFile* file)
+{
+	SSharedFileRegistry& registry = getSharedFileRegistry();
+	std::lock_guard<std::mutex> lock(registry.Mutex);
+	SSharedFile*& shared = registry.Files[file];
+	if (!shared)
+	{
+		shared = new SSharedFile();
+		shared->File = file;
+		shared->Users = 0u;
+		file->grab();
+	}
+	shared->Users++;
+	return shared;
+}
+
+
+void CLimitReadFile::releaseSharedFile(SSharedFile* shared)
+{
+	{
+		SSharedFileRegistry& registry = getSharedFileRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+		if (--shared->Users)
+			return;
+		registry.Files.erase(shared->File);
+	}
+	// nobody else can find it anymore
+	shared->File->drop();
+	delete shared;
+}
+
+
+size_t CLimitReadFile::readShared(SSharedFile* shared, size_t pos, void* buffer, size_t sizeToRead)
+{
+	std::lock_guard<std::mutex> lock(shared->Mutex);
+	shared->File->seek(pos);
+	return shared->File->read(buffer, sizeToRead);
+}
+
+
 } // end namespace io
 } // end namespace irr
 
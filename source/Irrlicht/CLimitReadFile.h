@@ -5,6 +5,9 @@
 #ifndef __C_LIMIT_READ_FILE_H_INCLUDED__
 #define __C_LIMIT_READ_FILE_H_INCLUDED__
 
+#include <mutex>
+
+#include "irr/core/Types.h"
 #include "IReadFile.h"
 
 namespace irr
@@ -19,6 +22,13 @@ namespace io
 		and may only read until a certain file position.
 		This can be useful, for example for reading uncompressed files
 		in an archive (zip, tar).
+		Limit files over the same underlying file (like the entries of one
+		archive) can be read from different threads, their seek and read
+		pairs on the underlying file get serialized by a mutex which lives
+		as long as any limit file over it.
+		A limit file over another limit file (an archive inside an archive)
+		reads straight from the innermost file, so its mutex is never held
+		while reading through another limit file.
 	!*/
 	class CLimitReadFile : public IReadFile
 	{
@@ -29,7 +39,7 @@ namespace io
             CLimitReadFile(IReadFile* alreadyOpenedFile, const size_t& pos, const size_t& areaSize, const io::path& name);
 
             //! returns how much was read
-            virtual int32_t read(void* buffer, uint32_t sizeToRead);
+            virtual size_t read(void* buffer, size_t sizeToRead);
 
             //! changes position in file, returns true if successful
             //! if relativeMovement==true, the pos is changed relative to current pos,
@@ -45,13 +55,44 @@ namespace io
             //! returns name of file
             virtual const io::path& getFileName() const;
 
+            //! returns the start of the area inside the underlying file's memory, if that one is mapped
+            virtual const void* getMappedPointer() const;
+
+            //! forwards the hint to the underlying file
+            virtual void setAccessPattern(E_FILE_ACCESS_PATTERN pattern);
+
+            //! Reads from `file` at `pos` without disturbing limit files reading from it at the same time
+            /** \return How many bytes were read. */
+            static size_t readAt(IReadFile* file, size_t pos, void* buffer, size_t sizeToRead);
+
         private:
+            //! The file limit files read from, with the mutex guarding its position, one per file
+            struct SSharedFile
+            {
+                IReadFile* File;
+                std::mutex Mutex;
+                uint32_t Users;
+            };
+
+            //! Shared states by file, so that limit files don't need anything from their archive (which can go away before them)
+            struct SSharedFileRegistry
+            {
+                std::mutex Mutex;
+                core::unordered_map<const IReadFile*,SSharedFile*> Files;
+            };
+            static SSharedFileRegistry& getSharedFileRegistry();
+
+            //! Gets the shared state of `file`, creating it (and grabbing the file) for the first user
+            static SSharedFile* acquireSharedFile(IReadFile* file);
+            //! Destroys the shared state (and drops the file) once its last user is gone
+            static void releaseSharedFile(SSharedFile* shared);
+            static size_t readShared(SSharedFile* shared, size_t pos, void* buffer, size_t sizeToRead);
 
             io::path Filename;
             size_t AreaStart;
             size_t AreaEnd;
             size_t Pos;
-            IReadFile* File;
+            SSharedFile* Shared;
 	};
 
 } // end namespace io
@@ -0,0 +1,174 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBAW Engine"
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CMappedReadFile.h"
+
+#include <string.h>
+
+#if defined(_IRR_WINDOWS_API_)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace irr
+{
+namespace io
+{
+
+
+CMappedReadFile::CMappedReadFile(const io::path& fileName)
+: MappedData(nullptr), FileSize(0), Pos(0), Opened(false), Filename(fileName)
+{
+	#ifdef _IRR_DEBUG
+	setDebugName("CMappedReadFile");
+	#endif
+
+	openFile();
+}
+
+
+CMappedReadFile::~CMappedReadFile()
+{
+	if (!MappedData)
+		return;
+
+#if defined(_IRR_WINDOWS_API_)
+	UnmapViewOfFile(MappedData);
+#else
+	munmap(MappedData, FileSize);
+#endif
+}
+
+
+//! returns how much was read
+size_t CMappedReadFile::read(void* buffer, size_t sizeToRead)
+{
+	if (!isOpen() || Pos>=FileSize)
+		return 0;
+
+	if (sizeToRead > FileSize-Pos)
+		sizeToRead = FileSize-Pos;
+
+	memcpy(buffer, reinterpret_cast<const uint8_t*>(MappedData)+Pos, sizeToRead);
+	Pos += sizeToRead;
+
+	return sizeToRead;
+}
+
+
+//! changes position in file, returns true if successful
+//! if relativeMovement==true, the pos is changed relative to current pos,
+//! otherwise from begin of file
+bool CMappedReadFile::seek(const size_t& finalPos, bool relativeMovement)
+{
+	if (!isOpen())
+		return false;
+
+	const size_t newPos = relativeMovement ? (Pos+finalPos):finalPos;
+	if (newPos > FileSize)
+		return false;
+
+	Pos = newPos;
+	return true;
+}
+
+
+//! passes the hint on to madvise
+void CMappedReadFile::setAccessPattern(E_FILE_ACCESS_PATTERN pattern)
+{
+	if (!MappedData)
+		return;
+
+#if defined(_IRR_WINDOWS_API_)
+	// only prefetching has an equivalent, PrefetchVirtualMemory needs Windows 8 so it is left out
+#else
+	int advice = MADV_NORMAL;
+	switch (pattern)
+	{
+		case EFAP_SEQUENTIAL:
+			advice = MADV_SEQUENTIAL;
+			break;
+		case EFAP_RANDOM:
+			advice = MADV_RANDOM;
+			break;
+		case EFAP_WILL_NEED:
+			advice = MADV_WILLNEED;
+			break;
+		default:
+			break;
+	}
+	madvise(MappedData, FileSize, advice);
+#endif
+}
+
+
+//! opens the file
+void CMappedReadFile::openFile()
+{
+	if (Filename.size() == 0)
+		return;
+
+#if defined(_IRR_WINDOWS_API_)
+	#if defined(_IRR_WCHAR_FILESYSTEM)
+	HANDLE file = CreateFileW(Filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	#else
+	HANDLE file = CreateFileA(Filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	#endif
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return;
+	}
+	FileSize = static_cast<size_t>(size.QuadPart);
+
+	if (FileSize)
+	{
+		// the view keeps the mapping object alive, so both handles can be closed right away
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		if (mapping)
+		{
+			MappedData = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	const int fd = open(Filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return;
+	}
+	FileSize = static_cast<size_t>(st.st_size);
+
+	if (FileSize)
+	{
+		// private writable mapping: pages are copied on write and never written back
+		void* ptr = mmap(nullptr, FileSize, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (ptr != MAP_FAILED)
+			MappedData = ptr;
+	}
+	close(fd); // the mapping stays valid after closing the descriptor
+#endif
+
+	Opened = MappedData || FileSize==0u;
+}
+
+
+} // end namespace io
+} // end namespace irr
+
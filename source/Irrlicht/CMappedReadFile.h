@@ -0,0 +1,69 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBAW Engine"
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_MAPPED_READ_FILE_H_INCLUDED__
+#define __C_MAPPED_READ_FILE_H_INCLUDED__
+
+#include "IReadFile.h"
+
+namespace irr
+{
+
+namespace io
+{
+
+	/*!
+		Class for reading a real file from disk through a memory mapping of the whole file.
+		The mapping is private (copy-on-write), so memory handed out by getMappedPointer()
+		may be adopted by writable containers without ever touching the file on disk.
+	*/
+	class CMappedReadFile : public IReadFile
+	{
+        protected:
+            virtual ~CMappedReadFile();
+
+        public:
+            CMappedReadFile(const io::path& fileName);
+
+            //! returns how much was read
+            virtual size_t read(void* buffer, size_t sizeToRead) override;
+
+            //! changes position in file, returns true if successful
+            virtual bool seek(const size_t& finalPos, bool relativeMovement = false) override;
+
+            //! returns size of file
+            virtual size_t getSize() const override {return FileSize;}
+
+            //! returns if file is open
+            bool isOpen() const {return Opened;}
+
+            //! returns where in the file we are.
+            virtual size_t getPos() const override {return Pos;}
+
+            //! returns name of file
+            virtual const io::path& getFileName() const override {return Filename;}
+
+            //! returns start of the mapped file contents
+            virtual const void* getMappedPointer() const override {return MappedData;}
+
+            //! passes the hint on to madvise
+            virtual void setAccessPattern(E_FILE_ACCESS_PATTERN pattern) override;
+
+        private:
+
+            //! opens and maps the file
+            void openFile();
+
+            void* MappedData;
+            size_t FileSize;
+            size_t Pos;
+            bool Opened;
+            io::path Filename;
+	};
+
+} // end namespace io
+} // end namespace irr
+
+#endif
+
@@ -139,20 +139,17 @@ namespace io
 
         virtual const io::path& getFileName() const override { return m_filename; }
 
-        virtual int32_t read(void* buffer, uint32_t sizeToRead) override
+        virtual size_t read(void* buffer, size_t sizeToRead) override
         {
-            int64_t amount = static_cast<int64_t>(sizeToRead);
-            if (m_position + amount > getSize())
-                amount -= m_position + amount - m_length;
-
-            if (amount <= 0ll)
+            if (m_position >= m_length)
                 return 0;
 
+            const size_t amount = core::min_(sizeToRead, m_length-m_position);
             memcpy(buffer, reinterpret_cast<uint8_t*>(m_storage)+m_position, amount);
 
             m_position += amount;
 
-            return static_cast<int32_t>(amount);
+            return amount;
         }
 
     protected:
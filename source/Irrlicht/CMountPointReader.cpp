@@ -99,6 +99,7 @@ CMountPointReader::CMountPointReader(IFileSystem * parent, const io::path& basen
 	Parent->changeWorkingDirectoryTo(basename);
 	buildDirectory();
 	Parent->changeWorkingDirectoryTo(work);
+	sort();
 }
 
 
@@ -154,13 +155,23 @@ IReadFile* CMountPointReader::createAndOpenFile(const io::path& filename)
     auto found = findFile(Files.begin(),Files.end(),filename,false);
 	if (found != Files.end())
     {
-        return Parent->createAndOpenFile(RealFileNames[found->ID]);
+        return createAndOpenFile(static_cast<uint32_t>(found-Files.begin()));
     }
 	
 	return nullptr;
 }
 
 
+//! opens a file by its index in the file list
+IReadFile* CMountPointReader::createAndOpenFile(uint32_t index)
+{
+	if (index >= Files.size())
+		return nullptr;
+
+	return Parent->createAndOpenFile(RealFileNames[Files[index].ID]);
+}
+
+
 } // io
 } // irr
 
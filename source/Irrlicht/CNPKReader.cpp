@@ -116,6 +116,7 @@ CNPKReader::CNPKReader(IReadFile* file, bool ignoreCase, bool ignorePaths)
 		File->grab();
 		if (!scanLocalHeader())
 			os::Printer::log("Failed to load NPK archive.");
+		sort();
 	}
 }
 
@@ -224,10 +225,21 @@ IReadFile* CNPKReader::createAndOpenFile(const io::path& filename)
 {
     auto it = findFile(Files.begin(),Files.end(),filename,false);
 	if (it!=Files.end())
-        return new CLimitReadFile(File, it->Offset, it->Size, it->FullName);
+        return createAndOpenFile(static_cast<uint32_t>(it-Files.begin()));
     return nullptr;
 }
 
+
+//! opens a file by its index in the file list
+IReadFile* CNPKReader::createAndOpenFile(uint32_t index)
+{
+	if (index >= Files.size())
+		return nullptr;
+
+	const SFileListEntry& entry = Files[index];
+	return new CLimitReadFile(File, entry.Offset, entry.Size, entry.FullName);
+}
+
 void CNPKReader::readString(core::stringc& name)
 {
 	short stringSize;
@@ -98,6 +98,9 @@ namespace io
             //! opens a file by file name
             virtual IReadFile* createAndOpenFile(const io::path& filename);
 
+            //! opens a file by its index in the file list
+            virtual IReadFile* createAndOpenFile(uint32_t index);
+
             //! returns the list of files
             virtual const IFileList* getFileList() const;
 
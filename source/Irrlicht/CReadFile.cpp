@@ -4,6 +4,10 @@
 
 #include "CReadFile.h"
 
+#if defined(_IRR_POSIX_API_)
+	#include <fcntl.h>
+#endif
+
 namespace irr
 {
 namespace io
@@ -29,12 +33,12 @@ CReadFile::~CReadFile()
 
 
 //! returns how much was read
-int32_t CReadFile::read(void* buffer, uint32_t sizeToRead)
+size_t CReadFile::read(void* buffer, size_t sizeToRead)
 {
 	if (!isOpen())
 		return 0;
 
-	return (int32_t)fread(buffer, 1, sizeToRead, File);
+	return fread(buffer, 1, sizeToRead, File);
 }
 
 
@@ -97,6 +101,33 @@ const io::path& CReadFile::getFileName() const
 }
 
 
+//! passes the hint on to posix_fadvise
+void CReadFile::setAccessPattern(E_FILE_ACCESS_PATTERN pattern)
+{
+#if defined(_IRR_POSIX_API_)
+	if (!isOpen())
+		return;
+
+	int advice = POSIX_FADV_NORMAL;
+	switch (pattern)
+	{
+		case EFAP_SEQUENTIAL:
+			advice = POSIX_FADV_SEQUENTIAL;
+			break;
+		case EFAP_RANDOM:
+			advice = POSIX_FADV_RANDOM;
+			break;
+		case EFAP_WILL_NEED:
+			advice = POSIX_FADV_WILLNEED;
+			break;
+		default:
+			break;
+	}
+	posix_fadvise(fileno(File), 0, 0, advice);
+#endif
+}
+
+
 } // end namespace io
 } // end namespace irr
 
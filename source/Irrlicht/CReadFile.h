@@ -27,7 +27,7 @@ namespace io
             CReadFile(const io::path& fileName);
 
             //! returns how much was read
-            virtual int32_t read(void* buffer, uint32_t sizeToRead);
+            virtual size_t read(void* buffer, size_t sizeToRead);
 
             //! changes position in file, returns true if successful
             virtual bool seek(const size_t& finalPos, bool relativeMovement = false);
@@ -47,6 +47,9 @@ namespace io
             //! returns name of file
             virtual const io::path& getFileName() const;
 
+            //! passes the hint on to posix_fadvise
+            virtual void setAccessPattern(E_FILE_ACCESS_PATTERN pattern);
+
         private:
 
             //! opens the file
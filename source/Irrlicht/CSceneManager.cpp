@@ -37,6 +37,8 @@
 #include "CSceneNodeAnimatorCameraModifiedMaya.h"
 
 #include "irr/asset/CGeometryCreator.h"
+#include "irr/core/parallel_for.h"
+#include "irr/core/radix_sort.h"
 
 namespace irr
 {
@@ -48,7 +50,7 @@ CSceneManager::CSceneManager(IrrlichtDevice* device, video::IVideoDriver* driver
 		gui::ICursorControl* cursorControl)
 : ISceneNode(0, 0), Driver(driver), Timer(timer), FileSystem(fs), Device(device),
 	CursorControl(cursorControl),
-	ActiveCamera(0), CurrentRendertime(ESNRP_NONE),
+	CullingCamera(0), CullingThreadCount(1u), ActiveCamera(0), CurrentRendertime(ESNRP_NONE),
 	IRR_XML_FORMAT_SCENE(L"irr_scene"), IRR_XML_FORMAT_NODE(L"node"), IRR_XML_FORMAT_NODE_ATTR_TYPE(L"type")
 {
 	#ifdef _IRR_DEBUG
@@ -533,6 +535,14 @@ bool CSceneManager::isCulled(ISceneNode* node) const
 		return false;
 	}
 
+	// already culled by cullVisibleNodes, unless the node changed since
+	if (cam==CullingCamera)
+	{
+		auto found = CullingEntryIndices.find(node);
+		if (found!=CullingEntryIndices.end() && CullingEntries[found->second].matches(node))
+			return CullingResults[found->second];
+	}
+
     core::aabbox3d<float> tbox = node->getBoundingBox();
     if (tbox.MinEdge==tbox.MaxEdge)
         return true;
@@ -553,6 +563,109 @@ bool CSceneManager::isCulled(ISceneNode* node) const
 }
 
 
+//! culls all visible nodes with box culling in one go
+void CSceneManager::cullVisibleNodes()
+{
+	CullingCamera = ActiveCamera;
+	CullingEntries.clear();
+	CullingEntryIndices.clear();
+	if (!ActiveCamera)
+		return;
+
+	// gather the same nodes OnRegisterSceneNode would visit
+	CullingTraversalStack.assign(Children.begin(),Children.end());
+	while (CullingTraversalStack.size())
+	{
+		IDummyTransformationSceneNode* tmp = CullingTraversalStack.back();
+		CullingTraversalStack.pop_back();
+		if (tmp->isISceneNode())
+		{
+			ISceneNode* node = static_cast<ISceneNode*>(tmp);
+			if (!node->isVisible())
+				continue;
+
+			// degenerate boxes and nodes without box culling are trivial for isCulled
+			const core::aabbox3df& box = node->getBoundingBox();
+			if ((node->getAutomaticCulling()&(EAC_BOX|EAC_FRUSTUM_BOX)) && !(box.MinEdge==box.MaxEdge))
+			{
+				CullingEntryIndices.insert({node,uint32_t(CullingEntries.size())});
+				CullingEntries.push_back({node->getAbsoluteTransformation(),box,node->getAutomaticCulling(),0u});
+			}
+		}
+		CullingTraversalStack.insert(CullingTraversalStack.end(),tmp->getChildren().begin(),tmp->getChildren().end());
+	}
+
+	const size_t nodeCount = CullingEntries.size();
+	CullingResults.resize(nodeCount);
+	// pad to whole groups of four with empty entries
+	CullingEntries.resize((nodeCount+3u)&(~size_t(3u)),{core::matrix4x3(),core::aabbox3df(),EAC_OFF,0u});
+
+	const SViewFrustum* frustum = ActiveCamera->getViewFrustum();
+	const core::aabbox3df& frustumBox = frustum->getBoundingBox();
+	static_assert(sizeof(CullingEntry)==20u*sizeof(float),"CullingEntry is loaded as 5 vectors");
+	auto cullGroup = [&](size_t group) -> void
+	{
+		// transpose four entries so that every lane holds a different node, same math as matrix4x3::transformBoxEx and SViewFrustum::intersectsAABB
+		core::vectorSIMDf s[20];
+		const float* entries = reinterpret_cast<const float*>(CullingEntries.data()+group*4u);
+		for (uint32_t i=0u; i<4u; i++)
+		for (uint32_t j=0u; j<5u; j++)
+			s[j*4u+i] = core::vectorSIMDf(entries+i*20u+j*4u);
+		for (uint32_t j=0u; j<5u; j++)
+			core::transpose4(s+j*4u);
+
+		const core::vectorSIMDf zero(0.f);
+		const core::vectorSIMDf* column = s;
+		const core::vectorSIMDf* inMin = s+12u;
+		const core::vectorSIMDf* inMax = s+15u;
+		core::vectorSIMDf outMin[3], outMax[3];
+		for (uint32_t a=0u; a<3u; a++)
+		{
+			const core::vectorSIMDf& c0 = column[a];
+			const core::vectorSIMDf& c1 = column[3u+a];
+			const core::vectorSIMDf& c2 = column[6u+a];
+			outMin[a] = c0*core::mix(inMin[0],inMax[0],c0<zero)+c1*core::mix(inMin[1],inMax[1],c1<zero)+c2*core::mix(inMin[2],inMax[2],c2<zero);
+			outMax[a] = c0*core::mix(inMax[0],inMin[0],c0<zero)+c1*core::mix(inMax[1],inMin[1],c1<zero)+c2*core::mix(inMax[2],inMin[2],c2<zero);
+			outMin[a] += column[9u+a];
+			outMax[a] += column[9u+a];
+		}
+
+		// box outside the frustum's bounding box
+		core::vector4db_SIMD outsideBox = outMin[0]>core::vectorSIMDf(frustumBox.MaxEdge.X);
+		outsideBox = outsideBox|(outMin[1]>core::vectorSIMDf(frustumBox.MaxEdge.Y));
+		outsideBox = outsideBox|(outMin[2]>core::vectorSIMDf(frustumBox.MaxEdge.Z));
+		outsideBox = outsideBox|(outMax[0]<core::vectorSIMDf(frustumBox.MinEdge.X));
+		outsideBox = outsideBox|(outMax[1]<core::vectorSIMDf(frustumBox.MinEdge.Y));
+		outsideBox = outsideBox|(outMax[2]<core::vectorSIMDf(frustumBox.MinEdge.Z));
+
+		// box completely behind any of the planes, the plane normals are the same for every lane so the corner to test is too
+		core::vector4db_SIMD outsideFrustum;
+		for (uint32_t p=0u; p<SViewFrustum::VF_PLANE_COUNT; p++)
+		{
+			const float* plane = reinterpret_cast<const float*>(frustum->planes+p);
+			core::vectorSIMDf maxCoord[4];
+			for (uint32_t a=0u; a<3u; a++)
+				maxCoord[a] = (plane[a]>0.f ? outMax[a]:outMin[a])*core::vectorSIMDf(plane[a]);
+			maxCoord[3] = core::vectorSIMDf(plane[3]);
+			const core::vector4db_SIMD& behind = ((maxCoord[0]+maxCoord[1])+(maxCoord[2]+maxCoord[3]))<zero;
+			if (p)
+				outsideFrustum = outsideFrustum|behind;
+			else
+				outsideFrustum = behind;
+		}
+
+		const uint32_t outsideBoxMask = _mm_movemask_ps(_mm_castsi128_ps(outsideBox.getAsRegister()));
+		const uint32_t outsideFrustumMask = _mm_movemask_ps(_mm_castsi128_ps(outsideFrustum.getAsRegister()));
+		for (size_t i=0u; i<4u && group*4u+i<nodeCount; i++)
+		{
+			const uint32_t cullMode = CullingEntries[group*4u+i].CullMode;
+			CullingResults[group*4u+i] = ((cullMode&EAC_BOX) && ((outsideBoxMask>>i)&1u)) || ((cullMode&EAC_FRUSTUM_BOX) && ((outsideFrustumMask>>i)&1u));
+		}
+	};
+	core::parallel_for(CullingThreadCount,size_t(0u),CullingEntries.size()/4u,cullGroup,size_t(256u));
+}
+
+
 //! registers a node for rendering it at a specific time.
 uint32_t CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass)
 {
@@ -710,6 +823,7 @@ void CSceneManager::drawAll()
 	}
 
 	// let all nodes register themselves
+	cullVisibleNodes();
 	OnRegisterSceneNode();
 
 	//render camera scenes
@@ -737,7 +851,7 @@ void CSceneManager::drawAll()
 	{
 		CurrentRendertime = ESNRP_SOLID;
 
-		std::sort(SolidNodeList.begin(),SolidNodeList.end()); // sort by textures
+		core::radix_sort(SolidNodeList.begin(),SolidNodeList.end(),[](const DefaultNodeEntry& e) {return e.getSortKey();}); // sort by textures
 
         for (i=0; i<SolidNodeList.size(); ++i)
             SolidNodeList[i].Node->render();
@@ -752,7 +866,7 @@ void CSceneManager::drawAll()
 	{
 		CurrentRendertime = ESNRP_TRANSPARENT;
 
-		std::sort(TransparentNodeList.begin(),TransparentNodeList.end()); // sort by distance from camera
+		core::radix_sort(TransparentNodeList.begin(),TransparentNodeList.end(),[](const TransparentNodeEntry& e) {return e.getSortKey();}); // sort by distance from camera
         for (i=0; i<TransparentNodeList.size(); ++i)
             TransparentNodeList[i].Node->render();
 
@@ -766,7 +880,7 @@ void CSceneManager::drawAll()
 	{
 		CurrentRendertime = ESNRP_TRANSPARENT_EFFECT;
 
-		std::sort(TransparentEffectNodeList.begin(),TransparentEffectNodeList.end()); // sort by distance from camera
+		core::radix_sort(TransparentEffectNodeList.begin(),TransparentEffectNodeList.end(),[](const TransparentNodeEntry& e) {return e.getSortKey();}); // sort by distance from camera
         for (i=0; i<TransparentEffectNodeList.size(); ++i)
             TransparentEffectNodeList[i].Node->render();
 #ifdef _IRR_SCENEMANAGER_DEBUG
@@ -777,6 +891,7 @@ void CSceneManager::drawAll()
 
 	LightList.clear();
 	clearDeletionList();
+	CullingCamera = 0;
 
 	CurrentRendertime = ESNRP_NONE;
 }
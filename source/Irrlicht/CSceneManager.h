@@ -9,6 +9,7 @@
 #include "ISceneNode.h"
 #include "ICursorControl.h"
 #include "ISkinningStateManager.h"
+#include "irr/core/open_addressing_multimap.h"
 
 #include <map>
 #include <string>
@@ -253,8 +254,15 @@ namespace scene
 		//! returns if node is culled
 		virtual bool isCulled(ISceneNode* node) const;
 
+		virtual void setCullingThreadCount(const uint32_t& threadCount) { CullingThreadCount = threadCount; }
+
+		virtual const uint32_t& getCullingThreadCount() const { return CullingThreadCount; }
+
 	protected:
 
+		//! Culls all visible nodes with box culling against the active camera at once, four per SIMD instruction and spread across CullingThreadCount threads
+		void cullVisibleNodes();
+
 		//! clears the deletion list
 		void clearDeletionList();
 
@@ -273,8 +281,18 @@ namespace scene
 					return (renderPriority < other.renderPriority)||(renderPriority==other.renderPriority && Material<other.Material);
 				}
 
+				//! key for radix sorting, in the same order as operator<
+				uint64_t getSortKey() const
+				{
+					return (uint64_t(renderPriority)<<MaterialKeyBits)|(uint64_t(Material)&MaterialKeyMask);
+				}
+
 				ISceneNode* Node;
 			private:
+				//! the material goes to the low bits of the sort key, so that the render priority takes precedence
+				static constexpr uint64_t MaterialKeyBits = 32ull;
+				static constexpr uint64_t MaterialKeyMask = (0x1ull<<MaterialKeyBits)-1ull;
+
 				uint32_t renderPriority;
 				video::E_MATERIAL_TYPE Material;
 		};
@@ -293,6 +311,15 @@ namespace scene
 				return Distance > other.Distance;
 			}
 
+			//! key for radix sorting, in the same order as operator<
+			uint64_t getSortKey() const
+			{
+				// squared distances are never negative, so their bits order the same as their values
+				uint64_t bits;
+				memcpy(&bits,&Distance,sizeof(bits));
+				return ~bits;
+			}
+
 			ISceneNode* Node;
 			private:
 				double Distance;
@@ -349,6 +376,28 @@ namespace scene
 
 		core::vector<IDummyTransformationSceneNode*> DeletionList;
 
+		//! A node gathered by cullVisibleNodes, exactly as it was when it got culled
+		struct CullingEntry
+		{
+			core::matrix4x3 Transform;
+			core::aabbox3df Box;
+			uint32_t CullMode;
+			uint32_t Padding;
+
+			bool matches(ISceneNode* node) const
+			{
+				return memcmp(&Transform,&node->getAbsoluteTransformation(),sizeof(Transform))==0 &&
+					memcmp(&Box,&node->getBoundingBox(),sizeof(Box))==0 && CullMode==node->getAutomaticCulling();
+			}
+		};
+		//! results of cullVisibleNodes, only valid during drawAll for CullingCamera
+		const ICameraSceneNode* CullingCamera;
+		core::vector<CullingEntry> CullingEntries;
+		core::vector<uint8_t> CullingResults;
+		core::open_addressing_multimap<const ISceneNode*,uint32_t> CullingEntryIndices;
+		core::vector<IDummyTransformationSceneNode*> CullingTraversalStack;
+		uint32_t CullingThreadCount;
+
 		//! current active camera
 		ICameraSceneNode* ActiveCamera;
 
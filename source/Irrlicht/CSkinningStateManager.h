@@ -5,6 +5,7 @@
 #include "ISkinningStateManager.h"
 #include "ITextureBufferObject.h"
 #include "IVideoDriver.h"
+#include "irr/core/parallel_for.h"
 
 ///#define UPDATE_WHOLE_BUFFER
 
@@ -86,6 +87,7 @@ namespace scene
                 tmp->refCount = 1;
                 tmp->frame = 0.f;
                 tmp->interpolateAnimation = true;
+                tmp->keyframeCursor = 0u;
                 tmp->attachedNode = attachedNode;
                 if (boneControlMode!=EBUM_CONTROL)
                 {
@@ -217,7 +219,7 @@ namespace scene
 
 
                 float interpolationFactor;
-                size_t foundKeyIx = referenceHierarchy->getLowerBoundBoneKeyframes(interpolationFactor,currentInstance->frame);
+                size_t foundKeyIx = referenceHierarchy->getLowerBoundBoneKeyframes(interpolationFactor,currentInstance->frame,currentInstance->keyframeCursor);
                 float interpolantPrecalcTerm2,interpolantPrecalcTerm3;
                 core::quaternion::flerp_interpolant_terms(interpolantPrecalcTerm2,interpolantPrecalcTerm3,interpolationFactor);
 
@@ -309,6 +311,35 @@ namespace scene
                                 uint8_t* boneData = reinterpret_cast<uint8_t*>(instanceBoneDataAllocator->getBackBufferPointer());
                                 bool notModified = true;
                                 uint32_t localFirstDirtyInstance,localLastDirtyInstance;
+                                if (boneControlMode==EBUM_NONE)
+                                {
+                                    // no scene nodes get touched, so instances can be spread across threads
+                                    const size_t firstAddr = instanceBoneDataAllocator->getAddressAllocator().get_align_offset();
+                                    const size_t instanceSlots = (instanceBoneDataAllocator->getAddressAllocator().get_total_size()-firstAddr)/instanceFinalBoneDataSize;
+                                    std::atomic<size_t> firstDirty(~size_t(0u)), lastDirty(0u);
+                                    core::parallel_for(boningThreadCount,size_t(0u),instanceSlots,[&](size_t slot) -> void
+                                    {
+                                        const size_t i = firstAddr+slot*instanceFinalBoneDataSize;
+                                        BoneHierarchyInstanceData* currentInstance = getBoneHierarchyInstanceFromAddr(i);
+                                        if (!currentInstance->refCount || currentInstance->frame==currentInstance->lastAnimatedFrame)
+                                            return;
+
+                                        boneInstance(referenceHierarchy,currentInstance->frame,currentInstance->interpolateAnimation,currentInstance->keyframeCursor,getGlobalMatrices(currentInstance),reinterpret_cast<FinalBoneData*>(boneData+i));
+
+                                        size_t expected = firstDirty.load(std::memory_order_relaxed);
+                                        while (i<expected && !firstDirty.compare_exchange_weak(expected,i,std::memory_order_relaxed)) {}
+                                        expected = lastDirty.load(std::memory_order_relaxed);
+                                        while (i>expected && !lastDirty.compare_exchange_weak(expected,i,std::memory_order_relaxed)) {}
+                                    },size_t(16u));
+
+                                    if (firstDirty.load()<=lastDirty.load())
+                                    {
+                                        localFirstDirtyInstance = firstDirty.load();
+                                        localLastDirtyInstance = lastDirty.load();
+                                        notModified = false;
+                                    }
+                                }
+                                else
                                 for (size_t i=instanceBoneDataAllocator->getAddressAllocator().get_align_offset(); i<instanceBoneDataAllocator->getAddressAllocator().get_total_size(); i+=instanceFinalBoneDataSize)
                                 {
                                     BoneHierarchyInstanceData* currentInstance = getBoneHierarchyInstanceFromAddr(i);
@@ -321,7 +352,7 @@ namespace scene
 
 
                                     float interpolationFactor;
-                                    size_t foundKeyIx = referenceHierarchy->getLowerBoundBoneKeyframes(interpolationFactor,currentInstance->frame);
+                                    size_t foundKeyIx = referenceHierarchy->getLowerBoundBoneKeyframes(interpolationFactor,currentInstance->frame,currentInstance->keyframeCursor);
                                     float interpolantPrecalcTerm2,interpolantPrecalcTerm3;
                                     core::quaternion::flerp_interpolant_terms(interpolantPrecalcTerm2,interpolantPrecalcTerm3,interpolationFactor);
 
@@ -135,6 +135,7 @@ CTarReader::CTarReader(IReadFile* file, bool ignoreCase, bool ignorePaths)
 
 		// fill the file list
 		populateFileList();
+		sort();
 	}
 }
 
@@ -230,9 +231,20 @@ IReadFile* CTarReader::createAndOpenFile(const io::path& filename)
 {
     auto it = findFile(Files.begin(),Files.end(),filename,false);
 	if (it!=Files.end())
-        return new CLimitReadFile(File, it->Offset, it->Size, it->FullName);
+        return createAndOpenFile(static_cast<uint32_t>(it-Files.begin()));
 
 	return 0;
+}
+
+
+//! opens a file by its index in the file list
+IReadFile* CTarReader::createAndOpenFile(uint32_t index)
+{
+	if (index >= Files.size())
+		return 0;
+
+	const SFileListEntry& entry = Files[index];
+	return new CLimitReadFile(File, entry.Offset, entry.Size, entry.FullName);
 }
 } // end namespace io
 } // end namespace irr
@@ -3,7 +3,6 @@
 // For conditions of distribution and use, see copyright notice in irrlicht.h
 
 #include "CZipReader.h"
-#include "CMemoryFile.h"
 #include "CLimitReadFile.h"
 
 #include "os.h"
@@ -158,6 +157,7 @@ CZipReader::CZipReader(IReadFile* file, bool ignoreCase, bool ignorePaths, bool
 			while (scanGZipHeader()) { }
 		else
 			while (scanZipHeader()) { }
+		sort();
 	}
 }
 
@@ -480,12 +480,433 @@ bool CZipReader::scanCentralDirectoryHeader()
 }
 
 
+namespace
+{
+#ifdef _IRR_COMPILE_WITH_LZMA_
+	//! Used for LZMA decompression. The lib has no default memory management
+	void *SzAlloc(ISzAllocPtr p, size_t size) { return _IRR_ALIGNED_MALLOC(size,_IRR_SIMD_ALIGNMENT); }
+	void SzFree(ISzAllocPtr p, void *address) { _IRR_ALIGNED_FREE(address); }
+	ISzAlloc lzmaAlloc = { SzAlloc, SzFree };
+#endif
+
+//! Decompresses (and decrypts) a zip entry while it is being read.
+/** Only a small window of decompressed data is kept in memory. Reads and seeks forward carry on
+from where decompression stopped, big reads get decompressed straight into the caller's buffer.
+Seeking back past the window restarts decompression from the beginning of the entry. */
+class CZipEntryReadFile : public IReadFile
+{
+	public:
+		CZipEntryReadFile(IReadFile* compressed, int16_t method, size_t uncompressedSize, const io::path& name)
+			: Compressed(compressed), Filename(name), Method(method), Size(uncompressedSize), Pos(0),
+			WindowStart(0), WindowFill(0), Decompressed(0), InputPos(0), InPtr(0), InAvail(0),
+			DecoderReady(false), Finished(false)
+#ifdef _IRR_COMPILE_WITH_ZIP_ENCRYPTION_
+			, Encrypted(false)
+#endif
+		{
+			#ifdef _IRR_DEBUG
+			setDebugName("CZipEntryReadFile");
+			#endif
+
+			Compressed->grab();
+		}
+
+		//! returns whether the compression method can be streamed in this build
+		static bool isMethodSupported(int16_t method)
+		{
+			switch (method)
+			{
+				case 0:
+					return true;
+#ifdef _IRR_COMPILE_WITH_ZLIB_
+				case 8:
+					return true;
+#endif
+#ifdef _IRR_COMPILE_WITH_BZIP2_
+				case 12:
+					return true;
+#endif
+#ifdef _IRR_COMPILE_WITH_LZMA_
+				case 14:
+					return true;
+#endif
+				default:
+					return false;
+			}
+		}
+
+#ifdef _IRR_COMPILE_WITH_ZIP_ENCRYPTION_
+		//! makes the compressed data get decrypted as it is read, call before open()
+		void setDecryption(const fcrypt_ctx& ctx)
+		{
+			InitialCryptCtx = ctx;
+			CryptCtx = ctx;
+			Encrypted = true;
+		}
+#endif
+
+		//! sets up the decoder, returns false if the entry can't be decompressed
+		bool open()
+		{
+			switch (Method)
+			{
+				case 0:
+					break;
+#ifdef _IRR_COMPILE_WITH_ZLIB_
+				case 8:
+					memset(&ZStream, 0, sizeof(ZStream));
+					// wbits < 0 indicates no zlib header inside the data.
+					if (inflateInit2(&ZStream, -MAX_WBITS) != Z_OK)
+						return false;
+					break;
+#endif
+#ifdef _IRR_COMPILE_WITH_BZIP2_
+				case 12:
+					memset(&BZStream, 0, sizeof(BZStream));
+					if (BZ2_bzDecompressInit(&BZStream, 0, 0) != BZ_OK)
+						return false;
+					break;
+#endif
+#ifdef _IRR_COMPILE_WITH_LZMA_
+				case 14:
+				{
+					LzmaDec_Construct(&LzmaDecoder);
+					const uint8_t* props = readLzmaHeader();
+					if (!props || LzmaDec_Allocate(&LzmaDecoder, props, LzmaPropSize, &lzmaAlloc) != SZ_OK)
+						return false;
+					LzmaDec_Init(&LzmaDecoder);
+					break;
+				}
+#endif
+				default:
+					return false;
+			}
+			DecoderReady = true;
+			return true;
+		}
+
+		//! returns how much was read
+		virtual size_t read(void* buffer, size_t sizeToRead) override
+		{
+			if (!DecoderReady || Pos >= Size)
+				return 0;
+
+			sizeToRead = core::min_(sizeToRead, Size - Pos);
+			uint8_t* out = reinterpret_cast<uint8_t*>(buffer);
+			size_t done = 0;
+			while (done < sizeToRead)
+			{
+				if (Pos >= WindowStart && Pos < WindowStart + WindowFill)
+				{
+					const size_t count = core::min_(WindowStart + WindowFill - Pos, sizeToRead - done);
+					memcpy(out + done, Window + (Pos - WindowStart), count);
+					done += count;
+					Pos += count;
+					continue;
+				}
+
+				if (Pos < Decompressed && !restart())
+					break;
+
+				if (Pos == Decompressed && sizeToRead - done >= kWindowSize)
+				{
+					const size_t count = decompress(out + done, sizeToRead - done);
+					WindowStart = Decompressed;
+					WindowFill = 0;
+					if (!count)
+						break;
+					done += count;
+					Pos += count;
+				}
+				else
+				{
+					// also skips forward until the window reaches Pos
+					WindowStart = Decompressed;
+					WindowFill = decompress(Window, core::min_(kWindowSize, Size - Decompressed));
+					if (!WindowFill)
+						break;
+				}
+			}
+			return done;
+		}
+
+		//! changes position in file, the data gets decompressed on the next read
+		virtual bool seek(const size_t& finalPos, bool relativeMovement = false) override
+		{
+			const size_t newPos = relativeMovement ? (Pos + finalPos) : finalPos;
+			if (newPos > Size)
+				return false;
+
+			Pos = newPos;
+			return true;
+		}
+
+		virtual size_t getSize() const override { return Size; }
+
+		virtual size_t getPos() const override { return Pos; }
+
+		virtual const io::path& getFileName() const override { return Filename; }
+
+	protected:
+		virtual ~CZipEntryReadFile()
+		{
+			if (DecoderReady)
+			{
+				switch (Method)
+				{
+#ifdef _IRR_COMPILE_WITH_ZLIB_
+					case 8:
+						inflateEnd(&ZStream);
+						break;
+#endif
+#ifdef _IRR_COMPILE_WITH_BZIP2_
+					case 12:
+						BZ2_bzDecompressEnd(&BZStream);
+						break;
+#endif
+#ifdef _IRR_COMPILE_WITH_LZMA_
+					case 14:
+						LzmaDec_Free(&LzmaDecoder, &lzmaAlloc);
+						break;
+#endif
+					default:
+						break;
+				}
+			}
+			Compressed->drop();
+		}
+
+	private:
+		//! makes more compressed data available, returns false when all of it has been consumed
+		bool refillInput()
+		{
+			const size_t compressedSize = Compressed->getSize();
+			if (InputPos >= compressedSize)
+				return false;
+
+			// data stored in a memory mapped archive gets decompressed in place
+			const uint8_t* mapped = reinterpret_cast<const uint8_t*>(Compressed->getMappedPointer());
+#ifdef _IRR_COMPILE_WITH_ZIP_ENCRYPTION_
+			if (Encrypted)
+				mapped = 0;
+#endif
+			if (mapped)
+			{
+				InPtr = mapped + InputPos;
+				InAvail = compressedSize - InputPos;
+				InputPos = compressedSize;
+				return true;
+			}
+
+			Compressed->seek(InputPos);
+			InAvail = Compressed->read(InBuf, core::min_(kInputSize, compressedSize - InputPos));
+			InPtr = InBuf;
+			InputPos += InAvail;
+#ifdef _IRR_COMPILE_WITH_ZIP_ENCRYPTION_
+			if (Encrypted)
+				fcrypt_decrypt(InBuf, InAvail, &CryptCtx);
+#endif
+			return InAvail != 0;
+		}
+
+#ifdef _IRR_COMPILE_WITH_LZMA_
+		//! skips the LZMA version and properties header, returns the properties
+		const uint8_t* readLzmaHeader()
+		{
+			if (!refillInput() || InAvail < 4)
+				return 0;
+
+			LzmaPropSize = (InPtr[3] << 8) + InPtr[2];
+			if (InAvail < 4 + LzmaPropSize)
+				return 0;
+
+			const uint8_t* props = InPtr + 4;
+			InPtr += 4 + LzmaPropSize;
+			InAvail -= 4 + LzmaPropSize;
+			return props;
+		}
+#endif
+
+		//! starts decompressing from the beginning of the entry again
+		bool restart()
+		{
+			InputPos = 0;
+			InAvail = 0;
+			Decompressed = 0;
+			WindowStart = 0;
+			WindowFill = 0;
+			Finished = false;
+#ifdef _IRR_COMPILE_WITH_ZIP_ENCRYPTION_
+			CryptCtx = InitialCryptCtx;
+#endif
+			switch (Method)
+			{
+#ifdef _IRR_COMPILE_WITH_ZLIB_
+				case 8:
+					return inflateReset(&ZStream) == Z_OK;
+#endif
+#ifdef _IRR_COMPILE_WITH_BZIP2_
+				case 12:
+					BZ2_bzDecompressEnd(&BZStream);
+					memset(&BZStream, 0, sizeof(BZStream));
+					if (BZ2_bzDecompressInit(&BZStream, 0, 0) == BZ_OK)
+						return true;
+					DecoderReady = false;
+					return false;
+#endif
+#ifdef _IRR_COMPILE_WITH_LZMA_
+				case 14:
+					LzmaDec_Init(&LzmaDecoder);
+					return readLzmaHeader() != 0;
+#endif
+				default:
+					return true;
+			}
+		}
+
+		//! decompresses up to `size` bytes to `out`, less only at the end of the entry or on errors
+		size_t decompress(uint8_t* out, size_t size)
+		{
+			size_t produced = 0;
+			while (produced < size && !Finished)
+			{
+				const bool inputLeft = InAvail || refillInput();
+				// the decoders take 32bit sizes
+				const size_t inCapacity = core::min_<size_t>(InAvail, 0x40000000u);
+				const size_t outCapacity = core::min_<size_t>(size - produced, 0x40000000u);
+				size_t inCount = 0, outCount = 0;
+				bool failed = false;
+				switch (Method)
+				{
+					case 0:
+						inCount = outCount = core::min_(inCapacity, outCapacity);
+						memcpy(out + produced, InPtr, outCount);
+						break;
+#ifdef _IRR_COMPILE_WITH_ZLIB_
+					case 8:
+					{
+						ZStream.next_in = (Bytef*)InPtr;
+						ZStream.avail_in = (uInt)inCapacity;
+						ZStream.next_out = (Bytef*)(out + produced);
+						ZStream.avail_out = (uInt)outCapacity;
+						const int err = inflate(&ZStream, Z_NO_FLUSH);
+						inCount = inCapacity - ZStream.avail_in;
+						outCount = outCapacity - ZStream.avail_out;
+						Finished = err == Z_STREAM_END;
+						failed = err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR;
+						break;
+					}
+#endif
+#ifdef _IRR_COMPILE_WITH_BZIP2_
+					case 12:
+					{
+						BZStream.next_in = (char*)InPtr;
+						BZStream.avail_in = (unsigned int)inCapacity;
+						BZStream.next_out = (char*)(out + produced);
+						BZStream.avail_out = (unsigned int)outCapacity;
+						const int err = BZ2_bzDecompress(&BZStream);
+						inCount = inCapacity - BZStream.avail_in;
+						outCount = outCapacity - BZStream.avail_out;
+						Finished = err == BZ_STREAM_END;
+						failed = err != BZ_OK && err != BZ_STREAM_END;
+						break;
+					}
+#endif
+#ifdef _IRR_COMPILE_WITH_LZMA_
+					case 14:
+					{
+						SizeT srcLen = inCapacity;
+						SizeT destLen = outCapacity;
+						ELzmaStatus status;
+						const SRes err = LzmaDec_DecodeToBuf(&LzmaDecoder, (Byte*)(out + produced), &destLen, InPtr, &srcLen, LZMA_FINISH_ANY, &status);
+						inCount = srcLen;
+						outCount = destLen;
+						Finished = status == LZMA_STATUS_FINISHED_WITH_MARK;
+						failed = err != SZ_OK;
+						break;
+					}
+#endif
+					default:
+						failed = true;
+						break;
+				}
+				InPtr += inCount;
+				InAvail -= inCount;
+				produced += outCount;
+
+				if (failed)
+					os::Printer::log("Error decompressing", Filename.c_str(), ELL_ERROR);
+				if (failed || (!outCount && (!inputLeft || !inCount)))
+				{
+					Finished = true;
+					break;
+				}
+			}
+			Decompressed += produced;
+			return produced;
+		}
+
+		static constexpr size_t kWindowSize = 0x10000u;
+		static constexpr size_t kInputSize = 0x10000u;
+
+		IReadFile* Compressed;
+		io::path Filename;
+		int16_t Method;
+		size_t Size;
+		size_t Pos;
+
+		//! decompressed bytes [WindowStart,WindowStart+WindowFill) of the entry
+		uint8_t Window[kWindowSize];
+		size_t WindowStart;
+		size_t WindowFill;
+		//! how much of the entry the decoder has produced so far
+		size_t Decompressed;
+
+		uint8_t InBuf[kInputSize];
+		//! how much of the compressed data has been handed to the decoder
+		size_t InputPos;
+		const uint8_t* InPtr;
+		size_t InAvail;
+
+		bool DecoderReady;
+		bool Finished;
+
+#ifdef _IRR_COMPILE_WITH_ZLIB_
+		z_stream ZStream;
+#endif
+#ifdef _IRR_COMPILE_WITH_BZIP2_
+		bz_stream BZStream;
+#endif
+#ifdef _IRR_COMPILE_WITH_LZMA_
+		CLzmaDec LzmaDecoder;
+		uint32_t LzmaPropSize;
+#endif
+#ifdef _IRR_COMPILE_WITH_ZIP_ENCRYPTION_
+		fcrypt_ctx InitialCryptCtx;
+		fcrypt_ctx CryptCtx;
+		bool Encrypted;
+#endif
+};
+}
+
+
 //! opens a file by file name
 IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
-{
+{
     auto found = findFile(Files.begin(),Files.end(),filename,false);
-	if (found==Files.end())
-        return nullptr;
+	if (found==Files.end())
+        return nullptr;
+
+	return createAndOpenFile(static_cast<uint32_t>(found-Files.begin()));
+}
+
+
+//! opens a file by its index in the file list
+IReadFile* CZipReader::createAndOpenFile(uint32_t index)
+{
+	if (index >= Files.size())
+		return nullptr;
+	auto found = Files.begin()+index;
 
 	// Irrlicht supports 0, 8, 12, 14, 99
 	//0 - The file is stored (no compression)
@@ -509,22 +930,27 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
 	const SZipFileEntry &e = FileInfo[found->ID];
 	wchar_t buf[64];
 	int16_t actualCompressionMethod=e.header.CompressionMethod;
-	IReadFile* decrypted=0;
-	uint8_t* decryptedBuf=0;
-	uint32_t decryptedSize=e.header.DataDescriptor.CompressedSize;
+	size_t dataOffset=e.Offset;
+	size_t dataSize=e.header.DataDescriptor.CompressedSize;
+	size_t uncompressedSize=e.header.DataDescriptor.UncompressedSize;
 #ifdef _IRR_COMPILE_WITH_ZIP_ENCRYPTION_
+	fcrypt_ctx zctx; // the encryption context
+	bool encrypted=false;
 	if ((e.header.GeneralBitFlag & ZIP_FILE_ENCRYPTED) && (e.header.CompressionMethod == 99))
 	{
 		os::Printer::log("Reading encrypted file.");
+		// entries of this archive may be read by other threads meanwhile
+		auto readAt = [this](size_t pos, void* buffer, size_t size) -> void
+		{
+			CLimitReadFile::readAt(File, pos, buffer, size);
+		};
 		uint8_t salt[16]={0};
 		const uint16_t saltSize = (((e.header.Sig & 0x00ff0000) >>16)+1)*4;
-		File->seek(e.Offset);
-		File->read(salt, saltSize);
+		readAt(e.Offset, salt, saltSize);
 		char pwVerification[2];
 		char pwVerificationFile[2];
-		File->read(pwVerification, 2);
-		fcrypt_ctx zctx; // the encryption context
-		int rc = fcrypt_init(
+		readAt(e.Offset+saltSize, pwVerification, 2);
+		fcrypt_init(
 			(e.header.Sig & 0x00ff0000) >>16,
 			(const unsigned char*)Password.c_str(), // the password
 			Password.size(), // number of bytes in password
@@ -536,44 +962,39 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
 			os::Printer::log("Wrong password");
 			return 0;
 		}
-		decryptedSize= e.header.DataDescriptor.CompressedSize-saltSize-12;
-		decryptedBuf= new uint8_t[decryptedSize];
-		uint32_t c = 0;
-		while ((c+32768)<=decryptedSize)
+		dataOffset = e.Offset+saltSize+2;
+		dataSize = e.header.DataDescriptor.CompressedSize-saltSize-12;
+
+		// the authentication code covers the encrypted data, check it before anything gets decrypted
+		fcrypt_ctx authCtx = zctx;
+		uint8_t block[32768];
+		for (size_t c=0; c<dataSize; c+=sizeof(block))
 		{
-			File->read(decryptedBuf+c, 32768);
-			fcrypt_decrypt(
-				decryptedBuf+c, // pointer to the data to decrypt
-				32768,   // how many bytes to decrypt
-				&zctx); // decryption context
-			c+=32768;
+			const size_t blockSize = core::min_(dataSize-c, sizeof(block));
+			readAt(dataOffset+c, block, blockSize);
+			hmac_sha1_data(block, blockSize, authCtx.auth_ctx);
 		}
-		File->read(decryptedBuf+c, decryptedSize-c);
-		fcrypt_decrypt(
-			decryptedBuf+c, // pointer to the data to decrypt
-			decryptedSize-c,   // how many bytes to decrypt
-			&zctx); // decryption context
 
 		char fileMAC[10];
 		char resMAC[10];
-		rc = fcrypt_end(
+		const int rc = fcrypt_end(
 			(unsigned char*)resMAC, // on return contains the authentication code
-			&zctx); // encryption context
+			&authCtx); // encryption context
 		if (rc != 10)
 		{
 			os::Printer::log("Error on encryption closing");
-			delete [] decryptedBuf;
 			return 0;
 		}
-		File->read(fileMAC, 10);
+		readAt(dataOffset+dataSize, fileMAC, 10);
 		if (strncmp(fileMAC, resMAC, 10))
 		{
 			os::Printer::log("Error on encryption check");
-			delete [] decryptedBuf;
 			return 0;
 		}
-        decrypted = new io::CMemoryReadFile(decryptedBuf, decryptedSize, found->FullName);
+		encrypted = true;
 		actualCompressionMethod = (e.header.Sig & 0xffff);
+		if (actualCompressionMethod == 0)
+			uncompressedSize = dataSize;
 #if 0
 		if ((e.header.Sig & 0xff000000)==0x01000000)
 		{
@@ -592,263 +1013,46 @@ IReadFile* CZipReader::createAndOpenFile(const io::path& filename)
 	switch(actualCompressionMethod)
 	{
 	case 0: // no compression
-		{
-            delete[] decryptedBuf;
-			if (decrypted)
-				return decrypted;
-			else
-                return new CLimitReadFile(File, e.Offset, decryptedSize, found->FullName);
-		}
+#ifdef _IRR_COMPILE_WITH_ZIP_ENCRYPTION_
+		if (encrypted)
+			break;
+#endif
+		return new CLimitReadFile(File, dataOffset, dataSize, found->FullName);
 	case 8:
-		{
-  			#ifdef _IRR_COMPILE_WITH_ZLIB_
-
-			const uint32_t uncompressedSize = e.header.DataDescriptor.UncompressedSize;
-			char* pBuf = new char[ uncompressedSize ];
-			if (!pBuf)
-			{
-				swprintf ( buf, 64, L"Not enough memory for decompressing %s", found->FullName.c_str() );
-				os::Printer::log( buf, ELL_ERROR);
-                delete[] decryptedBuf;
-				if (decrypted)
-					decrypted->drop();
-				return 0;
-			}
-
-			uint8_t *pcData = decryptedBuf;
-			if (!pcData)
-			{
-				pcData = new uint8_t[decryptedSize];
-				if (!pcData)
-				{
-					swprintf ( buf, 64, L"Not enough memory for decompressing %s", found->FullName.c_str() );
-					os::Printer::log( buf, ELL_ERROR);
-                    delete[] decryptedBuf;
-					delete [] pBuf;
-					return 0;
-				}
-
-				//memset(pcData, 0, decryptedSize);
-				File->seek(e.Offset);
-				File->read(pcData, decryptedSize);
-			}
-
-			// Setup the inflate stream.
-			z_stream stream;
-			int32_t err;
-
-			stream.next_in = (Bytef*)pcData;
-			stream.avail_in = (uInt)decryptedSize;
-			stream.next_out = (Bytef*)pBuf;
-			stream.avail_out = uncompressedSize;
-			stream.zalloc = (alloc_func)0;
-			stream.zfree = (free_func)0;
-
-			// Perform inflation. wbits < 0 indicates no zlib header inside the data.
-			err = inflateInit2(&stream, -MAX_WBITS);
-			if (err == Z_OK)
-			{
-				err = inflate(&stream, Z_FINISH);
-				inflateEnd(&stream);
-				if (err == Z_STREAM_END)
-					err = Z_OK;
-				err = Z_OK;
-				inflateEnd(&stream);
-			}
-
-			if (decrypted)
-				decrypted->drop();
-			else
-				delete[] pcData;
-
-            delete[] decryptedBuf;
-			if (err != Z_OK)
-			{
-				swprintf ( buf, 64, L"Error decompressing %s", found->FullName.c_str() );
-				os::Printer::log( buf, ELL_ERROR);
-				delete [] pBuf;
-				return 0;
-			}
-            else
-            {
-                auto ret = new io::CMemoryReadFile(pBuf, uncompressedSize, found->FullName);
-                delete[] pBuf;
-                return ret;
-            }
-
-			#else
-			return 0; // zlib not compiled, we cannot decompress the data.
-			#endif
-		}
 	case 12:
-		{
-  			#ifdef _IRR_COMPILE_WITH_BZIP2_
-
-			const uint32_t uncompressedSize = e.header.DataDescriptor.UncompressedSize;
-			char* pBuf = new char[ uncompressedSize ];
-			if (!pBuf)
-			{
-				swprintf ( buf, 64, L"Not enough memory for decompressing %s", found->FullName.c_str() );
-				os::Printer::log( buf, ELL_ERROR);
-                delete[] decryptedBuf;
-				if (decrypted)
-					decrypted->drop();
-				return 0;
-			}
-
-			uint8_t *pcData = decryptedBuf;
-			if (!pcData)
-			{
-				pcData = new uint8_t[decryptedSize];
-				if (!pcData)
-				{
-					swprintf ( buf, 64, L"Not enough memory for decompressing %s", found->FullName.c_str() );
-					os::Printer::log( buf, ELL_ERROR);
-					delete [] pBuf;
-                    delete[] decryptedBuf;
-					return 0;
-				}
-
-				//memset(pcData, 0, decryptedSize);
-				File->seek(e.Offset);
-				File->read(pcData, decryptedSize);
-			}
-
-			bz_stream bz_ctx={0};
-			/* use BZIP2's default memory allocation
-			bz_ctx->bzalloc = NULL;
-			bz_ctx->bzfree  = NULL;
-			bz_ctx->opaque  = NULL;
-			*/
-			int err = BZ2_bzDecompressInit(&bz_ctx, 0, 0); /* decompression */
-			if(err != BZ_OK)
-			{
-				os::Printer::log("bzip2 decompression failed. File cannot be read.", ELL_ERROR);
-                delete[] decryptedBuf;
-				return 0;
-			}
-			bz_ctx.next_in = (char*)pcData;
-			bz_ctx.avail_in = decryptedSize;
-			/* pass all input to decompressor */
-			bz_ctx.next_out = pBuf;
-			bz_ctx.avail_out = uncompressedSize;
-			err = BZ2_bzDecompress(&bz_ctx);
-			err = BZ2_bzDecompressEnd(&bz_ctx);
-
-			if (decrypted)
-				decrypted->drop();
-			else
-				delete[] pcData;
-
-			if (err != BZ_OK)
-			{
-				swprintf ( buf, 64, L"Error decompressing %s", found->FullName.c_str() );
-				os::Printer::log( buf, ELL_ERROR);
-				delete [] pBuf;
-                delete[] decryptedBuf;
-				return 0;
-			}
-            else
-            {
-                auto ret = new io::CMemoryReadFile(pBuf, uncompressedSize, found->FullName);
-                delete[] pBuf;
-                return ret;
-            }
-
-			#else
-            delete[] decryptedBuf;
-			os::Printer::log("bzip2 decompression not supported. File cannot be read.", ELL_ERROR);
-			return 0;
-			#endif
-		}
 	case 14:
-		{
-  			#ifdef _IRR_COMPILE_WITH_LZMA_
-
-			uint32_t uncompressedSize = e.header.DataDescriptor.UncompressedSize;
-			char* pBuf = new char[ uncompressedSize ];
-			if (!pBuf)
-			{
-				swprintf ( buf, 64, L"Not enough memory for decompressing %s", found->FullName.c_str() );
-				os::Printer::log( buf, ELL_ERROR);
-                delete[] decryptedBuf;
-				if (decrypted)
-					decrypted->drop();
-				return 0;
-			}
-
-			uint8_t *pcData = decryptedBuf;
-			if (!pcData)
-			{
-				pcData = new uint8_t[decryptedSize];
-				if (!pcData)
-				{
-					swprintf ( buf, 64, L"Not enough memory for decompressing %s", found->FullName.c_str() );
-					os::Printer::log( buf, ELL_ERROR);
-					delete [] pBuf;
-					return 0;
-				}
-
-				//memset(pcData, 0, decryptedSize);
-				File->seek(e.Offset);
-				File->read(pcData, decryptedSize);
-			}
-
-			ELzmaStatus status;
-			SizeT tmpDstSize = uncompressedSize;
-			SizeT tmpSrcSize = decryptedSize;
-
-			unsigned int propSize = (pcData[3]<<8)+pcData[2];
-			int err = LzmaDecode((Byte*)pBuf, &tmpDstSize,
-					pcData+4+propSize, &tmpSrcSize,
-					pcData+4, propSize,
-					e.header.GeneralBitFlag&0x1?LZMA_FINISH_END:LZMA_FINISH_ANY, &status,
-					&lzmaAlloc);
-			uncompressedSize = tmpDstSize; // may be different to expected value
-
-			if (decrypted)
-				decrypted->drop();
-			else
-				delete[] pcData;
-
-            delete[] decryptedBuf;
-			if (err != SZ_OK)
-			{
-				os::Printer::log( "Error decompressing", found->FullName, ELL_ERROR);
-				delete [] pBuf;
-				return 0;
-			}
-			else
-				return io::createMemoryReadFile(pBuf, uncompressedSize, found->FullName, true);
-
-			#else
-            delete[] decryptedBuf;
-			os::Printer::log("lzma decompression not supported. File cannot be read.", ELL_ERROR);
-			return 0;
-			#endif
-		}
+		if (CZipEntryReadFile::isMethodSupported(actualCompressionMethod))
+			break;
+		swprintf ( buf, 64, L"decompression of method %d not compiled in. %s", int(actualCompressionMethod), found->FullName.c_str() );
+		os::Printer::log( buf, ELL_ERROR);
+		return 0;
 	case 99:
 		// If we come here with an encrypted file, decryption support is missing
 		os::Printer::log("Decryption support not enabled. File cannot be read.", ELL_ERROR);
-        delete[] decryptedBuf;
 		return 0;
 	default:
 		swprintf ( buf, 64, L"file has unsupported compression method. %s", found->FullName.c_str() );
 		os::Printer::log( buf, ELL_ERROR);
-        delete[] decryptedBuf;
 		return 0;
 	};
-}
 
-#ifdef _IRR_COMPILE_WITH_LZMA_
-//! Used for LZMA decompression. The lib has no default memory management
-namespace
-{
-	void *SzAlloc(void *p, size_t size) { p = p; return _IRR_ALIGNED_MALLOC(size,_IRR_SIMD_ALIGNMENT); }
-	void SzFree(void *p, void *address) { p = p; _IRR_ALIGNED_FREE(address); }
-	ISzAlloc lzmaAlloc = { SzAlloc, SzFree };
-}
+	// entries get decompressed as they are read, never as a whole
+	IReadFile* compressed = new CLimitReadFile(File, dataOffset, dataSize, found->FullName);
+	CZipEntryReadFile* ret = new CZipEntryReadFile(compressed, actualCompressionMethod, uncompressedSize, found->FullName);
+	compressed->drop();
+#ifdef _IRR_COMPILE_WITH_ZIP_ENCRYPTION_
+	if (encrypted)
+		ret->setDecryption(zctx);
 #endif
+	if (!ret->open())
+	{
+		swprintf ( buf, 64, L"Error decompressing %s", found->FullName.c_str() );
+		os::Printer::log( buf, ELL_ERROR);
+		ret->drop();
+		return 0;
+	}
+	return ret;
+}
 
 } // end namespace io
 } // end namespace irr
@@ -79,6 +79,7 @@
 #include "quaternion.h"
 #include "rect.h"
 #include "SAABoxCollider.h"
+#include "SBoundingVolumeHierarchy.h"
 #include "SceneParameters.h"
 #include "SCollisionEngine.h"
 #include "SColor.h"
@@ -153,6 +154,7 @@
 #include "irr/core/alloc/PoolAddressAllocator.h"
 #include "irr/core/alloc/ResizableHeterogenousMemoryAllocator.h"
 #include "irr/core/alloc/StackAddressAllocator.h"
+#include "irr/core/alloc/TLSFAddressAllocator.h"
 #include "irr/core/math/irrMath.h"
 #include "irr/core/math/plane3dSIMD.h"
 #include "irr/core/memory/memory.h"
@@ -0,0 +1,165 @@
+// Copyright (C) 2019 DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "IrrlichtBAW Engine"
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "irr/asset/CAsyncAssetLoader.h"
+#include "irr/asset/IAssetManager.h"
+
+using namespace irr;
+using namespace asset;
+
+
+bool CAsyncAssetLoader::SRequest::addWaiter()
+{
+    uint32_t expected = stateAndWaiters.load();
+    do
+    {
+        if (getState(expected)==ES_CANCELLED)
+            return false;
+    } while (!stateAndWaiters.compare_exchange_weak(expected, expected+1u));
+    return true;
+}
+
+bool CAsyncAssetLoader::SRequest::transition(E_STATE _from, E_STATE _to)
+{
+    uint32_t expected = stateAndWaiters.load();
+    do
+    {
+        if (getState(expected)!=_from)
+            return false;
+    } while (!stateAndWaiters.compare_exchange_weak(expected, (uint32_t(_to)<<StateShift)|getWaiters(expected)));
+    return true;
+}
+
+bool SAssetLoadFuture::cancel()
+{
+    if (!m_request || m_cancelled)
+        return false;
+    m_cancelled = true;
+
+    using SRequest = CAsyncAssetLoader::SRequest;
+    uint32_t expected = m_request->stateAndWaiters.load();
+    uint32_t desired;
+    bool cancelLoad;
+    do
+    {
+        // only the last waiter of a request which no worker picked up yet cancels the load
+        cancelLoad = SRequest::getWaiters(expected)==1u && SRequest::getState(expected)==SRequest::ES_QUEUED;
+        desired = cancelLoad ? (uint32_t(SRequest::ES_CANCELLED)<<SRequest::StateShift):(expected-1u);
+    } while (!m_request->stateAndWaiters.compare_exchange_weak(expected, desired));
+
+    // only the exchange which did QUEUED->CANCELLED may fulfill the promise, the loader's shutdown fulfills the ones it cancels
+    if (!cancelLoad)
+        return false;
+    // workers skip cancelled requests, so nobody else touches the promise
+    m_request->promise.set_value(SAssetBundle());
+    return true;
+}
+
+
+CAsyncAssetLoader::CAsyncAssetLoader(IAssetManager* _mgr, uint32_t _maxThreadCount) : m_mgr(_mgr), m_maxThreadCount(core::resolveThreadCount(_maxThreadCount))
+{
+}
+
+CAsyncAssetLoader::~CAsyncAssetLoader()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_quit = true;
+        for (auto& queue : m_queues)
+        {
+            for (auto& request : queue)
+            if (request->transition(SRequest::ES_QUEUED, SRequest::ES_CANCELLED))
+                request->promise.set_value(SAssetBundle());
+            queue.clear();
+        }
+        m_queuedCount = 0u;
+        m_pending.clear();
+    }
+    m_cv.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+core::smart_refctd_ptr<CAsyncAssetLoader::SRequest> CAsyncAssetLoader::enqueue(const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, IAssetLoader::IAssetLoaderOverride* _override, E_ASSET_LOAD_PRIORITY _priority)
+{
+    // a duplicate is requested explicitly, so it must not be shared
+    const bool deduplicate = (_params.cacheFlags&IAssetLoader::ECF_DUPLICATE_TOP_LEVEL)!=IAssetLoader::ECF_DUPLICATE_TOP_LEVEL;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (deduplicate)
+    {
+        auto found = m_pending.find(_filename);
+        if (found!=m_pending.end() && found->second->addWaiter())
+        {
+            SRequest* request = found->second.get();
+            if (_priority>request->priority)
+            {
+                // the entry in the lower priority queue stays, whichever gets popped second gets skipped
+                request->priority = _priority;
+                pushToQueue(core::smart_refctd_ptr<SRequest>(request), _priority);
+            }
+            return core::smart_refctd_ptr<SRequest>(request);
+        }
+    }
+
+    auto request = core::make_smart_refctd_ptr<SRequest>(_filename, _params, _override, _priority);
+    if (deduplicate)
+        m_pending[_filename] = request;
+    pushToQueue(core::smart_refctd_ptr<SRequest>(request.get()), _priority);
+    return request;
+}
+
+void CAsyncAssetLoader::pushToQueue(core::smart_refctd_ptr<SRequest>&& _request, uint32_t _priority)
+{
+    m_queues[_priority].push_back(std::move(_request));
+    m_queuedCount++;
+    if (m_queuedCount>m_idleThreads && m_threads.size()<m_maxThreadCount)
+        m_threads.emplace_back(&CAsyncAssetLoader::workerMain, this);
+    else
+        m_cv.notify_one();
+}
+
+void CAsyncAssetLoader::workerMain()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_idleThreads++;
+        m_cv.wait(lock, [this]() { return m_quit||m_queuedCount; });
+        m_idleThreads--;
+        if (m_quit)
+            return;
+
+        core::smart_refctd_ptr<SRequest> request;
+        for (uint32_t p=EALP_COUNT; !request && p--;)
+        if (!m_queues[p].empty())
+        {
+            request = std::move(m_queues[p].front());
+            m_queues[p].pop_front();
+            m_queuedCount--;
+        }
+
+        auto forgetPending = [&]() -> void
+        {
+            auto found = m_pending.find(request->filename);
+            if (found!=m_pending.end() && found->second.get()==request.get())
+                m_pending.erase(found);
+        };
+        // already cancelled or it's a second queue entry of a request which got its priority raised
+        if (!request->transition(SRequest::ES_QUEUED, SRequest::ES_RUNNING))
+        {
+            if (SRequest::getState(request->stateAndWaiters.load())==SRequest::ES_CANCELLED)
+                forgetPending();
+            continue;
+        }
+
+        lock.unlock();
+        SAssetBundle asset = m_mgr->getAsset(request->filename, request->params, request->loaderOverride);
+        request->transition(SRequest::ES_RUNNING, SRequest::ES_DONE);
+        request->promise.set_value(std::move(asset));
+        lock.lock();
+
+        forgetPending();
+    }
+}
@@ -15,21 +15,48 @@
 #include "IrrlichtDevice.h"
 #include "irr/asset/bawformat/legacy/CBAWLegacy.h"
 #include "CMemoryFile.h"
+#include "irr/core/parallel_for.h"
 
 #undef Bool
 #include "lzma/C/LzmaDec.h"
+#include "irr/asset/bawformat/LzmaMemMngmnt.h"
 
 namespace irr
 {
 namespace asset
 {
 
-struct LzmaMemMngmnt
+//! Forwards everything to the wrapped file, except for the format version number in the file header which reads as `_version`
+/** Used when conversion into the next format version boils down to the version number, so that the file doesn't have to be copied (and stays memory mapped). */
+class CBAWVersionOverrideReadFile : public io::IReadFile
 {
-        static void *alloc(ISzAllocPtr, size_t _size) { return _IRR_ALIGNED_MALLOC(_size,_IRR_SIMD_ALIGNMENT); }
-        static void release(ISzAllocPtr, void* _addr) { _IRR_ALIGNED_FREE(_addr); }
-    private:
-        LzmaMemMngmnt() {}
+        static constexpr size_t VERSION_OFFSET = 24u;
+
+        core::smart_refctd_ptr<io::IReadFile> m_file;
+        uint64_t m_version;
+
+    public:
+        CBAWVersionOverrideReadFile(io::IReadFile* _file, uint64_t _version) : m_file(_file), m_version(_version) {}
+
+        virtual size_t read(void* buffer, size_t sizeToRead) override
+        {
+            const size_t pos = m_file->getPos();
+            const size_t res = m_file->read(buffer, sizeToRead);
+            if (res > 0 && pos < VERSION_OFFSET+sizeof(m_version) && pos+res > VERSION_OFFSET)
+            {
+                const size_t begin = core::max_<size_t>(pos, VERSION_OFFSET);
+                const size_t end = core::min_<size_t>(pos+res, VERSION_OFFSET+sizeof(m_version));
+                memcpy(reinterpret_cast<uint8_t*>(buffer)+(begin-pos), reinterpret_cast<const uint8_t*>(&m_version)+(begin-VERSION_OFFSET), end-begin);
+            }
+            return res;
+        }
+        virtual bool seek(const size_t& finalPos, bool relativeMovement = false) override { return m_file->seek(finalPos, relativeMovement); }
+        virtual size_t getSize() const override { return m_file->getSize(); }
+        virtual size_t getPos() const override { return m_file->getPos(); }
+        virtual const io::path& getFileName() const override { return m_file->getFileName(); }
+        //! Blobs are at the same place, only the header in the mapping has the original version number
+        virtual const void* getMappedPointer() const override { return m_file->getMappedPointer(); }
+        virtual void setAccessPattern(io::E_FILE_ACCESS_PATTERN pattern) override { m_file->setAccessPattern(pattern); }
 };
 
 
@@ -59,7 +86,7 @@ asset::SAssetBundle CBAWMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 
     ctx.inner.mainFile = tryCreateNewestFormatVersionFile(ctx.inner.mainFile, _override, std::make_integer_sequence<uint64_t, _IRR_BAW_FORMAT_VERSION>{});
 
-    asset::BlobHeaderV1* headers = nullptr;
+    asset::BlobHeaderVn<_IRR_BAW_FORMAT_VERSION>* headers = nullptr;
 
     auto exitRoutine = [&] {
         if (ctx.inner.mainFile != _file) // if mainFile is temparary memory file created just to update format to the newest version
@@ -105,8 +132,89 @@ asset::SAssetBundle CBAWMeshFileLoader::loadAsset(io::IReadFile* _file, const as
         ctx.inner.params,
         _override
     };
+    const uint32_t threadCnt = core::resolveThreadCount(ctx.inner.params.workerThreadCount);
+    void* retval = threadCnt>1u ?
+        loadBlobsInParallel(ctx, &meshBlobDataIter->second, rootCacheKey, params, _override, threadCnt):
+        loadBlobsSerially(ctx, &meshBlobDataIter->second, rootCacheKey, params, _override);
+    if (!retval)
+    {
+        return {};
+    }
+
+	ctx.releaseAllButThisOne(meshBlobDataIter); // call drop on all loaded objects except mesh
+
+#ifdef _IRR_DEBUG
+	std::ostringstream tmpString("Time to load ");
+	tmpString.seekp(0, std::ios_base::end);
+	tmpString << "BAW file: " << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now()-time).count() << "us";
+	os::Printer::log(tmpString.str());
+#endif // _IRR_DEBUG
+
+    asset::ICPUMesh* mesh = reinterpret_cast<asset::ICPUMesh*>(retval);
+    return {core::smart_refctd_ptr<asset::IAsset>(mesh,core::dont_grab)};
+}
+
+const void* CBAWMeshFileLoader::readBlobWithKeyAttempts(SBlobData& _data, SContext& _ctx, asset::IAssetLoader::IAssetLoaderOverride* _override, const std::string& _cacheKey, uint32_t _chunkThreadCnt) const
+{
+    uint8_t decrKey[16];
+    size_t decrKeyLen = 16u;
+    uint32_t attempt = 0u;
+    const void* blob = nullptr;
+    // todo: supposedFilename arg is missing (empty string) - what is it?
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_ctx.overrideMutex);
+            decrKeyLen = 16u;
+            if (!_override->getDecryptionKey(decrKey, decrKeyLen, attempt, _ctx.inner.mainFile, "", _cacheKey, _ctx.inner, _data.hierarchyLvl))
+                break;
+        }
+        if (!((_data.header->compressionType & asset::Blob::EBCT_AES128_GCM) && decrKeyLen != 16u))
+            blob = _data.heapBlob = tryReadBlobOnStack(_data, _ctx, decrKey, nullptr, 0u, _chunkThreadCnt);
+        if (blob)
+            break;
+        ++attempt;
+    }
+    return blob;
+}
+
+const void* CBAWMeshFileLoader::tryGetMappedBlob(SBlobData& _data, const SContext& _ctx) const
+{
+    const uint8_t* const mapping = reinterpret_cast<const uint8_t*>(_ctx.inner.mainFile->getMappedPointer());
+    if (!mapping || _data.header->blobType != asset::Blob::EBT_RAW_DATA_BUFFER || _data.header->compressionType != asset::Blob::EBCT_RAW)
+        return nullptr;
+    if (_data.absOffset+_data.header->effectiveSize() > _ctx.inner.mainFile->getSize())
+        return nullptr;
+
+    const void* blob = mapping+_data.absOffset;
+    // ICPUBuffer contents are assumed to be SIMD aligned, blobs aren't padded in the file so misaligned ones take the copying path
+    if (reinterpret_cast<size_t>(blob)&(_IRR_SIMD_ALIGNMENT-1u))
+        return nullptr;
+    if (!_data.header->validate(blob))
+    {
+#ifdef _IRR_DEBUG
+        os::Printer::log("Blob validation failed!", ELL_ERROR);
+#endif
+        return nullptr;
+    }
+    return _data.mappedBlob = blob;
+}
+
+void* CBAWMeshFileLoader::instantiateEmpty(SContext& _ctx, const SBlobData& _data, const asset::BlobLoadingParams& _params) const
+{
+    if (_data.mappedBlob)
+    {
+        // the buffer keeps the file (and so the mapping) alive, memory is private copy-on-write so writes through the buffer are fine
+        core::refctd_memory_view_allocator<uint8_t> view(core::smart_refctd_ptr<const core::IReferenceCounted>(_ctx.inner.mainFile));
+        return static_cast<asset::ICPUBuffer*>(new asset::CMemoryViewCPUBuffer(_data.header->blobSizeDecompr, const_cast<void*>(_data.mappedBlob), core::adopt_memory, std::move(view)));
+    }
+    return _ctx.loadingMgr.instantiateEmpty(_data.header->blobType, _data.heapBlob, _data.header->blobSizeDecompr, _params);
+}
+
+void* CBAWMeshFileLoader::loadBlobsSerially(SContext& _ctx, SBlobData* _root, const std::string& _rootCacheKey, const asset::BlobLoadingParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override)
+{
 	core::stack<SBlobData*> toLoad, toFinalize;
-	toLoad.push(&meshBlobDataIter->second);
+	toLoad.push(_root);
     toLoad.top()->hierarchyLvl = 0u;
 	while (!toLoad.empty())
 	{
@@ -116,59 +224,49 @@ asset::SAssetBundle CBAWMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 		const uint64_t handle = data->header->handle;
         const uint32_t size = data->header->blobSizeDecompr;
         const uint32_t blobType = data->header->blobType;
-        const std::string thisCacheKey = genSubAssetCacheKey(rootCacheKey, handle);
+        const std::string thisCacheKey = genSubAssetCacheKey(_rootCacheKey, handle);
         const uint32_t hierLvl = data->hierarchyLvl;
 
-        uint8_t decrKey[16];
-        size_t decrKeyLen = 16u;
-        uint32_t attempt = 0u;
-        const void* blob = nullptr;
-        // todo: supposedFilename arg is missing (empty string) - what is it?
-        while (_override->getDecryptionKey(decrKey, decrKeyLen, attempt, ctx.inner.mainFile, "", thisCacheKey, ctx.inner, hierLvl))
-        {
-            if (!((data->header->compressionType & asset::Blob::EBCT_AES128_GCM) && decrKeyLen != 16u))
-                blob = data->heapBlob = tryReadBlobOnStack(*data, ctx, decrKey);
-            if (blob)
-                break;
-            ++attempt;
-        }
-
+        const void* blob = tryGetMappedBlob(*data, _ctx);
+        if (!blob)
+            blob = readBlobWithKeyAttempts(*data, _ctx, _override, thisCacheKey);
 		if (!blob)
 		{
-            return {};
+            return nullptr;
 		}
 
-		core::unordered_set<uint64_t> deps = ctx.loadingMgr.getNeededDeps(blobType, blob);
+		core::unordered_set<uint64_t> deps = _ctx.loadingMgr.getNeededDeps(blobType, blob);
         for (auto it = deps.begin(); it != deps.end(); ++it)
         {
-            if (ctx.createdObjs.find(*it) == ctx.createdObjs.end())
+            if (_ctx.createdObjs.find(*it) == _ctx.createdObjs.end())
             {
-                toLoad.push(&ctx.blobs[*it]);
+                toLoad.push(&_ctx.blobs[*it]);
                 toLoad.top()->hierarchyLvl = hierLvl+1u;
             }
         }
 
-        auto foundBundle = _override->findCachedAsset(thisCacheKey, nullptr, ctx.inner, hierLvl).getContents();
+        auto foundBundle = _override->findCachedAsset(thisCacheKey, nullptr, _ctx.inner, hierLvl).getContents();
         if (foundBundle.first!=foundBundle.second)
         {
-            ctx.createdObjs[handle] = toAddrUsedByBlobsLoadingMgr(foundBundle.first->get(), blobType);
+            foundBundle.first->get()->grab(); // created objects get dropped at the end of loading, cached ones included
+            _ctx.createdObjs[handle] = toAddrUsedByBlobsLoadingMgr(foundBundle.first->get(), blobType);
             continue;
         }
 
-		bool fail = !(ctx.createdObjs[handle] = ctx.loadingMgr.instantiateEmpty(blobType, blob, size, params));
+		bool fail = !(_ctx.createdObjs[handle] = instantiateEmpty(_ctx, *data, _params));
 
 		if (fail)
 		{
-            return {};
+            return nullptr;
 		}
 
 		if (!deps.size())
 		{
-            void* obj = ctx.createdObjs[handle];
-			ctx.loadingMgr.finalize(blobType, obj, blob, size, ctx.createdObjs, params);
+            void* obj = _ctx.createdObjs[handle];
+			_ctx.loadingMgr.finalize(blobType, obj, blob, size, _ctx.createdObjs, _params);
             _IRR_ALIGNED_FREE(data->heapBlob);
 			blob = data->heapBlob = NULL;
-            insertAssetIntoCache(ctx, _override, obj, blobType, hierLvl, thisCacheKey);
+            insertAssetIntoCache(_ctx, _override, obj, blobType, hierLvl, thisCacheKey);
 		}
 		else
 			toFinalize.push(data);
@@ -180,29 +278,155 @@ asset::SAssetBundle CBAWMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 		SBlobData* data = toFinalize.top();
 		toFinalize.pop();
 
-		const void* blob = data->heapBlob;
+		const void* blob = data->mappedBlob ? data->mappedBlob:data->heapBlob;
 		const uint64_t handle = data->header->handle;
 		const uint32_t size = data->header->blobSizeDecompr;
 		const uint32_t blobType = data->header->blobType;
         const uint32_t hierLvl = data->hierarchyLvl;
-        const std::string thisCacheKey = genSubAssetCacheKey(rootCacheKey, handle);
+        const std::string thisCacheKey = genSubAssetCacheKey(_rootCacheKey, handle);
 
-		retval = ctx.loadingMgr.finalize(blobType, ctx.createdObjs[handle], blob, size, ctx.createdObjs, params); // last one will always be mesh
+		retval = _ctx.loadingMgr.finalize(blobType, _ctx.createdObjs[handle], blob, size, _ctx.createdObjs, _params); // last one will always be mesh
         if (!toFinalize.empty()) // don't cache root-asset (mesh) as sub-asset because it'll be cached by asset manager directly (and there's only one IAsset::cacheKey)
-            insertAssetIntoCache(ctx, _override, retval, blobType, hierLvl, thisCacheKey);
+            insertAssetIntoCache(_ctx, _override, retval, blobType, hierLvl, thisCacheKey);
 	}
 
-	ctx.releaseAllButThisOne(meshBlobDataIter); // call drop on all loaded objects except mesh
+    return retval;
+}
 
-#ifdef _IRR_DEBUG
-	std::ostringstream tmpString("Time to load ");
-	tmpString.seekp(0, std::ios_base::end);
-	tmpString << "BAW file: " << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now()-time).count() << "us";
-	os::Printer::log(tmpString.str());
-#endif // _IRR_DEBUG
+void* CBAWMeshFileLoader::loadBlobsInParallel(SContext& _ctx, SBlobData* _root, const std::string& _rootCacheKey, const asset::BlobLoadingParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override, uint32_t _threadCnt)
+{
+    const uint64_t rootHandle = _root->header->handle;
+
+    core::vector<SBlobData*> level{_root}, nextLevel;
+    core::unordered_set<uint64_t> scheduled{rootHandle};
+    // dependencies of every blob which has any, including blobs found in cache, because a pending blob can be reachable only through a cached one
+    core::unordered_map<uint64_t, core::unordered_set<uint64_t>> blobDeps;
+    // only blobs which need to be finalized after their dependencies land here
+    core::unordered_set<uint64_t> pending;
+    _root->hierarchyLvl = 0u;
+
+    void* retval = nullptr;
+    while (!level.empty())
+    {
+        // the expensive part (I/O, AES, LZ4/LZMA) of all blobs on the same dependency level can go wide
+        std::atomic<bool> failed(false);
+        // threads left over on narrow levels (like a single huge vertex buffer) decompress chunks of chunked blobs
+        const uint32_t chunkThreadCnt = core::max_<uint32_t>(_threadCnt/static_cast<uint32_t>(level.size()), 1u);
+        core::parallel_for<size_t>(_threadCnt, 0u, level.size(), [&](size_t i) {
+            if (failed.load(std::memory_order_relaxed))
+                return;
+            SBlobData* data = level[i];
+            if (tryGetMappedBlob(*data, _ctx))
+                return;
+            if (!readBlobWithKeyAttempts(*data, _ctx, _override, genSubAssetCacheKey(_rootCacheKey, data->header->handle), chunkThreadCnt))
+                failed.store(true, std::memory_order_relaxed);
+        });
+        if (failed.load())
+        {
+            return nullptr;
+        }
 
-    asset::ICPUMesh* mesh = reinterpret_cast<asset::ICPUMesh*>(retval);
-    return {core::smart_refctd_ptr<asset::IAsset>(mesh,core::dont_grab)};
+        nextLevel.clear();
+        for (SBlobData* data : level)
+        {
+            const void* blob = data->mappedBlob ? data->mappedBlob:data->heapBlob;
+            const uint64_t handle = data->header->handle;
+            const uint32_t size = data->header->blobSizeDecompr;
+            const uint32_t blobType = data->header->blobType;
+            const std::string thisCacheKey = genSubAssetCacheKey(_rootCacheKey, handle);
+            const uint32_t hierLvl = data->hierarchyLvl;
+
+            core::unordered_set<uint64_t> deps = _ctx.loadingMgr.getNeededDeps(blobType, blob);
+            for (auto it = deps.begin(); it != deps.end(); ++it)
+            {
+                if (scheduled.insert(*it).second)
+                {
+                    SBlobData* dep = &_ctx.blobs[*it];
+                    dep->hierarchyLvl = hierLvl+1u;
+                    nextLevel.push_back(dep);
+                }
+            }
+
+            auto foundBundle = _override->findCachedAsset(thisCacheKey, nullptr, _ctx.inner, hierLvl).getContents();
+            if (foundBundle.first!=foundBundle.second)
+            {
+                foundBundle.first->get()->grab(); // created objects get dropped at the end of loading, cached ones included
+                _ctx.createdObjs[handle] = toAddrUsedByBlobsLoadingMgr(foundBundle.first->get(), blobType);
+                if (deps.size())
+                    blobDeps[handle] = std::move(deps);
+                continue;
+            }
+
+            if (!(_ctx.createdObjs[handle] = instantiateEmpty(_ctx, *data, _params)))
+            {
+                return nullptr;
+            }
+
+            if (!deps.size())
+            {
+                void* obj = _ctx.createdObjs[handle];
+                obj = _ctx.loadingMgr.finalize(blobType, obj, blob, size, _ctx.createdObjs, _params);
+                _IRR_ALIGNED_FREE(data->heapBlob);
+                data->heapBlob = nullptr;
+                if (handle == rootHandle)
+                    retval = obj;
+                else
+                    insertAssetIntoCache(_ctx, _override, obj, blobType, hierLvl, thisCacheKey);
+            }
+            else
+            {
+                pending.insert(handle);
+                blobDeps[handle] = std::move(deps);
+            }
+        }
+        std::swap(level, nextLevel);
+    }
+
+    // a blob can be reachable through paths of different length, so level order is not enough, post-order DFS gives a valid topological order
+    core::vector<uint64_t> finalizeOrder;
+    finalizeOrder.reserve(pending.size());
+    {
+        core::unordered_set<uint64_t> visited;
+        core::stack<std::pair<uint64_t, bool>> dfs; // second: whether all dependencies were already emitted
+        dfs.push({rootHandle, false});
+        while (!dfs.empty())
+        {
+            const auto top = dfs.top();
+            dfs.pop();
+
+            // cached blobs are walked through as well, but never emitted
+            auto found = blobDeps.find(top.first);
+            if (found == blobDeps.end())
+                continue;
+            if (top.second)
+            {
+                if (pending.find(top.first) != pending.end())
+                    finalizeOrder.push_back(top.first);
+                continue;
+            }
+            if (!visited.insert(top.first).second)
+                continue;
+            dfs.push({top.first, true});
+            for (uint64_t dep : found->second)
+                if (visited.find(dep) == visited.end())
+                    dfs.push({dep, false});
+        }
+    }
+
+    for (uint64_t handle : finalizeOrder)
+    {
+        SBlobData* data = &_ctx.blobs[handle];
+        const uint32_t blobType = data->header->blobType;
+
+        const void* blob = data->mappedBlob ? data->mappedBlob:data->heapBlob;
+        void* obj = _ctx.loadingMgr.finalize(blobType, _ctx.createdObjs[handle], blob, data->header->blobSizeDecompr, _ctx.createdObjs, _params);
+        if (handle == rootHandle) // don't cache root-asset (mesh) as sub-asset because it'll be cached by asset manager directly (and there's only one IAsset::cacheKey)
+            retval = obj;
+        else
+            insertAssetIntoCache(_ctx, _override, obj, blobType, data->hierarchyLvl, genSubAssetCacheKey(_rootCacheKey, handle));
+    }
+
+    return retval;
 }
 
 bool CBAWMeshFileLoader::safeRead(io::IReadFile * _file, void * _buf, size_t _size) const
@@ -340,4 +564,14 @@ io::IReadFile* CBAWMeshFileLoader::createConvertIntoVer_spec<1>(SContext& _ctx,
     return ret;
 }
 
+template<>
+io::IReadFile* CBAWMeshFileLoader::createConvertIntoVer_spec<2>(SContext& _ctx, io::IReadFile* _baw1file, asset::IAssetLoader::IAssetLoaderOverride* _override, const CommonDataTuple<1>& _common)
+{
+    // v2 only adds asset::Blob::EBCT_CHUNKED coding, any v1 file is a valid v2 file apart from the version number
+    _IRR_ALIGNED_FREE(std::get<1>(_common));
+    _IRR_ALIGNED_FREE(std::get<2>(_common));
+
+    return new CBAWVersionOverrideReadFile(_baw1file, 2u);
+}
+
 }} // irr::scene
@@ -36,6 +36,8 @@ private:
 		HeaderT* header;
 		size_t absOffset; // absolute
 		void* heapBlob = nullptr;
+        //! set instead of `heapBlob` when the blob is used in-place from a memory mapped file
+        const void* mappedBlob = nullptr;
 		mutable bool validated = false;
         uint32_t hierarchyLvl = 0u;
 
@@ -43,6 +45,7 @@ private:
         SBlobData_t(const SBlobData_t<HeaderT>&) = delete;
         SBlobData_t(SBlobData_t<HeaderT>&& _other) {
             std::swap(heapBlob, _other.heapBlob);
+            mappedBlob = _other.mappedBlob;
             header = _other.header;
             absOffset = _other.absOffset;
             validated = _other.validated;
@@ -82,11 +85,15 @@ private:
 		}
 
         asset::IAssetLoader::SAssetLoadContext inner;
-		uint64_t fileVersion;
-		core::unordered_map<uint64_t, SBlobData> blobs;
-		core::unordered_map<uint64_t, void*> createdObjs;
-        asset::CBlobsLoadingManager loadingMgr;
-		unsigned char iv[16];
+		uint64_t fileVersion = 0ull;
+		core::unordered_map<uint64_t, SBlobData> blobs{};
+		core::unordered_map<uint64_t, void*> createdObjs{};
+        asset::CBlobsLoadingManager loadingMgr{};
+		unsigned char iv[16]{};
+        //! guards seek+read pairs on `inner.mainFile` when blobs are read by multiple threads
+        std::mutex fileMutex{};
+        //! loader overrides are not required to be thread-safe
+        std::mutex overrideMutex{};
 	};
 
 protected:
@@ -145,6 +152,7 @@ private:
         {
         case 0ull: return verifyFile<asset::legacyv0::BAWFileV0>(_ctx);
         case 1ull: return verifyFile<asset::BAWFileV1>(_ctx);
+        case 2ull: return verifyFile<asset::BAWFileV2>(_ctx);
         default: return false;
         }
     }
@@ -158,12 +166,41 @@ private:
 	bool safeRead(io::IReadFile* _file, void* _buf, size_t _size) const;
 
 	//! Reads blob to memory on stack or allocates sufficient amount on heap if provided stack storage was not big enough.
-	/** @returns `_stackPtr` if blob was read to it or pointer to malloc'd memory otherwise.*/
+	/** @param _chunkThreadCnt Amount of threads decompressing chunks of asset::Blob::EBCT_CHUNKED coded blobs.
+	@returns `_stackPtr` if blob was read to it or pointer to malloc'd memory otherwise.*/
     template<typename HeaderT>
-	void* tryReadBlobOnStack(const SBlobData_t<HeaderT>& _data, SContext& _ctx, const unsigned char pwd[16], void* _stackPtr=NULL, size_t _stackSize=0) const;
+	void* tryReadBlobOnStack(const SBlobData_t<HeaderT>& _data, SContext& _ctx, const unsigned char pwd[16], void* _stackPtr=NULL, size_t _stackSize=0, uint32_t _chunkThreadCnt=1u) const;
+
+    //! Reads blob into `_data.heapBlob` trying consecutive decryption keys provided by `_override` until one works.
+    /** Safe to call concurrently for different blobs of the same context.
+    @returns `_data.heapBlob` or nullptr if none of the keys was valid or the blob is corrupted. */
+    const void* readBlobWithKeyAttempts(SBlobData& _data, SContext& _ctx, asset::IAssetLoader::IAssetLoaderOverride* _override, const std::string& _cacheKey, uint32_t _chunkThreadCnt=1u) const;
+
+    //! Points `_data.mappedBlob` straight into the file if it is memory mapped and the blob is an uncompressed, unencrypted raw buffer.
+    /** @returns `_data.mappedBlob` or nullptr if the blob has to be read the usual way (or failed validation). */
+    const void* tryGetMappedBlob(SBlobData& _data, const SContext& _ctx) const;
+    //! Creates the object for the blob, blobs used in-place from a memory mapped file become buffers adopting a view into the mapping instead of copying it.
+    void* instantiateEmpty(SContext& _ctx, const SBlobData& _data, const asset::BlobLoadingParams& _params) const;
+
+    //! Depth-first walk over the blob graph, everything happens on the calling thread.
+    /** @returns root object (mesh) or nullptr on failure. */
+    void* loadBlobsSerially(SContext& _ctx, SBlobData* _root, const std::string& _rootCacheKey, const asset::BlobLoadingParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override);
+    //! Breadth-first walk over the blob graph, blobs of the same dependency level are read, decrypted and decompressed by `_threadCnt` threads.
+    /** Instantiation and finalization stay on the calling thread, the latter in topological order (dependencies before dependents).
+    @returns root object (mesh) or nullptr on failure. */
+    void* loadBlobsInParallel(SContext& _ctx, SBlobData* _root, const std::string& _rootCacheKey, const asset::BlobLoadingParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override, uint32_t _threadCnt);
 
 	bool decompressLzma(void* _dst, size_t _dstSize, const void* _src, size_t _srcSize) const;
 	bool decompressLz4(void* _dst, size_t _dstSize, const void* _src, size_t _srcSize) const;
+    //! Chunked coding only exists since .baw v2, so blobs of older versions never get here
+    template<typename HeaderT>
+    bool decompressChunked(void* _dst, const HeaderT& _header, const void* _src, uint32_t _threadCnt) const { return false; }
+    bool decompressChunked(void* _dst, const asset::BlobHeaderV2& _header, const void* _src, uint32_t _threadCnt) const
+    {
+        if (_header.blobSize < asset::BlobChunkIndexV2::calcSize(0u))
+            return false;
+        return asset::decompressBlobChunks(_src, _header, 0u, reinterpret_cast<const asset::BlobChunkIndexV2*>(_src)->chunkCount, _dst, _threadCnt);
+    }
 
     inline std::string genSubAssetCacheKey(const std::string& _rootKey, uint64_t _handle) const { return _rootKey + "?" + std::to_string(_handle); }
 
@@ -392,7 +429,7 @@ bool CBAWMeshFileLoader::validateHeaders(uint32_t* _blobCnt, uint32_t** _offsets
 }
 
 template<typename HeaderT>
-void* CBAWMeshFileLoader::tryReadBlobOnStack(const SBlobData_t<HeaderT> & _data, SContext & _ctx, const unsigned char _pwd[16], void * _stackPtr, size_t _stackSize) const
+void* CBAWMeshFileLoader::tryReadBlobOnStack(const SBlobData_t<HeaderT> & _data, SContext & _ctx, const unsigned char _pwd[16], void * _stackPtr, size_t _stackSize, uint32_t _chunkThreadCnt) const
 {
     void* dst;
     if (_stackPtr && _data.header->blobSizeDecompr <= _stackSize && _data.header->effectiveSize() <= _stackSize)
@@ -407,8 +444,11 @@ void* CBAWMeshFileLoader::tryReadBlobOnStack(const SBlobData_t<HeaderT> & _data,
     if (compressed)
         dstCompressed = _IRR_ALIGNED_MALLOC(_data.header->effectiveSize(), _IRR_SIMD_ALIGNMENT);
 
-    _ctx.inner.mainFile->seek(_data.absOffset);
-    _ctx.inner.mainFile->read(dstCompressed, _data.header->effectiveSize());
+    {
+        std::lock_guard<std::mutex> lock(_ctx.fileMutex);
+        _ctx.inner.mainFile->seek(_data.absOffset);
+        _ctx.inner.mainFile->read(dstCompressed, _data.header->effectiveSize());
+    }
 
     if (!_data.header->validate(dstCompressed))
     {
@@ -465,7 +505,9 @@ void* CBAWMeshFileLoader::tryReadBlobOnStack(const SBlobData_t<HeaderT> & _data,
         const uint8_t comprType = _data.header->compressionType;
         bool res = false;
 
-        if (comprType & asset::Blob::EBCT_LZ4)
+        if (comprType & asset::Blob::EBCT_CHUNKED)
+            res = decompressChunked(dst, *_data.header, dstCompressed, _chunkThreadCnt);
+        else if (comprType & asset::Blob::EBCT_LZ4)
             res = decompressLz4(dst, _data.header->blobSizeDecompr, dstCompressed, _data.header->blobSize);
         else if (comprType & asset::Blob::EBCT_LZMA)
             res = decompressLzma(dst, _data.header->blobSizeDecompr, dstCompressed, _data.header->blobSize);
@@ -14,24 +14,18 @@
 #include "irr/asset/ICPUSkinnedMeshBuffer.h"
 #include "CFinalBoneHierarchy.h"
 #include "os.h"
+#include "irr/core/parallel_for.h"
 #include "lz4/lib/lz4.h"
 
 #undef Bool
 #include "lzma/C/LzmaEnc.h"
+#include "irr/asset/bawformat/LzmaMemMngmnt.h"
 
 namespace irr
 {
 namespace asset
 {
 
-struct LzmaMemMngmnt
-{
-        static void *alloc(ISzAllocPtr, size_t _size) { return _IRR_ALIGNED_MALLOC(_size,_IRR_SIMD_ALIGNMENT); }
-        static void release(ISzAllocPtr, void* _addr) { _IRR_ALIGNED_FREE(_addr); }
-    private:
-        LzmaMemMngmnt() {}
-};
-
 	const char * const CBAWMeshWriter::BAW_FILE_HEADER = "IrrlichtBaW BinaryFile\0\0\0\0\0\0\0\0\0";
 
 	CBAWMeshWriter::CBAWMeshWriter(io::IFileSystem* _fs) : m_fileSystem(_fs)
@@ -45,13 +39,13 @@ struct LzmaMemMngmnt
 	void CBAWMeshWriter::exportAsBlob<asset::ICPUMesh>(asset::ICPUMesh* _obj, uint32_t _headerIdx, io::IWriteFile* _file, SContext& _ctx)
 	{
 		uint8_t stackData[1u<<14];
-        asset::MeshBlobV1* data = asset::MeshBlobV1::createAndTryOnStack(_obj, stackData, sizeof(stackData));
+        asset::MeshBlobV2* data = asset::MeshBlobV2::createAndTryOnStack(_obj, stackData, sizeof(stackData));
 
         const asset::E_WRITER_FLAGS flags = _ctx.writerOverride->getAssetWritingFlags(_ctx.inner, _obj, 0u);
         const uint8_t* encrPwd = nullptr;
         _ctx.writerOverride->getEncryptionKey(encrPwd, _ctx.inner, _obj, 0u);
         const float comprLvl = _ctx.writerOverride->getAssetCompressionLevel(_ctx.inner, _obj, 0u);
-		tryWrite(data, _file, _ctx, asset::MeshBlobV1::calcBlobSizeForObj(_obj), _headerIdx, flags, encrPwd, comprLvl);
+		tryWrite(data, _file, _ctx, asset::MeshBlobV2::calcBlobSizeForObj(_obj), _headerIdx, flags, encrPwd, comprLvl);
 
 		if ((uint8_t*)data != stackData)
 			_IRR_ALIGNED_FREE(data);
@@ -60,13 +54,13 @@ struct LzmaMemMngmnt
 	void CBAWMeshWriter::exportAsBlob<asset::ICPUSkinnedMesh>(asset::ICPUSkinnedMesh* _obj, uint32_t _headerIdx, io::IWriteFile* _file, SContext& _ctx)
 	{
 		uint8_t stackData[1u << 14];
-        asset::SkinnedMeshBlobV1* data = asset::SkinnedMeshBlobV1::createAndTryOnStack(_obj,stackData,sizeof(stackData));
+        asset::SkinnedMeshBlobV2* data = asset::SkinnedMeshBlobV2::createAndTryOnStack(_obj,stackData,sizeof(stackData));
 
         const asset::E_WRITER_FLAGS flags = _ctx.writerOverride->getAssetWritingFlags(_ctx.inner, _obj, 0u);
         const uint8_t* encrPwd = nullptr;
         _ctx.writerOverride->getEncryptionKey(encrPwd, _ctx.inner, _obj, 0u);
         const float comprLvl = _ctx.writerOverride->getAssetCompressionLevel(_ctx.inner, _obj, 0u);
-		tryWrite(data, _file, _ctx, asset::SkinnedMeshBlobV1::calcBlobSizeForObj(_obj), _headerIdx, flags, encrPwd, comprLvl);
+		tryWrite(data, _file, _ctx, asset::SkinnedMeshBlobV2::calcBlobSizeForObj(_obj), _headerIdx, flags, encrPwd, comprLvl);
 
 		if ((uint8_t*)data != stackData)
 			_IRR_ALIGNED_FREE(data);
@@ -74,7 +68,7 @@ struct LzmaMemMngmnt
 	template<>
 	void CBAWMeshWriter::exportAsBlob<asset::ICPUMeshBuffer>(asset::ICPUMeshBuffer* _obj, uint32_t _headerIdx, io::IWriteFile* _file, SContext& _ctx)
 	{
-        asset::MeshBufferBlobV1 data(_obj);
+        asset::MeshBufferBlobV2 data(_obj);
 
         const asset::E_WRITER_FLAGS flags = _ctx.writerOverride->getAssetWritingFlags(_ctx.inner, _obj, 1u);
         const uint8_t* encrPwd = nullptr;
@@ -85,7 +79,7 @@ struct LzmaMemMngmnt
 	template<>
 	void CBAWMeshWriter::exportAsBlob<asset::ICPUSkinnedMeshBuffer>(asset::ICPUSkinnedMeshBuffer* _obj, uint32_t _headerIdx, io::IWriteFile* _file, SContext& _ctx)
 	{
-        asset::SkinnedMeshBufferBlobV1 data(_obj);
+        asset::SkinnedMeshBufferBlobV2 data(_obj);
 
         const asset::E_WRITER_FLAGS flags = _ctx.writerOverride->getAssetWritingFlags(_ctx.inner, _obj, 1u);
         const uint8_t* encrPwd = nullptr;
@@ -113,9 +107,9 @@ struct LzmaMemMngmnt
 	void CBAWMeshWriter::exportAsBlob<scene::CFinalBoneHierarchy>(scene::CFinalBoneHierarchy* _obj, uint32_t _headerIdx, io::IWriteFile* _file, SContext& _ctx)
 	{
 		uint8_t stackData[1u<<14]; // 16kB
-        asset::FinalBoneHierarchyBlobV1* data = asset::FinalBoneHierarchyBlobV1::createAndTryOnStack(_obj,stackData,sizeof(stackData));
+        asset::FinalBoneHierarchyBlobV2* data = asset::FinalBoneHierarchyBlobV2::createAndTryOnStack(_obj,stackData,sizeof(stackData));
 
-		tryWrite(data, _file, _ctx, asset::FinalBoneHierarchyBlobV1::calcBlobSizeForObj(_obj), _headerIdx, asset::EWF_NONE);
+		tryWrite(data, _file, _ctx, asset::FinalBoneHierarchyBlobV2::calcBlobSizeForObj(_obj), _headerIdx, asset::EWF_NONE);
 
 		if ((uint8_t*)data != stackData)
 			_IRR_ALIGNED_FREE(data);
@@ -123,7 +117,7 @@ struct LzmaMemMngmnt
 	template<>
 	void CBAWMeshWriter::exportAsBlob<asset::IMeshDataFormatDesc<asset::ICPUBuffer> >(asset::IMeshDataFormatDesc<asset::ICPUBuffer>* _obj, uint32_t _headerIdx, io::IWriteFile* _file, SContext& _ctx)
 	{
-        asset::MeshDataFormatDescBlobV1 data(_obj);
+        asset::MeshDataFormatDescBlobV2 data(_obj);
 
 		tryWrite(&data, _file, _ctx, sizeof(data), _headerIdx, asset::EWF_NONE);
 	}
@@ -134,7 +128,7 @@ struct LzmaMemMngmnt
         const uint8_t* encrPwd = nullptr;
         _ctx.writerOverride->getEncryptionKey(encrPwd, _ctx.inner, _obj, 3u);
         const float comprLvl = _ctx.writerOverride->getAssetCompressionLevel(_ctx.inner, _obj, 3u);
-		tryWrite(_obj->getPointer(), _file, _ctx, _obj->getSize(), _headerIdx, flags, encrPwd, comprLvl);
+		tryWrite(_obj->getPointer(), _file, _ctx, _obj->getSize(), _headerIdx, flags, encrPwd, comprLvl, true);
 	}
 
 	bool CBAWMeshWriter::writeAsset(io::IWriteFile* _file, const SAssetWriteParams& _params, IAssetWriterOverride* _override)
@@ -152,7 +146,7 @@ struct LzmaMemMngmnt
         const asset::ICPUMesh* mesh = static_cast<const asset::ICPUMesh*>(_params.rootAsset);
 
 		constexpr uint32_t FILE_HEADER_SIZE = 32;
-        static_assert(FILE_HEADER_SIZE == sizeof(asset::BAWFileV1::fileHeader), "BAW header is not 32 bytes long!");
+        static_assert(FILE_HEADER_SIZE == sizeof(asset::BAWFileV2::fileHeader), "BAW header is not 32 bytes long!");
 
 		uint64_t header[4];
 		memcpy(header, BAW_FILE_HEADER, FILE_HEADER_SIZE);
@@ -161,22 +155,27 @@ struct LzmaMemMngmnt
 		_file->write(header, FILE_HEADER_SIZE);
 
         SContext ctx{ asset::IAssetWriter::SAssetWriteContext{_params, _file}, _override }; // context of this call of `writeMesh`
+        const WriteProperties* bawSpecific = reinterpret_cast<const WriteProperties*>(ctx.inner.params.userData);
+        const uint32_t threadCnt = core::resolveThreadCount(bawSpecific->workerThreadCount);
+        ctx.deferEncoding = threadCnt>1u;
+        ctx.statistics = bawSpecific->blobStatistics;
+        if (ctx.statistics)
+            ctx.statistics->clear();
 
 		const uint32_t numOfInternalBlobs = genHeaders(mesh, ctx);
-		const uint32_t OFFSETS_FILE_OFFSET = FILE_HEADER_SIZE + sizeof(uint32_t) + sizeof(asset::BAWFileV1::iv);
+		const uint32_t OFFSETS_FILE_OFFSET = FILE_HEADER_SIZE + sizeof(uint32_t) + sizeof(asset::BAWFileV2::iv);
 		const uint32_t HEADERS_FILE_OFFSET = OFFSETS_FILE_OFFSET + numOfInternalBlobs * sizeof(ctx.offsets[0]);
 
 		ctx.offsets.resize(numOfInternalBlobs);
 
 		_file->write(&numOfInternalBlobs, sizeof(numOfInternalBlobs));
 		//_file->write(ctx.pwdVer, 2);
-        const WriteProperties* bawSpecific = reinterpret_cast<const WriteProperties*>(ctx.inner.params.userData);
 		_file->write(bawSpecific->initializationVector, 16);
 		// will be overwritten after actually calculating offsets
 		_file->write(ctx.offsets.data(), ctx.offsets.size() * sizeof(ctx.offsets[0]));
 
 		// will be overwritten after calculating not known yet data (hash and size for texture paths)
-		_file->write(ctx.headers.data(), ctx.headers.size() * sizeof(asset::BlobHeaderV1));
+		_file->write(ctx.headers.data(), ctx.headers.size() * sizeof(asset::BlobHeaderV2));
 
 		ctx.offsets.resize(0); // set `used` to 0, to allow push starting from 0 index
 		for (int i = 0; i < ctx.headers.size(); ++i)
@@ -209,6 +208,8 @@ struct LzmaMemMngmnt
 				break;
 			}
 		}
+		if (ctx.deferEncoding)
+			writePendingBlobs(_file, ctx, threadCnt);
 
 		const size_t prevPos = _file->getPos();
 
@@ -217,7 +218,7 @@ struct LzmaMemMngmnt
 		_file->write(ctx.offsets.data(), ctx.offsets.size() * sizeof(ctx.offsets[0]));
 		// overwrite headers
 		_file->seek(HEADERS_FILE_OFFSET);
-		_file->write(ctx.headers.data(), ctx.headers.size() * sizeof(asset::BlobHeaderV1));
+		_file->write(ctx.headers.data(), ctx.headers.size() * sizeof(asset::BlobHeaderV2));
 
 		_file->seek(prevPos);
 
@@ -237,7 +238,7 @@ struct LzmaMemMngmnt
 			if (!skinnedMesh || (skinnedMesh && skinnedMesh->isStatic()))
 				isMeshAnimated = false;
 
-            asset::BlobHeaderV1 bh;
+            asset::BlobHeaderV2 bh;
 			bh.handle = reinterpret_cast<uint64_t>(_mesh);
 			bh.compressionType = asset::Blob::EBCT_RAW;
 			bh.blobType = isMeshAnimated ? asset::Blob::EBT_SKINNED_MESH : asset::Blob::EBT_MESH;
@@ -248,7 +249,7 @@ struct LzmaMemMngmnt
 
 		if (isMeshAnimated)
 		{
-            asset::BlobHeaderV1 bh;
+            asset::BlobHeaderV2 bh;
 			bh.handle = reinterpret_cast<uint64_t>(skinnedMesh->getBoneReferenceHierarchy());
 			bh.compressionType = asset::Blob::EBCT_RAW;
 			bh.blobType = asset::Blob::EBT_FINAL_BONE_HIERARCHY;
@@ -267,7 +268,7 @@ struct LzmaMemMngmnt
 
 			if (countedObjects.find(meshBuffer) == countedObjects.end())
 			{
-                asset::BlobHeaderV1 bh;
+                asset::BlobHeaderV2 bh;
 				bh.handle = reinterpret_cast<uint64_t>(meshBuffer);
 				bh.compressionType = asset::Blob::EBCT_RAW;
 				bh.blobType = isMeshAnimated ? asset::Blob::EBT_SKINNED_MESH_BUFFER : asset::Blob::EBT_MESH_BUFFER;
@@ -292,7 +293,7 @@ struct LzmaMemMngmnt
 
 			if (countedObjects.find(desc) == countedObjects.end())
 			{
-                asset::BlobHeaderV1 bh;
+                asset::BlobHeaderV2 bh;
 				bh.handle = reinterpret_cast<uint64_t>(desc);
 				bh.compressionType = asset::Blob::EBCT_RAW;
 				bh.blobType = asset::Blob::EBT_DATA_FORMAT_DESC;
@@ -303,7 +304,7 @@ struct LzmaMemMngmnt
 			const asset::ICPUBuffer* idxBuffer = desc->getIndexBuffer();
 			if (idxBuffer && countedObjects.find(idxBuffer) == countedObjects.end())
 			{
-                asset::BlobHeaderV1 bh;
+                asset::BlobHeaderV2 bh;
 				bh.handle = reinterpret_cast<uint64_t>(idxBuffer);
 				bh.compressionType = asset::Blob::EBCT_RAW;
 				bh.blobType = asset::Blob::EBT_RAW_DATA_BUFFER;
@@ -316,7 +317,7 @@ struct LzmaMemMngmnt
 				const asset::ICPUBuffer* attBuffer = desc->getMappedBuffer((asset::E_VERTEX_ATTRIBUTE_ID)attId);
 				if (attBuffer && countedObjects.find(attBuffer) == countedObjects.end())
 				{
-                    asset::BlobHeaderV1 bh;
+                    asset::BlobHeaderV2 bh;
 					bh.handle = reinterpret_cast<uint64_t>(attBuffer);
 					bh.compressionType = asset::Blob::EBCT_RAW;
 					bh.blobType = asset::Blob::EBT_RAW_DATA_BUFFER;
@@ -334,24 +335,58 @@ struct LzmaMemMngmnt
 		_ctx.offsets.push_back(!_ctx.offsets.size() ? 0 : _ctx.offsets.back() + _blobSize);
 	}
 
-	void CBAWMeshWriter::tryWrite(void* _data, io::IWriteFile * _file, SContext & _ctx, size_t _size, uint32_t _headerIdx, asset::E_WRITER_FLAGS _flags, const uint8_t* _encrPwd, float _comprLvl) const
+	void CBAWMeshWriter::tryWrite(void* _data, io::IWriteFile * _file, SContext & _ctx, size_t _size, uint32_t _headerIdx, asset::E_WRITER_FLAGS _flags, const uint8_t* _encrPwd, float _comprLvl, bool _dataOutlivesWrite) const
 	{
+		if (_ctx.deferEncoding)
+		{
+			_ctx.pending.emplace_back();
+			SPendingBlob& blob = _ctx.pending.back();
+			blob.size = _size;
+			blob.headerIdx = _headerIdx;
+			blob.flags = _flags;
+			blob.encrPwd = _encrPwd;
+			blob.comprLvl = _comprLvl;
+			if (_data && !_dataOutlivesWrite) // most of blobs are created on stack by exportAsBlob
+			{
+				blob.ownedCopy.resize(_size);
+				memcpy(blob.ownedCopy.data(), _data, _size);
+				blob.data = blob.ownedCopy.data();
+			}
+			else
+				blob.data = _data;
+			return;
+		}
+
 		if (!_data)
 			return pushCorruptedOffset(_ctx);
 
+		uint8_t stack[1u<<14];
+		const SEncodedBlob encoded = encodeBlob(_data, _ctx, _size, _headerIdx, _flags, _encrPwd, _comprLvl, stack, static_cast<uint32_t>(sizeof(stack)));
+		writeEncodedBlob(encoded, _file, _ctx, _size, _headerIdx);
+	}
+
+	CBAWMeshWriter::SEncodedBlob CBAWMeshWriter::encodeBlob(const void* _data, SContext& _ctx, size_t _size, uint32_t _headerIdx, asset::E_WRITER_FLAGS _flags, const uint8_t* _encrPwd, float _comprLvl, void* _stack, uint32_t _stackSize, uint32_t _chunkThreadCnt) const
+	{
 #ifndef _IRR_COMPILE_WITH_OPENSSL_
-		_encrypt = false;
+		_flags = static_cast<asset::E_WRITER_FLAGS>(_flags & ~asset::EWF_ENCRYPTED);
 #endif // _IRR_COMPILE_WITH_OPENSSL_
 
-		uint8_t stack[1u<<14];
+		const auto startTime = std::chrono::high_resolution_clock::now();
 
 		size_t compressedSize = _size;
-		void* data = _data;
+		const void* data = _data;
 		uint8_t comprType = asset::Blob::EBCT_RAW;
 
         if (_flags & asset::EWF_COMPRESSED)
         {
-            if (_comprLvl > 0.3f)
+            if (shouldChunk(_ctx, _size, _headerIdx, _flags, _comprLvl))
+            {
+                const WriteProperties* props = reinterpret_cast<const WriteProperties*>(_ctx.inner.params.userData);
+                void* chunked = compressChunked(_data, static_cast<uint32_t>(_size), props->blobChunkSize, _comprLvl, _chunkThreadCnt, compressedSize, comprType);
+                if (chunked)
+                    data = chunked;
+            }
+            else if (_comprLvl > 0.3f)
             {
                 data = compressWithLzma(data, _size, compressedSize);
                 if (data != _data)
@@ -359,7 +394,7 @@ struct LzmaMemMngmnt
             }
             else if (_comprLvl == 0.3f && _size<=0xffffffffull)
             {
-                data = compressWithLz4AndTryOnStack(data, static_cast<uint32_t>(_size), stack, static_cast<uint32_t>(sizeof(stack)), compressedSize);
+                data = compressWithLz4AndTryOnStack(data, static_cast<uint32_t>(_size), _stack, _stackSize, compressedSize);
                 if (data != _data)
                     comprType |= asset::Blob::EBCT_LZ4;
             }
@@ -367,18 +402,18 @@ struct LzmaMemMngmnt
 
 		if (_flags & asset::EWF_ENCRYPTED)
 		{
-			const size_t encrSize = asset::BlobHeaderV1::calcEncSize(compressedSize);
+			const size_t encrSize = asset::BlobHeaderV2::calcEncSize(compressedSize);
 			void* in = _IRR_ALIGNED_MALLOC(encrSize,_IRR_SIMD_ALIGNMENT);
-			memset(((uint8_t*)in) + (compressedSize-16), 0, 16);
+			memset(((uint8_t*)in) + (encrSize-16), 0, 16);
 			memcpy(in, data, compressedSize);
 
 			void* out = _IRR_ALIGNED_MALLOC(encrSize, _IRR_SIMD_ALIGNMENT);
 
             const WriteProperties* props = reinterpret_cast<const WriteProperties*>(_ctx.inner.params.userData);
-			if (asset::encAes128gcm(data, encrSize, out, encrSize, _encrPwd, props->initializationVector, _ctx.headers[_headerIdx].gcmTag))
+			if (asset::encAes128gcm(in, encrSize, out, encrSize, _encrPwd, props->initializationVector, _ctx.headers[_headerIdx].gcmTag))
 			{
-				if (data != _data && data != stack) // allocated in compressing functions?
-					_IRR_ALIGNED_FREE(data);
+				if (data != _data && data != _stack) // allocated in compressing functions?
+					_IRR_ALIGNED_FREE(const_cast<void*>(data));
 				data = out;
 				_IRR_ALIGNED_FREE(in);
 				comprType |= asset::Blob::EBCT_AES128_GCM;
@@ -394,12 +429,136 @@ struct LzmaMemMngmnt
 		}
 
 		_ctx.headers[_headerIdx].finalize(data, _size, compressedSize, comprType);
-		const size_t writeSize = (comprType & asset::Blob::EBCT_AES128_GCM) ? asset::BlobHeaderV1::calcEncSize(compressedSize) : compressedSize;
-		_file->write(data, writeSize);
+
+		SEncodedBlob retval;
+		retval.data = data;
+		if (data != _stack && data != _data)
+			retval.heapData = const_cast<void*>(data); // safe const_cast since the only case when this executes is when `data` points to _IRR_ALIGNED_MALLOC'd memory
+		retval.writeSize = (comprType & asset::Blob::EBCT_AES128_GCM) ? asset::BlobHeaderV2::calcEncSize(compressedSize) : compressedSize;
+		retval.encodingTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now()-startTime).count();
+		return retval;
+	}
+
+	void CBAWMeshWriter::writeEncodedBlob(const SEncodedBlob& _blob, io::IWriteFile* _file, SContext& _ctx, size_t _size, uint32_t _headerIdx) const
+	{
+		_file->write(_blob.data, _blob.writeSize);
 		calcAndPushNextOffset(!_headerIdx ? 0 : _ctx.headers[_headerIdx - 1].effectiveSize(), _ctx);
 
-		if (data != stack && data != _data)
-			_IRR_ALIGNED_FREE(const_cast<void*>(data)); // safe const_cast since the only case when this executes is when `data` points to _IRR_ALIGNED_MALLOC'd memory
+		if (_ctx.statistics)
+		{
+			const asset::BlobHeaderV2& header = _ctx.headers[_headerIdx];
+			_ctx.statistics->push_back({header.handle, header.blobType, header.compressionType, _size, _blob.writeSize, _blob.encodingTimeUs});
+		}
+
+		if (_blob.heapData)
+			_IRR_ALIGNED_FREE(_blob.heapData);
+	}
+
+	void CBAWMeshWriter::writePendingBlobs(io::IWriteFile* _file, SContext& _ctx, uint32_t _threadCnt) const
+	{
+		core::vector<SEncodedBlob> encoded(_ctx.pending.size());
+		// biggest blobs first so that a huge buffer landing last doesn't leave all but one thread idle
+		core::vector<uint32_t> order(_ctx.pending.size());
+		for (uint32_t i = 0u; i < order.size(); ++i)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return _ctx.pending[a].size > _ctx.pending[b].size; });
+
+		// blobs which get chunked are the biggest ones anyway, they go one by one with all threads on their chunks
+		size_t chunkedCnt = 0u;
+		for (; chunkedCnt < order.size(); ++chunkedCnt)
+		{
+			const SPendingBlob& blob = _ctx.pending[order[chunkedCnt]];
+			if (!blob.data || !shouldChunk(_ctx, blob.size, blob.headerIdx, blob.flags, blob.comprLvl))
+				break;
+			encoded[order[chunkedCnt]] = encodeBlob(blob.data, _ctx, blob.size, blob.headerIdx, blob.flags, blob.encrPwd, blob.comprLvl, nullptr, 0u, _threadCnt);
+		}
+
+		core::parallel_for<size_t>(_threadCnt, chunkedCnt, order.size(), [&](size_t i) {
+			const SPendingBlob& blob = _ctx.pending[order[i]];
+			if (blob.data)
+				encoded[order[i]] = encodeBlob(blob.data, _ctx, blob.size, blob.headerIdx, blob.flags, blob.encrPwd, blob.comprLvl, nullptr, 0u);
+		});
+
+		for (size_t i = 0u; i < _ctx.pending.size(); ++i)
+		{
+			const SPendingBlob& blob = _ctx.pending[i];
+			if (blob.data)
+				writeEncodedBlob(encoded[i], _file, _ctx, blob.size, blob.headerIdx);
+			else
+				pushCorruptedOffset(_ctx);
+		}
+		_ctx.pending.clear();
+	}
+
+	bool CBAWMeshWriter::shouldChunk(const SContext& _ctx, size_t _size, uint32_t _headerIdx, asset::E_WRITER_FLAGS _flags, float _comprLvl) const
+	{
+#ifndef _IRR_COMPILE_WITH_OPENSSL_
+		_flags = static_cast<asset::E_WRITER_FLAGS>(_flags & ~asset::EWF_ENCRYPTED);
+#endif // _IRR_COMPILE_WITH_OPENSSL_
+		const WriteProperties* props = reinterpret_cast<const WriteProperties*>(_ctx.inner.params.userData);
+		if (!props->blobChunkSize || _ctx.headers[_headerIdx].blobType != asset::Blob::EBT_RAW_DATA_BUFFER)
+			return false;
+		// chunks cannot be decrypted independently (one GCM tag per blob), so encrypted blobs are never chunked
+		if (!(_flags & asset::EWF_COMPRESSED) || (_flags & asset::EWF_ENCRYPTED) || _comprLvl < 0.3f)
+			return false;
+		return _size > 2ull*props->blobChunkSize && _size <= 0xffffffffull;
+	}
+
+	void* CBAWMeshWriter::compressChunked(const void* _input, uint32_t _inputSize, uint32_t _chunkSize, float _comprLvl, uint32_t _threadCnt, size_t& _outComprSize, uint8_t& _outComprType) const
+	{
+		const uint32_t chunkCount = asset::BlobChunkIndexV2::calcChunkCount(_inputSize, _chunkSize);
+		const bool lzma = _comprLvl > 0.3f;
+
+		core::vector<const void*> chunkData(chunkCount);
+		core::vector<size_t> chunkSizes(chunkCount);
+		core::parallel_for<uint32_t>(_threadCnt, 0u, chunkCount, [&](uint32_t i) {
+			const uint8_t* const in = reinterpret_cast<const uint8_t*>(_input) + size_t(i)*_chunkSize;
+			const uint32_t inSize = core::min_<uint32_t>(_chunkSize, _inputSize-i*_chunkSize);
+			size_t outSize = inSize;
+			const void* out = lzma ? compressWithLzma(in, inSize, outSize) : compressWithLz4AndTryOnStack(in, inSize, nullptr, 0u, outSize);
+			if (out != in && outSize >= inSize) // store raw, the loader recognizes it by compressed size equal to decompressed size
+			{
+				_IRR_ALIGNED_FREE(const_cast<void*>(out));
+				out = in;
+			}
+			if (out == in)
+				outSize = inSize;
+			chunkData[i] = out;
+			chunkSizes[i] = outSize;
+		});
+
+		const size_t indexSize = asset::BlobChunkIndexV2::calcSize(chunkCount);
+		size_t totalSize = indexSize;
+		bool anyCompressed = false;
+		for (uint32_t i = 0u; i < chunkCount; ++i)
+		{
+			totalSize += chunkSizes[i];
+			anyCompressed |= chunkData[i] != reinterpret_cast<const uint8_t*>(_input) + size_t(i)*_chunkSize;
+		}
+
+		uint8_t* retval = nullptr;
+		if (anyCompressed && totalSize < _inputSize)
+		{
+			retval = reinterpret_cast<uint8_t*>(_IRR_ALIGNED_MALLOC(totalSize, _IRR_SIMD_ALIGNMENT));
+			asset::BlobChunkIndexV2* index = reinterpret_cast<asset::BlobChunkIndexV2*>(retval);
+			index->chunkSize = _chunkSize;
+			index->chunkCount = chunkCount;
+			uint32_t offset = 0u;
+			for (uint32_t i = 0u; i < chunkCount; ++i)
+			{
+				index->chunks[i].offset = offset;
+				index->chunks[i].compressedSize = static_cast<uint32_t>(chunkSizes[i]);
+				memcpy(retval+indexSize+offset, chunkData[i], chunkSizes[i]);
+				offset += chunkSizes[i];
+			}
+			_outComprSize = totalSize;
+			_outComprType = asset::Blob::EBCT_CHUNKED | (lzma ? asset::Blob::EBCT_LZMA : asset::Blob::EBCT_LZ4);
+		}
+
+		for (uint32_t i = 0u; i < chunkCount; ++i)
+			if (chunkData[i] != reinterpret_cast<const uint8_t*>(_input) + size_t(i)*_chunkSize)
+				_IRR_ALIGNED_FREE(const_cast<void*>(chunkData[i]));
+		return retval;
 	}
 
 	void* CBAWMeshWriter::compressWithLz4AndTryOnStack(const void* _input, uint32_t _inputSize, void* _stack, uint32_t _stackSize, size_t& _outComprSize) const
@@ -413,7 +572,7 @@ struct LzmaMemMngmnt
 		{
 			if (lz4CompressBound > _stackSize)
 			{
-				dstSize = asset::BlobHeaderV1::calcEncSize(lz4CompressBound);
+				dstSize = asset::BlobHeaderV2::calcEncSize(lz4CompressBound);
 				data = _IRR_ALIGNED_MALLOC(dstSize,_IRR_SIMD_ALIGNMENT);
 			}
 			compressedSize = LZ4_compress_default((const char*)_input, (char*)data, _inputSize, dstSize);
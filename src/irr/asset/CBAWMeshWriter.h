@@ -37,6 +37,22 @@ namespace asset
 			EET_EVERYTHING = 0xffffffffu
 		};
 
+		//! Statistics of a single blob written out by writeAsset()
+		struct SBlobStatistics
+		{
+			uint64_t handle;
+			uint32_t blobType;
+			//! Combination of asset::Blob::E_BLOB_CODING_TYPE flags actually used (compression might fail or not pay off)
+			uint8_t compressionType;
+			size_t uncompressedSize;
+			//! Size of the blob in the file, including encryption padding
+			size_t sizeInFile;
+			//! Time spent on compression and encryption of the blob, in microseconds
+			uint64_t encodingTimeUs;
+
+			inline double compressionRatio() const { return sizeInFile ? double(uncompressedSize)/double(sizeInFile) : 0.0; }
+		};
+
 		//! Settings struct for mesh export
 		struct WriteProperties
 		{
@@ -44,15 +60,49 @@ namespace asset
 			unsigned char initializationVector[16];
 			//! Directory to which texture paths will be relative in output mesh file
 			io::path relPath;
+			//! Amount of threads compressing and encrypting blobs, 1 means the calling thread only and 0 means one per hardware thread.
+			/** Blobs still land in the file in the same order and with the same contents regardless of this setting. */
+			uint32_t workerThreadCount = 1u;
+			//! If not null, gets filled with statistics of every blob written (in the order of blobs in the file).
+			core::vector<SBlobStatistics>* blobStatistics = nullptr;
+			//! Compressed, unencrypted raw buffers bigger than twice this size are split into independently compressed chunks of this size (asset::Blob::EBCT_CHUNKED).
+			/** Such buffers can be decompressed by multiple threads and read partially (see asset::readBlobChunksRange). 0 disables chunking. */
+			uint32_t blobChunkSize = 1u<<20;
 		};
 
 	private:
+		//! Blob whose compression and encryption was deferred so that it can happen on worker threads
+		struct SPendingBlob
+		{
+			//! Points either to `ownedCopy` or to memory outliving writeAsset() (contents of an ICPUBuffer)
+			const void* data = nullptr;
+			core::vector<uint8_t> ownedCopy;
+			size_t size = 0u;
+			uint32_t headerIdx = 0u;
+			asset::E_WRITER_FLAGS flags = asset::EWF_NONE;
+			const uint8_t* encrPwd = nullptr;
+			float comprLvl = 0.f;
+		};
+		//! Result of compressing and encrypting a blob
+		struct SEncodedBlob
+		{
+			const void* data = nullptr;
+			//! Memory to free with _IRR_ALIGNED_FREE after writing, if any
+			void* heapData = nullptr;
+			size_t writeSize = 0u;
+			uint64_t encodingTimeUs = 0u;
+		};
+
 		struct SContext
 		{
 			asset::IAssetWriter::SAssetWriteContext inner;
             asset::IAssetWriter::IAssetWriterOverride* writerOverride;
-			core::vector<asset::BlobHeaderV1> headers;
-			core::vector<uint32_t> offsets;
+			core::vector<asset::BlobHeaderV2> headers{};
+			core::vector<uint32_t> offsets{};
+			//! Only used when blobs get encoded by multiple threads
+			bool deferEncoding = false;
+			core::vector<SPendingBlob> pending{};
+			core::vector<SBlobStatistics>* statistics = nullptr;
 		};
 
         class CBAWOverride : public IAssetWriterOverride
@@ -118,7 +168,23 @@ namespace asset
 		void pushCorruptedOffset(SContext& _ctx) const { _ctx.offsets.push_back(0xffffffff); }
 
 		//! Tries to write given data to file. If not possible (i.e. _data is NULL) - pushes "corrupted offset" and does not call .finalize() on blob-header.
-		void tryWrite(void* _data, io::IWriteFile* _file, SContext& _ctx, size_t _size, uint32_t _headerIdx, asset::E_WRITER_FLAGS _flags, const uint8_t* _encrPwd = nullptr, float _comprLvl = 0.f) const;
+		/** If `SContext::deferEncoding` is set, the blob is only queued and gets written by writePendingBlobs().
+		@param _dataOutlivesWrite Whether `_data` stays valid until writeAsset() returns, if not a deferred blob copies it. */
+		void tryWrite(void* _data, io::IWriteFile* _file, SContext& _ctx, size_t _size, uint32_t _headerIdx, asset::E_WRITER_FLAGS _flags, const uint8_t* _encrPwd = nullptr, float _comprLvl = 0.f, bool _dataOutlivesWrite = false) const;
+
+		//! Compresses and encrypts blob data, finalizes its header. Safe to call concurrently for different headers.
+		/** @param _stack Optional scratch memory for small compressed blobs, must stay valid until the blob is written. */
+		/** @param _chunkThreadCnt Amount of threads compressing chunks if the blob gets chunked (see shouldChunk()). */
+		SEncodedBlob encodeBlob(const void* _data, SContext& _ctx, size_t _size, uint32_t _headerIdx, asset::E_WRITER_FLAGS _flags, const uint8_t* _encrPwd, float _comprLvl, void* _stack, uint32_t _stackSize, uint32_t _chunkThreadCnt = 1u) const;
+		//! Whether the blob is going to be coded with asset::Blob::EBCT_CHUNKED, @see WriteProperties::blobChunkSize
+		bool shouldChunk(const SContext& _ctx, size_t _size, uint32_t _headerIdx, asset::E_WRITER_FLAGS _flags, float _comprLvl) const;
+		//! Compresses chunks of the blob independently and lays them out after asset::BlobChunkIndexV2.
+		/** @returns malloc'd data of the blob or nullptr if none of the chunks got smaller. */
+		void* compressChunked(const void* _input, uint32_t _inputSize, uint32_t _chunkSize, float _comprLvl, uint32_t _threadCnt, size_t& _outComprSize, uint8_t& _outComprType) const;
+		//! Writes encoded blob to file, pushes its offset and statistics. Must be called in order of headers.
+		void writeEncodedBlob(const SEncodedBlob& _blob, io::IWriteFile* _file, SContext& _ctx, size_t _size, uint32_t _headerIdx) const;
+		//! Encodes all queued blobs on `_threadCnt` threads and then writes them out in their original order.
+		void writePendingBlobs(io::IWriteFile* _file, SContext& _ctx, uint32_t _threadCnt) const;
 		
 		//! Uint32_t because lzma doesn't support compressing more than 4GB
 		void* compressWithLz4AndTryOnStack(const void* _input, uint32_t _inputSize, void* _stack, uint32_t _stackSize, size_t& _outComprSize) const;
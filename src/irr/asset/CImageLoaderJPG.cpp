@@ -173,8 +173,14 @@ asset::SAssetBundle CImageLoaderJPG::loadAsset(io::IReadFile* _file, const asset
 	const io::path& Filename = _file->getFileName();
 
 	uint8_t** rowPtr = nullptr;
-	uint8_t* input = new uint8_t[_file->getSize()];
-	_file->read(input, static_cast<uint32_t>(_file->getSize()));
+	// memory mapped files get decoded straight from the mapping
+	const uint8_t* const mapped = reinterpret_cast<const uint8_t*>(_file->getMappedPointer());
+	uint8_t* input = nullptr;
+	if (!mapped)
+	{
+		input = new uint8_t[_file->getSize()];
+		_file->read(input, _file->getSize());
+	}
 
 	// allocate and initialize JPEG decompression object
 	struct jpeg_decompress_struct cinfo;
@@ -198,7 +204,8 @@ asset::SAssetBundle CImageLoaderJPG::loadAsset(io::IReadFile* _file, const asset
 		if (rowPtr)
 			delete[] rowPtr;
 		jpeg_destroy_decompress(&cinfo);
-		delete[] input;
+		if (input)
+			delete[] input;
 	};
 	auto exiter = core::makeRAIIExiter(exitRoutine);
 	// compatibility fudge:
@@ -219,7 +226,7 @@ asset::SAssetBundle CImageLoaderJPG::loadAsset(io::IReadFile* _file, const asset
 
 	// Set up data pointer
 	jsrc.bytes_in_buffer = _file->getSize();
-	jsrc.next_input_byte = (JOCTET*)input;
+	jsrc.next_input_byte = mapped ? (const JOCTET*)mapped : (const JOCTET*)input;
 	cinfo.src = &jsrc;
 
 	jsrc.init_source = jpeg::init_source;
@@ -277,7 +277,7 @@ asset::IAsset* CImageLoaderRGB::loadAsset(io::IReadFile* _file, const asset::IAs
 // returns true on success
 bool CImageLoaderRGB::readHeader(io::IReadFile* file, rgbStruct& rgb) const
 {
-	if ( file->read(&rgb.Header, sizeof(rgb.Header)) < int32_t(sizeof(rgb.Header)) )
+	if ( file->read(&rgb.Header, sizeof(rgb.Header)) < sizeof(rgb.Header) )
 		return false;
 
 	// test for INTEL or BIG ENDIAN processor
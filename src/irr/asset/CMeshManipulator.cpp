@@ -18,6 +18,7 @@
 #include "irr/asset/COverdrawMeshOptimizer.h"
 #include "irr/asset/ICPUSkinnedMeshBuffer.h"
 #include "irr/asset/CSmoothNormalGenerator.h"
+#include "irr/core/parallel_for.h"
 
 namespace irr
 {
@@ -25,10 +26,10 @@ namespace asset
 {
 
 // declared as extern in SVertexManipulator.h
-core::vector<QuantizationCacheEntry2_10_10_10> normalCacheFor2_10_10_10Quant;
-core::vector<QuantizationCacheEntry8_8_8> normalCacheFor8_8_8Quant;
-core::vector<QuantizationCacheEntry16_16_16> normalCacheFor16_16_16Quant;
-core::vector<QuantizationCacheEntryHalfFloat> normalCacheForHalfFloatQuant;
+QuantizationCache<QuantizationCacheEntry2_10_10_10> normalCacheFor2_10_10_10Quant;
+QuantizationCache<QuantizationCacheEntry8_8_8> normalCacheFor8_8_8Quant;
+QuantizationCache<QuantizationCacheEntry16_16_16> normalCacheFor16_16_16Quant;
+QuantizationCache<QuantizationCacheEntryHalfFloat> normalCacheForHalfFloatQuant;
 
 
 //! Flips the direction of surfaces. Changes backfacing triangles to frontfacing
@@ -399,6 +400,111 @@ static bool cmpVertices(asset::ICPUMeshBuffer* _inbuf, const void* _va, const vo
     return true;
 }
 
+// Used by createMeshBufferWelded only
+/** Finds the same redirects as comparing every vertex against every other one (first matching `j!=i` in index order),
+but buckets the vertices on a grid of position cells at least as large as the position epsilon and compares
+only against vertices of the 3x3x3 cells around. Cells are hashed into a table, collisions only add candidates.
+@returns false (without touching `_redirects`) if the positions can't be bucketed without changing the result,
+i.e. they're not compared with EEM_POSITIONS, they're integers or some are non-finite or too far away for the grid. */
+template<class F>
+static bool findWeldRedirectsSpatialHash(uint32_t* _redirects, const uint8_t* _vertices, size_t _vertexCount, size_t _vertexSize, size_t _posOffset, asset::E_FORMAT _posFormat, const IMeshManipulator::SErrorMetric& _posErrMetric, F& _cmpfunc)
+{
+    if (_posErrMetric.method!=IMeshManipulator::EEM_POSITIONS || asset::isIntegerFormat(_posFormat) || asset::isScaledFormat(_posFormat))
+        return false;
+
+    const uint32_t dims = std::min(asset::getFormatChannelCount(_posFormat), 3u);
+    double cellSize[3] = { 1.0, 1.0, 1.0 };
+    for (uint32_t c = 0u; c < dims; ++c)
+    {
+        const float eps = _posErrMetric.epsilon.pointer[c];
+        if (!(eps>=0.f))
+            return false;
+        // with 0 epsilon only equal positions match and any cell size works, slightly enlarged cells make the +-1 cell search immune to rounding
+        if (eps>0.f)
+            cellSize[c] = double(eps)*1.001;
+    }
+
+    constexpr double maxCellCoord = double(1ll<<40);
+    core::vector<int64_t> cells(_vertexCount*3u, 0);
+    for (size_t i = 0u; i < _vertexCount; ++i)
+    {
+        core::vectorSIMDf pos;
+        asset::ICPUMeshBuffer::getAttribute(pos, _vertices+i*_vertexSize+_posOffset, _posFormat);
+        for (uint32_t c = 0u; c < dims; ++c)
+        {
+            // NaNs compare as equal to anything in compareFloatingPointAttribute, so they'd have to be in every cell
+            const double coord = std::floor(double(pos.pointer[c])/cellSize[c]);
+            if (!(std::abs(coord)<maxCellCoord))
+                return false;
+            cells[i*3u+c] = static_cast<int64_t>(coord);
+        }
+    }
+
+    const uint32_t tableSize = core::roundUpToPoT<uint32_t>(std::max<uint32_t>(_vertexCount, 2u));
+    auto hashCell = [tableSize](int64_t _x, int64_t _y, int64_t _z) -> uint32_t
+    {
+        const uint64_t h = (uint64_t(_x)*73856093ull)^(uint64_t(_y)*19349663ull)^(uint64_t(_z)*83492791ull);
+        return static_cast<uint32_t>(h^(h>>32))&(tableSize-1u);
+    };
+
+    // counting sort by cell hash, keeps vertices within a bucket in index order
+    core::vector<uint32_t> bucketBegin(tableSize+1u, 0u);
+    core::vector<uint32_t> vertexHash(_vertexCount);
+    for (size_t i = 0u; i < _vertexCount; ++i)
+    {
+        vertexHash[i] = hashCell(cells[i*3u], cells[i*3u+1u], cells[i*3u+2u]);
+        bucketBegin[vertexHash[i]+1u]++;
+    }
+    for (uint32_t b = 0u; b < tableSize; ++b)
+        bucketBegin[b+1u] += bucketBegin[b];
+    core::vector<uint32_t> bucketed(_vertexCount);
+    {
+        core::vector<uint32_t> fill(bucketBegin.begin(), bucketBegin.end()-1);
+        for (size_t i = 0u; i < _vertexCount; ++i)
+            bucketed[fill[vertexHash[i]]++] = i;
+    }
+
+    const int64_t range[3] = { dims>0u ? 1:0, dims>1u ? 1:0, dims>2u ? 1:0 };
+    constexpr size_t batchSize = 4096u;
+    core::parallel_for<size_t>(0u, 0u, (_vertexCount+batchSize-1u)/batchSize, [&](size_t _batch) -> void
+    {
+        core::vector<uint32_t> neighbourBuckets;
+        core::vector<uint32_t> candidates;
+        const size_t batchEnd = std::min(_vertexCount, (_batch+1u)*batchSize);
+        for (size_t i = _batch*batchSize; i < batchEnd; ++i)
+        {
+            const int64_t* cell = cells.data()+i*3u;
+            neighbourBuckets.clear();
+            for (int64_t z = -range[2]; z <= range[2]; ++z)
+            for (int64_t y = -range[1]; y <= range[1]; ++y)
+            for (int64_t x = -range[0]; x <= range[0]; ++x)
+                neighbourBuckets.push_back(hashCell(cell[0]+x, cell[1]+y, cell[2]+z));
+            std::sort(neighbourBuckets.begin(), neighbourBuckets.end());
+            neighbourBuckets.erase(std::unique(neighbourBuckets.begin(), neighbourBuckets.end()), neighbourBuckets.end());
+
+            candidates.clear();
+            for (uint32_t b : neighbourBuckets)
+                candidates.insert(candidates.end(), bucketed.begin()+bucketBegin[b], bucketed.begin()+bucketBegin[b+1u]);
+            std::sort(candidates.begin(), candidates.end());
+
+            uint32_t redir = i;
+            for (uint32_t j : candidates)
+            {
+                if (i == j)
+                    continue;
+                if (_cmpfunc(_vertices+_vertexSize*i, _vertices+_vertexSize*j))
+                {
+                    redir = j;
+                    break;
+                }
+            }
+            _redirects[i] = redir;
+        }
+    });
+
+    return true;
+}
+
 //! Creates a copy of a mesh, which will have identical vertices welded together
 asset::ICPUMeshBuffer* CMeshManipulator::createMeshBufferWelded(asset::ICPUMeshBuffer *inbuffer, const SErrorMetric* _errMetrics, const bool& optimIndexType, const bool& makeNewMesh) const
 {
@@ -412,10 +518,14 @@ asset::ICPUMeshBuffer* CMeshManipulator::createMeshBufferWelded(asset::ICPUMeshB
 
     size_t vertexAttrSize[asset::EVAI_COUNT];
     size_t vertexSize = 0;
+    const asset::E_VERTEX_ATTRIBUTE_ID posAttr = inbuffer->getPositionAttributeIx();
+    size_t posOffset = 0;
     for (size_t i=0; i<asset::EVAI_COUNT; i++)
     {
         const asset::ICPUBuffer* buf = oldDesc->getMappedBuffer((asset::E_VERTEX_ATTRIBUTE_ID)i);
         bufferPresent[i] = buf;
+        if (i==posAttr)
+            posOffset = vertexSize;
         if (buf)
         {
             const asset::E_FORMAT componentType = oldDesc->getAttribFormat((asset::E_VERTEX_ATTRIBUTE_ID)i);
@@ -457,10 +567,15 @@ asset::ICPUMeshBuffer* CMeshManipulator::createMeshBufferWelded(asset::ICPUMeshB
         }
     }
 
+    const bool bucketed = bufferPresent[posAttr] &&
+        findWeldRedirectsSpatialHash(redirects, epicData, vertexCount, vertexSize, posOffset, oldDesc->getAttribFormat(posAttr), _errMetrics[posAttr], cmpfunc);
     for (size_t i=0; i<vertexCount; i++)
     {
         uint32_t redir = i;
 
+        if (bucketed)
+            redir = redirects[i];
+        else
         for (size_t j = 0u; j < vertexCount; ++j)
         {
             if (i == j)
@@ -19,30 +19,13 @@
 #include "irr/asset/IAssetManager.h"
 
 #include "irr/core/Types.h"
+#include "irr/core/fast_atof.h"
+#include "irr/core/parallel_for.h"
 #include "irr/core/math/plane3dSIMD.h"
 
-/*
-namespace std
-{
-    template <>
-    struct hash<irr::asset::SObjVertex>
-    {
-        std::size_t operator()(const irr::asset::SObjVertex& k) const
-        {
-            using std::size_t;
-            using std::hash;
-
-            return hash(k.normal32bit)^
-                    (reinterpret_cast<const uint32_t&>(k.pos[0])*4996156539000000107ull)^
-                    (reinterpret_cast<const uint32_t&>(k.pos[1])*620612627000000023ull)^
-                    (reinterpret_cast<const uint32_t&>(k.pos[2])*1231379668000000199ull)^
-                    (reinterpret_cast<const uint32_t&>(k.uv[0])*1099543332000000001ull)^
-                    (reinterpret_cast<const uint32_t&>(k.uv[1])*1123461104000000009ull);
-        }
-    };
+#include <algorithm>
+#include <atomic>
 
-}
-*/
 
 
 namespace irr
@@ -55,6 +38,49 @@ namespace asset
 //#endif
 
 static const uint32_t WORD_BUFFER_LENGTH = 512;
+//! chunks of the file parsed in parallel are never smaller than this
+static const size_t kMinChunkSize = 0x100000u;
+
+namespace
+{
+    //! A vertex along with the material using it, corners of faces with equal keys share one vertex
+    struct SCornerKey
+    {
+        inline bool operator==(const SCornerKey& other) const
+        {
+            return material==other.material && vertex==other.vertex;
+        }
+
+        SObjVertex vertex;
+        uint32_t material;
+    };
+
+    struct SCornerKeyHash
+    {
+        inline size_t operator()(const SCornerKey& k) const
+        {
+            // adding 0.f turns -0.f into 0.f, they compare equal so they need to hash the same
+            auto bits = [](float x) -> uint64_t
+            {
+                x += 0.f;
+                uint32_t out;
+                memcpy(&out,&x,sizeof(out));
+                return out;
+            };
+            uint64_t hash = (uint64_t(k.vertex.normal32bit)|(uint64_t(k.material)<<32))^
+                            (bits(k.vertex.pos[0])*4996156539000000107ull)^
+                            (bits(k.vertex.pos[1])*620612627000000023ull)^
+                            (bits(k.vertex.pos[2])*1231379668000000199ull)^
+                            (bits(k.vertex.uv[0])*1099543332000000001ull)^
+                            (bits(k.vertex.uv[1])*1123461104000000009ull);
+            // the low bits pick buckets, make them depend on all of the bits
+            hash ^= hash>>33;
+            hash *= 0xff51afd7ed558ccdull;
+            hash ^= hash>>33;
+            return static_cast<size_t>(hash);
+        }
+    };
+}
 
 
 //! Constructor
@@ -82,16 +108,12 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
         _override
     );
 
-	const long filesize = _file->getSize();
+	const size_t filesize = _file->getSize();
 	if (!filesize)
         return {};
 
 	const uint32_t WORD_BUFFER_LENGTH = 512;
 
-	core::vector<core::vector3df> vertexBuffer;
-	core::vector<core::vector3df> normalsBuffer;
-	core::vector<core::vector2df> textureCoordBuffer;
-
 	SObjMtl * currMtl = new SObjMtl();
 	ctx.Materials.push_back(currMtl);
 	uint32_t smoothingGroup=0;
@@ -99,244 +121,319 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 	const io::path fullName = _file->getFileName();
 	const io::path relPath = io::IFileSystem::getFileDir(fullName)+"/";
 
-	char* buf = new char[filesize];
-	memset(buf, 0, filesize);
-	_file->read((void*)buf, filesize);
+	// memory mapped files are parsed in place
+	_file->setAccessPattern(io::EFAP_SEQUENTIAL);
+	const char* buf = reinterpret_cast<const char*>(_file->getMappedPointer());
+	char* fileContents = nullptr;
+	if (!buf)
+	{
+		fileContents = new char[filesize];
+		_file->read(fileContents, filesize);
+		buf = fileContents;
+	}
 	const char* const bufEnd = buf+filesize;
 
-	// Process obj information
-	const char* bufPtr = buf;
-	std::string grpName, mtlName;
-	bool mtlChanged=false;
-    bool submeshLoadedFromCache = false;
-	while(bufPtr != bufEnd)
+	// Parse v, vt, vn and f records of chunks starting at line boundaries in parallel,
+	// several chunks per thread so that lines of uneven cost balance out
+	const uint32_t threadCnt = core::resolveThreadCount(_params.workerThreadCount);
+	const size_t chunkCount = std::max<size_t>(std::min<size_t>(size_t(threadCnt)*4u, filesize/kMinChunkSize), 1u);
+	core::vector<const char*> chunkBounds(chunkCount+1u);
+	chunkBounds.front() = buf;
+	chunkBounds.back() = bufEnd;
+	for (size_t i=1u; i<chunkCount; i++)
 	{
-		switch(bufPtr[0])
+		const char* lineEnd = std::find(std::max(chunkBounds[i-1u], buf+filesize/chunkCount*i), bufEnd, '\n');
+		chunkBounds[i] = lineEnd!=bufEnd ? (lineEnd+1):bufEnd;
+	}
+	core::vector<SChunk> chunks(chunkCount);
+	core::parallel_for(threadCnt, size_t(0u), chunkCount, [&](size_t i) -> void
+	{
+		parseChunk(chunkBounds[i], chunkBounds[i+1u], chunks[i]);
+	});
+
+	// Offsets of every chunk's records in the whole file
+	struct SChunkOffsets
+	{
+		uint32_t records[3];
+		uint32_t corners;
+		uint32_t faces;
+	};
+	core::vector<SChunkOffsets> chunkOffsets(chunkCount+1u);
+	chunkOffsets.front() = SChunkOffsets{{0u,0u,0u},0u,0u};
+	for (size_t i=0u; i<chunkCount; i++)
+	{
+		const SChunkOffsets& prev = chunkOffsets[i];
+		chunkOffsets[i+1u] = SChunkOffsets{
+			{prev.records[0]+uint32_t(chunks[i].positions.size()),prev.records[1]+uint32_t(chunks[i].uvs.size()),prev.records[2]+uint32_t(chunks[i].normals.size())},
+			prev.corners+uint32_t(chunks[i].corners.size()),
+			prev.faces+uint32_t(chunks[i].faces.size())
+		};
+	}
+	const SChunkOffsets& totals = chunkOffsets.back();
+
+	core::vector<core::vector3df> vertexBuffer(totals.records[0]);
+	core::vector<core::vector2df> textureCoordBuffer(totals.records[1]);
+	core::vector<uint32_t> normalsBuffer(totals.records[2]); // already quantized
+	core::vector<SFaceCorner> corners(totals.corners);
+	core::vector<uint32_t> faces(totals.faces+1u);
+	faces.back() = totals.corners;
+	std::atomic<bool> indicesValid(true);
+	core::parallel_for(threadCnt, size_t(0u), chunkCount, [&](size_t i) -> void
+	{
+		SChunk& chunk = chunks[i];
+		const SChunkOffsets& offsets = chunkOffsets[i];
+		std::copy(chunk.positions.begin(), chunk.positions.end(), vertexBuffer.begin()+offsets.records[0]);
+		std::copy(chunk.uvs.begin(), chunk.uvs.end(), textureCoordBuffer.begin()+offsets.records[1]);
+		for (size_t j=0u; j<chunk.normals.size(); j++)
 		{
-		case 'm':	// mtllib (material)
+			core::vectorSIMDf simdNormal;
+			simdNormal.set(chunk.normals[j]);
+			normalsBuffer[offsets.records[2]+j] = asset::quantizeNormal2_10_10_10(simdNormal);
+		}
+		for (size_t j=0u; j<chunk.faces.size(); j++)
+			faces[offsets.faces+j] = offsets.corners+chunk.faces[j];
+
+		// make relative indices absolute and check all of them
+		for (size_t j=0u; j<chunk.corners.size(); j++)
 		{
-			if (ctx.useMaterials)
+			SFaceCorner corner = chunk.corners[j];
+			for (uint32_t k=0u; k<3u; k++)
 			{
-				char name[WORD_BUFFER_LENGTH];
-				bufPtr = goAndCopyNextWord(name, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-#ifdef _IRR_DEBUG_OBJ_LOADER_
-				os::Printer::log("Reading material _file",name);
-#endif
-				readMTL(ctx, name, relPath);
+				if (corner.relativeMask&(0x1u<<k))
+					corner.index[k] += int32_t(offsets.records[k]);
+				if (corner.index[k]<0 || corner.index[k]>=int32_t(totals.records[k]))
+					corner.index[k] = -1;
 			}
+			corner.relativeMask = 0u;
+			if (corner.index[0]<0)
+				indicesValid.store(false, std::memory_order_relaxed);
+			corners[offsets.corners+j] = corner;
 		}
-			break;
+	});
+	if (!indicesValid.load())
+	{
+		os::Printer::log("OBJ face references a vertex which does not exist", fullName.c_str(), ELL_ERROR);
+		delete [] fileContents;
+		return {};
+	}
 
-		case 'v':               // v, vn, vt
-            if (submeshLoadedFromCache)
-                break;
-			switch(bufPtr[1])
-			{
-			case ' ':          // vertex
-				{
-					core::vector3df vec;
-					bufPtr = readVec3(bufPtr, vec, bufEnd);
-					vertexBuffer.push_back(vec);
-				}
-				break;
+	// Handle the records which change materials and groups in file order, which assigns faces to materials
+	constexpr uint32_t kSkippedFace = 0xffffffffu;
+	core::vector<uint32_t> faceMaterials(totals.faces);
+	uint32_t currMtlIndex = 0u;
+	std::string grpName, mtlName;
+	bool mtlChanged=false;
+    bool submeshLoadedFromCache = false;
+	auto assignFaces = [&](uint32_t firstFace, uint32_t lastFace) -> void
+	{
+		if (firstFace==lastFace)
+			return;
+		if (!submeshLoadedFromCache && mtlChanged)
+		{
+			// retrieve the material
+			SObjMtl *useMtl = findMtl(ctx, mtlName, grpName);
+			// only change material if we found it
+			if (useMtl)
+				currMtlIndex = std::find(ctx.Materials.begin(), ctx.Materials.end(), useMtl)-ctx.Materials.begin();
+			mtlChanged=false;
+		}
+		std::fill(faceMaterials.begin()+firstFace, faceMaterials.begin()+lastFace, submeshLoadedFromCache ? kSkippedFace:currMtlIndex);
+	};
+	for (size_t i=0u; i<chunkCount; i++)
+	{
+		uint32_t firstFace = chunkOffsets[i].faces;
+		for (const auto& record : chunks[i].stateRecords)
+		{
+			const uint32_t recordFace = chunkOffsets[i].faces+record.second;
+			assignFaces(firstFace, recordFace);
+			firstFace = recordFace;
 
-			case 'n':       // normal
+			const char* bufPtr = record.first;
+			switch(bufPtr[0])
+			{
+			case 'm':	// mtllib (material)
+			{
+				if (ctx.useMaterials)
 				{
-					core::vector3df vec;
-					bufPtr = readVec3(bufPtr, vec, bufEnd);
-					normalsBuffer.push_back(vec);
+					char name[WORD_BUFFER_LENGTH];
+					bufPtr = goAndCopyNextWord(name, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
+#ifdef _IRR_DEBUG_OBJ_LOADER_
+					os::Printer::log("Reading material _file",name);
+#endif
+					readMTL(ctx, name, relPath);
 				}
+			}
 				break;
 
-			case 't':       // texcoord
+			case 'g': // group name
 				{
-					core::vector2df vec;
-					bufPtr = readUV(bufPtr, vec, bufEnd);
-					textureCoordBuffer.push_back(vec);
-				}
-				break;
-			}
-			break;
-
-		case 'g': // group name
-			{
-				char grp[WORD_BUFFER_LENGTH];
-				bufPtr = goAndCopyNextWord(grp, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
+					char grp[WORD_BUFFER_LENGTH];
+					bufPtr = goAndCopyNextWord(grp, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
 #ifdef _IRR_DEBUG_OBJ_LOADER_
 	os::Printer::log("Loaded group start",grp, ELL_DEBUG);
 #endif
-				if (ctx.useGroups)
-				{
-					if (0 != grp[0])
-						grpName = grp;
-					else
-						grpName = "default";
-
-                    asset::IAsset::E_TYPE types[] {asset::IAsset::ET_SUB_MESH, (asset::IAsset::E_TYPE)0u };
-                    auto mb_bundle = _override->findCachedAsset(genKeyForMeshBuf(ctx, _file->getFileName().c_str(), mtlName, grpName), types, ctx.inner, 1u).getContents();
-                    if (mb_bundle.first!=mb_bundle.second)
-                    {
-                        auto mb = static_cast<asset::ICPUMeshBuffer*>(mb_bundle.first->get());
-                        mb->grab();
-                        SObjMtl* mtl = findMtl(ctx, mtlName, grpName);
-                        ctx.preloadedSubmeshes.insert(std::make_pair(mtl, mb));
-                    }
-                    else mtlChanged=true;
-
-                    submeshLoadedFromCache = (mb_bundle.first!=mb_bundle.second);
+					if (ctx.useGroups)
+					{
+						if (0 != grp[0])
+							grpName = grp;
+						else
+							grpName = "default";
+
+                        asset::IAsset::E_TYPE types[] {asset::IAsset::ET_SUB_MESH, (asset::IAsset::E_TYPE)0u };
+                        auto mb_bundle = _override->findCachedAsset(genKeyForMeshBuf(ctx, _file->getFileName().c_str(), mtlName, grpName), types, ctx.inner, 1u).getContents();
+                        if (mb_bundle.first!=mb_bundle.second)
+                        {
+                            auto mb = static_cast<asset::ICPUMeshBuffer*>(mb_bundle.first->get());
+                            mb->grab();
+                            SObjMtl* mtl = findMtl(ctx, mtlName, grpName);
+                            ctx.preloadedSubmeshes.insert(std::make_pair(mtl, mb));
+                        }
+                        else mtlChanged=true;
+
+                        submeshLoadedFromCache = (mb_bundle.first!=mb_bundle.second);
+					}
 				}
-			}
-			break;
+				break;
 
-		case 's': // smoothing can be a group or off (equiv. to 0)
-			{
-				char smooth[WORD_BUFFER_LENGTH];
-				bufPtr = goAndCopyNextWord(smooth, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
+			case 's': // smoothing can be a group or off (equiv. to 0)
+				{
+					char smooth[WORD_BUFFER_LENGTH];
+					bufPtr = goAndCopyNextWord(smooth, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
 #ifdef _IRR_DEBUG_OBJ_LOADER_
 	os::Printer::log("Loaded smoothing group start",smooth, ELL_DEBUG);
 #endif
-				if (core::stringc("off")==smooth)
-					smoothingGroup=0;
-				else
-                    sscanf(smooth,"%u",&smoothingGroup);
-			}
-			break;
+					if (core::stringc("off")==smooth)
+						smoothingGroup=0;
+					else
+                        sscanf(smooth,"%u",&smoothingGroup);
+				}
+				break;
 
-		case 'u': // usemtl
-			// get name of material
-			{
-				char matName[WORD_BUFFER_LENGTH];
-				bufPtr = goAndCopyNextWord(matName, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
+			case 'u': // usemtl
+				// get name of material
+				{
+					char matName[WORD_BUFFER_LENGTH];
+					bufPtr = goAndCopyNextWord(matName, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
 #ifdef _IRR_DEBUG_OBJ_LOADER_
 	os::Printer::log("Loaded material start",matName, ELL_DEBUG);
 #endif
-				mtlName=matName;
+					mtlName=matName;
 
-                if (ctx.useMaterials && !ctx.useGroups)
-                {
-                    asset::IAsset::E_TYPE types[] {asset::IAsset::ET_SUB_MESH, (asset::IAsset::E_TYPE)0u };
-                    auto mb_bundle = _override->findCachedAsset(genKeyForMeshBuf(ctx, _file->getFileName().c_str(), mtlName, grpName), types, ctx.inner, 1u).getContents();
-                    if (mb_bundle.first!=mb_bundle.second)
+                    if (ctx.useMaterials && !ctx.useGroups)
                     {
-                        auto mb = static_cast<asset::ICPUMeshBuffer*>(mb_bundle.first->get());
-                        mb->grab();
-                        SObjMtl* mtl = findMtl(ctx, mtlName, grpName);
-                        ctx.preloadedSubmeshes.insert(std::make_pair(mtl, mb));
+                        asset::IAsset::E_TYPE types[] {asset::IAsset::ET_SUB_MESH, (asset::IAsset::E_TYPE)0u };
+                        auto mb_bundle = _override->findCachedAsset(genKeyForMeshBuf(ctx, _file->getFileName().c_str(), mtlName, grpName), types, ctx.inner, 1u).getContents();
+                        if (mb_bundle.first!=mb_bundle.second)
+                        {
+                            auto mb = static_cast<asset::ICPUMeshBuffer*>(mb_bundle.first->get());
+                            mb->grab();
+                            SObjMtl* mtl = findMtl(ctx, mtlName, grpName);
+                            ctx.preloadedSubmeshes.insert(std::make_pair(mtl, mb));
+                        }
+                        else mtlChanged=true;
+
+                        submeshLoadedFromCache = (mb_bundle.first!=mb_bundle.second);
                     }
-                    else mtlChanged=true;
-
-                    submeshLoadedFromCache = (mb_bundle.first!=mb_bundle.second);
-                }
+				}
+				break;
 			}
-			break;
+		}
+		assignFaces(firstFace, chunkOffsets[i+1u].faces);
+	}
+	chunks.clear();
+	// Clean up the allocate obj _file contents
+	delete [] fileContents;
 
-		case 'f':               // face
+	auto getVertex = [&](const SFaceCorner& corner) -> SObjVertex
+	{
+		SObjVertex v;
+		v.pos[0] = vertexBuffer[corner.index[0]].X;
+		v.pos[1] = vertexBuffer[corner.index[0]].Y;
+		v.pos[2] = vertexBuffer[corner.index[0]].Z;
+		//set texcoord
+		if ( -1 != corner.index[1] )
 		{
-            if (submeshLoadedFromCache)
-                break;
-			char vertexWord[WORD_BUFFER_LENGTH]; // for retrieving vertex data
-			SObjVertex v;
-			// Assign vertex color from currently active material's diffuse color
-			if (mtlChanged)
-			{
-				// retrieve the material
-				SObjMtl *useMtl = findMtl(ctx, mtlName, grpName);
-				// only change material if we found it
-				if (useMtl)
-					currMtl = useMtl;
-				mtlChanged=false;
-			}
-
-			// get all vertices data in this face (current line of obj _file)
-			const core::stringc wordBuffer = copyLine(bufPtr, bufEnd);
-			const char* linePtr = wordBuffer.c_str();
-			const char* const endPtr = linePtr+wordBuffer.size();
+			v.uv[0] = textureCoordBuffer[corner.index[1]].X;
+			v.uv[1] = textureCoordBuffer[corner.index[1]].Y;
+		}
+		else
+		{
+			v.uv[0] = 0.f;
+			v.uv[1] = 0.f;
+		}
+		//set normal
+		v.normal32bit = -1 != corner.index[2] ? normalsBuffer[corner.index[2]]:0u;
+		return v;
+	};
+
+	// De-duplicate equal vertices of the same material, every corner gets the first corner in file order with the same vertex as its representative.
+	// Corners are spread over buckets by the hash of their vertex and the buckets are processed in parallel, each in file order, so the result does not depend on the thread count.
+	const uint32_t bucketCount = threadCnt>1u ? threadCnt*16u:1u;
+	core::vector<uint32_t> cornerBuckets(totals.corners);
+	core::parallel_for(threadCnt, uint32_t(0u), totals.faces, [&](uint32_t face) -> void
+	{
+		for (uint32_t c=faces[face]; c<faces[face+1u]; c++)
+			cornerBuckets[c] = faceMaterials[face]!=kSkippedFace ? uint32_t(SCornerKeyHash()(SCornerKey{getVertex(corners[c]),faceMaterials[face]})%bucketCount):bucketCount;
+	}, 1024u);
+	core::vector<uint32_t> bucketOffsets(bucketCount+2u, 0u);
+	for (uint32_t bucket : cornerBuckets)
+		bucketOffsets[bucket+2u]++;
+	for (uint32_t bucket=2u; bucket<bucketOffsets.size(); bucket++)
+		bucketOffsets[bucket] += bucketOffsets[bucket-1u];
+	core::vector<uint32_t> bucketedCorners(totals.corners);
+	for (uint32_t c=0u; c<totals.corners; c++)
+		bucketedCorners[bucketOffsets[cornerBuckets[c]+1u]++] = c;
+	cornerBuckets.clear();
+
+	core::vector<uint32_t> cornerFaces(totals.corners);
+	for (uint32_t face=0u; face<totals.faces; face++)
+		std::fill(cornerFaces.begin()+faces[face], cornerFaces.begin()+faces[face+1u], face);
+	core::vector<uint32_t> representatives(totals.corners);
+	core::parallel_for(threadCnt, uint32_t(0u), bucketCount, [&](uint32_t bucket) -> void
+	{
+		core::unordered_map<SCornerKey,uint32_t,SCornerKeyHash> firstOccurences;
+		firstOccurences.reserve(bucketOffsets[bucket+1u]-bucketOffsets[bucket]);
+		for (uint32_t i=bucketOffsets[bucket]; i<bucketOffsets[bucket+1u]; i++)
+		{
+			const uint32_t c = bucketedCorners[i];
+			representatives[c] = firstOccurences.emplace(SCornerKey{getVertex(corners[c]),faceMaterials[cornerFaces[c]]},c).first->second;
+		}
+	});
+	bucketedCorners.clear();
+	cornerFaces.clear();
 
-			core::vector<uint32_t> faceCorners;
-			faceCorners.reserve(32); // should be large enough
+	// Build vertices and triangulated indices of every material in file order
+	core::vector<uint32_t> cornerVertices(totals.corners);
+	for (uint32_t face=0u; face<totals.faces; face++)
+	{
+		if (faceMaterials[face]==kSkippedFace)
+			continue;
+		currMtl = ctx.Materials[faceMaterials[face]];
 
-			// read in all vertices
-			linePtr = goNextWord(linePtr, endPtr);
-			while (0 != linePtr[0])
+		const uint32_t firstCorner = faces[face];
+		const uint32_t lastCorner = faces[face+1u];
+		for (uint32_t c=firstCorner; c<lastCorner; c++)
+		{
+			if (representatives[c]==c)
 			{
-				// Array to communicate with retrieveVertexIndices()
-				// sends the buffer sizes and gets the actual indices
-				// if index not set returns -1
-				int32_t Idx[3];
-				Idx[1] = Idx[2] = -1;
-
-				// read in next vertex's data
-				uint32_t wlength = copyWord(vertexWord, linePtr, WORD_BUFFER_LENGTH, endPtr);
-				// this function will also convert obj's 1-based index to c++'s 0-based index
-				retrieveVertexIndices(vertexWord, Idx, vertexWord+wlength+1, vertexBuffer.size(), textureCoordBuffer.size(), normalsBuffer.size());
-				v.pos[0] = vertexBuffer[Idx[0]].X;
-				v.pos[1] = vertexBuffer[Idx[0]].Y;
-				v.pos[2] = vertexBuffer[Idx[0]].Z;
-				//set texcoord
-				if ( -1 != Idx[1] )
-                {
-					v.uv[0] = textureCoordBuffer[Idx[1]].X;
-					v.uv[1] = textureCoordBuffer[Idx[1]].Y;
-                }
-				else
-                {
-					v.uv[0] = 0.f;
-					v.uv[1] = 0.f;
-                }
-                //set normal
-				if ( -1 != Idx[2] )
-                {
-					core::vectorSIMDf simdNormal;
-					simdNormal.set(normalsBuffer[Idx[2]]);
-					v.normal32bit = asset::quantizeNormal2_10_10_10(simdNormal);
-                }
-				else
-				{
-					v.normal32bit = 0;
+				cornerVertices[c] = currMtl->Vertices.size();
+				currMtl->Vertices.push_back(getVertex(corners[c]));
+				if (corners[c].index[2]<0)
 					currMtl->RecalculateNormals=true;
-				}
-
-				int vertLocation;
-				core::map<SObjVertex, int>::iterator n = currMtl->VertMap.find(v);
-				if (n!=currMtl->VertMap.end())
-				{
-					vertLocation = n->second;
-				}
-				else
-				{
-					currMtl->Vertices.push_back(v);
-					vertLocation = currMtl->Vertices.size() -1;
-					currMtl->VertMap.insert(std::pair<SObjVertex, int>(v, vertLocation));
-				}
-
-				faceCorners.push_back(vertLocation);
-
-				// go to next vertex
-				linePtr = goNextWord(linePtr, endPtr);
-			}
-
-			// triangulate the face
-			for ( uint32_t i = 1; i < faceCorners.size() - 1; ++i )
-			{
-				// Add a triangle
-				currMtl->Indices.push_back( faceCorners[i+1] );
-				currMtl->Indices.push_back( faceCorners[i] );
-				currMtl->Indices.push_back( faceCorners[0] );
 			}
-			faceCorners.resize(0); // fast clear
-			faceCorners.reserve(32);
+			else
+				cornerVertices[c] = cornerVertices[representatives[c]];
 		}
-		break;
 
-		case '#': // comment
-		default:
-			break;
-		}	// end switch(bufPtr[0])
-		// eat up rest of line
-		bufPtr = goNextLine(bufPtr, bufEnd);
-	}	// end while(bufPtr && (bufPtr-buf<filesize))
-	// Clean up the allocate obj _file contents
-	delete [] buf;
+		// triangulate the face
+		for ( uint32_t c = firstCorner+1; c < lastCorner-1; ++c )
+		{
+			// Add a triangle
+			currMtl->Indices.push_back( cornerVertices[c+1] );
+			currMtl->Indices.push_back( cornerVertices[c] );
+			currMtl->Indices.push_back( cornerVertices[firstCorner] );
+		}
+	}
 
 	asset::SCPUMesh* mesh = new asset::SCPUMesh();
 
@@ -378,10 +475,10 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
                 newNormals[ctx.Materials[m]->Indices[i+1]] += normal;
                 newNormals[ctx.Materials[m]->Indices[i+2]] += normal;
             }
-            for (size_t i=0; i<ctx.Materials[m]->Vertices.size(); i++)
+            core::parallel_for(threadCnt, size_t(0u), ctx.Materials[m]->Vertices.size(), [&](size_t i) -> void
             {
                 ctx.Materials[m]->Vertices[i].normal32bit = asset::quantizeNormal2_10_10_10(newNormals[i]);
-            }
+            }, size_t(1024u));
             alctr.deallocate(newNormals,ctx.Materials[m]->Vertices.size());
         }
         if (ctx.Materials[m]->Material.MaterialType == -1)
@@ -463,6 +560,82 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 }
 
 
+void COBJMeshFileLoader::parseChunk(const char* bufPtr, const char* const bufEnd, SChunk& chunk)
+{
+	for (bufPtr = goFirstWord(bufPtr, bufEnd); bufPtr != bufEnd; bufPtr = goNextLine(bufPtr, bufEnd))
+	{
+		switch(bufPtr[0])
+		{
+		case 'v':               // v, vn, vt
+			if (bufEnd-bufPtr < 2)
+				break;
+			switch(bufPtr[1])
+			{
+			case ' ':          // vertex
+				{
+					core::vector3df vec;
+					bufPtr = readVec3(bufPtr, vec, bufEnd);
+					chunk.positions.push_back(vec);
+				}
+				break;
+
+			case 'n':       // normal
+				{
+					core::vector3df vec;
+					bufPtr = readVec3(bufPtr, vec, bufEnd);
+					chunk.normals.push_back(vec);
+				}
+				break;
+
+			case 't':       // texcoord
+				{
+					core::vector2df vec;
+					bufPtr = readUV(bufPtr, vec, bufEnd);
+					chunk.uvs.push_back(vec);
+				}
+				break;
+			}
+			break;
+
+		case 'f':               // face
+		{
+			const uint32_t recordCounts[3] = {uint32_t(chunk.positions.size()),uint32_t(chunk.uvs.size()),uint32_t(chunk.normals.size())};
+			const size_t firstCorner = chunk.corners.size();
+
+			// read in all vertices of the face (current line of obj file)
+			bufPtr = goNextWord(bufPtr, bufEnd, false);
+			while (bufPtr != bufEnd && *bufPtr != '\n' && *bufPtr != '\r')
+			{
+				SFaceCorner corner;
+				bufPtr = readFaceCorner(bufPtr, bufEnd, corner, recordCounts);
+				chunk.corners.push_back(corner);
+				while (bufPtr != bufEnd && (*bufPtr == ' ' || *bufPtr == '\t'))
+					++bufPtr;
+			}
+
+			// only polygons can be triangulated
+			if (chunk.corners.size()-firstCorner < 3u)
+				chunk.corners.resize(firstCorner);
+			else
+				chunk.faces.push_back(uint32_t(firstCorner));
+		}
+		break;
+
+		case 'm':	// mtllib (material)
+		case 'g':	// group name
+		case 's':	// smoothing group
+		case 'u':	// usemtl
+			chunk.stateRecords.push_back(std::make_pair(bufPtr, uint32_t(chunk.faces.size())));
+			break;
+
+		case '#': // comment
+		default:
+			break;
+		}	// end switch(bufPtr[0])
+	}
+}
+
+
 const char* COBJMeshFileLoader::readTextures(const SContext& _ctx, const char* bufPtr, const char* const bufEnd, SObjMtl* currMaterial, const io::path& relPath)
 {
 	E_TEXTURE_TYPE type = ETT_COLOR_MAP; // map_Kd - diffuse color texture map
@@ -829,15 +1002,12 @@ const char* COBJMeshFileLoader::readColor(const char* bufPtr, video::SColor& col
 //! Read 3d vector of floats
 const char* COBJMeshFileLoader::readVec3(const char* bufPtr, core::vector3df& vec, const char* const bufEnd)
 {
-	const uint32_t WORD_BUFFER_LENGTH = 256;
-	char wordBuffer[WORD_BUFFER_LENGTH];
-
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",&vec.X);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",&vec.Y);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",&vec.Z);
+	bufPtr = goNextWord(bufPtr, bufEnd, false);
+	core::fast_atof_move(bufPtr, bufEnd, vec.X);
+	bufPtr = goNextWord(bufPtr, bufEnd, false);
+	core::fast_atof_move(bufPtr, bufEnd, vec.Y);
+	bufPtr = goNextWord(bufPtr, bufEnd, false);
+	core::fast_atof_move(bufPtr, bufEnd, vec.Z);
 
 	vec.X = -vec.X; // change handedness
 	return bufPtr;
@@ -847,13 +1017,10 @@ const char* COBJMeshFileLoader::readVec3(const char* bufPtr, core::vector3df& ve
 //! Read 2d vector of floats
 const char* COBJMeshFileLoader::readUV(const char* bufPtr, core::vector2df& vec, const char* const bufEnd)
 {
-	const uint32_t WORD_BUFFER_LENGTH = 256;
-	char wordBuffer[WORD_BUFFER_LENGTH];
-
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",&vec.X);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",&vec.Y);
+	bufPtr = goNextWord(bufPtr, bufEnd, false);
+	core::fast_atof_move(bufPtr, bufEnd, vec.X);
+	bufPtr = goNextWord(bufPtr, bufEnd, false);
+	core::fast_atof_move(bufPtr, bufEnd, vec.Y);
 
 	vec.Y = 1-vec.Y; // change handedness
 	return bufPtr;
@@ -957,9 +1124,9 @@ uint32_t COBJMeshFileLoader::copyWord(char* outBuf, const char* const inBuf, uin
 	}
 
 	uint32_t i = 0;
-	while(inBuf[i])
+	while(&(inBuf[i]) != bufEnd && inBuf[i])
 	{
-		if (core::isspace(inBuf[i]) || &(inBuf[i]) == bufEnd)
+		if (core::isspace(inBuf[i]))
 			break;
 		++i;
 	}
@@ -973,23 +1140,6 @@ uint32_t COBJMeshFileLoader::copyWord(char* outBuf, const char* const inBuf, uin
 }
 
 
-core::stringc COBJMeshFileLoader::copyLine(const char* inBuf, const char* bufEnd)
-{
-	if (!inBuf)
-		return core::stringc();
-
-	const char* ptr = inBuf;
-	while (ptr<bufEnd)
-	{
-		if (*ptr=='\n' || *ptr=='\r')
-			break;
-		++ptr;
-	}
-	// we must avoid the +1 in case the array is used up
-	return core::stringc(inBuf, (uint32_t)(ptr-inBuf+((ptr < bufEnd) ? 1 : 0)));
-}
-
-
 const char* COBJMeshFileLoader::goAndCopyNextWord(char* outBuf, const char* inBuf, uint32_t outBufLength, const char* bufEnd)
 {
 	inBuf = goNextWord(inBuf, bufEnd, false);
@@ -998,72 +1148,42 @@ const char* COBJMeshFileLoader::goAndCopyNextWord(char* outBuf, const char* inBu
 }
 
 
-bool COBJMeshFileLoader::retrieveVertexIndices(char* vertexData, int32_t* idx, const char* bufEnd, uint32_t vbsize, uint32_t vtsize, uint32_t vnsize)
+const char* COBJMeshFileLoader::readFaceCorner(const char* bufPtr, const char* const bufEnd, SFaceCorner& corner, const uint32_t* recordCounts)
 {
-	char word[16] = "";
-	const char* p = goFirstWord(vertexData, bufEnd);
-	uint32_t idxType = 0;	// 0 = posIdx, 1 = texcoordIdx, 2 = normalIdx
+	corner.index[0] = corner.index[1] = corner.index[2] = -1;
+	corner.relativeMask = 0u;
 
-	uint32_t i = 0;
-	while ( p != bufEnd )
+	for (uint32_t idxType = 0u; idxType < 3u; ++idxType) // 0 = posIdx, 1 = texcoordIdx, 2 = normalIdx
 	{
-		if ( ( core::isdigit(*p)) || (*p == '-') )
-		{
-			// build up the number
-			word[i++] = *p;
-		}
-		else if ( *p == '/' || *p == ' ' || *p == '\0' )
+		const bool relative = bufPtr != bufEnd && *bufPtr == '-';
+		if (relative)
+			++bufPtr;
+		uint32_t value = 0u;
+		for (; bufPtr != bufEnd && core::isdigit(*bufPtr); ++bufPtr)
+			value = value*10u + uint32_t(*bufPtr-'0');
+
+		// if no number was found the index stays -1
+		if (value)
 		{
-			// number is completed. Convert and store it
-			word[i] = '\0';
-			// if no number was found index will become 0 and later on -1 by decrement
-			sscanf(word,"%u",idx+idxType);
-			if (idx[idxType]<0)
-			{
-				switch (idxType)
-				{
-					case 0:
-						idx[idxType] += vbsize;
-						break;
-					case 1:
-						idx[idxType] += vtsize;
-						break;
-					case 2:
-						idx[idxType] += vnsize;
-						break;
-				}
-			}
-			else
-				idx[idxType]-=1;
-
-			// reset the word
-			word[0] = '\0';
-			i = 0;
-
-			// go to the next kind of index type
-			if (*p == '/')
+			if (relative)
 			{
-				if ( ++idxType > 2 )
-				{
-					// error checking, shouldn't reach here unless file is wrong
-					idxType = 0;
-				}
+				corner.index[idxType] = int32_t(recordCounts[idxType]) - int32_t(value);
+				corner.relativeMask |= 0x1u<<idxType;
 			}
 			else
-			{
-				// set all missing values to disable (=-1)
-				while (++idxType < 3)
-					idx[idxType]=-1;
-				++p;
-				break; // while
-			}
+				corner.index[idxType] = int32_t(value-1u);
 		}
 
-		// go to the next char
-		++p;
+		// go to the next kind of index type
+		if (bufPtr == bufEnd || *bufPtr != '/')
+			break;
+		++bufPtr;
 	}
 
-	return true;
+	// skip whatever else is in the word
+	while (bufPtr != bufEnd && !core::isspace(*bufPtr))
+		++bufPtr;
+	return bufPtr;
 }
 
 std::string COBJMeshFileLoader::genKeyForMeshBuf(const SContext & _ctx, const std::string & _baseKey, const std::string & _mtlName, const std::string & _grpName) const
@@ -185,7 +185,6 @@ private:
                 Material = o.Material;
             }
 
-            core::map<SObjVertex, int> VertMap;
             core::vector<SObjVertex> Vertices;
             core::vector<uint32_t> Indices;
             video::SCPUMaterial Material;
@@ -196,6 +195,30 @@ private:
             bool RecalculateNormals;
 	};
 
+	//! One corner of a face, v/vt/vn indices are 0-based and -1 when not present
+	struct SFaceCorner
+	{
+		int32_t index[3];
+		//! bit N is set while index[N] is relative to the first record of its kind in the chunk
+		uint32_t relativeMask;
+	};
+
+	//! Records of a piece of the file which starts and ends on a line boundary
+	struct SChunk
+	{
+		core::vector<core::vector3df> positions;
+		core::vector<core::vector3df> normals;
+		core::vector<core::vector2df> uvs;
+		core::vector<SFaceCorner> corners;
+		//! first corner of every face
+		core::vector<uint32_t> faces;
+		//! mtllib, usemtl, g and s lines along with how many faces of the chunk came before them, they are handled in file order afterwards
+		core::vector<std::pair<const char*,uint32_t> > stateRecords;
+	};
+
+	//! Parses the v, vt, vn and f records of a chunk, chunks can be parsed concurrently
+	void parseChunk(const char* bufPtr, const char* const bufEnd, SChunk& chunk);
+
 	// helper method for material reading
 	const char* readTextures(const SContext& _ctx, const char* bufPtr, const char* const bufEnd, SObjMtl* currMaterial, const io::path& relPath);
 
@@ -207,8 +230,6 @@ private:
 	const char* goNextLine(const char* buf, const char* const bufEnd);
 	// copies the current word from the inBuf to the outBuf
 	uint32_t copyWord(char* outBuf, const char* inBuf, uint32_t outBufLength, const char* const pBufEnd);
-	// copies the current line from the inBuf to the outBuf
-	core::stringc copyLine(const char* inBuf, const char* const bufEnd);
 
 	// combination of goNextWord followed by copyWord
 	const char* goAndCopyNextWord(char* outBuf, const char* inBuf, uint32_t outBufLength, const char* const pBufEnd);
@@ -228,10 +249,10 @@ private:
 	//! Read boolean value represented as 'on' or 'off'
 	const char* readBool(const char* bufPtr, bool& tf, const char* const bufEnd);
 
-	// reads and convert to integer the vertex indices in a line of obj file's face statement
+	// reads the vertex indices of a corner in a line of obj file's face statement
 	// -1 for the index if it doesn't exist
-	// indices are changed to 0-based index instead of 1-based from the obj file
-	bool retrieveVertexIndices(char* vertexData, int32_t* idx, const char* bufEnd, uint32_t vbsize, uint32_t vtsize, uint32_t vnsize);
+	// indices are changed to 0-based index instead of 1-based from the obj file, negative ones are resolved against `recordCounts`
+	const char* readFaceCorner(const char* bufPtr, const char* const bufEnd, SFaceCorner& corner, const uint32_t* recordCounts);
 
     std::string genKeyForMeshBuf(const SContext& _ctx, const std::string& _baseKey, const std::string& _mtlName, const std::string& _grpName) const;
 
@@ -10,182 +10,218 @@
 #include "irr/asset/SCPUMesh.h"
 #include "irr/asset/ICPUMeshBuffer.h"
 #include "irr/core/math/plane3dSIMD.h"
+#include "irr/core/fast_atof.h"
+#include "irr/core/parallel_for.h"
 
 #include "IReadFile.h"
 #include "coreutil.h"
 #include "os.h"
 #include "SVertexManipulator.h"
 
-#include <vector>
+#include <algorithm>
+#include <atomic>
 
 namespace irr
 {
 namespace asset
 {
 
+namespace
+{
+    //! Binary facets are read in batches of this many when the file is not memory mapped
+    constexpr size_t kBinaryFacetBatch = 1u<<16u;
+    //! ASCII text is read in chunks of this many bytes when the file is not memory mapped
+    constexpr size_t kASCIIChunkSize = 16u<<20u;
+    //! Threads are not given less ASCII text than this to parse
+    constexpr size_t kMinASCIIPieceSize = 1u<<20u;
+    constexpr size_t kBinaryFacetSize = 50u;
+    constexpr size_t kColoredVertexSize = 3*sizeof(float)+4+4;
+    constexpr size_t kVertexSize = 3*sizeof(float)+4;
+}
+
 asset::SAssetBundle CSTLMeshFileLoader::loadAsset(io::IReadFile* _file, const asset::IAssetLoader::SAssetLoadParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override, uint32_t _hierarchyLevel)
 {
-	const long filesize = _file->getSize();
+	const size_t filesize = _file->getSize();
 	if (filesize < 6) // we need a header
         return {};
 
-    bool hasColor = false;
+    const uint32_t threadCnt = core::resolveThreadCount(_params.workerThreadCount);
+    // when the file is memory mapped everything gets parsed in place, otherwise it is read in big chunks
+    _file->setAccessPattern(io::EFAP_SEQUENTIAL);
+    const uint8_t* const mapped = reinterpret_cast<const uint8_t*>(_file->getMappedPointer());
 
-	asset::SCPUMesh* mesh = new asset::SCPUMesh();
-    asset::ICPUMeshDataFormatDesc* desc = new asset::ICPUMeshDataFormatDesc();
+	bool binary = false;
     {
-	asset::ICPUMeshBuffer* meshbuffer = new asset::ICPUMeshBuffer();
-	meshbuffer->setMeshDataAndFormat(desc);
-	desc->drop();
-
-	mesh->addMeshBuffer(meshbuffer);
-	meshbuffer->drop();
+        char header[84];
+        const size_t headerSize = std::min<size_t>(filesize,sizeof(header));
+        _file->seek(0u);
+        _file->read(header, headerSize);
+        const char* word = goNextWord(header, header+headerSize);
+        binary = !getNextToken(word, header+headerSize, "solid");
     }
 
-	bool binary = false;
-	core::stringc token;
-	if (getNextToken(_file, token) != "solid")
-		binary = hasColor = true;
-
-    core::vector<core::vectorSIMDf> positions, normals;
-    core::vector<uint32_t> colors;
+    bool hasColor = false;
+	asset::ICPUBuffer* vertexBuf = nullptr;
+    size_t vertexCount = 0u;
 	if (binary)
 	{
-        if (_file->getSize() < 80)
-        {
-            mesh->drop();
+        if (filesize < 84u)
             return {};
-        }
-		_file->seek(80); // skip header
-        uint32_t vtxCnt = 0u;
-		_file->read(&vtxCnt, 4);
-        positions.reserve(3*vtxCnt);
-        normals.reserve(vtxCnt);
-        colors.reserve(vtxCnt);
-	}
-	else
-		goNextLine(_file); // skip header
 
+        // like always, trust the file size over the facet count in the header
+        const size_t facetCount = (filesize-84u)/kBinaryFacetSize;
+        vertexCount = 3u*facetCount;
+		vertexBuf = new asset::ICPUBuffer(kColoredVertexSize*vertexCount);
+        uint8_t* const vertices = reinterpret_cast<uint8_t*>(vertexBuf->getPointer());
 
-	uint16_t attrib=0u;
-	token.reserve(32);
-	while (_file->getPos() < filesize)
-	{
-		if (!binary)
-		{
-			if (getNextToken(_file, token) != "facet")
-			{
-				if (token=="endsolid")
-					break;
-				mesh->drop();
-                return {};
-			}
-			if (getNextToken(_file, token) != "normal")
-			{
-				mesh->drop();
-                return {};
-			}
-		}
-
+        hasColor = true;
+        if (mapped)
+            hasColor = decodeBinaryFacets(mapped+84u, facetCount, vertices, threadCnt);
+        else
         {
-        core::vectorSIMDf n;
-		getNextVector(_file, n, binary);
-        normals.push_back(n);
+            core::vector<uint8_t> facets(std::min(facetCount,kBinaryFacetBatch)*kBinaryFacetSize);
+		    _file->seek(84u);
+            for (size_t firstFacet=0u; firstFacet<facetCount; firstFacet+=kBinaryFacetBatch)
+            {
+                const size_t batchSize = std::min(facetCount-firstFacet,kBinaryFacetBatch);
+                _file->read(facets.data(), batchSize*kBinaryFacetSize);
+                hasColor = decodeBinaryFacets(facets.data(), batchSize, vertices+3u*firstFacet*kColoredVertexSize, threadCnt) && hasColor;
+            }
         }
 
-		if (!binary)
-		{
-			if (getNextToken(_file, token) != "outer")
-			{
-				mesh->drop();
-                return {};
-			}
-			if (getNextToken(_file, token) != "loop")
-			{
-				mesh->drop();
-                return {};
-			}
-		}
-
+        if (!hasColor) // assuming VisCam/SolidView non-standard trick to store color in 2 bytes of extra attribute, all facets need it
         {
-        core::vectorSIMDf p[3];
-		for (uint32_t i = 0u; i < 3u; ++i)
-		{
-			if (!binary)
-			{
-				if (getNextToken(_file, token) != "vertex")
-				{
-					mesh->drop();
-                    return {};
-				}
-			}
-			getNextVector(_file, p[i], binary);
-		}
-        for (uint32_t i = 0u; i < 3u; ++i) // seems like in STL format vertices are ordered in clockwise manner...
-            positions.push_back(p[2u-i]);
+            asset::ICPUBuffer* uncoloredBuf = new asset::ICPUBuffer(kVertexSize*vertexCount);
+            uint8_t* const dst = reinterpret_cast<uint8_t*>(uncoloredBuf->getPointer());
+            for (size_t i = 0u; i < vertexCount; ++i)
+                memcpy(dst+i*kVertexSize, vertices+i*kColoredVertexSize, kVertexSize);
+            vertexBuf->drop();
+            vertexBuf = uncoloredBuf;
         }
-
-		if (!binary)
-		{
-			if (getNextToken(_file, token) != "endloop")
-			{
-				mesh->drop();
-                return {};
-			}
-			if (getNextToken(_file, token) != "endfacet")
-			{
-				mesh->drop();
-                return {};
-			}
-		}
-		else
-		{
-			_file->read(&attrib, 2);
-		}
-
-        if (hasColor && (attrib & 0x8000)) // assuming VisCam/SolidView non-standard trick to store color in 2 bytes of extra attribute
+	}
+	else
+	{
+        core::vector<core::vectorSIMDf> positions, normals;
+        bool reachedEndSolid = false;
+        // splits [_begin,_end) at facet boundaries into a piece per thread and parses them, results get appended in order
+        auto parseText = [&](const char* _begin, const char* _end) -> bool
+        {
+            const size_t pieceCount = std::min<size_t>(threadCnt, (_end-_begin)/kMinASCIIPieceSize+1u);
+            core::vector<const char*> bounds(pieceCount+1u);
+            bounds.front() = _begin;
+            bounds.back() = _end;
+            for (size_t i = 1u; i < pieceCount; ++i)
+                bounds[i] = findNextFacet(std::max(bounds[i-1u], _begin+(_end-_begin)*i/pieceCount), _end);
+
+            struct SPiece
+            {
+                core::vector<core::vectorSIMDf> positions, normals;
+                const char* stop = nullptr;
+                bool reachedEndSolid = false;
+            };
+            core::vector<SPiece> pieces(pieceCount);
+            core::parallel_for(threadCnt, size_t(0u), pieceCount, [&](size_t i) -> void
+            {
+                SPiece& piece = pieces[i];
+                piece.positions.reserve((bounds[i+1u]-bounds[i])/64u);
+                piece.normals.reserve(piece.positions.capacity()/3u);
+                piece.stop = parseASCIIFacets(bounds[i], bounds[i+1u], piece.positions, piece.normals, piece.reachedEndSolid);
+            });
+
+            for (const SPiece& piece : pieces)
+            {
+                if (!piece.stop)
+                    return false;
+                positions.insert(positions.end(), piece.positions.begin(), piece.positions.end());
+                normals.insert(normals.end(), piece.normals.begin(), piece.normals.end());
+                if (piece.reachedEndSolid)
+                {
+                    reachedEndSolid = true;
+                    break;
+                }
+            }
+            return true;
+        };
+
+        bool wellFormed = true;
+        if (mapped)
         {
-            colors.push_back(video::A1R5G5B5toA8R8G8B8(attrib));
+            const char* const end = reinterpret_cast<const char*>(mapped)+filesize;
+            wellFormed = parseText(goNextLine(reinterpret_cast<const char*>(mapped), end), end); // skip header
         }
         else
         {
-            hasColor = false;
-            colors.clear();
+            // text is parsed up to the last facet start read so far, the rest gets carried over to the next chunk
+            core::vector<char> text(kASCIIChunkSize);
+            size_t carried = 0u;
+            size_t fileLeft = filesize;
+            bool skipHeader = true;
+            _file->seek(0u);
+            while (wellFormed && !reachedEndSolid && (fileLeft || carried))
+            {
+                const size_t readSize = std::min(text.size()-carried, fileLeft);
+                _file->read(text.data()+carried, readSize);
+                fileLeft -= readSize;
+                const size_t available = carried+readSize;
+
+                const char* begin = text.data();
+                const char* const end = begin+available;
+                if (skipHeader)
+                    begin = goNextLine(begin, end);
+                const char* cut = fileLeft ? findLastFacet(begin, end):end;
+                if (cut==begin && fileLeft)
+                {
+                    // not even one whole facet fits
+                    text.resize(2u*text.size());
+                    carried = available;
+                    continue;
+                }
+                skipHeader = false;
+
+                wellFormed = parseText(begin, cut);
+                carried = end-cut;
+                memmove(text.data(), cut, carried);
+                if (!fileLeft)
+                    break;
+            }
         }
+        if (!wellFormed)
+            return {};
 
-		if ((normals.back() == core::vectorSIMDf()).all())
+        vertexCount = positions.size();
+		vertexBuf = new asset::ICPUBuffer(kVertexSize*vertexCount);
+        uint8_t* const vertices = reinterpret_cast<uint8_t*>(vertexBuf->getPointer());
+        core::parallel_for(threadCnt, size_t(0u), normals.size(), [&](size_t i) -> void
         {
-			normals.back().set(
-                core::plane3dSIMDf(
-                    *(positions.rbegin()+2),
-                    *(positions.rbegin()+1),
-                    *(positions.rbegin()+0)).getNormal()
-            );
-        }
-	} // end while (_file->getPos() < filesize)
-
-    const size_t vtxSize = hasColor ? (3 * sizeof(float) + 4 + 4) : (3 * sizeof(float) + 4);
-	asset::ICPUBuffer* vertexBuf = new asset::ICPUBuffer(vtxSize*positions.size());
+            const uint32_t normal = asset::quantizeNormal2_10_10_10(normals[i]);
+            for (size_t j = 0u; j < 3u; ++j)
+            {
+                uint8_t* ptr = vertices + (3u*i+j)*kVertexSize;
+                memcpy(ptr, positions[3u*i+j].pointer, 3*4);
+                memcpy(ptr+12, &normal, 4);
+            }
+        }, size_t(1024u));
+	}
 
-    uint32_t normal{};
-    for (size_t i = 0u; i < positions.size(); ++i)
+	asset::SCPUMesh* mesh = new asset::SCPUMesh();
+    asset::ICPUMeshDataFormatDesc* desc = new asset::ICPUMeshDataFormatDesc();
     {
-        if (i%3 == 0)
-            normal = asset::quantizeNormal2_10_10_10(normals[i/3]);
-        uint8_t* ptr = ((uint8_t*)(vertexBuf->getPointer())) + i*vtxSize;
-        memcpy(ptr, positions[i].pointer, 3*4);
-        ((uint32_t*)(ptr+12))[0] = normal;
-        if (hasColor)
-            memcpy(ptr+16, colors.data()+i/3, 4);
+	asset::ICPUMeshBuffer* meshbuffer = new asset::ICPUMeshBuffer();
+	meshbuffer->setMeshDataAndFormat(desc);
+	desc->drop();
+
+	mesh->addMeshBuffer(meshbuffer);
+	meshbuffer->drop();
     }
 
+    const size_t vtxSize = hasColor ? kColoredVertexSize : kVertexSize;
 	desc->setVertexAttrBuffer(vertexBuf, asset::EVAI_ATTR0, asset::EF_R32G32B32_SFLOAT, vtxSize, 0);
 	desc->setVertexAttrBuffer(vertexBuf, asset::EVAI_ATTR3, asset::EF_A2B10G10R10_SNORM_PACK32, vtxSize, 12);
     if (hasColor)
 	    desc->setVertexAttrBuffer(vertexBuf, asset::EVAI_ATTR1, asset::EF_B8G8R8A8_UNORM, vtxSize, 16);
 	vertexBuf->drop();
 
-	mesh->getMeshBuffer(0)->setIndexCount(positions.size());
+	mesh->getMeshBuffer(0)->setIndexCount(vertexCount);
     //mesh->getMeshBuffer(0)->setPrimitiveType(EPT_POINTS);
 	mesh->recalculateBoundingBox(true);
 
@@ -194,6 +230,82 @@ asset::SAssetBundle CSTLMeshFileLoader::loadAsset(io::IReadFile* _file, const as
 	return bundle;
 }
 
+bool CSTLMeshFileLoader::decodeBinaryFacets(const uint8_t* _facets, size_t _facetCount, uint8_t* _vertices, uint32_t _threadCnt)
+{
+    std::atomic<bool> allColored(true);
+    core::parallel_for(_threadCnt, size_t(0u), _facetCount, [&](size_t i) -> void
+    {
+        const uint8_t* facet = _facets + i*kBinaryFacetSize;
+        float data[12];
+        memcpy(data, facet, sizeof(data));
+        uint16_t attrib;
+        memcpy(&attrib, facet+sizeof(data), 2);
+
+        core::vectorSIMDf n(-data[0], data[1], data[2]);
+        core::vectorSIMDf p[3];
+        for (uint32_t k = 0u; k < 3u; ++k)
+            p[k].set(-data[3u+3u*k], data[4u+3u*k], data[5u+3u*k]);
+		if (n.x==0.f && n.y==0.f && n.z==0.f)
+            n.set(core::plane3dSIMDf(p[2], p[1], p[0]).getNormal());
+
+        const uint32_t normal = asset::quantizeNormal2_10_10_10(n);
+        uint32_t color = 0u;
+        if (attrib & 0x8000)
+            color = video::A1R5G5B5toA8R8G8B8(attrib);
+        else
+            allColored.store(false, std::memory_order_relaxed);
+
+        for (uint32_t j = 0u; j < 3u; ++j) // seems like in STL format vertices are ordered in clockwise manner...
+        {
+            uint8_t* ptr = _vertices + (3u*i+j)*kColoredVertexSize;
+            memcpy(ptr, p[2u-j].pointer, 3*4);
+            memcpy(ptr+12, &normal, 4);
+            memcpy(ptr+16, &color, 4);
+        }
+    }, size_t(1024u));
+    return allColored.load();
+}
+
+const char* CSTLMeshFileLoader::parseASCIIFacets(const char* _it, const char* _end, core::vector<core::vectorSIMDf>& _positions, core::vector<core::vectorSIMDf>& _normals, bool& _reachedEndSolid)
+{
+    for (_it = goNextWord(_it, _end); _it != _end; _it = goNextWord(_it, _end))
+    {
+        if (!getNextToken(_it, _end, "facet"))
+        {
+            if (getNextToken(_it, _end, "endsolid"))
+            {
+                _reachedEndSolid = true;
+                return _it;
+            }
+            return nullptr;
+        }
+        if (!getNextToken(_it, _end, "normal"))
+            return nullptr;
+        core::vectorSIMDf n;
+        getNextVector(_it, _end, n);
+
+        if (!getNextToken(_it, _end, "outer") || !getNextToken(_it, _end, "loop"))
+            return nullptr;
+        core::vectorSIMDf p[3];
+        for (uint32_t i = 0u; i < 3u; ++i)
+        {
+            if (!getNextToken(_it, _end, "vertex"))
+                return nullptr;
+            getNextVector(_it, _end, p[i]);
+        }
+        if (!getNextToken(_it, _end, "endloop") || !getNextToken(_it, _end, "endfacet"))
+            return nullptr;
+
+        for (uint32_t i = 0u; i < 3u; ++i) // seems like in STL format vertices are ordered in clockwise manner...
+            _positions.push_back(p[2u-i]);
+		if (n.x==0.f && n.y==0.f && n.z==0.f)
+            n.set(core::plane3dSIMDf(p[2], p[1], p[0]).getNormal());
+        _normals.push_back(n);
+    }
+    return _it;
+}
+
+
 bool CSTLMeshFileLoader::isALoadableFileFormat(io::IReadFile* _file) const
 {
     if (!_file || _file->getSize() <= 6u)
@@ -224,77 +336,87 @@ bool CSTLMeshFileLoader::isALoadableFileFormat(io::IReadFile* _file) const
 }
 
 //! Read 3d vector of floats
-void CSTLMeshFileLoader::getNextVector(io::IReadFile* file, core::vectorSIMDf& vec, bool binary) const
+void CSTLMeshFileLoader::getNextVector(const char*& _it, const char* _end, core::vectorSIMDf& vec)
 {
-	if (binary)
+	for (uint32_t i = 0u; i < 3u; ++i)
 	{
-		file->read(&vec.X, 4);
-		file->read(&vec.Y, 4);
-		file->read(&vec.Z, 4);
-	}
-	else
-	{
-		goNextWord(file);
-		core::stringc tmp;
-
-		getNextToken(file, tmp);
-		sscanf(tmp.c_str(),"%f",&vec.X);
-		getNextToken(file, tmp);
-		sscanf(tmp.c_str(),"%f",&vec.Y);
-		getNextToken(file, tmp);
-		sscanf(tmp.c_str(),"%f",&vec.Z);
+		_it = goNextWord(_it, _end);
+		const char* numberEnd = core::fast_atof_move(_it, _end, vec.pointer[i]);
+		if (numberEnd == _it) // not a number, skip the word
+		{
+			vec.pointer[i] = 0.f;
+			while (numberEnd != _end && !core::isspace(*numberEnd))
+				++numberEnd;
+		}
+		_it = numberEnd;
 	}
 	vec.X=-vec.X;
 }
 
 
-//! Read next word
-const core::stringc& CSTLMeshFileLoader::getNextToken(io::IReadFile* file, core::stringc& token) const
+//! Read next word if it matches
+bool CSTLMeshFileLoader::getNextToken(const char*& _it, const char* _end, const char* _word)
+{
+	_it = goNextWord(_it, _end);
+	const size_t length = strlen(_word);
+	if (size_t(_end-_it) < length || memcmp(_it, _word, length) != 0)
+		return false;
+	if (_it+length != _end && !core::isspace(_it[length]))
+		return false;
+	_it += length;
+	return true;
+}
+
+
+//! skip to next word
+const char* CSTLMeshFileLoader::goNextWord(const char* _it, const char* _end)
+{
+	while (_it != _end && core::isspace(*_it))
+		++_it;
+	return _it;
+}
+
+
+//! Read until line break is reached
+const char* CSTLMeshFileLoader::goNextLine(const char* _it, const char* _end)
 {
-	goNextWord(file);
-	uint8_t c;
-	token = "";
-	while(file->getPos() != file->getSize())
+	// look for newline characters
+	while (_it != _end)
 	{
-		file->read(&c, 1);
+		const char c = *(_it++);
 		// found it, so leave
-		if (core::isspace(c))
+		if (c=='\n' || c=='\r')
 			break;
-		token.append(c);
 	}
-	return token;
+	return _it;
 }
 
 
-//! skip to next word
-void CSTLMeshFileLoader::goNextWord(io::IReadFile* file) const
+//! Find the first "facet" starting a word
+const char* CSTLMeshFileLoader::findNextFacet(const char* _it, const char* _end)
 {
-	uint8_t c;
-	while(file->getPos() != file->getSize())
+	for (; _end-_it >= 5; ++_it)
 	{
-		file->read(&c, 1);
-		// found it, so leave
-		if (!core::isspace(c))
-		{
-			file->seek(-1, true);
-			break;
-		}
+		if (memcmp(_it, "facet", 5) == 0 && core::isspace(_it[-1]))
+			return _it;
 	}
+	return _end;
 }
 
 
-//! Read until line break is reached and stop at the next non-space character
-void CSTLMeshFileLoader::goNextLine(io::IReadFile* file) const
+//! Find the last "facet" starting a word
+const char* CSTLMeshFileLoader::findLastFacet(const char* _begin, const char* _end)
 {
-	uint8_t c;
-	// look for newline characters
-	while(file->getPos() != file->getSize())
+	// a match needs a character before it, so there is nothing to find in 5 bytes or less
+	if (_end-_begin <= 5)
+		return _begin;
+
+	for (const char* it = _end-5; it > _begin; --it)
 	{
-		file->read(&c, 1);
-		// found it, so leave
-		if (c=='\n' || c=='\r')
-			break;
+		if (memcmp(it, "facet", 5) == 0 && core::isspace(it[-1]))
+			return it;
 	}
+	return _begin;
 }
 
 } // end namespace scene
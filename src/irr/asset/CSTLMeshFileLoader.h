@@ -31,16 +31,27 @@ public:
     virtual uint64_t getSupportedAssetTypesBitfield() const override { return asset::IAsset::ET_MESH; }
 
 private:
+	//! Decodes `_facetCount` binary facets (50 bytes each) into 3 vertices of position, normal and color (20 bytes each) per facet
+	/** \return Whether every facet had the VisCam/SolidView color bit set. */
+	static bool decodeBinaryFacets(const uint8_t* _facets, size_t _facetCount, uint8_t* _vertices, uint32_t _threadCnt);
+
+	//! Parses ASCII facets in [_it,_end) until "endsolid", appends 3 positions and 1 normal per facet
+	/** \return Pointer past the last facet (or the "endsolid") parsed, nullptr if the text is not a sequence of facets. */
+	static const char* parseASCIIFacets(const char* _it, const char* _end, core::vector<core::vectorSIMDf>& _positions, core::vector<core::vectorSIMDf>& _normals, bool& _reachedEndSolid);
 
 	// skips to the first non-space character available
-	void goNextWord(io::IReadFile* file) const;
-	// returns the next word
-	const core::stringc& getNextToken(io::IReadFile* file, core::stringc& token) const;
-	// skip to next printable character after the first line break
-	void goNextLine(io::IReadFile* file) const;
+	static const char* goNextWord(const char* _it, const char* _end);
+	// moves past the next word if it is `_word`
+	static bool getNextToken(const char*& _it, const char* _end, const char* _word);
+	// skip to the character after the first line break
+	static const char* goNextLine(const char* _it, const char* _end);
+	// returns the start of the first "facet" keyword in [_it,_end), `_end` if there is none
+	static const char* findNextFacet(const char* _it, const char* _end);
+	// returns the start of the last "facet" keyword in [_begin,_end), `_begin` if there is none
+	static const char* findLastFacet(const char* _begin, const char* _end);
 
 	//! Read 3d vector of floats
-	void getNextVector(io::IReadFile* file, core::vectorSIMDf& vec, bool binary) const;
+	static void getNextVector(const char*& _it, const char* _end, core::vectorSIMDf& vec);
 };
 
 } // end namespace scene
@@ -630,22 +630,27 @@ bool CXMeshFileLoader::load(SContext& _ctx, io::IReadFile* file)
 //! Reads file into memory
 bool CXMeshFileLoader::readFileIntoMemory(SContext& _ctx, io::IReadFile* file)
 {
-	const long size = file->getSize();
+	const size_t size = file->getSize();
 	if (size < 12)
 	{
 		os::Printer::log("X File is too small.", ELL_WARNING);
 		return false;
 	}
 
-	std::string Buffer;
-	Buffer.resize(size);
-	//! read all into memory
-	if (file->read(&Buffer[0], size) != size)
+	//! parse memory mapped files in place, read others all into memory
+	file->setAccessPattern(io::EFAP_SEQUENTIAL);
+	const char* contents = reinterpret_cast<const char*>(file->getMappedPointer());
+	if (!contents)
 	{
-		os::Printer::log("Could not read from x file.", ELL_WARNING);
-		return false;
+		_ctx.fileBuffer.resize(size);
+		if (file->read(&_ctx.fileBuffer[0], size) != size)
+		{
+			os::Printer::log("Could not read from x file.", ELL_WARNING);
+			return false;
+		}
+		contents = _ctx.fileBuffer.data();
 	}
-    _ctx.fileContents.str(Buffer);
+    _ctx.fileView.setView(contents, size);
 
 	//! check header "xof "
 	char tmp[4];
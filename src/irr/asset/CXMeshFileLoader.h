@@ -48,6 +48,33 @@ public:
 } PACK_STRUCT;
 #include "irr/irrunpack.h"
 
+//! Read-only stream buffer over memory owned by someone else, lets the parser run straight on a memory mapped file
+class CMemoryViewStreamBuf : public std::streambuf
+{
+    public:
+        void setView(const char* _begin, size_t _size)
+        {
+            char* begin = const_cast<char*>(_begin); // get area is never written to, putback only moves the pointer back
+            setg(begin, begin, begin+_size);
+        }
+
+    protected:
+        virtual pos_type seekoff(off_type _off, std::ios_base::seekdir _dir, std::ios_base::openmode _which = std::ios_base::in) override
+        {
+            char* base = _dir==std::ios_base::beg ? eback() : (_dir==std::ios_base::end ? egptr() : gptr());
+            const off_type newPos = (base-eback())+_off;
+            if (!(_which&std::ios_base::in) || newPos<0 || newPos>egptr()-eback())
+                return pos_type(off_type(-1));
+
+            setg(eback(), eback()+newPos, egptr());
+            return pos_type(newPos);
+        }
+        virtual pos_type seekpos(pos_type _pos, std::ios_base::openmode _which = std::ios_base::in) override
+        {
+            return seekoff(off_type(_pos), std::ios_base::beg, _which);
+        }
+};
+
 
 //! Meshloader capable of loading x meshes.
 class CXMeshFileLoader : public asset::IAssetLoader
@@ -127,7 +154,7 @@ private:
             Inner(_inner),
             loaderOverride(_ovrr),
             AllJoints(0), AnimatedMesh(0),
-            BinaryNumCount(0),
+            fileContents(&fileView), BinaryNumCount(0),
             CurFrame(0), MajorVersion(0), MinorVersion(0), BinaryFormat(false), FloatSize(0)
         {}
 
@@ -141,7 +168,10 @@ private:
 
         asset::CCPUSkinnedMesh* AnimatedMesh;
 
-        std::istringstream fileContents;
+        //! only used when the file is not memory mapped
+        std::string fileBuffer;
+        CMemoryViewStreamBuf fileView;
+        std::istream fileContents;
         // counter for number arrays in binary format
         uint32_t BinaryNumCount;
         io::path FilePath;
@@ -35,3 +35,183 @@ const IMeshManipulator* IAssetManager::getMeshManipulator() const
 {
     return m_meshManipulator;
 }
+
+void IAssetManager::trackCachedAsset(const SAssetBundle& _asset) const
+{
+    if (_asset.isEmpty())
+        return;
+
+    uint64_t bytes = 0u;
+    for (auto it = _asset.getContents().first; it != _asset.getContents().second; ++it)
+        bytes += (*it)->conservativeSizeEstimate();
+
+    SCacheBudget& cache = m_cacheBudgets[IAsset::typeFlagToIndex(_asset.getAssetType())];
+    std::unique_lock<std::mutex> lock(cache.mutex);
+    auto inserted = cache.lookup.insert({_asset.m_contents.get(), cache.clock.size()});
+    if (!inserted.second) // same bundle cached under two keys
+        return;
+    cache.clock.push_back({_asset, bytes, true, false, false});
+    cache.usedBytes += bytes;
+}
+
+void IAssetManager::untrackCachedAsset(const SAssetBundle& _asset) const
+{
+    if (_asset.isEmpty())
+        return;
+
+    SCacheBudget& cache = m_cacheBudgets[IAsset::typeFlagToIndex(_asset.getAssetType())];
+    std::unique_lock<std::mutex> lock(cache.mutex);
+    auto found = cache.lookup.find(_asset.m_contents.get());
+    if (found == cache.lookup.end())
+        return;
+
+    const size_t ix = found->second;
+    cache.usedBytes -= cache.clock[ix].bytes;
+    cache.lookup.erase(found);
+    // order of the clock doesn't need to be exact, so fill the hole with the last entry
+    if (ix+1u != cache.clock.size())
+    {
+        cache.clock[ix] = std::move(cache.clock.back());
+        cache.lookup[cache.clock[ix].bundle.m_contents.get()] = ix;
+    }
+    cache.clock.pop_back();
+}
+
+size_t IAssetManager::markCachedAssetsReferenced(SAssetBundle* _begin, SAssetBundle* _end) const
+{
+    auto usableEnd = _begin;
+    for (auto it = _begin; it != _end; ++it)
+    {
+        if (!it->isEmpty())
+        {
+            const uint32_t typeIx = IAsset::typeFlagToIndex(it->getAssetType());
+            SCacheBudget& cache = m_cacheBudgets[typeIx];
+            bool dummy = false;
+            {
+                std::unique_lock<std::mutex> lock(cache.mutex);
+                auto found = cache.lookup.find(it->m_contents.get());
+                if (found != cache.lookup.end())
+                {
+                    cache.clock[found->second].referenced = true;
+                    dummy = cache.clock[found->second].dummy;
+                }
+            }
+            // the budget's lock must not be held here, removal disposes the bundle which takes it again
+            if (dummy)
+            {
+                m_assetCache[typeIx]->removeObject(*it, it->getCacheKey());
+                *it = SAssetBundle();
+                continue;
+            }
+        }
+        if (it != usableEnd)
+            std::swap(*it, *usableEnd);
+        ++usableEnd;
+    }
+    return usableEnd-_begin;
+}
+
+bool IAssetManager::isOnlyReferencedByCache(const SAssetBundle& _asset, int32_t _extraRefs)
+{
+    // one reference is held by the cache and one by the budget tracker
+    if (_asset.m_contents->getReferenceCount() != 2+_extraRefs)
+        return false;
+    for (auto it = _asset.getContents().first; it != _asset.getContents().second; ++it)
+        if ((*it)->getReferenceCount() != 1)
+            return false;
+    return true;
+}
+
+void IAssetManager::enforceCacheBudget(uint32_t _typeIx)
+{
+    SCacheBudget& cache = m_cacheBudgets[_typeIx];
+
+    core::vector<SAssetBundle> victims;
+    E_CACHE_EVICTION_MODE mode;
+    {
+        std::unique_lock<std::mutex> lock(cache.mutex);
+        if (!cache.budget || cache.usedBytes <= cache.budget)
+            return;
+
+        mode = cache.mode;
+        uint64_t projectedBytes = cache.usedBytes;
+        // second chance: the first pass over a referenced entry only clears its bit, so two full turns of the hand are enough
+        for (size_t visited = 0u; projectedBytes > cache.budget && visited < 2u*cache.clock.size(); ++visited, ++cache.hand)
+        {
+            if (cache.hand >= cache.clock.size())
+                cache.hand = 0u;
+            auto& entry = cache.clock[cache.hand];
+            if (entry.evicting || !entry.bytes)
+                continue;
+            if (entry.referenced)
+            {
+                entry.referenced = false;
+                continue;
+            }
+            if (!isOnlyReferencedByCache(entry.bundle, 0))
+                continue;
+            entry.evicting = true;
+            victims.push_back(entry.bundle);
+            projectedBytes -= entry.bytes;
+        }
+    }
+
+    // cache locks are taken after the budget's lock got released, since the dispose function takes the budget's lock under them
+    for (auto& victim : victims)
+    {
+        uint64_t bytes = 0u;
+        if (mode == ECEM_REMOVE)
+        {
+            {
+                std::unique_lock<std::mutex> lock(cache.mutex);
+                auto found = cache.lookup.find(victim.m_contents.get());
+                if (found == cache.lookup.end())
+                    continue; // got removed meanwhile
+                bytes = cache.clock[found->second].bytes;
+            }
+            if (!m_assetCache[_typeIx]->removeObject(victim, victim.getCacheKey()))
+            {
+                std::unique_lock<std::mutex> lock(cache.mutex);
+                auto found = cache.lookup.find(victim.m_contents.get());
+                if (found != cache.lookup.end())
+                    cache.clock[found->second].evicting = false;
+                continue;
+            }
+        }
+        else
+        {
+            // the cache's lock keeps lookups from taking new references between the check and the conversion
+            const bool converted = m_assetCache[_typeIx]->applyIfCached(victim, victim.getCacheKey(), [&]() -> bool {
+                std::unique_lock<std::mutex> lock(cache.mutex);
+                auto found = cache.lookup.find(victim.m_contents.get());
+                if (found == cache.lookup.end())
+                    return false;
+                auto& entry = cache.clock[found->second];
+                entry.evicting = false;
+                // somebody could have looked it up since it got picked, the victims array holds one more reference
+                if (!isOnlyReferencedByCache(victim, 1))
+                    return false;
+                for (auto it = victim.getContents().first; it != victim.getContents().second; ++it)
+                    (*it)->convertToDummyObject();
+                // dummy stays cached until looked up, but it no longer counts towards the budget
+                bytes = entry.bytes;
+                cache.usedBytes -= bytes;
+                entry.bytes = 0u;
+                entry.dummy = true;
+                return true;
+            });
+            if (!converted)
+            {
+                std::unique_lock<std::mutex> lock(cache.mutex);
+                auto found = cache.lookup.find(victim.m_contents.get());
+                if (found != cache.lookup.end())
+                    cache.clock[found->second].evicting = false;
+                continue;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(cache.mutex);
+        cache.evictions++;
+        cache.evictedBytes += bytes;
+    }
+}
@@ -9,6 +9,13 @@
 #include "irr/asset/ICPUSkinnedMeshBuffer.h"
 #include "irr/asset/bawformat/legacy/CBAWLegacy.h"
 #include "CFinalBoneHierarchy.h"
+#include "IReadFile.h"
+#include "irr/core/parallel_for.h"
+#include "lz4/lib/lz4.h"
+
+#undef Bool
+#include "lzma/C/LzmaDec.h"
+#include "irr/asset/bawformat/LzmaMemMngmnt.h"
 
 #ifdef _IRR_COMPILE_WITH_OPENSSL_
 #include "openssl/evp.h"
@@ -330,4 +337,134 @@ bool decAes128gcm(const void* _input, size_t _inSize, void* _output, size_t _out
 #endif
 }
 
+bool BlobChunkIndexV2::validate(uint32_t _blobSize, uint32_t _sizeDecompr) const
+{
+	if (!chunkSize || chunkCount != calcChunkCount(_sizeDecompr, chunkSize))
+		return false;
+	const size_t indexSize = calcSize(chunkCount);
+	if (indexSize > _blobSize)
+		return false;
+	const size_t dataSize = _blobSize - indexSize;
+	for (uint32_t i = 0u; i < chunkCount; ++i)
+	{
+		const ChunkEntry& chunk = chunks[i];
+		if (size_t(chunk.offset) + chunk.compressedSize > dataSize || chunk.compressedSize > calcChunkSizeDecompr(i, _sizeDecompr))
+			return false;
+	}
+	return true;
+}
+
+//! `_src` points to the chunk, a chunk as big as its decompressed contents is stored raw
+static bool decompressChunk(const void* _src, uint32_t _srcSize, void* _dst, uint32_t _dstSize, uint8_t _comprType)
+{
+	if (_srcSize == _dstSize)
+	{
+		memcpy(_dst, _src, _dstSize);
+		return true;
+	}
+	if (_comprType & Blob::EBCT_LZ4)
+		return LZ4_decompress_safe((const char*)_src, (char*)_dst, _srcSize, _dstSize) == int(_dstSize);
+	if (_comprType & Blob::EBCT_LZMA)
+	{
+		if (_srcSize < LZMA_PROPS_SIZE)
+			return false;
+		SizeT dstSize = _dstSize;
+		SizeT srcSize = _srcSize - LZMA_PROPS_SIZE;
+		ELzmaStatus status;
+		ISzAlloc alloc{&LzmaMemMngmnt::alloc, &LzmaMemMngmnt::release};
+		const SRes res = LzmaDecode((Byte*)_dst, &dstSize, (const Byte*)(_src)+LZMA_PROPS_SIZE, &srcSize, (const Byte*)_src, LZMA_PROPS_SIZE, LZMA_FINISH_ANY, &status, &alloc);
+		return res == SZ_OK && dstSize == _dstSize;
+	}
+	return false;
+}
+
+bool decompressBlobChunks(const void* _blob, const BlobHeaderV2& _header, uint32_t _firstChunk, uint32_t _lastChunk, void* _dst, uint32_t _threadCnt)
+{
+	const BlobChunkIndexV2* index = reinterpret_cast<const BlobChunkIndexV2*>(_blob);
+	if (!(_header.compressionType & Blob::EBCT_CHUNKED) || _header.blobSize < BlobChunkIndexV2::calcSize(0u) || !index->validate(_header.blobSize, _header.blobSizeDecompr))
+		return false;
+	if (_firstChunk > _lastChunk || _lastChunk > index->chunkCount)
+		return false;
+
+	const uint8_t* const chunksBegin = reinterpret_cast<const uint8_t*>(_blob) + BlobChunkIndexV2::calcSize(index->chunkCount);
+	std::atomic<bool> ok(true);
+	core::parallel_for<uint32_t>(_threadCnt, _firstChunk, _lastChunk, [&](uint32_t i) {
+		const BlobChunkIndexV2::ChunkEntry& chunk = index->chunks[i];
+		uint8_t* const dst = reinterpret_cast<uint8_t*>(_dst) + size_t(i-_firstChunk)*index->chunkSize;
+		if (!decompressChunk(chunksBegin+chunk.offset, chunk.compressedSize, dst, index->calcChunkSizeDecompr(i, _header.blobSizeDecompr), _header.compressionType))
+			ok.store(false, std::memory_order_relaxed);
+	});
+	return ok.load();
+}
+
+bool readBlobChunksRange(io::IReadFile* _file, size_t _blobOffset, const BlobHeaderV2& _header, size_t _offset, size_t _size, void* _dst, uint32_t _threadCnt)
+{
+	if (!(_header.compressionType & Blob::EBCT_CHUNKED) || _offset > _header.blobSizeDecompr || _size > _header.blobSizeDecompr-_offset)
+		return false;
+	if (!_size)
+		return true;
+
+	// the chunk size and count have to be inside the blob before anything else of the index is looked at
+	uint32_t counts[2]; // chunkSize, chunkCount
+	if (_header.blobSize < BlobChunkIndexV2::calcSize(0u) || _blobOffset+_header.blobSize > _file->getSize())
+		return false;
+	_file->seek(_blobOffset);
+	if (size_t(_file->read(counts, sizeof(counts))) != sizeof(counts))
+		return false;
+	if (!counts[0] || counts[1] != BlobChunkIndexV2::calcChunkCount(_header.blobSizeDecompr, counts[0]))
+		return false;
+
+	// whole chunk table has to fit in the blob too
+	const size_t indexSize = BlobChunkIndexV2::calcSize(counts[1]);
+	if (indexSize > _header.blobSize)
+		return false;
+	BlobChunkIndexV2* index = reinterpret_cast<BlobChunkIndexV2*>(_IRR_ALIGNED_MALLOC(indexSize, _IRR_SIMD_ALIGNMENT));
+	_file->seek(_blobOffset);
+	bool ok = size_t(_file->read(index, indexSize)) == indexSize && index->validate(_header.blobSize, _header.blobSizeDecompr);
+	const uint32_t firstChunk = ok ? _offset/index->chunkSize : 0u;
+	const uint32_t lastChunk = ok ? (_offset+_size-1u)/index->chunkSize + 1u : 0u;
+	ok = ok && lastChunk <= index->chunkCount;
+	if (ok)
+	{
+		// chunks are laid out in order, so the range of chunks is one contiguous read
+		const BlobChunkIndexV2::ChunkEntry& last = index->chunks[lastChunk-1u];
+		const uint32_t comprBegin = index->chunks[firstChunk].offset;
+		const uint32_t comprEnd = last.offset + last.compressedSize;
+		ok = comprBegin <= comprEnd;
+		if (ok)
+		{
+			const size_t decomprBegin = size_t(firstChunk)*index->chunkSize;
+			const size_t decomprSize = size_t(lastChunk-1u)*index->chunkSize + index->calcChunkSizeDecompr(lastChunk-1u, _header.blobSizeDecompr) - decomprBegin;
+
+			uint8_t* const compressed = reinterpret_cast<uint8_t*>(_IRR_ALIGNED_MALLOC(comprEnd-comprBegin, _IRR_SIMD_ALIGNMENT));
+			_file->seek(_blobOffset+indexSize+comprBegin);
+			ok = size_t(_file->read(compressed, comprEnd-comprBegin)) == comprEnd-comprBegin;
+			if (ok)
+			{
+				// decompress straight into `_dst` when the range is chunk-aligned
+				const bool aligned = decomprBegin == _offset && decomprSize == _size;
+				uint8_t* const decompressed = aligned ? reinterpret_cast<uint8_t*>(_dst) : reinterpret_cast<uint8_t*>(_IRR_ALIGNED_MALLOC(decomprSize, _IRR_SIMD_ALIGNMENT));
+
+				std::atomic<bool> chunksOk(true);
+				core::parallel_for<uint32_t>(_threadCnt, firstChunk, lastChunk, [&](uint32_t i) {
+					const BlobChunkIndexV2::ChunkEntry& chunk = index->chunks[i];
+					if (chunk.offset < comprBegin || chunk.offset+chunk.compressedSize > comprEnd || !decompressChunk(compressed+(chunk.offset-comprBegin), chunk.compressedSize, decompressed+size_t(i-firstChunk)*index->chunkSize, index->calcChunkSizeDecompr(i, _header.blobSizeDecompr), _header.compressionType))
+						chunksOk.store(false, std::memory_order_relaxed);
+				});
+				ok = chunksOk.load();
+
+				if (!aligned)
+				{
+					if (ok)
+						memcpy(_dst, decompressed+(_offset-decomprBegin), _size);
+					_IRR_ALIGNED_FREE(decompressed);
+				}
+			}
+			_IRR_ALIGNED_FREE(compressed);
+		}
+	}
+	_IRR_ALIGNED_FREE(index);
+	return ok;
+}
+
 }} // irr::core
@@ -0,0 +1,25 @@
+#ifndef __IRR_LZMA_MEM_MNGMNT_H_INCLUDED__
+#define __IRR_LZMA_MEM_MNGMNT_H_INCLUDED__
+
+//! This file is not supposed to be included in user-accesible header files
+
+#include "irr/core/memory/memory.h"
+
+#undef Bool
+#include "lzma/C/7zTypes.h"
+
+namespace irr { namespace asset
+{
+
+//! SIMD-aligned allocation callbacks for the ISzAlloc of the LZMA encoder and decoder used by the .baw loader and writer
+struct LzmaMemMngmnt
+{
+        static void *alloc(ISzAllocPtr, size_t _size) { return _IRR_ALIGNED_MALLOC(_size,_IRR_SIMD_ALIGNMENT); }
+        static void release(ISzAllocPtr, void* _addr) { _IRR_ALIGNED_FREE(_addr); }
+    private:
+        LzmaMemMngmnt() {}
+};
+
+}} // irr::asset
+
+#endif
@@ -1,19 +1,22 @@
 #define _IRR_STATIC_LIB_
 
 #include <irrlicht.h>
-#include <SMesh.h>
-#include <SSkinMeshBuffer.h>
-#include <IMeshBuffer.h>
-#include "../source/Irrlicht/CBAWMeshWriter.h"
-#include "../source/Irrlicht/CSkinnedMesh.h"
+#include "../src/irr/asset/CBAWMeshWriter.h"
+#include "irr/asset/SCPUMesh.h"
+#include "irr/asset/CCPUSkinnedMesh.h"
+#include "irr/core/parallel_for.h"
 #include <vector>
 #include <cstdlib>
 #include <chrono>
+#include <atomic>
+#include <mutex>
+#include <fstream>
+#include <sstream>
 
 #include "print.h"
 
 // Usage: convert2BAW [-i [list of input files delimited with spaces]] [-o [list of output files delimited with spaces]]
-//			[-rel <dir>] [-pwd <password>] [-optmesh <{ error metric settings threes delimited with commas }>]
+//			[-rel <dir>] [-pwd <password>] [-optmesh <{ error metric settings threes delimited with commas }>] [-j <N>] [-manifest <file>]
 // Options:
 // -i [list of input files]
 // -o [list of output files]
@@ -29,9 +32,15 @@
 //	Settings must be enclosed with curly (i.e. {}) braces and grouped in threes. Threes must be delimited with commas. Order of threes is irrelevant.
 //	Elements of each group of three must be delimited with spaces and must come with strict order: atrribute-id epsilon cmp-method
 //	Attribute-id must be integer in range [0; 15]. Epsilon is floating point number. Cmp-method must be single character and one of: A - angles, Q - quaternions, P - positions (lower-case chars are also accepted)
+// -j <N>
+//	Amount of files converted concurrently, 0 means one per hardware thread. Defaults to 1 (then blobs of the file get compressed by all hardware threads instead).
+// -manifest <file>
+//	Incremental mode. Inputs whose contents and conversion settings hash the same as recorded in the manifest by the previous run are skipped,
+//	unless their output file is missing. The manifest is created if it doesn't exist and gets updated after conversion.
+// Exit code is 0 only if every input got converted (or skipped as unchanged).
 
 //Example:
-//	convert2BAW -i somefile.obj someotherfile.x -o f1.baw f2.baw -rel /home/me/assets/ -pwd deadbeefbaadf00d0badcafefeeee997 -optmesh { 0 0.02 P, 3 0.003 A }
+//	convert2BAW -i somefile.obj someotherfile.x -o f1.baw f2.baw -rel /home/me/assets/ -pwd deadbeefbaadf00d0badcafefeeee997 -optmesh { 0 0.02 P, 3 0.003 A } -j 8 -manifest assets.manifest
 
 
 using namespace irr;
@@ -43,29 +52,83 @@ enum E_GATHER_TARGET
 	EGT_OUTPUTS
 };
 
+//! A single input file and where it goes
+struct SConversionJob
+{
+	const char* input;
+	const char* output;
+	//! Hash of input contents and conversion settings (hex string), only computed in incremental mode
+	std::string digest;
+	bool skipped = false;
+	bool succeeded = false;
+};
+
 static bool checkHex(const char* _str);
 //! Input must be 32 bytes long. Output buffer must be at least 16 bytes.
 static void hexStrToIntegers(const char* _input, unsigned char* _out);
 static uint8_t hexCharToUint8(char _c);
-static bool optMesh(scene::ICPUMesh* _mesh, const scene::IMeshManipulator* _manip, const scene::IMeshManipulator::SErrorMetric* _errMetrics);
+//! Computes digest of `_data` keyed with `_settings`, so that changing conversion settings invalidates the manifest too.
+static std::string computeDigest(const void* _data, size_t _size, const std::string& _settings);
+//! Manifest is a text file with one `<digest>\t<input>\t<output>` line per converted file, keys of the returned map are `<input>\t<output>`.
+static core::unordered_map<std::string, std::string> readManifest(const char* _filename);
+static bool writeManifest(const char* _filename, const core::unordered_map<std::string, std::string>& _entries);
+
+template<typename MeshT, typename MeshBufT>
+static bool _optMesh(MeshT* _mesh, const asset::IMeshManipulator* _manip, const asset::IMeshManipulator::SErrorMetric* _errMetrics)
+{
+    std::vector<asset::ICPUMeshBuffer*> buffers;
+
+    bool status = true;
+    for (size_t i = 0u; i < _mesh->getMeshBufferCount(); ++i)
+    {
+        asset::ICPUMeshBuffer* optdBuf = _manip->createOptimizedMeshBuffer(_mesh->getMeshBuffer(i), _errMetrics);
+        if (!optdBuf)
+        {
+            status = false;
+            break;
+        }
+        buffers.push_back(optdBuf);
+    }
+
+    if (status)
+    {
+        _mesh->clearMeshBuffers();
+        for (asset::ICPUMeshBuffer* b : buffers)
+            if (MeshBufT* bb = dynamic_cast<MeshBufT*>(b))
+            _mesh->addMeshBuffer(bb);
+    }
+
+    for (const asset::ICPUMeshBuffer* b : buffers)
+        b->drop();
+
+    return status;
+}
+static bool optMesh(asset::ICPUMesh* _mesh, const asset::IMeshManipulator* _manip, const asset::IMeshManipulator::SErrorMetric* _errMetrics)
+{
+    if (asset::CCPUSkinnedMesh* m = dynamic_cast<asset::CCPUSkinnedMesh*>(_mesh))
+        return _optMesh<asset::CCPUSkinnedMesh, asset::ICPUSkinnedMeshBuffer>(m, _manip, _errMetrics);
+    else if (asset::SCPUMesh* m = dynamic_cast<asset::SCPUMesh*>(_mesh))
+        return _optMesh<asset::SCPUMesh, asset::ICPUMeshBuffer>(m, _manip, _errMetrics);
+    return false;
+}
 
 int main(int _optCnt, char** _options)
 {
 	--_optCnt;
 	++_options;
+	const size_t optCnt = static_cast<size_t>(_optCnt);
 
 	irr::SIrrlichtCreationParameters params;
-	params.DriverType = video::EDT_OPENGL;
-	params.WindowSize = core::dimension2d<uint32_t>(128, 128);
+	// loaders and writers don't need a GPU, with the null driver no window or context gets created, so the tool runs on headless machines
+	params.DriverType = video::EDT_NULL;
 	IrrlichtDevice* device = createDeviceEx(params);
 
 	if (!device)
 		return 1;
 
-	scene::ISceneManager* const smgr = device->getSceneManager();
 	io::IFileSystem* const fs = device->getFileSystem();
-	scene::CBAWMeshWriter* const writer = dynamic_cast<scene::CBAWMeshWriter*>(smgr->createMeshWriter(irr::scene::EMWT_BAW));
-	scene::IMeshManipulator* const meshManip = smgr->getMeshManipulator();
+	asset::IAssetManager& assetMgr = device->getAssetManager();
+	const asset::IMeshManipulator* const meshManip = assetMgr.getMeshManipulator();
 
 	std::vector<const char*> inNames;
 	std::vector<const char*> outNames;
@@ -74,8 +137,13 @@ int main(int _optCnt, char** _options)
 	bool usePwd = 0;
 	bool optimizeMesh = 0;
 	bool printInfo = 0;
-	scene::CBAWMeshWriter::WriteProperties properties;
-	scene::IMeshManipulator::SErrorMetric errMetrics[16];
+	uint32_t jobCount = 1u;
+	const char* manifestName = nullptr;
+	// everything which influences the output, apart from the input itself
+	std::string settings;
+	unsigned char encryptionKey[16];
+	asset::CBAWMeshWriter::WriteProperties properties;
+	asset::IMeshManipulator::SErrorMetric errMetrics[16];
 
 	srand(std::chrono::high_resolution_clock::now().time_since_epoch().count());
 	for (size_t i = 0u; i < 16u; ++i)
@@ -84,7 +152,7 @@ int main(int _optCnt, char** _options)
 		reinterpret_cast<uint8_t*>(properties.initializationVector)[i] ^= std::chrono::high_resolution_clock::now().time_since_epoch().count();
     }
 
-	for (size_t idx = 0u; idx < _optCnt; ++idx)
+	for (size_t idx = 0u; idx < optCnt; ++idx)
 	{
 		if (_options[idx][0] == '-')
 		{
@@ -92,7 +160,7 @@ int main(int _optCnt, char** _options)
 				gatherWhat = EGT_INPUTS;
 			else if (core::equalsIgnoreCase("o", _options[idx]+1))
 				gatherWhat = EGT_OUTPUTS;
-			else if (idx+1 != _optCnt && core::equalsIgnoreCase("pwd", _options[idx]+1))
+			else if (idx+1 != optCnt && core::equalsIgnoreCase("pwd", _options[idx]+1))
 			{
 				++idx;
 				gatherWhat = EGT_UNDEFINED;
@@ -106,11 +174,11 @@ int main(int _optCnt, char** _options)
 					printf("Password must consist of only hex digits! Ignore - password not set.\n");
 					continue;
 				}
-				hexStrToIntegers(_options[idx], properties.encryptionPassPhrase);
+				hexStrToIntegers(_options[idx], encryptionKey);
 				usePwd = 1;
 				continue;
 			}
-			else if (idx+1 != _optCnt && core::equalsIgnoreCase("rel", _options[idx]+1))
+			else if (idx+1 != optCnt && core::equalsIgnoreCase("rel", _options[idx]+1))
 			{
 				++idx;
 				gatherWhat = EGT_UNDEFINED;
@@ -123,7 +191,21 @@ int main(int _optCnt, char** _options)
 				printInfo = 1;
 				continue;
 			}
-			else if (idx+1 != _optCnt && core::equalsIgnoreCase("optmesh", _options[idx]+1))
+			else if (idx+1 != optCnt && core::equalsIgnoreCase("j", _options[idx]+1))
+			{
+				++idx;
+				gatherWhat = EGT_UNDEFINED;
+				jobCount = core::resolveThreadCount(strtoul(_options[idx], nullptr, 10));
+				continue;
+			}
+			else if (idx+1 != optCnt && core::equalsIgnoreCase("manifest", _options[idx]+1))
+			{
+				++idx;
+				gatherWhat = EGT_UNDEFINED;
+				manifestName = _options[idx];
+				continue;
+			}
+			else if (idx+1 != optCnt && core::equalsIgnoreCase("optmesh", _options[idx]+1))
 			{
 				gatherWhat = EGT_UNDEFINED;
 				optimizeMesh = 1;
@@ -143,6 +225,7 @@ int main(int _optCnt, char** _options)
 
 				} while (!strstr(_options[idx++], "}"));
 				--idx;
+				settings += "optmesh " + s + '\n';
 
 				const size_t cnt = std::count(s.begin(), s.end(), ',')+1;
 				std::transform(s.cbegin(), s.cend(), s.begin(), [](char c) { return (c == '{' || c == '}' || c == ',') ? ' ' : c; });
@@ -162,13 +245,13 @@ int main(int _optCnt, char** _options)
 					switch (method)
 					{
 					case 'a':
-						errMetrics[vaid].method = scene::IMeshManipulator::EEM_ANGLES;
+						errMetrics[vaid].method = asset::IMeshManipulator::EEM_ANGLES;
 						break;
 					case 'q':
-						errMetrics[vaid].method = scene::IMeshManipulator::EEM_QUATERNION;
+						errMetrics[vaid].method = asset::IMeshManipulator::EEM_QUATERNION;
 						break;
 					case 'p':
-						errMetrics[vaid].method = scene::IMeshManipulator::EEM_POSITIONS;
+						errMetrics[vaid].method = asset::IMeshManipulator::EEM_POSITIONS;
 						break;
 					}
 				}
@@ -205,52 +288,125 @@ int main(int _optCnt, char** _options)
 	if (inNames.size() != outNames.size())
 	{
 		printf("Fatal error. Amounts of input and output filenames doesn't match. Exiting.\n");
-        writer->drop();
         device->drop();
 		return 1;
 	}
 
-	for (size_t i = 0u; i < inNames.size(); ++i)
+	// the password itself never lands in the manifest, changing it doesn't change the output in a way worth detecting anyway (the IV is random every run)
+	settings += std::string("rel ") + properties.relPath.c_str() + "\nencrypted " + (usePwd ? "1":"0") + '\n';
+	// files are already converted concurrently then, so blobs of a file get encoded by the thread converting it
+	properties.workerThreadCount = jobCount>1u ? 1u:0u;
+
+	core::unordered_map<std::string, std::string> manifest;
+	if (manifestName)
+		manifest = readManifest(manifestName);
+
+	std::vector<SConversionJob> jobs(inNames.size());
+	for (size_t i = 0u; i < jobs.size(); ++i)
 	{
-		scene::ICPUMesh* inmesh = smgr->getMesh(inNames[i]);
-		if (!inmesh)
+		jobs[i].input = inNames[i];
+		jobs[i].output = outNames[i];
+	}
+
+	const asset::IAssetWriter::SAssetWriteParams wparams(nullptr, usePwd ? asset::E_WRITER_FLAGS(asset::EWF_COMPRESSED|asset::EWF_ENCRYPTED):asset::EWF_COMPRESSED, 0.f, usePwd ? 16u:0u, usePwd ? encryptionKey:nullptr, &properties);
+	// keeps mesh info of different files from interleaving
+	std::mutex printMutex;
+
+	// loaders keep their state per load and the asset cache is thread safe, so every job only needs its own copies of write params
+	auto convert = [&](size_t _jobIx) -> void
+	{
+		SConversionJob& job = jobs[_jobIx];
+
+		// memory mapped file lets the contents be hashed and then parsed without an extra copy, the fallback reads the file into memory once
+		core::vector<uint8_t> contents;
+		io::IReadFile* infile = fs->createMappedReadFile(job.input);
+		if (!infile || !infile->getMappedPointer())
 		{
-			printf("Could not load mesh %s.\n", inNames[i]);
-			continue;
+			if (infile)
+				infile->drop();
+			infile = nullptr;
+			if (io::IReadFile* file = fs->createAndOpenFile(job.input))
+			{
+				contents.resize(file->getSize());
+				if (file->read(contents.data(), contents.size()) == contents.size())
+					infile = fs->createMemoryReadFile(contents.data(), contents.size(), job.input);
+				file->drop();
+			}
 		}
-		io::IWriteFile* outfile = fs->createAndWriteFile(outNames[i]);
-		if (!outfile)
+		if (!infile)
 		{
-			printf("Could not create/open file %s.\n", outNames[i]);
-            smgr->getMeshCache()->removeMesh(inmesh);
-			continue;
+			printf("Could not open file %s.\n", job.input);
+			return;
 		}
-		if (optimizeMesh && !optMesh(inmesh, meshManip, errMetrics))
+
+		if (manifestName)
 		{
-			printf("Could not optimize mesh %s. Mesh not exported!\n", inNames[i]);
-			smgr->getMeshCache()->removeMesh(inmesh);
-            outfile->drop();
-			continue;
+			const void* data = contents.empty() ? infile->getMappedPointer() : contents.data();
+			job.digest = computeDigest(data, infile->getSize(), settings);
+
+			auto found = manifest.find(std::string(job.input)+'\t'+job.output);
+			if (found != manifest.end() && found->second == job.digest && fs->existFile(job.output))
+			{
+				infile->drop();
+				job.skipped = true;
+				job.succeeded = true;
+				return;
+			}
 		}
 
-        if (printInfo)
-        {
-            printf("%s INFO:\n", inNames[i]);
-            printFullMeshInfo(stdout, inmesh);
-        }
+		asset::IAssetLoader::SAssetLoadParams lparams;
+		asset::SAssetBundle bundle = assetMgr.getAsset(infile, job.input, lparams);
+		infile->drop();
+		if (bundle.isEmpty() || bundle.getAssetType() != asset::IAsset::ET_MESH)
+		{
+			printf("Could not load mesh %s.\n", job.input);
+			return;
+		}
+		asset::ICPUMesh* inmesh = static_cast<asset::ICPUMesh*>(bundle.getContents().first->get());
 
-		if (usePwd)
-			writer->writeMesh(outfile, inmesh, properties);
+		if (optimizeMesh && !optMesh(inmesh, meshManip, errMetrics))
+			printf("Could not optimize mesh %s. Mesh not exported!\n", job.input);
 		else
-			writer->writeMesh(outfile, inmesh, scene::EMWF_WRITE_COMPRESSED);
+		{
+			if (printInfo)
+			{
+				std::lock_guard<std::mutex> lock(printMutex);
+				printf("%s INFO:\n", job.input);
+				printFullMeshInfo(stdout, inmesh);
+			}
+
+			asset::IAssetWriter::SAssetWriteParams jobParams = wparams;
+			jobParams.rootAsset = inmesh;
+			job.succeeded = assetMgr.writeAsset(job.output, jobParams);
+			if (!job.succeeded)
+				printf("Could not create/open file %s.\n", job.output);
+		}
 
-        smgr->getMeshCache()->removeMesh(inmesh);
-		outfile->drop();
+		assetMgr.removeAssetFromCache(bundle);
+	};
+	core::parallel_for(jobCount, size_t(0u), jobs.size(), convert);
+
+	size_t skippedCnt = 0u, failedCnt = 0u;
+	for (const SConversionJob& job : jobs)
+	{
+		skippedCnt += job.skipped;
+		failedCnt += !job.succeeded;
+		if (!manifestName)
+			continue;
+		// failed conversions get dropped, so they are retried next time regardless of whether their inputs change
+		const std::string key = std::string(job.input)+'\t'+job.output;
+		if (job.succeeded)
+			manifest[key] = job.digest;
+		else
+			manifest.erase(key);
 	}
-	writer->drop();
+	if (manifestName && !writeManifest(manifestName, manifest))
+		printf("Could not write manifest %s.\n", manifestName);
+	printf("Converted %u, skipped %u unchanged, failed %u.\n", uint32_t(jobs.size()-skippedCnt-failedCnt), uint32_t(skippedCnt), uint32_t(failedCnt));
+
 	device->drop();
 
-	return 0;
+	return failedCnt ? 1:0;
 }
 
 static bool checkHex(const char* _str)
@@ -282,71 +438,44 @@ static uint8_t hexCharToUint8(char _c)
 	return tolower(_c) - 'a' + 10;
 }
 
-//static bool optMesh(scene::ICPUMesh* _mesh, const scene::IMeshManipulator* _manip, const scene::IMeshManipulator::SErrorMetric* _errMetrics)
-//{
-//	std::vector<scene::ICPUMeshBuffer*> buffers;
-//
-//	bool status = true;
-//	size_t c = _mesh->getMeshBufferCount();
-//	for (size_t i = 0u; i < _mesh->getMeshBufferCount(); ++i)
-//	{
-//		scene::ICPUMeshBuffer* optdBuf = _manip->createOptimizedMeshBuffer(_mesh->getMeshBuffer(i), _errMetrics);
-//		if (!optdBuf)
-//		{
-//			status = false;
-//			break;
-//		}
-//		buffers.push_back(optdBuf);
-//	}
-//
-//	if (status)
-//	{
-//		_mesh->clearMeshBuffers();
-//		for (scene::ICPUMeshBuffer* b : buffers)
-//			_mesh->addMeshBuffer(b);
-//	}
-//
-//	for (const scene::ICPUMeshBuffer* b : buffers)
-//		b->drop();
-//
-//	return status;
-//}
-template<typename MeshT, typename MeshBufT>
-static bool _optMesh(MeshT* _mesh, const scene::IMeshManipulator* _manip, const scene::IMeshManipulator::SErrorMetric* _errMetrics)
-{
-    std::vector<scene::ICPUMeshBuffer*> buffers;
-
-    bool status = true;
-    size_t c = _mesh->getMeshBufferCount();
-    for (size_t i = 0u; i < _mesh->getMeshBufferCount(); ++i)
-    {
-        scene::ICPUMeshBuffer* optdBuf = _manip->createOptimizedMeshBuffer(_mesh->getMeshBuffer(i), _errMetrics);
-        if (!optdBuf)
-        {
-            status = false;
-            break;
-        }
-        buffers.push_back(optdBuf);
-    }
 
-    if (status)
-    {
-        _mesh->clearMeshBuffers();
-        for (scene::ICPUMeshBuffer* b : buffers)
-            if (MeshBufT* bb = dynamic_cast<MeshBufT*>(b))
-            _mesh->addMeshBuffer(bb);
-    }
+static std::string computeDigest(const void* _data, size_t _size, const std::string& _settings)
+{
+	auto toHex = [](const uint64_t* _hash) -> std::string
+	{
+		char str[65];
+		for (size_t i = 0u; i < 4u; ++i)
+			sprintf(str+16u*i, "%016llx", static_cast<unsigned long long>(_hash[i]));
+		return std::string(str, 64u);
+	};
+
+	uint64_t hash[4];
+	core::XXHash_256(_data, _size, hash);
+	const std::string keyed = toHex(hash) + _settings;
+	core::XXHash_256(keyed.data(), keyed.size(), hash);
+	return toHex(hash);
+}
 
-    for (const scene::ICPUMeshBuffer* b : buffers)
-        b->drop();
+static core::unordered_map<std::string, std::string> readManifest(const char* _filename)
+{
+	core::unordered_map<std::string, std::string> entries;
 
-    return status;
+	std::ifstream file(_filename);
+	std::string line;
+	while (std::getline(file, line))
+	{
+		const size_t tab = line.find('\t');
+		if (tab == std::string::npos)
+			continue;
+		entries[line.substr(tab+1u)] = line.substr(0u, tab);
+	}
+	return entries;
 }
-static bool optMesh(scene::ICPUMesh* _mesh, const scene::IMeshManipulator* _manip, const scene::IMeshManipulator::SErrorMetric* _errMetrics)
+
+static bool writeManifest(const char* _filename, const core::unordered_map<std::string, std::string>& _entries)
 {
-    if (scene::CCPUSkinnedMesh* m = dynamic_cast<scene::CCPUSkinnedMesh*>(_mesh))
-        return _optMesh<scene::CCPUSkinnedMesh, scene::SCPUSkinMeshBuffer>(m, _manip, _errMetrics);
-    else if (scene::SCPUMesh* m = dynamic_cast<scene::SCPUMesh*>(_mesh))
-        return _optMesh<scene::SCPUMesh, scene::ICPUMeshBuffer>(m, _manip, _errMetrics);
-    return false;
+	std::ofstream file(_filename, std::ios_base::trunc);
+	for (const auto& entry : _entries)
+		file << entry.second << '\t' << entry.first << '\n';
+	return bool(file);
 }
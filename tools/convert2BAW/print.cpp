@@ -1,73 +1,35 @@
 #include "print.h"
 
-#include <IMesh.h>
-#include <IMeshBuffer.h>
+#include "irr/asset/ICPUMesh.h"
+#include "irr/asset/ICPUMeshBuffer.h"
 
 using namespace irr;
 
-static std::string idxTypeToStr(scene::E_INDEX_TYPE _it) 
+static std::string idxTypeToStr(asset::E_INDEX_TYPE _it) 
 {
 	switch (_it)
 	{
-	case scene::EIT_16BIT: return "EIT_16BIT";
-	case scene::EIT_32BIT: return "EIT_32BIT";
-	case scene::EIT_UNKNOWN: return "EIT_UNKNOWN";
+	case asset::EIT_16BIT: return "EIT_16BIT";
+	case asset::EIT_32BIT: return "EIT_32BIT";
+	case asset::EIT_UNKNOWN: return "EIT_UNKNOWN";
 	}
 	return "";
 }
-static std::string primitiveTypeToStr(scene::E_PRIMITIVE_TYPE _pt)
+static std::string primitiveTypeToStr(asset::E_PRIMITIVE_TYPE _pt)
 {
 	switch (_pt)
 	{
-	case scene::EPT_POINTS: return "EPT_POINTS";
-	case scene::EPT_LINE_STRIP: return "EPT_LINE_STRIP";
-	case scene::EPT_LINE_LOOP: return "EPT_LINE_LOOP";
-	case scene::EPT_LINES: return "EPT_LINES";
-	case scene::EPT_TRIANGLE_STRIP: return "EPT_TRIANGLE_STRIP";
-	case scene::EPT_TRIANGLE_FAN: return "EPT_TRIANGLE_FAN";
-	case scene::EPT_TRIANGLES: return "EPT_TRIANGLES";
+	case asset::EPT_POINTS: return "EPT_POINTS";
+	case asset::EPT_LINE_STRIP: return "EPT_LINE_STRIP";
+	case asset::EPT_LINE_LOOP: return "EPT_LINE_LOOP";
+	case asset::EPT_LINES: return "EPT_LINES";
+	case asset::EPT_TRIANGLE_STRIP: return "EPT_TRIANGLE_STRIP";
+	case asset::EPT_TRIANGLE_FAN: return "EPT_TRIANGLE_FAN";
+	case asset::EPT_TRIANGLES: return "EPT_TRIANGLES";
 	}
 	return "";
 }
-static std::string cmpntTypeToStr(scene::E_COMPONENT_TYPE _cp)
-{
-	using namespace scene;
-	switch (_cp)
-	{
-	case ECT_FLOAT: return "ECT_FLOAT";
-	case ECT_HALF_FLOAT: return "ECT_HALF_FLOAT";
-	case ECT_DOUBLE_IN_FLOAT_OUT: return "ECT_DOUBLE_IN_FLOAT_OUT";
-	case ECT_UNSIGNED_INT_10F_11F_11F_REV: return "ECT_UNSIGNED_INT_10F_11F_11F_REV";
-	case ECT_NORMALIZED_INT_2_10_10_10_REV: return "ECT_NORMALIZED_INT_2_10_10_10_REV";
-	case ECT_NORMALIZED_UNSIGNED_INT_2_10_10_10_REV: return "ECT_NORMALIZED_UNSIGNED_INT_2_10_10_10_REV";
-	case ECT_NORMALIZED_BYTE: return "ECT_NORMALIZED_BYTE";
-	case ECT_NORMALIZED_UNSIGNED_BYTE: return "ECT_NORMALIZED_UNSIGNED_BYTE";
-	case ECT_NORMALIZED_SHORT: return "ECT_NORMALIZED_SHORT";
-	case ECT_NORMALIZED_UNSIGNED_SHORT: return "ECT_NORMALIZED_UNSIGNED_SHORT";
-	case ECT_NORMALIZED_INT: return "ECT_NORMALIZED_INT";
-	case ECT_NORMALIZED_UNSIGNED_INT: return "ECT_NORMALIZED_UNSIGNED_INT";
-	case ECT_INT_2_10_10_10_REV: return "ECT_INT_2_10_10_10_REV";
-	case ECT_UNSIGNED_INT_2_10_10_10_REV: return "ECT_UNSIGNED_INT_2_10_10_10_REV";
-	case ECT_BYTE: return "ECT_BYTE";
-	case ECT_UNSIGNED_BYTE: return "ECT_UNSIGNED_BYTE";
-	case ECT_SHORT: return "ECT_SHORT";
-	case ECT_UNSIGNED_SHORT: return "ECT_UNSIGNED_SHORT";
-	case ECT_INT: return "ECT_INT";
-	case ECT_UNSIGNED_INT: return "ECT_UNSIGNED_INT";
-	case ECT_INTEGER_INT_2_10_10_10_REV: return "ECT_INTEGER_INT_2_10_10_10_REV";
-	case ECT_INTEGER_UNSIGNED_INT_2_10_10_10_REV: return "ECT_INTEGER_UNSIGNED_INT_2_10_10_10_REV";
-	case ECT_INTEGER_BYTE: return "ECT_INTEGER_BYTE";
-	case ECT_INTEGER_UNSIGNED_BYTE: return "ECT_INTEGER_UNSIGNED_BYTE";
-	case ECT_INTEGER_SHORT: return "ECT_INTEGER_SHORT";
-	case ECT_INTEGER_UNSIGNED_SHORT: return "ECT_INTEGER_UNSIGNED_SHORT";
-	case ECT_INTEGER_INT: return "ECT_INTEGER_INT";
-	case ECT_INTEGER_UNSIGNED_INT: return "ECT_INTEGER_UNSIGNED_INT";
-	case ECT_DOUBLE_IN_DOUBLE_OUT: return "ECT_DOUBLE_IN_DOUBLE_OUT";
-	}
-	return "";
-}
-
-void printFullMeshInfo(FILE* _ostream, const irr::scene::ICPUMesh * _mesh, size_t _indent)
+void printFullMeshInfo(FILE* _ostream, const irr::asset::ICPUMesh * _mesh, size_t _indent)
 {
 	const std::string indent(_indent, '\t');
 
@@ -75,52 +37,52 @@ void printFullMeshInfo(FILE* _ostream, const irr::scene::ICPUMesh * _mesh, size_
 	printMeshInfo(_ostream, _mesh, _indent+1);
 }
 
-void printMeshInfo(FILE* _ostream, const scene::ICPUMesh* _mesh, size_t _indent)
+void printMeshInfo(FILE* _ostream, const asset::ICPUMesh* _mesh, size_t _indent)
 {
 	const std::string indent(_indent, '\t');
 
 	for (size_t i = 0u; i < _mesh->getMeshBufferCount(); ++i)
 	{
-		fprintf(_ostream, "%sMesh buffer %u:\n", indent.c_str(), i);
+		fprintf(_ostream, "%sMesh buffer %zu:\n", indent.c_str(), i);
 		printMeshBufferInfo(_ostream, _mesh->getMeshBuffer(i), _indent+1);
 	}
 }
 
-void printMeshBufferInfo(FILE* _ostream, const scene::ICPUMeshBuffer* _buf, size_t _indent)
+void printMeshBufferInfo(FILE* _ostream, const asset::ICPUMeshBuffer* _buf, size_t _indent)
 {
 	const std::string indent(_indent, '\t');
 
 	fprintf(_ostream, "%sindexType: %s\n", indent.c_str(), idxTypeToStr(_buf->getIndexType()).c_str());
 	fprintf(_ostream, "%sbaseVertex: %d\n", indent.c_str(), _buf->getBaseVertex());
-	fprintf(_ostream, "%sindexCount: %u\n", indent.c_str(), _buf->getIndexCount());
-	fprintf(_ostream, "%sindexBufOffset: %u\n", indent.c_str(), _buf->getIndexBufferOffset());
-	fprintf(_ostream, "%sinstanceCount: %u\n", indent.c_str(), _buf->getInstanceCount());
+	fprintf(_ostream, "%sindexCount: %llu\n", indent.c_str(), static_cast<unsigned long long>(_buf->getIndexCount()));
+	fprintf(_ostream, "%sindexBufOffset: %zu\n", indent.c_str(), _buf->getIndexBufferOffset());
+	fprintf(_ostream, "%sinstanceCount: %zu\n", indent.c_str(), _buf->getInstanceCount());
 	fprintf(_ostream, "%sbaseInstance: %u\n", indent.c_str(), _buf->getBaseInstance());
 	fprintf(_ostream, "%sprimitiveType: %s\n", indent.c_str(), primitiveTypeToStr(_buf->getPrimitiveType()).c_str());
 	fprintf(_ostream, "%smeshLayout:\n", indent.c_str());
 	printDescInfo(_ostream, _buf->getMeshDataAndFormat(), _indent+1);
 }
 
-static void printAttributeInfo(FILE* _ostream, const scene::IMeshDataFormatDesc<core::ICPUBuffer>* _desc, scene::E_VERTEX_ATTRIBUTE_ID _vaid, size_t _indent)
+static void printAttributeInfo(FILE* _ostream, const asset::IMeshDataFormatDesc<asset::ICPUBuffer>* _desc, asset::E_VERTEX_ATTRIBUTE_ID _vaid, size_t _indent)
 {
 	const std::string indent(_indent, '\t');
 
-	fprintf(_ostream, "%scompntsPerAttr: %u\n", indent.c_str(), (size_t)_desc->getAttribComponentCount(_vaid));
-	fprintf(_ostream, "%sattrType: %s\n", indent.c_str(), cmpntTypeToStr(_desc->getAttribType(_vaid)).c_str());
+	fprintf(_ostream, "%scompntsPerAttr: %u\n", indent.c_str(), asset::getFormatChannelCount(_desc->getAttribFormat(_vaid)));
+	fprintf(_ostream, "%sattrFormat: %u\n", indent.c_str(), (uint32_t)_desc->getAttribFormat(_vaid));
 	fprintf(_ostream, "%sstride: %u\n", indent.c_str(), _desc->getMappedBufferStride(_vaid));
-	fprintf(_ostream, "%soffset: %u\n", indent.c_str(), _desc->getMappedBufferOffset(_vaid));
+	fprintf(_ostream, "%soffset: %zu\n", indent.c_str(), _desc->getMappedBufferOffset(_vaid));
 	fprintf(_ostream, "%sdivisor: %u\n", indent.c_str(), _desc->getAttribDivisor(_vaid));
 }
-void printDescInfo(FILE* _ostream, const scene::IMeshDataFormatDesc<core::ICPUBuffer>* _desc, size_t _indent)
+void printDescInfo(FILE* _ostream, const asset::IMeshDataFormatDesc<asset::ICPUBuffer>* _desc, size_t _indent)
 {
 	const std::string indent(_indent, '\t');
 
-	for (size_t vaid = 0u; vaid < scene::EVAI_COUNT; ++vaid)
+	for (size_t vaid = 0u; vaid < asset::EVAI_COUNT; ++vaid)
 	{
-		if (const void* b = _desc->getMappedBuffer((scene::E_VERTEX_ATTRIBUTE_ID)vaid))
+		if (const void* b = _desc->getMappedBuffer((asset::E_VERTEX_ATTRIBUTE_ID)vaid))
 		{
-			fprintf(_ostream, "%sAttribute %u in buffer %p:\n", indent.c_str(), vaid, b);
-			printAttributeInfo(_ostream, _desc, (scene::E_VERTEX_ATTRIBUTE_ID)vaid, _indent+1);
+			fprintf(_ostream, "%sAttribute %zu in buffer %p:\n", indent.c_str(), vaid, b);
+			printAttributeInfo(_ostream, _desc, (asset::E_VERTEX_ATTRIBUTE_ID)vaid, _indent+1);
 		}
 	}
 }
\ No newline at end of file
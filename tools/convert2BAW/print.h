@@ -5,21 +5,18 @@
 
 namespace irr 
 { 
-	namespace core
+	namespace asset
 	{
 		class ICPUBuffer;
-	}
-	namespace scene 
-	{
 		class ICPUMesh;
 		class ICPUMeshBuffer;
 		template<typename> class IMeshDataFormatDesc;
 	}
 }
-void printFullMeshInfo(FILE* _ostream, const irr::scene::ICPUMesh* _mesh, size_t _indent = 0u);
-void printMeshInfo(FILE* _ostream, const irr::scene::ICPUMesh* _mesh, size_t _indent);
-void printMeshBufferInfo(FILE* _ostream, const irr::scene::ICPUMeshBuffer* _buf, size_t _indent);
-void printDescInfo(FILE* _ostream, const irr::scene::IMeshDataFormatDesc<irr::core::ICPUBuffer>* _desc, size_t _indent);
+void printFullMeshInfo(FILE* _ostream, const irr::asset::ICPUMesh* _mesh, size_t _indent = 0u);
+void printMeshInfo(FILE* _ostream, const irr::asset::ICPUMesh* _mesh, size_t _indent);
+void printMeshBufferInfo(FILE* _ostream, const irr::asset::ICPUMeshBuffer* _buf, size_t _indent);
+void printDescInfo(FILE* _ostream, const irr::asset::IMeshDataFormatDesc<irr::asset::ICPUBuffer>* _desc, size_t _indent);
 
 
 #endif
\ No newline at end of file